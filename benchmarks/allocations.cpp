@@ -0,0 +1,67 @@
+#include <new>
+#include <cstdlib>
+
+#include "allocations.hpp"
+
+
+namespace {
+
+thread_local std::uint64_t thread_allocations = 0;
+
+void* Allocate(std::size_t bytes)
+{
+    ++thread_allocations;
+
+    if (const auto allocated = std::malloc(bytes ? bytes : 1); allocated)
+    {
+        return allocated;
+    }
+
+    throw std::bad_alloc();
+}
+
+void* AllocateAligned(std::size_t bytes, std::align_val_t alignment)
+{
+    ++thread_allocations;
+
+    const auto align = static_cast<std::size_t>(alignment);
+    const auto size  = (bytes + align - 1) / align * align;
+
+    if (const auto allocated = std::aligned_alloc(align, size ? size : align); allocated)
+    {
+        return allocated;
+    }
+
+    throw std::bad_alloc();
+}
+
+}  // namespace
+
+
+namespace ntp::bench {
+
+std::uint64_t ThreadAllocations() noexcept
+{
+    return thread_allocations;
+}
+
+}  // namespace ntp::bench
+
+
+//
+// Replaced global allocation functions
+//
+
+void* operator new(std::size_t bytes) { return Allocate(bytes); }
+void* operator new[](std::size_t bytes) { return Allocate(bytes); }
+void* operator new(std::size_t bytes, std::align_val_t alignment) { return AllocateAligned(bytes, alignment); }
+void* operator new[](std::size_t bytes, std::align_val_t alignment) { return AllocateAligned(bytes, alignment); }
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept { std::free(ptr); }
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstdint>
+
+
+namespace ntp::bench {
+
+/**
+ * @brief Number of global operator new calls made by the current thread.
+ * 
+ * Global operator new is replaced in benchmarks executable to count allocations.
+ */
+std::uint64_t ThreadAllocations() noexcept;
+
+}  // namespace ntp::bench
@@ -0,0 +1,32 @@
+#pragma once
+
+//
+// Google benchmark library
+//
+
+#include "benchmark/benchmark.h"
+
+
+//
+// STL headers
+//
+
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <vector>
+#include <array>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <tuple>
+#include <string>
+#include <memory>
+#include <algorithm>
+
+
+//
+// ntp library
+//
+
+#include "ntp.hpp"
@@ -0,0 +1,83 @@
+#include "bench_config.hpp"
+
+namespace {
+
+using ntp::allocator::SlabAllocator;
+
+void BM_SlabAllocator(benchmark::State& state)
+{
+    const auto size = static_cast<size_t>(state.range(0));
+
+    for (auto _ : state)
+    {
+        const auto block = SlabAllocator::AllocateBytes(size);
+        benchmark::DoNotOptimize(block);
+
+        SlabAllocator::Free(block, size);
+    }
+
+    state.counters["hit_rate"] = benchmark::Counter(SlabAllocator::Statistics().HitRate(), benchmark::Counter::kAvgThreads);
+}
+
+void BM_OperatorNew(benchmark::State& state)
+{
+    const auto size = static_cast<size_t>(state.range(0));
+
+    for (auto _ : state)
+    {
+        const auto block = ::operator new(size, std::align_val_t { SlabAllocator::kBlockAlignment });
+        benchmark::DoNotOptimize(block);
+
+        ::operator delete(block, std::align_val_t { SlabAllocator::kBlockAlignment });
+    }
+}
+
+/**
+ * @brief Allocation in one thread and free in another one (as WorkManager does).
+ */
+template<typename Allocate, typename Free>
+void CrossThread(benchmark::State& state, Allocate allocate, Free free)
+{
+    static constexpr size_t kBlocks = 1024;
+    static constexpr size_t kSize   = 64;
+
+    std::vector<void*> blocks(kBlocks);
+
+    for (auto _ : state)
+    {
+        for (auto& block : blocks)
+        {
+            block = allocate(kSize);
+        }
+
+        std::thread([&blocks, &free]() {
+            for (auto block : blocks)
+            {
+                free(block, kSize);
+            }
+        }).join();
+    }
+
+    state.SetItemsProcessed(state.iterations() * kBlocks);
+}
+
+void BM_SlabAllocatorCrossThread(benchmark::State& state)
+{
+    CrossThread(state, SlabAllocator::AllocateBytes, SlabAllocator::Free);
+    state.counters["hit_rate"] = benchmark::Counter(SlabAllocator::Statistics().HitRate(), benchmark::Counter::kAvgThreads);
+}
+
+void BM_OperatorNewCrossThread(benchmark::State& state)
+{
+    CrossThread(state, 
+        [](size_t bytes) { return ::operator new(bytes); },
+        [](void* ptr, size_t) { ::operator delete(ptr); });
+}
+
+}  // namespace
+
+
+BENCHMARK(BM_SlabAllocator)->Arg(64)->Arg(256)->Arg(1024)->ThreadRange(1, 8);
+BENCHMARK(BM_OperatorNew)->Arg(64)->Arg(256)->Arg(1024)->ThreadRange(1, 8);
+BENCHMARK(BM_SlabAllocatorCrossThread);
+BENCHMARK(BM_OperatorNewCrossThread);
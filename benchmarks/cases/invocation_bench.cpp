@@ -0,0 +1,63 @@
+#include "bench_config.hpp"
+
+namespace {
+
+/**
+ * @brief Callable with "heavy" arguments.
+ */
+struct Consumer
+{
+    void operator()(const std::string& name, const std::vector<int>& values) const
+    {
+        benchmark::DoNotOptimize(name.data());
+        benchmark::DoNotOptimize(values.data());
+    }
+};
+
+std::vector<int> MakeValues(benchmark::State& state)
+{
+    return std::vector<int>(static_cast<size_t>(state.range(0)), 1);
+}
+
+/**
+ * @brief Invocation through ICallback (arguments are passed by reference).
+ */
+void BM_TimerCallbackCall(benchmark::State& state)
+{
+    ntp::details::callback_t callback;
+    callback.Emplace<ntp::timer::details::TimerCallback<Consumer, std::string, std::vector<int>>>(
+        Consumer {}, std::string("periodic timer with a long name"), MakeValues(state));
+
+    for (auto _ : state)
+    {
+        //
+        // Hide callback type from optimizer to keep the virtual call
+        //
+
+        ntp::details::ICallback* target = callback.operator->();
+        benchmark::DoNotOptimize(target);
+
+        target->Call(nullptr, nullptr);
+    }
+}
+
+/**
+ * @brief Baseline: copy of stored arguments on every call.
+ */
+void BM_CopyingCall(benchmark::State& state)
+{
+    Consumer consumer;
+    const auto arguments = std::make_tuple(std::string("periodic timer with a long name"), MakeValues(state));
+
+    for (auto _ : state)
+    {
+        const auto args = std::tuple_cat(std::make_tuple(), arguments);
+        std::apply(consumer, args);
+    }
+}
+
+}  // namespace
+
+
+BENCHMARK(BM_TimerCallbackCall)->Arg(0)->Arg(16)->Arg(1024);
+BENCHMARK(BM_CopyingCall)->Arg(0)->Arg(16)->Arg(1024);
@@ -0,0 +1,504 @@
+#include "bench_config.hpp"
+
+#if defined(NTP_PLATFORM_LINUX)
+#   include <cstdlib>
+#   include <unistd.h>
+#endif
+
+namespace {
+
+/**
+ * @brief Temporary file opened for asynchronous IO. It is deleted, when closed.
+ */
+class BenchFile final
+{
+    BenchFile(const BenchFile&)            = delete;
+    BenchFile& operator=(const BenchFile&) = delete;
+
+public:
+    BenchFile()
+    {
+#if defined(NTP_PLATFORM_LINUX)
+        char path[] = "/tmp/~ntpbenchXXXXXX";
+
+        const auto descriptor = mkstemp(path);
+        unlink(path);
+
+        handle_ = HandleFromDescriptor(descriptor);
+#else
+        std::array<wchar_t, MAX_PATH> temp_path;
+        std::array<wchar_t, MAX_PATH> file_name;
+
+        GetTempPathW(static_cast<DWORD>(temp_path.size()), temp_path.data());
+        GetTempFileNameW(temp_path.data(), L"~ntp", 0, file_name.data());
+
+        handle_ = CreateFileW(file_name.data(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+            FILE_FLAG_OVERLAPPED | FILE_FLAG_DELETE_ON_CLOSE, nullptr);
+#endif
+    }
+
+    ~BenchFile()
+    {
+        CloseHandle(handle_);
+    }
+
+    operator HANDLE() const noexcept { return handle_; }
+
+private:
+    HANDLE handle_;
+};
+
+
+/**
+ * @brief Size of a single write.
+ */
+constexpr DWORD kChunk = 4096;
+
+
+/**
+ * @brief Starts a write of a single chunk and waits until its completion callback runs.
+ *
+ * @param file File to write into
+ * @param buffer Chunk to write
+ * @param overlapped Overlapped structure of the operation
+ * @param completed Counter, that is incremented by the callback
+ * @param expected Value of the counter after the operation completes
+ * @returns true if operation has been started
+ */
+bool WriteAndWait(HANDLE file, const std::vector<char>& buffer, OVERLAPPED& overlapped,
+    const std::atomic<int64_t>& completed, int64_t expected)
+{
+    overlapped = {};
+
+    if (!WriteFile(file, buffer.data(), kChunk, nullptr, &overlapped) && GetLastError() != ERROR_IO_PENDING)
+    {
+        return false;
+    }
+
+    while (completed.load(std::memory_order_acquire) != expected)
+    {
+        std::this_thread::yield();
+    }
+
+    return true;
+}
+
+
+/**
+ * @brief Writes chunks with a new IO object per operation (SubmitIo).
+ */
+void BM_IoSubmitPerOperation(benchmark::State& state)
+{
+    BenchFile file;
+    std::vector<char> buffer(kChunk, 'x');
+    std::atomic<int64_t> completed = 0;
+
+    ntp::SystemThreadPool pool;
+    OVERLAPPED overlapped;
+
+    int64_t expected = 0;
+    for (auto _ : state)
+    {
+        const auto io = pool.SubmitIo(file, [&completed](LPVOID, ULONG, ULONG_PTR) {
+            completed.fetch_add(1, std::memory_order_release);
+        });
+
+        if (!WriteAndWait(file, buffer, overlapped, completed, ++expected))
+        {
+            pool.AbortIo(io);
+            state.SkipWithError("Cannot start write");
+            break;
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+
+/**
+ * @brief Writes chunks through a single persistent IO binding (BindIo + BeginOperation).
+ */
+void BM_IoBinding(benchmark::State& state)
+{
+    BenchFile file;
+    std::vector<char> buffer(kChunk, 'x');
+    std::atomic<int64_t> completed = 0;
+
+    ntp::SystemThreadPool pool;
+    OVERLAPPED overlapped;
+
+    const auto binding = pool.BindIo(file, [&completed](LPVOID, ULONG, ULONG_PTR) {
+        completed.fetch_add(1, std::memory_order_release);
+    });
+
+    int64_t expected = 0;
+    for (auto _ : state)
+    {
+        binding.BeginOperation();
+
+        if (!WriteAndWait(file, buffer, overlapped, completed, ++expected))
+        {
+            binding.AbortOperation();
+            state.SkipWithError("Cannot start write");
+            break;
+        }
+    }
+
+    pool.UnbindIo(binding);
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+
+/**
+ * @brief Context of operation allocated from heap (baseline for IoBufferPool).
+ */
+struct HeapOperation
+{
+    OVERLAPPED overlapped;
+    void* data;
+};
+
+
+/**
+ * @brief Allocates and frees an operation context with a page-aligned chunk on heap.
+ */
+void BM_IoContextHeap(benchmark::State& state)
+{
+    for (auto _ : state)
+    {
+        const auto operation = new HeapOperation {};
+        operation->data      = ::operator new(kChunk, std::align_val_t { ntp::io::IoBufferPool::kPageSize });
+
+        benchmark::DoNotOptimize(operation->data);
+
+        ::operator delete(operation->data, std::align_val_t { ntp::io::IoBufferPool::kPageSize });
+        delete operation;
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+
+/**
+ * @brief Takes an operation context with a chunk from IoBufferPool and returns it.
+ */
+void BM_IoContextPool(benchmark::State& state)
+{
+    for (auto _ : state)
+    {
+        const auto operation = ntp::io::IoBufferPool::Acquire(kChunk);
+
+        benchmark::DoNotOptimize(operation->Data());
+
+        operation->Release();
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+
+/**
+ * @brief Writes chunks through a single binding with pooled contexts, released after callbacks.
+ */
+void BM_IoBindingPooled(benchmark::State& state)
+{
+    BenchFile file;
+    std::atomic<int64_t> completed = 0;
+
+    ntp::SystemThreadPool pool;
+
+    const auto binding = pool.BindIo(file, [&completed](ntp::io::IoOperation&, ULONG, ULONG_PTR) {
+        completed.fetch_add(1, std::memory_order_release);
+    });
+
+    int64_t expected = 0;
+    for (auto _ : state)
+    {
+        const auto operation = ntp::io::IoBufferPool::Acquire(kChunk);
+
+        binding.BeginOperation();
+
+        if (!WriteFile(file, operation->Data(), kChunk, nullptr, operation->Overlapped()) && GetLastError() != ERROR_IO_PENDING)
+        {
+            binding.AbortOperation();
+            operation->Release();
+
+            state.SkipWithError("Cannot start write");
+            break;
+        }
+
+        ++expected;
+        while (completed.load(std::memory_order_acquire) != expected)
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    pool.UnbindIo(binding);
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+
+#if defined(NTP_PLATFORM_LINUX)
+
+/**
+ * @brief Number of chunks in a file, that is read by throughput benchmarks.
+ */
+constexpr std::size_t kReadChunks = 256;
+
+
+/**
+ * @brief Fills a file with kReadChunks chunks, so that further reads are served from page cache.
+ */
+bool FillFile(HANDLE file)
+{
+    const std::vector<char> content(kReadChunks * kChunk, 'x');
+    return pwrite(DescriptorFromHandle(file), content.data(), content.size(), 0) == static_cast<ssize_t>(content.size());
+}
+
+
+/**
+ * @brief Reads chunks through io_uring: each iteration starts state.range(0)
+ *        reads at once (ReadFile on a bound file) and waits for all of them.
+ *
+ * @param fixed If true, buffer is registered in the ring
+ */
+void IoRingRead(benchmark::State& state, bool fixed)
+{
+    BenchFile file;
+    if (!FillFile(file))
+    {
+        state.SkipWithError("Cannot fill file");
+        return;
+    }
+
+    const auto depth = static_cast<std::size_t>(state.range(0));
+
+    std::vector<char> buffer(depth * kChunk);
+    std::vector<OVERLAPPED> overlapped(depth);
+    std::atomic<int64_t> completed = 0;
+
+    ntp::SystemThreadPool pool;
+
+    const auto binding = pool.BindIo(file, [&completed](LPVOID, ULONG, ULONG_PTR) {
+        completed.fetch_add(1, std::memory_order_release);
+    });
+
+    if (fixed && !binding.RegisterBuffer(buffer.data(), buffer.size()))
+    {
+        pool.UnbindIo(binding);
+        state.SkipWithError("io_uring is not available");
+        return;
+    }
+
+    int64_t expected  = 0;
+    std::size_t chunk = 0;
+
+    for (auto _ : state)
+    {
+        for (std::size_t i = 0; i < depth; ++i)
+        {
+            overlapped[i]        = {};
+            overlapped[i].Offset = static_cast<DWORD>((chunk++ % kReadChunks) * kChunk);
+
+            binding.BeginOperation();
+            ReadFile(file, buffer.data() + i * kChunk, kChunk, nullptr, &overlapped[i]);
+        }
+
+        expected += static_cast<int64_t>(depth);
+        while (completed.load(std::memory_order_acquire) != expected)
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    if (fixed)
+    {
+        binding.UnregisterBuffer(buffer.data());
+    }
+
+    pool.UnbindIo(binding);
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.SetBytesProcessed(state.iterations() * state.range(0) * kChunk);
+}
+
+void BM_IoRingRead(benchmark::State& state)
+{
+    IoRingRead(state, false);
+}
+
+void BM_IoRingReadFixed(benchmark::State& state)
+{
+    IoRingRead(state, true);
+}
+
+
+/**
+ * @brief Baseline for io_uring reads: each iteration submits state.range(0)
+ *        work callbacks, each of them reads a chunk with plain pread.
+ */
+void BM_IoPreadWork(benchmark::State& state)
+{
+    BenchFile file;
+    if (!FillFile(file))
+    {
+        state.SkipWithError("Cannot fill file");
+        return;
+    }
+
+    const auto depth      = static_cast<std::size_t>(state.range(0));
+    const auto descriptor = DescriptorFromHandle(file);
+
+    std::vector<char> buffer(depth * kChunk);
+    std::atomic<int64_t> completed = 0;
+
+    ntp::SystemThreadPool pool;
+
+    int64_t expected  = 0;
+    std::size_t chunk = 0;
+
+    for (auto _ : state)
+    {
+        for (std::size_t i = 0; i < depth; ++i)
+        {
+            const auto offset = static_cast<off_t>((chunk++ % kReadChunks) * kChunk);
+
+            pool.SubmitWork([&completed, descriptor, data = buffer.data() + i * kChunk, offset]() {
+                pread(descriptor, data, kChunk, offset);
+                completed.fetch_add(1, std::memory_order_release);
+            });
+        }
+
+        expected += static_cast<int64_t>(depth);
+        while (completed.load(std::memory_order_acquire) != expected)
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.SetBytesProcessed(state.iterations() * state.range(0) * kChunk);
+}
+
+
+/**
+ * @brief Size of a log record written by vectored IO benchmarks.
+ */
+constexpr std::size_t kRecord = 128;
+
+
+/**
+ * @brief Appends state.range(0) small records per iteration, one WriteFile per record.
+ */
+void BM_IoWritePerRecord(benchmark::State& state)
+{
+    BenchFile file;
+
+    const auto records = static_cast<std::size_t>(state.range(0));
+
+    std::vector<char> buffer(records * kRecord, 'r');
+    std::vector<OVERLAPPED> overlapped(records);
+    std::atomic<int64_t> completed = 0;
+
+    ntp::SystemThreadPool pool;
+
+    const auto binding = pool.BindIo(file, [&completed](LPVOID, ULONG, ULONG_PTR) {
+        completed.fetch_add(1, std::memory_order_release);
+    });
+
+    int64_t expected = 0;
+
+    for (auto _ : state)
+    {
+        for (std::size_t i = 0; i < records; ++i)
+        {
+            overlapped[i]        = {};
+            overlapped[i].Offset = static_cast<DWORD>(i * kRecord);
+
+            binding.BeginOperation();
+            WriteFile(file, buffer.data() + i * kRecord, static_cast<DWORD>(kRecord), nullptr, &overlapped[i]);
+        }
+
+        expected += static_cast<int64_t>(records);
+        while (completed.load(std::memory_order_acquire) != expected)
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    pool.UnbindIo(binding);
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+
+/**
+ * @brief Appends state.range(0) small records per iteration with a single vectored write.
+ */
+void BM_IoWriteGather(benchmark::State& state)
+{
+    BenchFile file;
+
+    const auto records = static_cast<std::size_t>(state.range(0));
+
+    std::vector<char> buffer(records * kRecord, 'r');
+    std::vector<ntp::io::IoSegment> segments;
+    std::atomic<int64_t> completed = 0;
+
+    for (std::size_t i = 0; i < records; ++i)
+    {
+        segments.push_back({ buffer.data() + i * kRecord, kRecord });
+    }
+
+    ntp::SystemThreadPool pool;
+
+    const auto binding = pool.BindIo(file, [&completed](LPVOID, ULONG, ULONG_PTR) {
+        completed.fetch_add(1, std::memory_order_release);
+    });
+
+    int64_t expected = 0;
+    OVERLAPPED overlapped;
+
+    for (auto _ : state)
+    {
+        overlapped = {};
+
+        if (!binding.WriteGather(file, segments.data(), segments.size(), &overlapped))
+        {
+            state.SkipWithError("Cannot start write");
+            break;
+        }
+
+        ++expected;
+        while (completed.load(std::memory_order_acquire) != expected)
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    pool.UnbindIo(binding);
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+#endif  // NTP_PLATFORM_LINUX
+
+}  // namespace
+
+
+BENCHMARK(BM_IoSubmitPerOperation)->UseRealTime();
+BENCHMARK(BM_IoBinding)->UseRealTime();
+BENCHMARK(BM_IoBindingPooled)->UseRealTime();
+BENCHMARK(BM_IoContextHeap);
+BENCHMARK(BM_IoContextPool);
+
+#if defined(NTP_PLATFORM_LINUX)
+BENCHMARK(BM_IoRingRead)->RangeMultiplier(8)->Range(1, 64)->UseRealTime();
+BENCHMARK(BM_IoRingReadFixed)->RangeMultiplier(8)->Range(1, 64)->UseRealTime();
+BENCHMARK(BM_IoPreadWork)->RangeMultiplier(8)->Range(1, 64)->UseRealTime();
+BENCHMARK(BM_IoWritePerRecord)->RangeMultiplier(8)->Range(8, 512)->UseRealTime();
+BENCHMARK(BM_IoWriteGather)->RangeMultiplier(8)->Range(8, 512)->UseRealTime();
+#endif  // NTP_PLATFORM_LINUX
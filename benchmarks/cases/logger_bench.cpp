@@ -0,0 +1,71 @@
+#include "bench_config.hpp"
+#include "logger/logger_internal.hpp"
+
+namespace {
+
+void NullLogger(ntp::logger::Severity /* severity */, const wchar_t* message)
+{
+    benchmark::DoNotOptimize(message);
+}
+
+/**
+ * @brief Installs a logger and a minimum severity for a benchmark and restores previous ones.
+ */
+class ScopedLogger final
+{
+public:
+    explicit ScopedLogger(ntp::logger::Severity min_severity)
+        : logger_(ntp::logger::SetLogger(NullLogger))
+        , severity_(ntp::logger::SetMinSeverity(min_severity))
+    { }
+
+    ~ScopedLogger()
+    {
+        ntp::logger::SetMinSeverity(severity_);
+        ntp::logger::SetLogger(logger_);
+    }
+
+private:
+    ntp::logger::logger_t logger_;
+    ntp::logger::Severity severity_;
+};
+
+/**
+ * @brief Trace call, that is dropped by runtime threshold (e.g. kExtended trace of WaitAll in production).
+ */
+void BM_DisabledTrace(benchmark::State& state)
+{
+    ScopedLogger scoped { ntp::logger::Severity::kError };
+
+    std::size_t left_unprocessed = 42;
+    benchmark::DoNotOptimize(left_unprocessed);
+
+    for (auto _ : state)
+    {
+        ntp::logger::details::Logger::Instance().TraceMessage(ntp::logger::Severity::kExtended,
+            L"[WorkManager::CancelAll]: tasks cancelled and %1!zu! left unprocessed", left_unprocessed);
+    }
+}
+
+/**
+ * @brief Baseline: the same trace call, that is formatted and delivered.
+ */
+void BM_EnabledTrace(benchmark::State& state)
+{
+    ScopedLogger scoped { ntp::logger::Severity::kExtended };
+
+    std::size_t left_unprocessed = 42;
+    benchmark::DoNotOptimize(left_unprocessed);
+
+    for (auto _ : state)
+    {
+        ntp::logger::details::Logger::Instance().TraceMessage(ntp::logger::Severity::kExtended,
+            L"[WorkManager::CancelAll]: tasks cancelled and %1!zu! left unprocessed", left_unprocessed);
+    }
+}
+
+}  // namespace
+
+
+BENCHMARK(BM_DisabledTrace);
+BENCHMARK(BM_EnabledTrace);
@@ -0,0 +1,106 @@
+#include "bench_config.hpp"
+
+namespace {
+
+/**
+ * @brief Registry with a single shard behaves like a container under one global lock.
+ */
+template<size_t ShardCount>
+using registry_t = ntp::details::ShardedRegistry<void*, std::unique_ptr<int>, ShardCount>;
+
+
+/**
+ * @brief Inserts and erases keys from several threads, while registry holds range(0) other keys.
+ */
+template<size_t ShardCount>
+void BM_RegistryContention(benchmark::State& state)
+{
+    static registry_t<ShardCount>* registry = nullptr;
+    static std::vector<std::unique_ptr<char[]>> keys;
+
+    const auto preloaded = static_cast<size_t>(state.range(0));
+
+    if (state.thread_index() == 0)
+    {
+        registry = new registry_t<ShardCount>();
+        keys.clear();
+
+        for (size_t i = 0; i < preloaded; ++i)
+        {
+            keys.push_back(std::make_unique<char[]>(16));
+            registry->Insert(keys.back().get(), std::make_unique<int>(0), [](auto&) {});
+        }
+    }
+
+    //
+    // Keys are unique for each thread, like handles of newly created objects
+    //
+
+    std::vector<std::unique_ptr<char[]>> own_keys;
+    for (size_t i = 0; i < 64; ++i)
+    {
+        own_keys.push_back(std::make_unique<char[]>(16));
+    }
+
+    size_t index = 0;
+    for (auto _ : state)
+    {
+        const auto key = own_keys[index++ % own_keys.size()].get();
+
+        registry->Insert(key, std::make_unique<int>(1), [](auto&) {});
+        registry->Erase(key, [](auto&) {});
+    }
+
+    if (state.thread_index() == 0)
+    {
+        delete registry;
+        registry = nullptr;
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+
+/**
+ * @brief Submits and cancels timers from several threads, while the pool holds range(0) other timers.
+ */
+void BM_TimerSubmitCancel(benchmark::State& state)
+{
+    using namespace std::chrono_literals;
+
+    static ntp::SystemThreadPool* pool = nullptr;
+
+    const auto preloaded = static_cast<size_t>(state.range(0));
+
+    if (state.thread_index() == 0)
+    {
+        pool = new ntp::SystemThreadPool();
+
+        for (size_t i = 0; i < preloaded; ++i)
+        {
+            pool->SubmitTimer(1h, []() {});
+        }
+    }
+
+    for (auto _ : state)
+    {
+        const auto timer = pool->SubmitTimer(1h, []() {});
+        pool->CancelTimer(timer);
+    }
+
+    if (state.thread_index() == 0)
+    {
+        delete pool;
+        pool = nullptr;
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+}  // namespace
+
+
+BENCHMARK_TEMPLATE(BM_RegistryContention, 1)->Arg(10000)->Arg(100000)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_RegistryContention, 64)->Arg(10000)->Arg(100000)->ThreadRange(1, 8)->UseRealTime();
+
+BENCHMARK(BM_TimerSubmitCancel)->Arg(10000)->Arg(100000)->ThreadRange(1, 8)->UseRealTime();
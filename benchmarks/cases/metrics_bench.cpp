@@ -0,0 +1,65 @@
+#include "bench_config.hpp"
+#include "details/metrics.hpp"
+
+namespace {
+
+ntp::metrics::details::MetricsRecorder recorder;
+
+/**
+ * @brief Recording of a work callback with already known timestamps (histograms only).
+ */
+void BM_MetricsRecord(benchmark::State& state)
+{
+    std::uint64_t ticks = 1000;
+
+    for (auto _ : state)
+    {
+        recorder.Completed(ticks - 500, ticks, ticks + 300);
+
+        ++ticks;
+    }
+}
+
+/**
+ * @brief Reading of timestamp.
+ */
+void BM_MetricsReadTicks(benchmark::State& state)
+{
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(ntp::metrics::details::ReadTicks());
+    }
+}
+
+/**
+ * @brief Everything, that is done per work callback: histograms and timestamps.
+ */
+void BM_MetricsCallback(benchmark::State& state)
+{
+    const auto enqueued = ntp::metrics::details::ReadTicks();
+
+    for (auto _ : state)
+    {
+        ntp::metrics::details::CallbackScope scope { recorder, enqueued };
+        benchmark::DoNotOptimize(&scope);
+    }
+}
+
+/**
+ * @brief Baseline: steady clock, that could be used for timestamps instead.
+ */
+void BM_SteadyClockNow(benchmark::State& state)
+{
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(std::chrono::steady_clock::now());
+    }
+}
+
+}  // namespace
+
+
+BENCHMARK(BM_MetricsRecord)->ThreadRange(1, 8);
+BENCHMARK(BM_MetricsReadTicks);
+BENCHMARK(BM_MetricsCallback)->ThreadRange(1, 8);
+BENCHMARK(BM_SteadyClockNow);
@@ -0,0 +1,61 @@
+#include "bench_config.hpp"
+#include "details/queue.hpp"
+
+namespace {
+
+/**
+ * @brief Baseline: std::deque protected with a mutex.
+ */
+class LockedQueue final
+{
+public:
+    bool TryPush(void* value)
+    {
+        std::lock_guard lock { lock_ };
+        queue_.push_back(value);
+
+        return true;
+    }
+
+    bool TryPop(void*& value)
+    {
+        std::lock_guard lock { lock_ };
+
+        if (queue_.empty())
+        {
+            return false;
+        }
+
+        value = queue_.front();
+        queue_.pop_front();
+
+        return true;
+    }
+
+private:
+    std::mutex lock_;
+    std::deque<void*> queue_;
+};
+
+
+template<typename Queue>
+void BM_QueuePushPop(benchmark::State& state)
+{
+    static Queue queue;
+
+    void* value = nullptr;
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(queue.TryPush(&value));
+        benchmark::DoNotOptimize(queue.TryPop(value));
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+}  // namespace
+
+
+BENCHMARK_TEMPLATE(BM_QueuePushPop, ntp::details::MpmcQueue<void*>)->ThreadRange(1, 16)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_QueuePushPop, LockedQueue)->ThreadRange(1, 16)->UseRealTime();
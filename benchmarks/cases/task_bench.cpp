@@ -0,0 +1,88 @@
+#include <future>
+
+#include "bench_config.hpp"
+#include "allocations.hpp"
+
+namespace {
+
+/**
+ * @brief Fan-out of tasks with results: SubmitTask and Get.
+ */
+void BM_SubmitTask(benchmark::State& state)
+{
+    const auto fan_out = static_cast<size_t>(state.range(0));
+
+    std::vector<ntp::task::Future<int>> futures;
+    futures.reserve(fan_out);
+
+    ntp::SystemThreadPool pool;
+
+    const auto allocations_before = ntp::bench::ThreadAllocations();
+
+    for (auto _ : state)
+    {
+        for (size_t i = 0; i < fan_out; ++i)
+        {
+            futures.push_back(pool.SubmitTask([](size_t value) {
+                return static_cast<int>(value);
+            }, i));
+        }
+
+        int sum = 0;
+        for (auto& future : futures)
+        {
+            sum += future.Get();
+        }
+
+        futures.clear();
+        benchmark::DoNotOptimize(sum);
+    }
+
+    const auto allocations = ntp::bench::ThreadAllocations() - allocations_before;
+
+    state.counters["heap_allocs_per_task"] = static_cast<double>(allocations) / static_cast<double>(state.iterations() * state.range(0));
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+/**
+ * @brief The same fan-out with std::async (baseline).
+ */
+void BM_StdAsync(benchmark::State& state)
+{
+    const auto fan_out = static_cast<size_t>(state.range(0));
+
+    std::vector<std::future<int>> futures;
+    futures.reserve(fan_out);
+
+    const auto allocations_before = ntp::bench::ThreadAllocations();
+
+    for (auto _ : state)
+    {
+        for (size_t i = 0; i < fan_out; ++i)
+        {
+            futures.push_back(std::async(std::launch::async, [](size_t value) {
+                return static_cast<int>(value);
+            }, i));
+        }
+
+        int sum = 0;
+        for (auto& future : futures)
+        {
+            sum += future.get();
+        }
+
+        futures.clear();
+        benchmark::DoNotOptimize(sum);
+    }
+
+    const auto allocations = ntp::bench::ThreadAllocations() - allocations_before;
+
+    state.counters["heap_allocs_per_task"] = static_cast<double>(allocations) / static_cast<double>(state.iterations() * state.range(0));
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+}  // namespace
+
+
+BENCHMARK(BM_SubmitTask)->Arg(16)->Arg(256)->UseRealTime();
+BENCHMARK(BM_StdAsync)->Arg(16)->Arg(256)->UseRealTime();
@@ -0,0 +1,291 @@
+#include "bench_config.hpp"
+
+#if defined(NTP_PLATFORM_LINUX)
+#   include <sys/resource.h>
+#endif
+
+namespace {
+
+/**
+ * @brief Timer with some user data, like in ntp::timer::details::SoftTimer.
+ */
+struct BenchTimer : ntp::details::TimerWheelEntry
+{
+    size_t payload = 0;
+};
+
+
+/**
+ * @brief Inserts a timer into the wheel with range(0) timers and cancels it.
+ */
+void BM_TimerWheelInsertCancel(benchmark::State& state)
+{
+    ntp::details::TimerWheel<> wheel;
+
+    std::vector<BenchTimer> timers(static_cast<size_t>(state.range(0)));
+    for (size_t i = 0; i < timers.size(); ++i)
+    {
+        wheel.Insert(&timers[i], 1 + (i * 7919) % 100000);
+    }
+
+    BenchTimer timer;
+    std::uint64_t expiry = 0;
+
+    for (auto _ : state)
+    {
+        wheel.Insert(&timer, 1 + (expiry++ * 7919) % 100000);
+        wheel.Cancel(&timer);
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+
+/**
+ * @brief Inserts range(0) timers spread over 100k ticks and expires all of them.
+ */
+void BM_TimerWheelExpire(benchmark::State& state)
+{
+    std::vector<BenchTimer> timers(static_cast<size_t>(state.range(0)));
+    size_t expired = 0;
+
+    for (auto _ : state)
+    {
+        ntp::details::TimerWheel<> wheel;
+
+        for (size_t i = 0; i < timers.size(); ++i)
+        {
+            wheel.Insert(&timers[i], 1 + (i * 7919) % 100000);
+        }
+
+        for (std::uint64_t tick = 1; tick <= 100000; ++tick)
+        {
+            wheel.Advance(tick, [&expired](ntp::details::TimerWheelEntry*) { ++expired; });
+        }
+    }
+
+    benchmark::DoNotOptimize(expired);
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+
+/**
+ * @brief Submits and cancels a soft timer, while the pool holds range(0) soft timers.
+ */
+void BM_SoftTimerSubmitCancel(benchmark::State& state)
+{
+    using namespace std::chrono_literals;
+
+    ntp::SystemThreadPool pool;
+
+    for (int64_t i = 0; i < state.range(0); ++i)
+    {
+        pool.SubmitSoftTimer(1h, []() {});
+    }
+
+    for (auto _ : state)
+    {
+        pool.CancelSoftTimer(pool.SubmitSoftTimer(1h, []() {}));
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+
+/**
+ * @brief Submits and cancels a threadpool timer object, while the pool holds range(0) timers.
+ */
+void BM_NativeTimerSubmitCancel(benchmark::State& state)
+{
+    using namespace std::chrono_literals;
+
+    ntp::SystemThreadPool pool;
+
+    for (int64_t i = 0; i < state.range(0); ++i)
+    {
+        pool.SubmitTimer(1h, []() {});
+    }
+
+    for (auto _ : state)
+    {
+        pool.CancelTimer(pool.SubmitTimer(1h, []() {}));
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+
+/**
+ * @brief Postpones an existing timer by replacing its callback with the same one and by rearming it.
+ *        range(0) is 0 for ReplaceTimer and 1 for RearmTimer.
+ */
+void BM_TimerPostpone(benchmark::State& state)
+{
+    using namespace std::chrono_literals;
+
+    ntp::SystemThreadPool pool;
+
+    const auto rearm = state.range(0) != 0;
+    const auto timer = pool.SubmitTimer(1h, []() {});
+
+    for (auto _ : state)
+    {
+        if (rearm)
+        {
+            benchmark::DoNotOptimize(pool.RearmTimer(timer, 1h));
+        }
+        else
+        {
+            benchmark::DoNotOptimize(pool.ReplaceTimer(timer, []() {}));
+        }
+    }
+
+    state.SetLabel(rearm ? "rearm" : "replace");
+    state.SetItemsProcessed(state.iterations());
+}
+
+
+/**
+ * @brief Submits range(0) already expired timers and waits until all of them fire
+ *        (create to fire rate, items per second is the measure).
+ */
+void BM_NativeTimerFire(benchmark::State& state)
+{
+    using namespace std::chrono_literals;
+
+    ntp::SystemThreadPool pool;
+
+    std::atomic<int64_t> fired = 0;
+    int64_t expected = 0;
+
+    for (auto _ : state)
+    {
+        for (int64_t i = 0; i < state.range(0); ++i)
+        {
+            pool.SubmitTimer(0ms, [&fired]() {
+                fired.fetch_add(1, std::memory_order_release);
+            });
+        }
+
+        expected += state.range(0);
+
+        while (fired.load(std::memory_order_acquire) != expected)
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+
+/**
+ * @brief Number of voluntary context switches of the process (i.e. how many times its threads slept and woke up).
+ */
+double ProcessWakeups()
+{
+#if defined(NTP_PLATFORM_LINUX)
+    rusage usage {};
+    getrusage(RUSAGE_SELF, &usage);
+
+    return static_cast<double>(usage.ru_nvcsw);
+#else
+    return 0;
+#endif
+}
+
+
+/**
+ * @brief Runs 64 periodic timers with 20 ms period and staggered due times for 200 ms per iteration.
+ *        Tolerance is range(0) milliseconds. Reports wakeups per second (Linux only) and callbacks per second.
+ */
+void BM_PeriodicTimerWakeups(benchmark::State& state)
+{
+    using namespace std::chrono_literals;
+
+    static constexpr auto kTimers = 64;
+    static constexpr auto kPeriod = 20ms;
+
+    const auto tolerance = ntp::time::Tolerance(std::chrono::milliseconds(state.range(0)));
+
+    std::atomic_int64_t callbacks = 0;
+    double wakeups                = 0;
+    std::chrono::steady_clock::duration elapsed {};
+
+    for (auto _ : state)
+    {
+        ntp::SystemThreadPool pool;
+
+        const auto wakeups_before = ProcessWakeups();
+        const auto start          = std::chrono::steady_clock::now();
+
+        for (auto i = 0; i < kTimers; ++i)
+        {
+            pool.SubmitTimer(kPeriod * i / kTimers + 1ms, kPeriod, tolerance, [&callbacks]() {
+                ++callbacks;
+            });
+        }
+
+        std::this_thread::sleep_for(200ms);
+        pool.CancelTimers();
+
+        elapsed += std::chrono::steady_clock::now() - start;
+        wakeups += ProcessWakeups() - wakeups_before;
+    }
+
+    const auto seconds = std::chrono::duration<double>(elapsed).count();
+
+    state.counters["wakeups_per_sec"]   = wakeups / seconds;
+    state.counters["callbacks_per_sec"] = static_cast<double>(callbacks.load()) / seconds;
+}
+
+
+/**
+ * @brief Runs a precise periodic timer with range(0) microseconds period for 200 ms per iteration.
+ *        Reports ticks per second, missed ticks and percentiles of jitter (in microseconds).
+ */
+void BM_PreciseTimerJitter(benchmark::State& state)
+{
+    using namespace std::chrono_literals;
+
+    const auto period = std::chrono::microseconds(state.range(0));
+
+    ntp::SystemThreadPool pool;
+    auto jitter = std::make_shared<ntp::time::JitterHistogram>();
+
+    std::atomic<std::uint64_t> missed = 0;
+
+    for (auto _ : state)
+    {
+        const auto timer = pool.SubmitPeriodicTimer(0ms, period, jitter, [&missed](const ntp::time::TimerTick& tick) {
+            missed += tick.missed;
+        });
+
+        std::this_thread::sleep_for(200ms);
+        pool.CancelTimer(timer);
+    }
+
+    const auto to_us = [](ntp::time::native_duration_t value) {
+        return std::chrono::duration<double, std::micro>(value).count();
+    };
+
+    state.counters["ticks/s"] = benchmark::Counter(static_cast<double>(jitter->Count()), benchmark::Counter::kIsRate);
+    state.counters["missed"]  = static_cast<double>(missed.load());
+    state.counters["p50_us"]  = to_us(jitter->Percentile(0.5));
+    state.counters["p99_us"]  = to_us(jitter->Percentile(0.99));
+    state.counters["max_us"]  = to_us(jitter->Max());
+}
+
+}  // namespace
+
+
+BENCHMARK(BM_TimerWheelInsertCancel)->Arg(0)->Arg(10000)->Arg(200000);
+BENCHMARK(BM_TimerWheelExpire)->Arg(10000)->Arg(200000)->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_SoftTimerSubmitCancel)->Arg(0)->Arg(10000)->Arg(200000);
+BENCHMARK(BM_NativeTimerSubmitCancel)->Arg(0)->Arg(10000)->Arg(200000);
+BENCHMARK(BM_TimerPostpone)->Arg(0)->Arg(1);
+BENCHMARK(BM_NativeTimerFire)->Arg(1)->Arg(256)->UseRealTime();
+
+BENCHMARK(BM_PeriodicTimerWakeups)->Arg(0)->Arg(5)->Arg(20)->Unit(benchmark::kMillisecond)->Iterations(5);
+BENCHMARK(BM_PreciseTimerJitter)->Arg(250)->Arg(1000)->Unit(benchmark::kMillisecond)->Iterations(5)->UseRealTime();
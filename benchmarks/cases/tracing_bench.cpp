@@ -0,0 +1,57 @@
+#include "bench_config.hpp"
+#include "details/tracing.hpp"
+
+namespace {
+
+/**
+ * @brief Tracing scope, when tracing is stopped (the cost of compiled in tracing).
+ */
+void BM_TraceStopped(benchmark::State& state)
+{
+    ntp::tracing::Stop();
+
+    for (auto _ : state)
+    {
+        ntp::tracing::details::TraceScope scope { ntp::tracing::CallbackKind::kWork, nullptr };
+        benchmark::DoNotOptimize(&scope);
+    }
+}
+
+/**
+ * @brief Recording of an event: timestamps and a write to thread's buffer.
+ */
+void BM_TraceStarted(benchmark::State& state)
+{
+    static constexpr std::size_t kEventsPerStart = 4096;
+
+    std::size_t recorded = 0;
+    ntp::tracing::Start();
+
+    for (auto _ : state)
+    {
+        {
+            ntp::tracing::details::TraceScope scope { ntp::tracing::CallbackKind::kWork, "bench" };
+            benchmark::DoNotOptimize(&scope);
+        }
+
+        if (++recorded == kEventsPerStart)
+        {
+            //
+            // Buffer is reset, so that events are not dropped
+            //
+
+            state.PauseTiming();
+            ntp::tracing::Start();
+            state.ResumeTiming();
+
+            recorded = 0;
+        }
+    }
+
+    ntp::tracing::Stop();
+}
+
+}  // namespace
+
+BENCHMARK(BM_TraceStopped);
+BENCHMARK(BM_TraceStarted);
@@ -0,0 +1,196 @@
+#include "bench_config.hpp"
+
+namespace {
+
+/**
+ * @brief Signals an auto-reset event and waits until the wait callback observes it.
+ *
+ * @param event Auto-reset event to signal
+ * @param signaled Counter, that is incremented by the callback
+ * @param expected Value of the counter after the signal is handled
+ */
+void SignalAndWait(HANDLE event, const std::atomic<int64_t>& signaled, int64_t expected)
+{
+    SetEvent(event);
+
+    while (signaled.load(std::memory_order_acquire) != expected)
+    {
+        std::this_thread::yield();
+    }
+}
+
+
+/**
+ * @brief Waits on an auto-reset event with a new wait object per signal (created, submitted and closed each time).
+ */
+void BM_WaitOneShot(benchmark::State& state)
+{
+    const auto event = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+    std::atomic<int64_t> signaled = 0;
+
+    ntp::SystemThreadPool pool;
+
+    int64_t expected = 0;
+    for (auto _ : state)
+    {
+        pool.SubmitWait(event, [&signaled](TP_WAIT_RESULT) {
+            signaled.fetch_add(1, std::memory_order_release);
+        });
+
+        SignalAndWait(event, signaled, ++expected);
+    }
+
+    pool.CancelWaits();
+    CloseHandle(event);
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+
+/**
+ * @brief Waits on an auto-reset event with a single persistent wait object, that is rearmed by its callback.
+ */
+void BM_WaitPersistent(benchmark::State& state)
+{
+    const auto event = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+    std::atomic<int64_t> signaled = 0;
+
+    ntp::SystemThreadPool pool;
+
+    pool.SubmitWait(event, [&signaled](TP_WAIT_RESULT) {
+        signaled.fetch_add(1, std::memory_order_release);
+        return ntp::wait::WaitAction::kRearm;
+    });
+
+    int64_t expected = 0;
+    for (auto _ : state)
+    {
+        SignalAndWait(event, signaled, ++expected);
+    }
+
+    pool.CancelWaits();
+    CloseHandle(event);
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+
+/**
+ * @brief Baseline for signal to callback latency: a dedicated thread
+ *        waits on std::condition_variable instead of a wait object.
+ */
+void BM_ConditionVariableSignal(benchmark::State& state)
+{
+    std::mutex lock;
+    std::condition_variable condition;
+
+    int64_t signals = 0;
+    bool stopped    = false;
+
+    std::atomic<int64_t> signaled = 0;
+
+    std::thread waiter([&]() {
+        std::unique_lock guard { lock };
+
+        for (int64_t handled = 0;;)
+        {
+            condition.wait(guard, [&]() { return stopped || signals != handled; });
+
+            if (stopped)
+            {
+                return;
+            }
+
+            handled = signals;
+            signaled.store(handled, std::memory_order_release);
+        }
+    });
+
+    int64_t expected = 0;
+    for (auto _ : state)
+    {
+        {
+            std::lock_guard guard { lock };
+            signals = ++expected;
+        }
+
+        condition.notify_one();
+
+        while (signaled.load(std::memory_order_acquire) != expected)
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    {
+        std::lock_guard guard { lock };
+        stopped = true;
+    }
+
+    condition.notify_one();
+    waiter.join();
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+
+/**
+ * @brief Registers and cancels waits for a set of events one by one with SubmitWait.
+ */
+void BM_WaitRegisterEach(benchmark::State& state)
+{
+    std::vector<HANDLE> events(static_cast<size_t>(state.range(0)));
+    std::generate(events.begin(), events.end(), [] { return CreateEvent(nullptr, TRUE, FALSE, nullptr); });
+
+    ntp::SystemThreadPool pool;
+
+    for (auto _ : state)
+    {
+        for (const auto event : events)
+        {
+            pool.SubmitWait(event, [](TP_WAIT_RESULT) {});
+        }
+
+        state.PauseTiming();
+        pool.CancelWaits();
+        state.ResumeTiming();
+    }
+
+    std::for_each(events.begin(), events.end(), CloseHandle);
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+
+/**
+ * @brief Registers and cancels waits for a set of events as a single group with SubmitWaits.
+ */
+void BM_WaitRegisterGroup(benchmark::State& state)
+{
+    std::vector<HANDLE> events(static_cast<size_t>(state.range(0)));
+    std::generate(events.begin(), events.end(), [] { return CreateEvent(nullptr, TRUE, FALSE, nullptr); });
+
+    ntp::SystemThreadPool pool;
+
+    for (auto _ : state)
+    {
+        const auto group = pool.SubmitWaits(events, [](HANDLE, TP_WAIT_RESULT) {});
+
+        state.PauseTiming();
+        pool.CancelWaitGroup(group);
+        state.ResumeTiming();
+    }
+
+    std::for_each(events.begin(), events.end(), CloseHandle);
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+}  // namespace
+
+
+BENCHMARK(BM_WaitOneShot)->UseRealTime();
+BENCHMARK(BM_WaitPersistent)->UseRealTime();
+BENCHMARK(BM_ConditionVariableSignal)->UseRealTime();
+BENCHMARK(BM_WaitRegisterEach)->Arg(1000)->Arg(10000)->UseRealTime();
+BENCHMARK(BM_WaitRegisterGroup)->Arg(1000)->Arg(10000)->UseRealTime();
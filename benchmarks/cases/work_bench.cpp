@@ -0,0 +1,224 @@
+#include "bench_config.hpp"
+#include "allocations.hpp"
+#include "naive_pool.hpp"
+
+namespace {
+
+/**
+ * @brief Submits callbacks with state of specific size and reports allocations per submit.
+ */
+template<size_t StateSize>
+void BM_SubmitWork(benchmark::State& state)
+{
+    std::array<char, StateSize> payload {};
+    std::atomic_int counter = 0;
+
+    ntp::SystemThreadPool pool;
+
+    const auto allocations_before = ntp::bench::ThreadAllocations();
+    const auto slab_before        = ntp::allocator::SlabAllocator::Statistics();
+
+    for (auto _ : state)
+    {
+        pool.SubmitWork([payload, &counter]() {
+            counter += payload.front() + 1;
+        });
+    }
+
+    const auto allocations = ntp::bench::ThreadAllocations() - allocations_before;
+    const auto slab        = ntp::allocator::SlabAllocator::Statistics();
+
+    pool.WaitWorks();
+
+    const auto submits = static_cast<double>(state.iterations());
+
+    state.counters["heap_allocs_per_submit"] = static_cast<double>(allocations) / submits;
+    state.counters["slab_allocs_per_submit"] = static_cast<double>((slab.allocations - slab_before.allocations) +
+        (slab.large_allocations - slab_before.large_allocations)) / submits;
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+}  // namespace
+
+
+BENCHMARK_TEMPLATE(BM_SubmitWork, 8);
+BENCHMARK_TEMPLATE(BM_SubmitWork, 32);
+BENCHMARK_TEMPLATE(BM_SubmitWork, 256);
+
+
+namespace {
+
+/**
+ * @brief Submits a range of callbacks one by one (items per second is the measure).
+ */
+void BM_SubmitWorkLoop(benchmark::State& state)
+{
+    std::vector<int> values(static_cast<size_t>(state.range(0)), 1);
+    std::atomic_int counter = 0;
+
+    ntp::SystemThreadPool pool;
+
+    for (auto _ : state)
+    {
+        for (const auto value : values)
+        {
+            pool.SubmitWork([&counter](int value) {
+                counter.fetch_add(value, std::memory_order_relaxed);
+            }, value);
+        }
+
+        pool.WaitWorks();
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+/**
+ * @brief Submits the same range of callbacks by SubmitWorkBatch.
+ */
+void BM_SubmitWorkBatch(benchmark::State& state)
+{
+    std::vector<int> values(static_cast<size_t>(state.range(0)), 1);
+    std::atomic_int counter = 0;
+
+    ntp::SystemThreadPool pool;
+
+    for (auto _ : state)
+    {
+        pool.SubmitWorkBatch(values, [&counter](int value) {
+            counter.fetch_add(value, std::memory_order_relaxed);
+        });
+
+        pool.WaitWorks();
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+}  // namespace
+
+
+BENCHMARK(BM_SubmitWorkLoop)->Arg(64)->Arg(1024)->Arg(16384)->UseRealTime();
+BENCHMARK(BM_SubmitWorkBatch)->Arg(64)->Arg(1024)->Arg(16384)->UseRealTime();
+
+
+namespace {
+
+/**
+ * @brief Round trip of a single empty callback: submit and wait for its completion.
+ */
+void BM_WaitWorksLatency(benchmark::State& state)
+{
+    ntp::SystemThreadPool pool;
+
+    for (auto _ : state)
+    {
+        pool.SubmitWork([]() {});
+        pool.WaitWorks();
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+}  // namespace
+
+
+BENCHMARK(BM_WaitWorksLatency)->UseRealTime();
+
+
+namespace {
+
+/**
+ * @brief Number of callbacks submitted by a producer per iteration.
+ */
+constexpr int64_t kProducerBatch = 64;
+
+
+/**
+ * @brief Every benchmark thread is a producer: it submits kProducerBatch callbacks into
+ *        the shared pool and waits until they complete (submit to complete throughput).
+ */
+template<typename Pool, typename Submit>
+void RunProducers(benchmark::State& state, Pool*& pool, Submit&& submit)
+{
+    if (state.thread_index() == 0)
+    {
+        pool = new Pool();
+    }
+
+    std::atomic<int64_t> completed = 0;
+    int64_t expected = 0;
+
+    for (auto _ : state)
+    {
+        for (int64_t i = 0; i < kProducerBatch; ++i)
+        {
+            submit(*pool, [&completed]() {
+                completed.fetch_add(1, std::memory_order_release);
+            });
+        }
+
+        expected += kProducerBatch;
+
+        while (completed.load(std::memory_order_acquire) != expected)
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    if (state.thread_index() == 0)
+    {
+        delete pool;
+        pool = nullptr;
+    }
+
+    state.SetItemsProcessed(state.iterations() * kProducerBatch);
+}
+
+/**
+ * @brief Submit to complete throughput of SubmitWork with several producers.
+ */
+void BM_SubmitWorkProducers(benchmark::State& state)
+{
+    static ntp::SystemThreadPool* pool = nullptr;
+
+    RunProducers(state, pool, [](ntp::SystemThreadPool& pool, auto&& callback) {
+        pool.SubmitWork(std::forward<decltype(callback)>(callback));
+    });
+}
+
+/**
+ * @brief Baseline: the same producers with std::thread and std::condition_variable pool.
+ */
+void BM_NaivePoolProducers(benchmark::State& state)
+{
+    static ntp::bench::NaivePool* pool = nullptr;
+
+    RunProducers(state, pool, [](ntp::bench::NaivePool& pool, auto&& callback) {
+        pool.Submit(std::forward<decltype(callback)>(callback));
+    });
+}
+
+/**
+ * @brief Baseline for BM_WaitWorksLatency: round trip through the naive pool.
+ */
+void BM_NaivePoolLatency(benchmark::State& state)
+{
+    ntp::bench::NaivePool pool;
+
+    for (auto _ : state)
+    {
+        pool.Submit([]() {});
+        pool.WaitAll();
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+}  // namespace
+
+
+BENCHMARK(BM_SubmitWorkProducers)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(BM_NaivePoolProducers)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(BM_NaivePoolLatency)->UseRealTime();
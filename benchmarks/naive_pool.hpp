@@ -0,0 +1,125 @@
+#pragma once
+
+#include <mutex>
+#include <deque>
+#include <thread>
+#include <vector>
+#include <cstddef>
+#include <algorithm>
+#include <functional>
+#include <condition_variable>
+
+
+namespace ntp::bench {
+
+/**
+ * @brief Baseline thread pool: fixed set of std::thread workers and a single
+ *        queue of std::function, protected by a mutex and a condition variable.
+ */
+class NaivePool final
+{
+    NaivePool(const NaivePool&)            = delete;
+    NaivePool& operator=(const NaivePool&) = delete;
+
+public:
+    explicit NaivePool(std::size_t threads = (std::max)(std::thread::hardware_concurrency(), 1u))
+    {
+        workers_.reserve(threads);
+
+        for (std::size_t i = 0; i < threads; ++i)
+        {
+            workers_.emplace_back([this]() { Run(); });
+        }
+    }
+
+    ~NaivePool()
+    {
+        {
+            std::lock_guard lock { lock_ };
+            stopped_ = true;
+        }
+
+        work_condition_.notify_all();
+
+        for (auto& worker : workers_)
+        {
+            worker.join();
+        }
+    }
+
+    /**
+     * @brief Queues a callback.
+     */
+    void Submit(std::function<void()> callback)
+    {
+        {
+            std::lock_guard lock { lock_ };
+
+            queue_.push_back(std::move(callback));
+            ++outstanding_;
+        }
+
+        work_condition_.notify_one();
+    }
+
+    /**
+     * @brief Waits until all queued callbacks complete.
+     */
+    void WaitAll()
+    {
+        std::unique_lock lock { lock_ };
+        done_condition_.wait(lock, [this]() { return !outstanding_; });
+    }
+
+private:
+    void Run()
+    {
+        std::unique_lock lock { lock_ };
+
+        for (;;)
+        {
+            work_condition_.wait(lock, [this]() { return stopped_ || !queue_.empty(); });
+
+            if (queue_.empty())
+            {
+                return;
+            }
+
+            auto callback = std::move(queue_.front());
+            queue_.pop_front();
+
+            lock.unlock();
+            callback();
+            lock.lock();
+
+            if (!--outstanding_)
+            {
+                done_condition_.notify_all();
+            }
+        }
+    }
+
+private:
+    // Lock of the whole state
+    std::mutex lock_;
+
+    // Workers wait for callbacks here
+    std::condition_variable work_condition_;
+
+    // WaitAll waits for completion here
+    std::condition_variable done_condition_;
+
+    // Queued callbacks
+    std::deque<std::function<void()>> queue_;
+
+    // Number of queued and running callbacks
+    std::size_t outstanding_ = 0;
+
+    // Are workers stopping
+    bool stopped_ = false;
+
+    // Worker threads
+    std::vector<std::thread> workers_;
+};
+
+}  // namespace ntp::bench
@@ -9,101 +9,112 @@
  * of the following allocators:
  * - HeapAllocator
  * - AlignedAllocator 
+ * - SlabAllocator
+ *
+ * It also contains details::SlabCache -- thread-local caches of free
+ * blocks over global depots, that SlabAllocator and io::IoBufferPool
+ * are built on.
  */
 
 #pragma once
 
+#include <new>
+#include <array>
+#include <mutex>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
 #include "details/exception.hpp"
 #include "details/windows.hpp"
 
 
 namespace ntp::allocator {
 
-/**
- * @brief Allocator that uses HeapAlloc/HeapFree
- * 
- * @tparam Ty Type, which type an allocated memory pointer has
- */
+//
+// Void specializations are defined before generic versions, because
+// generic allocators use them
+//
+
 template<typename Ty>
-class HeapAllocator final
-{
-    // Actually I use allocator for void-pointers
-    using basic_allocator_t = HeapAllocator<void>;
+class HeapAllocator;
 
-public:
-    /**
-     * @brief Allocates specific number of elements
-     * 
-     * @param count Number of elements to allocate (default = 1)
-     * @returns Pointer to allocated memory
-     * @throws exception::Win32Exception if count is zero or in case
-     *                                   of allocation failure
-     */
-    static Ty* Allocate(size_t count = 1)
-    {
-        return AllocateBytes(count * sizeof(Ty));
-    }
+template<typename Ty>
+class AlignedAllocator;
 
+
+/**
+ * @brief Allocator that uses HeapAlloc/HeapFree for void-pointers
+ */
+template<>
+struct HeapAllocator<void> final
+{
     /**
      * @brief Allocates specific number of bytes
-     * 
-     * @param bytes Number of bytes to allocate (default = sizeof(Ty))
+     *
+     * @param bytes Number of bytes to allocate
      * @returns Pointer to allocated memory
-     * @throws exception::Win32Exception if bytes is less than sizeof(Ty) or
-     *                                   in case of allocation failure
-     * 
+     * @throws exception::Win32Exception in case of allocation failure
+     *
      */
-    static Ty* AllocateBytes(size_t bytes = sizeof(Ty))
+    static void* AllocateBytes(size_t bytes)
     {
-        if (bytes < sizeof(Ty))
+        const auto allocated = HeapAlloc(GetProcessHeap(),
+            HEAP_ZERO_MEMORY, static_cast<SIZE_T>(bytes));
+
+        if (!allocated)
         {
-            throw exception::Win32Exception(ERROR_INVALID_PARAMETER);
+            throw exception::Win32Exception();
         }
 
-        return static_cast<Ty*>(basic_allocator_t::AllocateBytes(bytes));
+        return allocated;
     }
 
     /**
      * @brief Frees a memory, allocated with HeapAllocator
-     * 
+     *
      * @param ptr Pointer to memory (may be NULL-pointer)
      */
-    static void Free(Ty* ptr) noexcept
+    static void Free(void* ptr) noexcept
     {
-        return basic_allocator_t::Free(static_cast<void*>(ptr));
+        if (ptr)
+        {
+            HeapFree(GetProcessHeap(), 0, ptr);
+        }
     }
 };
 
 
 /**
- * @brief Allocator that uses HeapAlloc/HeapFree for void-pointers
+ * @brief Allocator that uses _aligned_malloc/_aligned_free for void pointers
  */
 template<>
-struct HeapAllocator<void> final
+struct AlignedAllocator<void> final
 {
     /**
      * @brief Allocates specific number of bytes
      *
+     * @tparam alignment Alignment value (default = NTP_ALLOCATION_ALIGNMENT)
      * @param bytes Number of bytes to allocate
      * @returns Pointer to allocated memory
      * @throws exception::Win32Exception in case of allocation failure
      *
      */
+    template<size_t alignment = NTP_ALLOCATION_ALIGNMENT>
     static void* AllocateBytes(size_t bytes)
     {
-        const auto allocated = HeapAlloc(GetProcessHeap(),
-            HEAP_ZERO_MEMORY, static_cast<SIZE_T>(bytes));
-
+        const auto allocated = _aligned_malloc(bytes, alignment);
         if (!allocated)
         {
-            throw exception::Win32Exception();
+            throw exception::Win32Exception(ERROR_NOT_ENOUGH_MEMORY);
         }
 
         return allocated;
     }
 
     /**
-     * @brief Frees a memory, allocated with HeapAllocator
+     * @brief Frees a memory, allocated with AlignedAllocator<void>
      *
      * @param ptr Pointer to memory (may be NULL-pointer)
      */
@@ -111,8 +122,64 @@ struct HeapAllocator<void> final
     {
         if (ptr)
         {
-            HeapFree(GetProcessHeap(), 0, ptr);
+            _aligned_free(ptr);
+        }
+    }
+};
+
+
+/**
+ * @brief Allocator that uses HeapAlloc/HeapFree
+ * 
+ * @tparam Ty Type, which type an allocated memory pointer has
+ */
+template<typename Ty>
+class HeapAllocator final
+{
+    // Actually I use allocator for void-pointers
+    using basic_allocator_t = HeapAllocator<void>;
+
+public:
+    /**
+     * @brief Allocates specific number of elements
+     * 
+     * @param count Number of elements to allocate (default = 1)
+     * @returns Pointer to allocated memory
+     * @throws exception::Win32Exception if count is zero or in case
+     *                                   of allocation failure
+     */
+    static Ty* Allocate(size_t count = 1)
+    {
+        return AllocateBytes(count * sizeof(Ty));
+    }
+
+    /**
+     * @brief Allocates specific number of bytes
+     * 
+     * @param bytes Number of bytes to allocate (default = sizeof(Ty))
+     * @returns Pointer to allocated memory
+     * @throws exception::Win32Exception if bytes is less than sizeof(Ty) or
+     *                                   in case of allocation failure
+     * 
+     */
+    static Ty* AllocateBytes(size_t bytes = sizeof(Ty))
+    {
+        if (bytes < sizeof(Ty))
+        {
+            throw exception::Win32Exception(ERROR_INVALID_PARAMETER);
         }
+
+        return static_cast<Ty*>(basic_allocator_t::AllocateBytes(bytes));
+    }
+
+    /**
+     * @brief Frees a memory, allocated with HeapAllocator
+     * 
+     * @param ptr Pointer to memory (may be NULL-pointer)
+     */
+    static void Free(Ty* ptr) noexcept
+    {
+        return basic_allocator_t::Free(static_cast<void*>(ptr));
     }
 };
 
@@ -178,44 +245,431 @@ public:
 
 
 /**
- * @brief Allocator that uses _aligned_malloc/_aligned_free for void pointers
+ * @brief Counters of SlabAllocator
  */
-template<>
-struct AlignedAllocator<void> final
+struct SlabStatistics final
+{
+    uint64_t allocations;       /**< Number of allocations, that fit into size classes */
+    uint64_t cache_hits;        /**< Number of allocations, served by thread-local cache */
+    uint64_t depot_hits;        /**< Number of thread-local cache refills from global depot */
+    uint64_t slab_refills;      /**< Number of thread-local cache refills from a slab */
+    uint64_t large_allocations; /**< Number of allocations, passed to operator new */
+    uint64_t frees;             /**< Number of freed blocks, that fit into size classes */
+
+    /**
+     * @brief Part of allocations, served by thread-local cache without any synchronization
+     *
+     * @returns Value from 0 to 1 (0 if there were no allocations)
+     */
+    double HitRate() const noexcept
+    {
+        return allocations ? static_cast<double>(cache_hits) / static_cast<double>(allocations) : 0.0;
+    }
+};
+
+
+/**
+ * @brief Size-class slab allocator with thread-local caches.
+ *
+ * Blocks up to kMaxBlockSize bytes are rounded up to the power of 2 (at least
+ * kMinBlockSize) and taken from a thread-local free list. Empty thread-local
+ * lists are refilled by batches from a global depot or from a new slab, and
+ * overfilled lists (blocks are often freed by another thread) return batches
+ * to the depot. Larger blocks are passed to aligned operator new.
+ *
+ * Allocator does not store any headers, therefore size of a block
+ * MUST be passed to Free. Slabs are never returned to the system.
+ */
+class SlabAllocator final
 {
+public:
+    /**
+     * @brief Size of the smallest size class.
+     */
+    static constexpr size_t kMinBlockSize = 32;
+
+    /**
+     * @brief Size of the largest size class.
+     */
+    static constexpr size_t kMaxBlockSize = 1024;
+
+    /**
+     * @brief Alignment of every allocated block.
+     */
+    static constexpr size_t kBlockAlignment = NTP_ALLOCATION_ALIGNMENT;
+
     /**
      * @brief Allocates specific number of bytes
      *
-     * @tparam alignment Alignment value (default = NTP_ALLOCATION_ALIGNMENT)
      * @param bytes Number of bytes to allocate
-     * @returns Pointer to allocated memory
+     * @returns Pointer to allocated memory (aligned at least to kBlockAlignment)
      * @throws exception::Win32Exception in case of allocation failure
+     */
+    static void* AllocateBytes(size_t bytes);
+
+    /**
+     * @brief Frees a memory, allocated with SlabAllocator
      *
+     * @param ptr Pointer to memory (may be NULL-pointer)
+     * @param bytes Size of block, passed to AllocateBytes
      */
-    template<size_t alignment = NTP_ALLOCATION_ALIGNMENT>
-    static void* AllocateBytes(size_t bytes)
+    static void Free(void* ptr, size_t bytes) noexcept;
+
+    /**
+     * @brief Get allocator counters. Other threads publish their counters 
+     * on slow paths only, so the result is approximate.
+     *
+     * @returns Global counters plus counters of the calling thread
+     */
+    static SlabStatistics Statistics() noexcept;
+};
+
+
+namespace details {
+
+/**
+ * @brief Intrusive list of free blocks of the same size class.
+ *
+ * @tparam Traits Traits of blocks (refer to SlabCache)
+ */
+template<typename Traits>
+struct FreeList
+{
+    using block_t = typename Traits::block_t;
+
+    block_t* head       = nullptr;
+    std::uint32_t count = 0;
+
+    void Push(block_t* block) noexcept
     {
-        const auto allocated = _aligned_malloc(bytes, alignment);
-        if (!allocated)
+        Traits::Next(block) = head;
+        head                = block;
+        ++count;
+    }
+
+    block_t* Pop() noexcept
+    {
+        const auto block = head;
+        head             = Traits::Next(block);
+        --count;
+
+        return block;
+    }
+
+    /**
+     * @brief Detaches at most `blocks` first blocks
+     */
+    FreeList Split(std::uint32_t blocks) noexcept
+    {
+        FreeList detached { head, 0 };
+
+        block_t* last = nullptr;
+        for (; detached.count < blocks && head; ++detached.count)
         {
-            throw exception::Win32Exception(ERROR_NOT_ENOUGH_MEMORY);
+            last = head;
+            head = Traits::Next(head);
         }
 
-        return allocated;
+        if (last)
+        {
+            Traits::Next(last) = nullptr;
+        }
+
+        count -= detached.count;
+        return detached;
     }
+};
+
+
+/**
+ * @brief Global storage of free blocks of the same size class.
+ *
+ * @tparam Traits Traits of blocks (refer to SlabCache)
+ */
+template<typename Traits>
+class Depot final
+{
+public:
+    explicit Depot(std::uint32_t size_class) noexcept
+        : slab_(size_class)
+    { }
 
     /**
-     * @brief Frees a memory, allocated with AlignedAllocator<void>
+     * @brief Get a batch of blocks from depot or from a new slab
      *
-     * @param ptr Pointer to memory (may be NULL-pointer)
+     * @param from_slab Is set to true if blocks were taken from a slab
+     * @returns Batch of blocks (empty list in case of allocation failure)
      */
-    static void Free(void* ptr) noexcept
+    FreeList<Traits> Take(bool& from_slab) noexcept
     {
-        if (ptr)
+        std::lock_guard lock { lock_ };
+
+        if (!batches_.empty())
         {
-            _aligned_free(ptr);
+            const auto batch = batches_.back();
+            batches_.pop_back();
+
+            from_slab = false;
+            return batch;
+        }
+
+        from_slab = true;
+
+        FreeList<Traits> batch;
+        slab_.Carve(batch);
+
+        return batch;
+    }
+
+    /**
+     * @brief Put a batch of blocks into depot
+     */
+    void Put(FreeList<Traits> batch) noexcept
+    {
+        std::lock_guard lock { lock_ };
+
+        try
+        {
+            batches_.push_back(batch);
+        }
+        catch (const std::bad_alloc&)
+        {
+            //
+            // Cannot store a batch, blocks are leaked, but
+            // slabs are never freed anyway
+            //
+        }
+    }
+
+private:
+    // Lock for batches and slab
+    std::mutex lock_;
+
+    // Batches of free blocks
+    std::vector<FreeList<Traits>> batches_;
+
+    // Source of new blocks
+    typename Traits::Slab slab_;
+};
+
+
+/**
+ * @brief Thread-local caches of free blocks over global depots of size classes.
+ *
+ * Blocks are taken from a thread-local free list of their size class. Empty
+ * lists are refilled by batches from a global depot or from a new slab, and
+ * overfilled lists (blocks are often freed by another thread) return batches
+ * to the depot. Counters are gathered per thread and added to the global
+ * sink on slow paths only. Global state is never destroyed, because
+ * thread-local caches of other threads may return blocks while the process
+ * is terminating.
+ *
+ * Traits must provide:
+ * - `block_t` -- type of blocks;
+ * - `static block_t*& Next(block_t*)` -- link of a free block;
+ * - `kClasses` -- number of size classes;
+ * - `kBatchSize` -- number of blocks moved between thread-local cache and depot at once;
+ * - `Slab` -- source of new blocks, constructed from index of size class, with
+ *   `void Carve(FreeList<Traits>&) noexcept`, that pushes up to kBatchSize blocks;
+ * - `sink_t` -- global counters with `counters_t` (plain counters of a thread),
+ *   `Add(const counters_t&)`, `Load()` and static `Merge(counters_t&, const counters_t&)`
+ *   and hooks `Allocated(counters_t&)`, `CacheHit(counters_t&)`,
+ *   `Refilled(counters_t&, bool from_slab)` and `Freed(counters_t&)`.
+ *
+ * @tparam Traits Traits of blocks
+ */
+template<typename Traits>
+class SlabCache final
+{
+public:
+    using block_t    = typename Traits::block_t;
+    using sink_t     = typename Traits::sink_t;
+    using counters_t = typename sink_t::counters_t;
+
+    /**
+     * @brief Takes a free block of a size class
+     *
+     * @param size_class Index of size class
+     * @returns Block or NULL in case of allocation failure
+     */
+    static block_t* Allocate(std::uint32_t size_class) noexcept
+    {
+        if (!cache_destroyed)
+        {
+            return cache.Allocate(size_class);
+        }
+
+        //
+        // Thread is exiting, use depot directly
+        //
+
+        bool from_slab = false;
+        auto& depot    = GetGlobal().depots[size_class];
+        auto batch     = depot.Take(from_slab);
+
+        if (!batch.count)
+        {
+            return nullptr;
         }
+
+        const auto block = batch.Pop();
+        depot.Put(batch);
+
+        return block;
     }
+
+    /**
+     * @brief Returns a block of a size class
+     *
+     * @param block Block taken with Allocate
+     * @param size_class Index of size class
+     */
+    static void Free(block_t* block, std::uint32_t size_class) noexcept
+    {
+        if (!cache_destroyed)
+        {
+            cache.Free(block, size_class);
+            return;
+        }
+
+        FreeList<Traits> batch;
+        batch.Push(block);
+
+        GetGlobal().depots[size_class].Put(batch);
+    }
+
+    /**
+     * @brief Get global counters plus counters of the calling thread
+     */
+    static counters_t Statistics() noexcept
+    {
+        auto statistics = GetGlobal().sink.Load();
+
+        if (!cache_destroyed)
+        {
+            sink_t::Merge(statistics, cache.LocalStatistics());
+        }
+
+        return statistics;
+    }
+
+    /**
+     * @brief Get global counters (e.g. to count events, that bypass caches).
+     */
+    static sink_t& Sink() noexcept { return GetGlobal().sink; }
+
+private:
+    /**
+     * @brief Thread-local cache returns a batch to depot if it has more blocks
+     */
+    static constexpr std::uint32_t kCacheLimit = 2 * Traits::kBatchSize;
+
+    using depots_t = std::array<Depot<Traits>, Traits::kClasses>;
+
+    /**
+     * @brief Global state of caches.
+     */
+    struct Global
+    {
+        Global() noexcept
+            : depots(MakeDepots(std::make_index_sequence<Traits::kClasses>()))
+        { }
+
+        depots_t depots;
+
+        sink_t sink;
+    };
+
+    template<std::size_t... Classes>
+    static depots_t MakeDepots(std::index_sequence<Classes...>) noexcept
+    {
+        return { Depot<Traits>(static_cast<std::uint32_t>(Classes))... };
+    }
+
+    static Global& GetGlobal() noexcept
+    {
+        static const auto global = new Global();
+        return *global;
+    }
+
+    /**
+     * @brief Thread-local cache of free blocks.
+     */
+    class ThreadCache final
+    {
+    public:
+        ~ThreadCache()
+        {
+            cache_destroyed = true;
+
+            auto& global = GetGlobal();
+
+            for (std::uint32_t size_class = 0; size_class < Traits::kClasses; ++size_class)
+            {
+                if (lists_[size_class].count)
+                {
+                    global.depots[size_class].Put(lists_[size_class]);
+                }
+            }
+
+            Publish();
+        }
+
+        block_t* Allocate(std::uint32_t size_class) noexcept
+        {
+            auto& list = lists_[size_class];
+
+            sink_t::Allocated(statistics_);
+
+            if (list.count)
+            {
+                sink_t::CacheHit(statistics_);
+                return list.Pop();
+            }
+
+            bool from_slab = false;
+            list           = GetGlobal().depots[size_class].Take(from_slab);
+
+            sink_t::Refilled(statistics_, from_slab);
+            Publish();
+
+            return list.count ? list.Pop() : nullptr;
+        }
+
+        void Free(block_t* block, std::uint32_t size_class) noexcept
+        {
+            auto& list = lists_[size_class];
+
+            sink_t::Freed(statistics_);
+            list.Push(block);
+
+            if (list.count > kCacheLimit)
+            {
+                GetGlobal().depots[size_class].Put(list.Split(Traits::kBatchSize));
+                Publish();
+            }
+        }
+
+        void Publish() noexcept
+        {
+            GetGlobal().sink.Add(statistics_);
+            statistics_ = {};
+        }
+
+        const counters_t& LocalStatistics() const noexcept { return statistics_; }
+
+    private:
+        std::array<FreeList<Traits>, Traits::kClasses> lists_;
+
+        // Counters, not yet added to global ones
+        counters_t statistics_ {};
+    };
+
+    // Cache object is never accessed after its destruction
+    static inline thread_local bool cache_destroyed = false;
+
+    static inline thread_local ThreadCache cache;
 };
 
+}  // namespace details
 }  // namespace ntp::allocator
@@ -0,0 +1,141 @@
+/**
+ * @file coalescing.hpp
+ * @brief Deadline queue, that coalesces expirations of timers with tolerance
+ */
+
+#pragma once
+
+#include <map>
+#include <set>
+#include <cstddef>
+#include <utility>
+
+
+namespace ntp::details {
+
+/**
+ * @brief Queue of deadlines with tolerance (slack).
+ *
+ * Each item has a soft deadline (its due time) and a hard one (due time
+ * plus tolerance). Owner wakes up at the nearest hard deadline (see
+ * ntp::details::CoalescingQueue::Wakeup) and expires all items, whose soft
+ * deadlines are already gone. Hence timers, whose tolerance windows overlap,
+ * expire at once during a single wakeup. Items without tolerance behave as
+ * in an ordinary deadline queue.
+ *
+ * Class is not thread-safe, owner must synchronize access to it.
+ *
+ * @tparam TimePoint Type of time points (std::chrono::time_point)
+ * @tparam Value Type of values, that are associated with deadlines
+ */
+template<typename TimePoint, typename Value>
+class CoalescingQueue final
+{
+    CoalescingQueue(const CoalescingQueue&)            = delete;
+    CoalescingQueue& operator=(const CoalescingQueue&) = delete;
+
+    using hard_t = std::multiset<TimePoint>;
+    using soft_t = std::multimap<TimePoint, std::pair<Value, typename hard_t::iterator>>;
+
+public:
+    /**
+     * @brief Type of tolerance.
+     */
+    using duration_t = typename TimePoint::duration;
+
+    /**
+     * @brief Handle of queued item. It remains valid until item is erased or expired.
+     */
+    using handle_t = typename soft_t::iterator;
+
+public:
+    CoalescingQueue() = default;
+
+    /**
+     * @brief Checks if queue is empty.
+     */
+    bool Empty() const noexcept { return soft_.empty(); }
+
+    /**
+     * @brief Number of queued items.
+     */
+    std::size_t Size() const noexcept { return soft_.size(); }
+
+    /**
+     * @brief Get time, when owner must wake up: the nearest hard deadline. Queue must not be empty.
+     */
+    TimePoint Wakeup() const noexcept { return *hard_.begin(); }
+
+    /**
+     * @brief Puts an item into queue.
+     *
+     * @param due Soft deadline
+     * @param tolerance Tolerable delay of expiration (must not be negative)
+     * @param value Value associated with deadline
+     * @returns handle of queued item
+     */
+    handle_t Insert(TimePoint due, duration_t tolerance, Value value)
+    {
+        const auto hard = hard_.insert(due + tolerance);
+
+        try
+        {
+            return soft_.emplace(due, std::make_pair(std::move(value), hard));
+        }
+        catch (...)
+        {
+            hard_.erase(hard);
+            throw;
+        }
+    }
+
+    /**
+     * @brief Removes an item from queue.
+     *
+     * @param handle Handle of queued item
+     */
+    void Erase(handle_t handle) noexcept
+    {
+        hard_.erase(handle->second.second);
+        soft_.erase(handle);
+    }
+
+    /**
+     * @brief Removes all items with gone soft deadlines (in order of deadlines).
+     *
+     * @param now Current time
+     * @param expire Callable, that accepts soft deadline and value of expired item.
+     *               It may insert new items into queue.
+     * @returns number of expired items
+     */
+    template<typename Callback>
+    std::size_t Expire(TimePoint now, Callback&& expire)
+    {
+        std::size_t expired = 0;
+
+        while (!soft_.empty() && soft_.begin()->first <= now)
+        {
+            const auto nearest = soft_.begin();
+
+            const auto due = nearest->first;
+            auto value     = std::move(nearest->second.first);
+
+            hard_.erase(nearest->second.second);
+            soft_.erase(nearest);
+
+            expire(due, std::move(value));
+            ++expired;
+        }
+
+        return expired;
+    }
+
+private:
+    // Hard deadlines (only the nearest one matters)
+    hard_t hard_;
+
+    // Items ordered by soft deadlines
+    soft_t soft_;
+};
+
+}  // namespace ntp::details
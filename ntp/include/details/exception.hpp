@@ -14,6 +14,17 @@
 #include "details/windows.hpp"
 
 
+namespace ntp::details {
+
+//
+// Declared in details/utils.hpp, that cannot be included here
+//
+
+std::string FormatMessage(DWORD flags, LPCSTR source, DWORD message_id, ...) noexcept;
+
+}  // namespace ntp::details
+
+
 namespace ntp::exception {
 
 /**
@@ -0,0 +1,452 @@
+/**
+ * @file metrics.hpp
+ * @brief Low-overhead counters and latency histograms of threadpool object managers
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include "ntp_config.hpp"
+#include "details/queue.hpp"
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#   include <intrin.h>
+#   define NTP_METRICS_HAS_TSC 1
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#   include <x86intrin.h>
+#   define NTP_METRICS_HAS_TSC 1
+#endif
+
+
+namespace ntp::metrics {
+
+/**
+ * @brief Log-linear histogram of durations.
+ *
+ * Every power of 2 is split into 4 linear buckets, hence relative
+ * error of a reported value does not exceed 25%.
+ */
+class Histogram final
+{
+public:
+    /**
+     * @brief Number of linear buckets per power of 2 (as a power of 2).
+     */
+    static constexpr std::size_t kSubBucketBits = 2;
+
+    /**
+     * @brief Number of buckets. The last one holds all larger values.
+     */
+    static constexpr std::size_t kBuckets = 176;
+
+    /**
+     * @brief Storage of bucket counters.
+     */
+    using buckets_t = std::array<std::uint64_t, kBuckets>;
+
+public:
+    Histogram() noexcept = default;
+
+    /**
+     * @brief Constructs histogram from raw bucket counters.
+     *
+     * @param buckets Counters of buckets (indexed by ntp::metrics::Histogram::BucketOf)
+     * @param nanoseconds_per_unit Duration of a unit of recorded values
+     */
+    explicit Histogram(const buckets_t& buckets, double nanoseconds_per_unit) noexcept;
+
+    /**
+     * @brief Get index of a bucket, that holds a value.
+     */
+    static constexpr std::size_t BucketOf(std::uint64_t value) noexcept
+    {
+        constexpr std::uint64_t kSubBuckets = 1ull << kSubBucketBits;
+
+        if (value < kSubBuckets)
+        {
+            return static_cast<std::size_t>(value);
+        }
+
+        const auto msb      = MostSignificantBit(value);
+        const auto exponent = msb - kSubBucketBits + 1;
+        const auto index    = exponent * kSubBuckets + ((value >> (exponent - 1)) & (kSubBuckets - 1));
+
+        return index < kBuckets ? static_cast<std::size_t>(index) : kBuckets - 1;
+    }
+
+    /**
+     * @brief Get the smallest value, that falls into a bucket.
+     */
+    static constexpr std::uint64_t LowerBoundOf(std::size_t bucket) noexcept
+    {
+        constexpr std::uint64_t kSubBuckets = 1ull << kSubBucketBits;
+
+        if (bucket < kSubBuckets)
+        {
+            return bucket;
+        }
+
+        const auto exponent = bucket >> kSubBucketBits;
+        const auto mantissa = bucket & (kSubBuckets - 1);
+
+        return (kSubBuckets + mantissa) << (exponent - 1);
+    }
+
+    /**
+     * @brief Get total number of recorded values.
+     */
+    std::uint64_t Count() const noexcept { return count_; }
+
+    /**
+     * @brief Get number of values in a bucket.
+     */
+    std::uint64_t Count(std::size_t bucket) const noexcept { return buckets_[bucket]; }
+
+    /**
+     * @brief Get the smallest duration, that falls into a bucket.
+     */
+    std::chrono::nanoseconds LowerBound(std::size_t bucket) const noexcept;
+
+    /**
+     * @brief Get approximate percentile (upper bound of the bucket, that contains it).
+     *
+     * @param fraction Percentile as a fraction of values (e.g. 0.99)
+     * @returns zero duration if histogram is empty
+     */
+    std::chrono::nanoseconds Percentile(double fraction) const noexcept;
+
+    /**
+     * @brief Merges values of another histogram into this one.
+     */
+    Histogram& operator+=(const Histogram& other) noexcept;
+
+private:
+    static constexpr std::size_t MostSignificantBit(std::uint64_t value) noexcept
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        return 63 - static_cast<std::size_t>(__builtin_clzll(value));
+#else  // !__GNUC__ && !__clang__
+        std::size_t msb = 0;
+        for (auto rest = value; rest >>= 1;)
+        {
+            ++msb;
+        }
+
+        return msb;
+#endif  // __GNUC__ || __clang__
+    }
+
+private:
+    // Counters of buckets
+    buckets_t buckets_ {};
+
+    // Total number of values
+    std::uint64_t count_ = 0;
+
+    // Duration of a unit of recorded values
+    double nanoseconds_per_unit_ = 1.0;
+};
+
+
+/**
+ * @brief Metrics of a single threadpool object manager.
+ */
+struct ManagerMetrics
+{
+    std::uint64_t submitted = 0; /**< Number of submitted callbacks (every object of a wait group counts) */
+
+    std::uint64_t completed = 0; /**< Number of callback invocations, that returned or have thrown */
+
+    std::uint64_t cancelled = 0; /**< Number of callbacks or objects, that were cancelled before completion */
+
+    std::size_t queue_depth = 0; /**< Number of callbacks waiting in queue (work callbacks only) */
+
+    std::size_t live_objects = 0; /**< Number of live threadpool objects (outstanding callbacks for work) */
+
+    Histogram queue_latency; /**< Time from submission to start of callback (work callbacks only) */
+
+    Histogram run_time; /**< Time of callback execution */
+};
+
+
+/**
+ * @brief Metrics of all object managers of a threadpool.
+ */
+struct Snapshot
+{
+    ManagerMetrics work;  /**< Work callbacks */
+    ManagerMetrics wait;  /**< Wait callbacks (including wait groups) */
+    ManagerMetrics timer; /**< Timer callbacks (including soft timers) */
+    ManagerMetrics io;    /**< IO callbacks (including IO bindings) */
+};
+
+
+namespace details {
+
+/**
+ * @brief Reads a cheap monotonic timestamp (TSC on x86 and x64, steady clock elsewhere).
+ */
+inline std::uint64_t ReadTimestamp() noexcept
+{
+#if defined(NTP_METRICS_HAS_TSC)
+    return __rdtsc();
+#else  // !NTP_METRICS_HAS_TSC
+    return static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif  // NTP_METRICS_HAS_TSC
+}
+
+/**
+ * @brief Reads a timestamp for metrics (refer to ntp::metrics::details::ReadTimestamp).
+ *        Always returns 0, if NTP_DISABLE_METRICS is defined.
+ */
+inline std::uint64_t ReadTicks() noexcept
+{
+#if defined(NTP_DISABLE_METRICS)
+    return 0;
+#else  // !NTP_DISABLE_METRICS
+    return ReadTimestamp();
+#endif  // NTP_DISABLE_METRICS
+}
+
+/**
+ * @brief Get duration of a tick returned by ntp::metrics::details::ReadTimestamp.
+ *        TSC frequency is calibrated once, when the function is called for the first time.
+ */
+double NanosecondsPerTick() noexcept;
+
+
+/**
+ * @brief Get slot of the calling thread. Slots are unique among live threads,
+ *        slot is released, when its thread exits.
+ *
+ * @returns slot index or ntp::metrics::details::kSharedSlot if all slots are taken
+ */
+std::size_t ThreadSlot() noexcept;
+
+/**
+ * @brief Number of slots, that can be owned by threads exclusively.
+ */
+inline constexpr std::size_t kThreadSlots = 64;
+
+/**
+ * @brief Slot of threads, that did not get their own slot.
+ */
+inline constexpr std::size_t kSharedSlot = kThreadSlots;
+
+
+/**
+ * @brief Recorder of metrics of a manager.
+ *
+ * Every thread writes to its own shard of counters (shards are allocated
+ * on the first record of a thread), hence counters are updated with plain
+ * loads and stores instead of locked instructions. Threads, that did not get
+ * their own slot (or shard allocation failed), share an atomically updated
+ * shard. Shards are summed up by Collect. Recording is compiled out, if
+ * NTP_DISABLE_METRICS is defined.
+ */
+class MetricsRecorder final
+{
+    MetricsRecorder(const MetricsRecorder&)            = delete;
+    MetricsRecorder& operator=(const MetricsRecorder&) = delete;
+
+public:
+    /**
+     * @brief Are metrics recorded (refer to NTP_DISABLE_METRICS).
+     */
+#if defined(NTP_DISABLE_METRICS)
+    static constexpr bool kEnabled = false;
+#else  // !NTP_DISABLE_METRICS
+    static constexpr bool kEnabled = true;
+#endif  // NTP_DISABLE_METRICS
+
+public:
+    MetricsRecorder() noexcept;
+    ~MetricsRecorder();
+
+    /**
+     * @brief Records submission of callbacks.
+     */
+    void Submitted(std::uint64_t count = 1) noexcept
+    {
+        if constexpr (kEnabled)
+        {
+            auto& shard = Local();
+            Add(shard, shard.submitted, count);
+        }
+    }
+
+    /**
+     * @brief Records cancellation of callbacks.
+     */
+    void Cancelled(std::uint64_t count = 1) noexcept
+    {
+        if constexpr (kEnabled)
+        {
+            auto& shard = Local();
+            Add(shard, shard.cancelled, count);
+        }
+    }
+
+    /**
+     * @brief Records execution of a callback (it is counted as completed).
+     *
+     * @param started Timestamp of start
+     * @param finished Timestamp of completion
+     */
+    void Completed(std::uint64_t started, std::uint64_t finished) noexcept
+    {
+        if constexpr (kEnabled)
+        {
+            auto& shard = Local();
+            Add(shard, shard.run_time[Histogram::BucketOf(finished - started)], 1);
+        }
+    }
+
+    /**
+     * @brief Records execution of a queued callback: time from submission
+     *        to start and time of execution (it is counted as completed).
+     *
+     * @param enqueued Timestamp of submission
+     * @param started Timestamp of start
+     * @param finished Timestamp of completion
+     */
+    void Completed(std::uint64_t enqueued, std::uint64_t started, std::uint64_t finished) noexcept
+    {
+        if constexpr (kEnabled)
+        {
+            auto& shard = Local();
+            Add(shard, shard.queue_latency[Histogram::BucketOf(started - enqueued)], 1);
+            Add(shard, shard.run_time[Histogram::BucketOf(finished - started)], 1);
+        }
+    }
+
+    /**
+     * @brief Sums up all shards. Result is approximate, if metrics are recorded concurrently.
+     *
+     * @returns metrics without queue depth and live objects (they are filled by managers)
+     */
+    ManagerMetrics Collect() const noexcept;
+
+private:
+    struct alignas(ntp::details::kCacheLine) Shard
+    {
+        bool exclusive = false; /**< Is shard written by a single thread */
+
+        std::atomic<std::uint64_t> submitted { 0 }; /**< Number of submitted callbacks */
+
+        std::atomic<std::uint64_t> cancelled { 0 }; /**< Number of cancelled callbacks */
+
+        std::array<std::atomic<std::uint64_t>, Histogram::kBuckets> queue_latency {}; /**< Buckets of queue latency */
+
+        std::array<std::atomic<std::uint64_t>, Histogram::kBuckets> run_time {}; /**< Buckets of run time */
+    };
+
+    static void Add(const Shard& shard, std::atomic<std::uint64_t>& counter, std::uint64_t value) noexcept
+    {
+        //
+        // Collect reads counters concurrently, so they are atomic
+        // anyway, but single writer needs no read-modify-write
+        //
+
+        if (shard.exclusive)
+        {
+            counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        }
+        else
+        {
+            counter.fetch_add(value, std::memory_order_relaxed);
+        }
+    }
+
+    Shard& Local() noexcept
+    {
+        const auto slot = ThreadSlot();
+
+        if (slot != kSharedSlot)
+        {
+            if (const auto shard = shards_[slot].load(std::memory_order_acquire); shard)
+            {
+                return *shard;
+            }
+        }
+
+        return AllocateShard(slot);
+    }
+
+    Shard& AllocateShard(std::size_t slot) noexcept;
+
+private:
+    // Shards of thread slots (allocated on demand)
+    std::array<std::atomic<Shard*>, kThreadSlots> shards_;
+
+    // Shard of threads without their own slot
+    Shard shared_;
+};
+
+
+/**
+ * @brief Measures execution of a callback and records it on destruction
+ *        (so callbacks, that have thrown, are recorded as well).
+ */
+class CallbackScope final
+{
+    CallbackScope(const CallbackScope&)            = delete;
+    CallbackScope& operator=(const CallbackScope&) = delete;
+
+public:
+    /**
+     * @brief Starts measurement.
+     *
+     * @param recorder Recorder of owning manager
+     */
+    explicit CallbackScope(MetricsRecorder& recorder) noexcept
+        : recorder_(recorder)
+        , enqueued_(0)
+        , started_(ReadTicks())
+        , queued_(false)
+    { }
+
+    /**
+     * @brief Starts measurement of a queued callback.
+     *
+     * @param recorder Recorder of owning manager
+     * @param enqueued Timestamp of submission
+     */
+    explicit CallbackScope(MetricsRecorder& recorder, std::uint64_t enqueued) noexcept
+        : recorder_(recorder)
+        , enqueued_(enqueued)
+        , started_(ReadTicks())
+        , queued_(true)
+    { }
+
+    ~CallbackScope()
+    {
+        if (queued_)
+        {
+            recorder_.Completed(enqueued_, started_, ReadTicks());
+        }
+        else
+        {
+            recorder_.Completed(started_, ReadTicks());
+        }
+    }
+
+private:
+    // Recorder of owning manager
+    MetricsRecorder& recorder_;
+
+    // Timestamps of submission and start
+    const std::uint64_t enqueued_;
+    const std::uint64_t started_;
+
+    // Is time from submission recorded
+    const bool queued_;
+};
+
+}  // namespace details
+}  // namespace ntp::metrics
@@ -0,0 +1,249 @@
+/**
+ * @file periodic.hpp
+ * @brief Scheduling math of drift-free periodic timers and jitter statistics
+ */
+
+#pragma once
+
+#include <array>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+
+#include "details/time.hpp"
+
+
+namespace ntp::time {
+
+/**
+ * @brief Information about a single expiration of a periodic timer.
+ */
+struct TimerTick
+{
+    std::uint64_t index = 0; /**< Number of the tick since timer was set (missed ticks are counted too) */
+
+    std::uint64_t missed = 0; /**< Number of ticks skipped right before this one (e.g. callback was too long) */
+
+    clock_t::time_point deadline {}; /**< Time, when this tick was scheduled to expire */
+
+    native_duration_t lateness {}; /**< How late the tick expired (i.e. its jitter) */
+};
+
+
+/**
+ * @brief Schedule of a periodic timer, that is anchored at an absolute time point.
+ *
+ * Tick N is scheduled at anchor + N * period exactly, hence errors of
+ * individual expirations never accumulate. If several ticks are gone
+ * at once, only the latest of them is reported, others are counted as missed.
+ *
+ * Class is not thread-safe, owner must synchronize access to it.
+ */
+class PeriodicSchedule final
+{
+public:
+    /**
+     * @brief Constructor.
+     *
+     * @param first Deadline of the first tick
+     * @param period Timer period (must be positive)
+     */
+    PeriodicSchedule(clock_t::time_point first, native_duration_t period) noexcept
+        : anchor_(first)
+        , period_(period)
+        , base_(0)
+        , next_(0)
+    { }
+
+    /**
+     * @brief Timer period.
+     */
+    native_duration_t Period() const noexcept { return period_; }
+
+    /**
+     * @brief Index of the next tick.
+     */
+    std::uint64_t NextIndex() const noexcept { return next_; }
+
+    /**
+     * @brief Deadline of the next tick.
+     */
+    clock_t::time_point Deadline() const noexcept { return DeadlineOf(next_); }
+
+    /**
+     * @brief Checks if the next tick is due.
+     *
+     * @param now Current time
+     */
+    bool Due(clock_t::time_point now) const noexcept { return now >= Deadline(); }
+
+    /**
+     * @brief Expires the latest gone tick and moves schedule to the following one.
+     *        The next tick must be due (see ntp::time::PeriodicSchedule::Due).
+     *
+     * @param now Current time
+     * @returns information about expired tick
+     */
+    TimerTick Expire(clock_t::time_point now) noexcept
+    {
+        const auto late    = std::chrono::duration_cast<native_duration_t>(now - Deadline());
+        const auto skipped = static_cast<std::uint64_t>(late / period_);
+
+        TimerTick tick;
+        tick.index    = next_ + skipped;
+        tick.missed   = skipped;
+        tick.deadline = DeadlineOf(tick.index);
+        tick.lateness = std::chrono::duration_cast<native_duration_t>(now - tick.deadline);
+
+        next_ = tick.index + 1;
+
+        return tick;
+    }
+
+    /**
+     * @brief Moves schedule, so that the next tick expires at a new deadline.
+     *        Tick numbering continues.
+     *
+     * @param next New deadline of the next tick
+     */
+    void Reset(clock_t::time_point next) noexcept
+    {
+        anchor_ = next;
+        base_   = next_;
+    }
+
+private:
+    clock_t::time_point DeadlineOf(std::uint64_t index) const noexcept
+    {
+        return anchor_ + std::chrono::duration_cast<clock_t::duration>(period_ * static_cast<long long>(index - base_));
+    }
+
+private:
+    // Deadline of tick with index base_
+    clock_t::time_point anchor_;
+
+    // Timer period
+    native_duration_t period_;
+
+    // Index of tick, that expires at anchor_
+    std::uint64_t base_;
+
+    // Index of the next tick
+    std::uint64_t next_;
+};
+
+
+/**
+ * @brief Histogram of timer expiration delays.
+ *
+ * Bucket 0 counts delays shorter than 100 ns, bucket i > 0 counts delays
+ * in [2^(i-1), 2^i) * 100 ns. Samples are recorded with relaxed atomics,
+ * so histogram may be read while timer is running.
+ */
+class JitterHistogram final
+{
+    JitterHistogram(const JitterHistogram&)            = delete;
+    JitterHistogram& operator=(const JitterHistogram&) = delete;
+
+public:
+    /**
+     * @brief Number of buckets.
+     */
+    static constexpr std::size_t kBuckets = 40;
+
+public:
+    JitterHistogram() noexcept = default;
+
+    /**
+     * @brief Records a sample.
+     *
+     * @param lateness Delay of expiration (negative values are treated as zero)
+     */
+    void Record(native_duration_t lateness) noexcept
+    {
+        const auto ticks = lateness.count() > 0 ? static_cast<std::uint64_t>(lateness.count()) : 0ull;
+
+        std::size_t bucket = 0;
+        while (bucket + 1 < kBuckets && (ticks >> bucket) != 0)
+        {
+            ++bucket;
+        }
+
+        buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+        count_.fetch_add(1, std::memory_order_relaxed);
+
+        auto max = max_.load(std::memory_order_relaxed);
+        while (max < lateness.count() && !max_.compare_exchange_weak(max, lateness.count(), std::memory_order_relaxed))
+        { }
+    }
+
+    /**
+     * @brief Total number of samples.
+     */
+    std::uint64_t Count() const noexcept { return count_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Number of samples in a bucket.
+     *
+     * @param bucket Index of bucket (less than kBuckets)
+     */
+    std::uint64_t Bucket(std::size_t bucket) const noexcept { return buckets_[bucket].load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Exclusive upper bound of delays, that are counted in a bucket.
+     *
+     * @param bucket Index of bucket (less than kBuckets)
+     */
+    static native_duration_t UpperBound(std::size_t bucket) noexcept
+    {
+        return native_duration_t(static_cast<long long>(1ull << bucket));
+    }
+
+    /**
+     * @brief The largest recorded delay.
+     */
+    native_duration_t Max() const noexcept { return native_duration_t(max_.load(std::memory_order_relaxed)); }
+
+    /**
+     * @brief Estimates a percentile of delays (upper bound of the bucket, that contains it).
+     *
+     * @param fraction Percentile as a fraction (e.g. 0.99)
+     * @returns estimated delay or zero, if histogram is empty
+     */
+    native_duration_t Percentile(double fraction) const noexcept
+    {
+        const auto count = Count();
+        if (0 == count)
+        {
+            return native_duration_t::zero();
+        }
+
+        const auto rank = static_cast<std::uint64_t>(fraction * static_cast<double>(count - 1)) + 1;
+
+        std::uint64_t seen = 0;
+        for (std::size_t bucket = 0; bucket < kBuckets; ++bucket)
+        {
+            seen += Bucket(bucket);
+            if (seen >= rank)
+            {
+                return (std::min)(UpperBound(bucket), Max());
+            }
+        }
+
+        return Max();
+    }
+
+private:
+    // Samples per bucket
+    std::array<std::atomic<std::uint64_t>, kBuckets> buckets_ {};
+
+    // Total number of samples
+    std::atomic<std::uint64_t> count_ { 0 };
+
+    // The largest sample (in 100 ns units)
+    std::atomic<long long> max_ { 0 };
+};
+
+}  // namespace ntp::time
@@ -0,0 +1,507 @@
+/**
+ * @file queue.hpp
+ * @brief Lock-free multi-producer multi-consumer FIFO queue
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <thread>
+#include <memory>
+#include <new>
+#include <cstdint>
+#include <utility>
+#include <type_traits>
+
+#if defined(_MSC_VER)
+#   include <intrin.h>
+#endif
+
+
+namespace ntp::details {
+
+/**
+ * @brief Size of cache line, used to separate frequently modified variables.
+ */
+inline constexpr std::size_t kCacheLine = 64;
+
+
+/**
+ * @brief Helper for busy waiting: spins for a while and then yields the processor.
+ */
+class Backoff final
+{
+    static constexpr std::uint32_t kSpinLimit = 64;
+
+public:
+    /**
+     * @brief Waits a bit longer than the previous call.
+     */
+    void Pause() noexcept
+    {
+        if (spins_ < kSpinLimit)
+        {
+            for (std::uint32_t i = 0; i < spins_ + 1; ++i)
+            {
+                CpuRelax();
+            }
+
+            spins_ *= 2;
+            spins_ += 1;
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+
+private:
+    static void CpuRelax() noexcept
+    {
+#if defined(_MSC_VER)
+        _mm_pause();
+#elif defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#elif defined(__aarch64__)
+        asm volatile("yield");
+#endif
+    }
+
+private:
+    std::uint32_t spins_ = 0;
+};
+
+
+/**
+ * @brief Result of insertion into MpmcQueue.
+ */
+enum class PushResult
+{
+    kPushed,  /**< Items are inserted */
+    kFull,    /**< Queue has no room for items */
+    kNoMemory /**< Segment for items cannot be allocated */
+};
+
+
+/**
+ * @brief Bounded lock-free MPMC FIFO queue.
+ *
+ * Every operation takes a ticket with a single atomic operation: producers
+ * advance tail, consumers -- head. Ticket defines a slot in one of fixed-size
+ * segments, so items are dequeued in exactly the same order, as their tickets
+ * were taken. Segments are allocated on demand and reached through a directory,
+ * that is indexed by segment number modulo Segments. Directory entry tracks
+ * which segment number it currently serves, hence no thread ever dereferences
+ * a segment, that can be concurrently released.
+ *
+ * Producer takes tickets only if their segments are already allocated and
+ * their directory entries are free, hence neither producers nor consumers
+ * wait for segments. Queue is full, if producers get ahead of the oldest
+ * segment in use by SegmentSize * Segments items: insertion fails then
+ * (as well as if a segment cannot be allocated) instead of waiting.
+ *
+ * Items can be moved in and out of the queue (Push/TryPop) or filled and
+ * consumed right inside the queue slots (PushWith/TryConsume). The latter
+ * allows to store non-movable objects: slot is reused only after its
+ * consumer returns, hence consumer must leave the item in a reusable state.
+ *
+ * @tparam Ty Type of stored items (must be nothrow default constructible)
+ * @tparam SegmentSize Number of slots in a segment
+ * @tparam Segments Number of directory entries
+ */
+template<typename Ty, std::size_t SegmentSize = 1024, std::size_t Segments = 1024>
+class MpmcQueue final
+{
+    static_assert(std::is_nothrow_default_constructible_v<Ty>,
+        "[ntp::details::MpmcQueue]: Ty MUST be nothrow default constructible");
+
+    MpmcQueue(const MpmcQueue&)            = delete;
+    MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+private:
+    /**
+     * @brief Single cell of a segment.
+     */
+    struct Slot
+    {
+        std::atomic<bool> ready { false }; /**< Is value written by producer */
+
+        Ty value {}; /**< Stored value */
+    };
+
+    /**
+     * @brief Fixed-size array of slots.
+     */
+    struct Segment
+    {
+        std::atomic<std::size_t> consumed { 0 }; /**< Number of values taken from segment */
+
+        std::array<Slot, SegmentSize> slots; /**< Slots themselves */
+    };
+
+    /**
+     * @brief Directory entry.
+     */
+    struct Entry
+    {
+        std::atomic<std::uint64_t> turn { 0 }; /**< Number of segment, that entry serves now */
+
+        std::atomic<Segment*> segment { nullptr }; /**< Segment for turn (NULL if not allocated yet) */
+    };
+
+public:
+    explicit MpmcQueue()
+        : entries_(std::make_unique<Entry[]>(Segments))
+    {
+        for (std::size_t i = 0; i < Segments; ++i)
+        {
+            entries_[i].turn.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    ~MpmcQueue()
+    {
+        for (std::size_t i = 0; i < Segments; ++i)
+        {
+            delete entries_[i].segment.load(std::memory_order_relaxed);
+        }
+
+        delete spare_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Inserts a new item at the end of the queue.
+     *
+     * @param value Item to insert
+     * @returns PushResult::kPushed if item is inserted, reason of failure otherwise
+     */
+    PushResult TryPush(Ty value) noexcept
+    {
+        static_assert(std::is_nothrow_move_assignable_v<Ty>,
+            "[ntp::details::MpmcQueue::TryPush]: Ty MUST be nothrow move assignable");
+
+        return TryPushWith([&value](Ty& slot) noexcept { slot = std::move(value); });
+    }
+
+    /**
+     * @brief Inserts a new item at the end of the queue, item
+     * is filled right in the slot.
+     *
+     * Filler is called only if ticket is taken. If filler throws, slot is
+     * published as is (i.e. in its previous reusable state) and exception
+     * is rethrown.
+     *
+     * @param fill Callable, that accepts Ty& and fills it
+     * @returns PushResult::kPushed if item is inserted, reason of failure otherwise
+     */
+    template<typename Filler>
+    PushResult TryPushWith(Filler&& fill)
+    {
+        std::uint64_t ticket = 0;
+
+        if (const auto result = Reserve(1, ticket); result != PushResult::kPushed)
+        {
+            return result;
+        }
+
+        auto& slot = SegmentOf(ticket)->slots[ticket % SegmentSize];
+
+        struct Publisher
+        {
+            ~Publisher() { ready.store(true, std::memory_order_release); }
+
+            std::atomic<bool>& ready;
+        } publisher { slot.ready };
+
+        std::forward<Filler>(fill)(slot.value);
+        return PushResult::kPushed;
+    }
+
+    /**
+     * @brief Inserts a batch of items at the end of the queue with a single 
+     * atomic operation, items are filled right in the slots in order.
+     *
+     * Either all items are inserted, or none (filler is not called then).
+     * If filler throws, the rest of the slots are published as is (i.e. in
+     * their previous reusable state) and exception is rethrown.
+     *
+     * @param count Number of items to insert
+     * @param fill Callable, that accepts Ty& and fills it (called count times)
+     * @returns PushResult::kPushed if items are inserted, reason of failure otherwise
+     */
+    template<typename Filler>
+    PushResult TryPushBatch(std::size_t count, Filler&& fill)
+    {
+        if (!count)
+        {
+            return PushResult::kPushed;
+        }
+
+        std::uint64_t first = 0;
+
+        if (const auto result = Reserve(count, first); result != PushResult::kPushed)
+        {
+            return result;
+        }
+
+        std::size_t index = 0;
+
+        //
+        // Cache current segment, batch usually fits into one or two segments
+        //
+
+        Segment* segment     = nullptr;
+        std::uint64_t number = 0;
+
+        const auto next_slot = [this, &segment, &number](std::uint64_t ticket) -> Slot& {
+            if (!segment || number != ticket / SegmentSize)
+            {
+                number  = ticket / SegmentSize;
+                segment = SegmentOf(ticket);
+            }
+
+            return segment->slots[ticket % SegmentSize];
+        };
+
+        try
+        {
+            for (; index < count; ++index)
+            {
+                auto& slot = next_slot(first + index);
+
+                fill(slot.value);
+                slot.ready.store(true, std::memory_order_release);
+            }
+        }
+        catch (...)
+        {
+            for (; index < count; ++index)
+            {
+                next_slot(first + index).ready.store(true, std::memory_order_release);
+            }
+
+            throw;
+        }
+
+        return PushResult::kPushed;
+    }
+
+    /**
+     * @brief Removes the first item from the queue.
+     *
+     * If an item is being inserted concurrently, waits for it.
+     *
+     * @param value Receives removed item
+     * @returns true if an item is removed, false if queue is empty
+     */
+    bool TryPop(Ty& value) noexcept
+    {
+        static_assert(std::is_nothrow_move_assignable_v<Ty>,
+            "[ntp::details::MpmcQueue::TryPop]: Ty MUST be nothrow move assignable");
+
+        return TryConsume([&value](Ty& slot) noexcept { value = std::move(slot); });
+    }
+
+    /**
+     * @brief Removes the first item from the queue, item is consumed right in the slot.
+     *
+     * If an item is being inserted concurrently, waits for it. Slot is released 
+     * after consumer returns (or throws).
+     *
+     * @param consume Callable, that accepts Ty& and leaves it in a reusable state
+     * @returns true if an item is consumed, false if queue is empty
+     */
+    template<typename Consumer>
+    bool TryConsume(Consumer&& consume)
+    {
+        auto ticket = head_.load(std::memory_order_acquire);
+
+        do
+        {
+            if (ticket >= tail_.load(std::memory_order_acquire))
+            {
+                return false;
+            }
+        } while (!head_.compare_exchange_weak(ticket, ticket + 1, std::memory_order_acq_rel, std::memory_order_acquire));
+
+        //
+        // Slot is owned by this consumer now, but producer
+        // may not have written the value yet
+        //
+
+        const auto segment = SegmentOf(ticket);
+        auto& slot         = segment->slots[ticket % SegmentSize];
+
+        for (Backoff backoff; !slot.ready.load(std::memory_order_acquire);)
+        {
+            backoff.Pause();
+        }
+
+        struct Releaser
+        {
+            ~Releaser()
+            {
+                if (segment->consumed.fetch_add(1, std::memory_order_acq_rel) + 1 == SegmentSize)
+                {
+                    queue->ReleaseSegment(number, segment);
+                }
+            }
+
+            MpmcQueue* queue;
+            Segment* segment;
+            std::uint64_t number;
+        } releaser { this, segment, ticket / SegmentSize };
+
+        std::forward<Consumer>(consume)(slot.value);
+        return true;
+    }
+
+    /**
+     * @brief Approximate number of queued items.
+     */
+    std::size_t Size() const noexcept
+    {
+        const auto head = head_.load(std::memory_order_acquire);
+        const auto tail = tail_.load(std::memory_order_acquire);
+
+        return (tail > head) ? static_cast<std::size_t>(tail - head) : 0;
+    }
+
+private:
+    PushResult Reserve(std::size_t count, std::uint64_t& first) noexcept
+    {
+        auto tail = tail_.load(std::memory_order_acquire);
+
+        do
+        {
+            for (auto result = Prepare(tail, count); result != PushResult::kPushed; result = Prepare(tail, count))
+            {
+                //
+                // Entries are not ready for tickets, that are already taken
+                // by other producers, if tail has moved: just try again
+                //
+
+                if (const auto current = tail_.load(std::memory_order_acquire); current != tail)
+                {
+                    tail = current;
+                    continue;
+                }
+
+                return result;
+            }
+        } while (!tail_.compare_exchange_weak(tail, tail + count, std::memory_order_acq_rel, std::memory_order_acquire));
+
+        first = tail;
+        return PushResult::kPushed;
+    }
+
+    PushResult Prepare(std::uint64_t first, std::size_t count) noexcept
+    {
+        //
+        // Entry cannot start serving the next segment, until tickets
+        // of its current one are taken, hence entries, that are ready
+        // here, stay ready until tail moves
+        //
+
+        const auto last = (first + count - 1) / SegmentSize;
+
+        for (auto number = first / SegmentSize; number <= last; ++number)
+        {
+            auto& entry = entries_[number % Segments];
+
+            if (entry.turn.load(std::memory_order_acquire) != number)
+            {
+                return PushResult::kFull;
+            }
+
+            if (entry.segment.load(std::memory_order_acquire))
+            {
+                continue;
+            }
+
+            const auto fresh = AllocateSegment();
+            if (!fresh)
+            {
+                return PushResult::kNoMemory;
+            }
+
+            //
+            // If entry has switched to the next segment meanwhile,
+            // fresh segment serves it just as well
+            //
+
+            Segment* expected = nullptr;
+
+            if (!entry.segment.compare_exchange_strong(expected, fresh, std::memory_order_acq_rel))
+            {
+                RecycleSegment(fresh);
+            }
+        }
+
+        return PushResult::kPushed;
+    }
+
+    Segment* SegmentOf(std::uint64_t ticket) const noexcept
+    {
+        //
+        // Segment of a taken ticket is allocated before the ticket
+        // and released only after it is consumed
+        //
+
+        return entries_[(ticket / SegmentSize) % Segments].segment.load(std::memory_order_acquire);
+    }
+
+    void ReleaseSegment(std::uint64_t number, Segment* segment) noexcept
+    {
+        //
+        // Every producer and consumer of this segment has finished
+        //
+
+        auto& entry = entries_[number % Segments];
+
+        entry.segment.store(nullptr, std::memory_order_relaxed);
+        entry.turn.store(number + Segments, std::memory_order_release);
+
+        RecycleSegment(segment);
+    }
+
+    Segment* AllocateSegment() noexcept
+    {
+        if (const auto spare = spare_.exchange(nullptr, std::memory_order_acquire); spare)
+        {
+            return spare;
+        }
+
+        return new (std::nothrow) Segment();
+    }
+
+    void RecycleSegment(Segment* segment) noexcept
+    {
+        segment->consumed.store(0, std::memory_order_relaxed);
+
+        for (auto& slot : segment->slots)
+        {
+            slot.ready.store(false, std::memory_order_relaxed);
+        }
+
+        //
+        // Keep one segment to avoid allocation at every segment switch
+        //
+
+        delete spare_.exchange(segment, std::memory_order_acq_rel);
+    }
+
+private:
+    // Tickets of consumers and producers (on separate cache lines)
+    alignas(kCacheLine) std::atomic<std::uint64_t> head_ { 0 };
+    alignas(kCacheLine) std::atomic<std::uint64_t> tail_ { 0 };
+
+    // Segments directory
+    alignas(kCacheLine) std::unique_ptr<Entry[]> entries_;
+
+    // Cached free segment
+    std::atomic<Segment*> spare_ { nullptr };
+};
+
+}  // namespace ntp::details
@@ -0,0 +1,221 @@
+/**
+ * @file registry.hpp
+ * @brief Sharded hash table used by threadpool object managers
+ */
+
+#pragma once
+
+#include <array>
+#include <mutex>
+#include <cstdint>
+#include <utility>
+#include <functional>
+#include <shared_mutex>
+#include <unordered_map>
+
+#include "details/utils.hpp"
+#include "details/queue.hpp"
+
+
+namespace ntp::details {
+
+/**
+ * @brief Hash table split into independently locked shards.
+ *
+ * Every operation locks only a shard, that owns the key, hence
+ * operations on different objects rarely contend with each other.
+ * Lookup is O(1) on average. Operations accept callables, that
+ * are invoked under shard's lock, so that callers can keep their
+ * invariants (e.g. close a threadpool object and remove it atomically).
+ *
+ * @tparam Key Type of keys (must be hashable with std::hash)
+ * @tparam Value Type of values
+ * @tparam ShardCount Number of shards (must be a power of 2)
+ */
+template<typename Key, typename Value, std::size_t ShardCount = 64>
+class ShardedRegistry final
+{
+    static_assert(ShardCount != 0 && (ShardCount & (ShardCount - 1)) == 0,
+        "[ntp::details::ShardedRegistry]: ShardCount must be a power of 2");
+
+    ShardedRegistry(const ShardedRegistry&)            = delete;
+    ShardedRegistry& operator=(const ShardedRegistry&) = delete;
+
+public:
+    /**
+     * @brief Type of shard's container.
+     */
+    using container_t = std::unordered_map<Key, Value>;
+
+    /**
+     * @brief Lock primitive.
+     */
+    using lock_t = RtlResource;
+
+public:
+    ShardedRegistry() = default;
+
+    /**
+     * @brief Inserts (or replaces) a value and invokes a callable on it under shard's lock.
+     *
+     * @param key Key to insert
+     * @param value Value to insert
+     * @param visitor Callable, that accepts reference to inserted value
+     */
+    template<typename Visitor>
+    void Insert(const Key& key, Value value, Visitor&& visitor)
+    {
+        auto& shard = ShardOf(key);
+        std::unique_lock lock { shard.lock };
+
+        const auto [iter, _] = shard.container.insert_or_assign(key, std::move(value));
+        std::invoke(std::forward<Visitor>(visitor), iter->second);
+    }
+
+    /**
+     * @brief Invokes a callable on a value under shard's lock.
+     *
+     * @param key Key to look for
+     * @param visitor Callable, that accepts reference to found value
+     * @returns true if value was found and visited, false otherwise
+     */
+    template<typename Visitor>
+    bool Visit(const Key& key, Visitor&& visitor)
+    {
+        auto& shard = ShardOf(key);
+        std::unique_lock lock { shard.lock };
+
+        if (const auto iter = shard.container.find(key); iter != shard.container.end())
+        {
+            std::invoke(std::forward<Visitor>(visitor), iter->second);
+            return true;
+        }
+
+        return false;
+    }
+
+    /**
+     * @brief Invokes a callable on a value under shard's shared lock.
+     *
+     * Callable may be invoked concurrently for different (or even the same) values.
+     *
+     * @param key Key to look for
+     * @param visitor Callable, that accepts const reference to found value
+     * @returns true if value was found and visited, false otherwise
+     */
+    template<typename Visitor>
+    bool VisitShared(const Key& key, Visitor&& visitor) const
+    {
+        auto& shard = ShardOf(key);
+        std::shared_lock lock { shard.lock };
+
+        if (const auto iter = shard.container.find(key); iter != shard.container.end())
+        {
+            std::invoke(std::forward<Visitor>(visitor), std::as_const(iter->second));
+            return true;
+        }
+
+        return false;
+    }
+
+    /**
+     * @brief Invokes a callable on a value and then removes it. Both under shard's lock.
+     *
+     * @param key Key to remove
+     * @param visitor Callable, that accepts reference to value being removed
+     * @returns true if value was found and removed, false otherwise
+     */
+    template<typename Visitor>
+    bool Erase(const Key& key, Visitor&& visitor)
+    {
+        auto& shard = ShardOf(key);
+        std::unique_lock lock { shard.lock };
+
+        if (const auto iter = shard.container.find(key); iter != shard.container.end())
+        {
+            std::invoke(std::forward<Visitor>(visitor), iter->second);
+            shard.container.erase(iter);
+
+            return true;
+        }
+
+        return false;
+    }
+
+    /**
+     * @brief Invokes a callable on every key and value and then removes them.
+     *
+     * Shards are locked one by one, so values, inserted concurrently
+     * into already processed shards, remain in the registry.
+     *
+     * @param visitor Callable, that accepts key and reference to value being removed
+     */
+    template<typename Visitor>
+    void Clear(Visitor&& visitor)
+    {
+        for (auto& shard : shards_)
+        {
+            std::unique_lock lock { shard.lock };
+
+            for (auto& [key, value] : shard.container)
+            {
+                std::invoke(visitor, key, value);
+            }
+
+            shard.container.clear();
+        }
+    }
+
+    /**
+     * @brief Get number of stored values. Result is approximate if registry is modified concurrently.
+     *
+     * @returns Number of values
+     */
+    std::size_t Size() const
+    {
+        std::size_t size = 0;
+
+        for (auto& shard : shards_)
+        {
+            std::shared_lock lock { shard.lock };
+            size += shard.container.size();
+        }
+
+        return size;
+    }
+
+private:
+    struct alignas(kCacheLine) Shard
+    {
+        mutable lock_t lock; /**< Lock for this shard only */
+
+        container_t container; /**< Values, that belong to this shard */
+    };
+
+    Shard& ShardOf(const Key& key) noexcept
+    {
+        return shards_[ShardIndex(key)];
+    }
+
+    const Shard& ShardOf(const Key& key) const noexcept
+    {
+        return shards_[ShardIndex(key)];
+    }
+
+    static std::size_t ShardIndex(const Key& key) noexcept
+    {
+        //
+        // Keys are mostly pointers (handles) with low bits equal to zero,
+        // hence hash is mixed before taking the shard index (Fibonacci hashing)
+        //
+
+        const auto hash = static_cast<std::uint64_t>(std::hash<Key>{}(key)) * 0x9E3779B97F4A7C15ull;
+        return static_cast<std::size_t>(hash >> 32) & (ShardCount - 1);
+    }
+
+private:
+    // Independently locked shards
+    std::array<Shard, ShardCount> shards_;
+};
+
+}  // namespace ntp::details
@@ -7,6 +7,8 @@
 
 #include <ratio>
 #include <chrono>
+#include <memory>
+#include <type_traits>
 
 #include "details/windows.hpp"
 
@@ -82,6 +84,70 @@ using native_duration_t = std::chrono::duration<long long, std::ratio<1, 10'000'
 inline constexpr auto max_native_duration = (native_duration_t::max)();
 
 
+/**
+ * @brief Tolerable delay of timer expiration (slack).
+ *
+ * Timer with tolerance expires somewhere between its due time and due time
+ * plus tolerance. It allows to expire several timers at once and reduce
+ * number of wakeups.
+ */
+struct Tolerance
+{
+    /**
+     * @brief Zero tolerance (timer expires as close to its due time as possible).
+     */
+    constexpr Tolerance() noexcept = default;
+
+    /**
+     * @brief Constructor from arbitrary duration.
+     *
+     * @param tolerance Tolerable delay (negative values are treated as zero)
+     */
+    template<typename Rep, typename Period>
+    constexpr explicit Tolerance(const std::chrono::duration<Rep, Period>& tolerance) noexcept
+        : value(std::chrono::duration_cast<native_duration_t>(tolerance) > native_duration_t::zero()
+                    ? std::chrono::duration_cast<native_duration_t>(tolerance)
+                    : native_duration_t::zero())
+    { }
+
+    native_duration_t value {}; /**< Tolerable delay */
+};
+
+
+// Forward declaration (see details/periodic.hpp)
+class JitterHistogram;
+
+
+namespace details {
+
+/**
+ * @brief Trait that detects ntp::time::Tolerance.
+ *
+ * Helper inline (since C++17) variable.
+ */
+template<typename Ty>
+inline constexpr bool is_tolerance_v = std::is_same_v<Ty, Tolerance>;
+
+/**
+ * @brief Trait that detects histograms of timer jitter (see ntp::time::JitterHistogram).
+ *
+ * Helper inline (since C++17) variable.
+ */
+template<typename Ty>
+inline constexpr bool is_jitter_v = std::is_same_v<Ty, std::shared_ptr<JitterHistogram>>;
+
+/**
+ * @brief Trait that detects types, that are time-related arguments of
+ *        timer submission functions and therefore cannot be callables.
+ *
+ * Helper inline (since C++17) variable.
+ */
+template<typename Ty>
+inline constexpr bool is_timer_argument_v = is_duration_v<Ty> || is_time_point_v<Ty> || is_tolerance_v<Ty> || is_jitter_v<Ty>;
+
+}  // namespace details
+
+
 /**
  * @brief Default clock.
  */
@@ -95,6 +161,34 @@ template<typename Clock, typename Duration>
 using deadline_t = std::chrono::time_point<Clock, Duration>;
 
 
+/**
+ * @brief Computes the nearest expiration of a timer, that is not gone yet.
+ *
+ * One-shot timer expires at its deadline (even if it is gone). Periodic
+ * timer, whose deadline is gone, expires at the first period boundary
+ * after now, so its schedule stays anchored at the original deadline.
+ *
+ * @param deadline Absolute time of (the first) expiration
+ * @param period Timer period (zero for one-shot timers)
+ * @param now Current time
+ * @returns Absolute time of the next expiration
+ */
+template<typename Clock, typename Duration, typename Rep, typename Period>
+std::chrono::time_point<Clock, Duration> NextExpiration(const std::chrono::time_point<Clock, Duration>& deadline,
+    const std::chrono::duration<Rep, Period>& period, const std::chrono::time_point<Clock, Duration>& now) noexcept
+{
+    if (deadline >= now || period <= std::chrono::duration<Rep, Period>::zero())
+    {
+        return deadline;
+    }
+
+    const auto step    = std::chrono::duration_cast<Duration>(period);
+    const auto periods = (now - deadline + step - Duration(1)) / step;
+
+    return deadline + periods * step;
+}
+
+
 /**
  * @brief Converts std::chrono::duration to FILETIME.
  * 
@@ -123,8 +217,14 @@ FILETIME AsFileTime(const std::chrono::duration<Rep, Period>& duration) noexcept
  */
 inline FILETIME Negate(FILETIME time) noexcept
 {
-    time.dwLowDateTime = static_cast<DWORD>(-static_cast<LONG>(time.dwLowDateTime));
-    return time;
+    //
+    // Whole 64-bit value is negated, not only its low part
+    //
+
+    const auto value   = (static_cast<unsigned long long>(time.dwHighDateTime) << 32) | time.dwLowDateTime;
+    const auto negated = static_cast<unsigned long long>(-static_cast<long long>(value));
+
+    return FILETIME { static_cast<DWORD>(negated), static_cast<DWORD>(negated >> 32) };
 }
 
 }  // namespace ntp::time
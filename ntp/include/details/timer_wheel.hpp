@@ -0,0 +1,332 @@
+/**
+ * @file timer_wheel.hpp
+ * @brief Hierarchical timing wheel
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+
+
+namespace ntp::details {
+
+/**
+ * @brief Intrusive doubly linked list hook, used by timing wheel slots.
+ */
+struct TimerWheelHook
+{
+    TimerWheelHook* prev = nullptr; /**< Previous node (or list head) */
+
+    TimerWheelHook* next = nullptr; /**< Next node (or list head) */
+
+    /**
+     * @brief Checks if node is in a list now.
+     */
+    bool Linked() const noexcept { return next != nullptr; }
+
+    /**
+     * @brief Makes this node an empty list head.
+     */
+    void MakeHead() noexcept { prev = next = this; }
+
+    /**
+     * @brief Checks if this list head has no nodes.
+     */
+    bool Empty() const noexcept { return next == this; }
+
+    /**
+     * @brief Inserts a node before this one (at the tail, if this one is a list head).
+     */
+    void LinkBefore(TimerWheelHook* node) noexcept
+    {
+        node->prev = prev;
+        node->next = this;
+        prev->next = node;
+        prev       = node;
+    }
+
+    /**
+     * @brief Removes this node from its list.
+     */
+    void Unlink() noexcept
+    {
+        prev->next = next;
+        next->prev = prev;
+        prev = next = nullptr;
+    }
+};
+
+
+/**
+ * @brief Timer, that can be scheduled in ntp::details::TimerWheel.
+ *        Users derive from it to attach their own data.
+ */
+struct TimerWheelEntry : TimerWheelHook
+{
+    std::uint64_t expiry = 0; /**< Tick, at which timer expires */
+};
+
+
+/**
+ * @brief Hierarchical timing wheel (timers are measured in abstract ticks).
+ *
+ * Level 0 has a slot for each of the next 2^SlotBits ticks, every next level
+ * has slots, that are 2^SlotBits times wider. Timers are placed into the
+ * lowest level, that covers their expiry, and are moved (cascaded) to lower
+ * levels, when wheel reaches their slot. Insertion and cancellation are O(1),
+ * expiration is O(1) amortized per timer. Timers, that expire later than
+ * the whole wheel covers, are parked in the last level and re-placed on
+ * each revolution.
+ *
+ * Class is not thread-safe, owner must synchronize access to it.
+ *
+ * @tparam SlotBits Logarithm of number of slots per level
+ * @tparam Levels Number of levels
+ */
+template<std::size_t SlotBits = 6, std::size_t Levels = 5>
+class TimerWheel final
+{
+    static_assert(SlotBits > 0 && Levels > 0 && SlotBits * Levels < 64,
+        "[ntp::details::TimerWheel]: wheel must cover less than 2^64 ticks");
+
+    TimerWheel(const TimerWheel&)            = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    static constexpr std::uint64_t kSlots   = std::uint64_t { 1 } << SlotBits;
+    static constexpr std::uint64_t kMask    = kSlots - 1;
+    static constexpr std::uint64_t kMaxSpan = (std::uint64_t { 1 } << (SlotBits * Levels)) - 1;
+
+public:
+    /**
+     * @brief Constructs an empty wheel.
+     *
+     * @param now Initial tick
+     */
+    explicit TimerWheel(std::uint64_t now = 0) noexcept
+        : current_(now)
+        , size_(0)
+    {
+        for (auto& level : levels_)
+        {
+            for (auto& slot : level)
+            {
+                slot.MakeHead();
+            }
+        }
+    }
+
+    /**
+     * @brief Current tick of the wheel (the last processed one).
+     */
+    std::uint64_t Now() const noexcept { return current_; }
+
+    /**
+     * @brief Number of scheduled timers.
+     */
+    std::size_t Size() const noexcept { return size_; }
+
+    /**
+     * @brief Checks if there are no scheduled timers.
+     */
+    bool Empty() const noexcept { return 0 == size_; }
+
+    /**
+     * @brief Moves current tick of an empty wheel.
+     *
+     * @param now New current tick
+     * @returns false if wheel is not empty (nothing is changed then)
+     */
+    bool Reset(std::uint64_t now) noexcept
+    {
+        if (!Empty())
+        {
+            return false;
+        }
+
+        current_ = now;
+        return true;
+    }
+
+    /**
+     * @brief Schedules a timer. Timers, that expire at or before the current
+     *        tick, expire on the next one.
+     *
+     * @param entry Timer to schedule (must not be scheduled already)
+     * @param expiry Tick, at which timer expires
+     */
+    void Insert(TimerWheelEntry* entry, std::uint64_t expiry) noexcept
+    {
+        entry->expiry = expiry;
+        Place(entry, current_ + 1);
+
+        ++size_;
+    }
+
+    /**
+     * @brief Removes a scheduled timer.
+     *
+     * @param entry Timer to remove
+     * @returns false if timer is not scheduled
+     */
+    bool Cancel(TimerWheelEntry* entry) noexcept
+    {
+        if (!entry->Linked())
+        {
+            return false;
+        }
+
+        entry->Unlink();
+        --size_;
+
+        return true;
+    }
+
+    /**
+     * @brief Advances the wheel and expires timers.
+     *
+     * @param now Tick to advance to (nothing happens, if it is not greater than current one)
+     * @param expire Callable, that accepts TimerWheelEntry*. It is invoked for every
+     *               expired timer after the timer is removed from the wheel. It may
+     *               destroy the timer, but must not modify the wheel.
+     */
+    template<typename Expire>
+    void Advance(std::uint64_t now, Expire&& expire)
+    {
+        while (current_ < now)
+        {
+            if (Empty())
+            {
+                current_ = now;
+                break;
+            }
+
+            ++current_;
+
+            //
+            // Bring down timers from higher levels, whose slots start at this tick
+            //
+
+            for (std::size_t level = 1; level < Levels; ++level)
+            {
+                if (current_ & ((std::uint64_t { 1 } << (SlotBits * level)) - 1))
+                {
+                    break;
+                }
+
+                Cascade(levels_[level][(current_ >> (SlotBits * level)) & kMask]);
+            }
+
+            auto& slot = levels_[0][current_ & kMask];
+            while (!slot.Empty())
+            {
+                const auto entry = static_cast<TimerWheelEntry*>(slot.next);
+
+                entry->Unlink();
+                --size_;
+
+                expire(entry);
+            }
+        }
+    }
+
+    /**
+     * @brief Removes all timers.
+     *
+     * @param remove Callable, that accepts TimerWheelEntry*. It is invoked for every
+     *               timer after the timer is removed from the wheel.
+     */
+    template<typename Remove>
+    void Clear(Remove&& remove)
+    {
+        for (auto& level : levels_)
+        {
+            for (auto& slot : level)
+            {
+                while (!slot.Empty())
+                {
+                    const auto entry = static_cast<TimerWheelEntry*>(slot.next);
+
+                    entry->Unlink();
+                    --size_;
+
+                    remove(entry);
+                }
+            }
+        }
+    }
+
+private:
+    void Place(TimerWheelEntry* entry, std::uint64_t earliest) noexcept
+    {
+        //
+        // Expired timers go to the earliest tick, that is not processed yet,
+        // too distant ones are clamped to the farthest tick the wheel covers
+        //
+
+        auto expiry = entry->expiry;
+        if (expiry < earliest)
+        {
+            expiry = earliest;
+        }
+
+        if (expiry - current_ > kMaxSpan)
+        {
+            expiry = current_ + kMaxSpan;
+        }
+
+        const auto delta = expiry - current_;
+
+        std::size_t level = 0;
+        while (level + 1 < Levels && delta >= (std::uint64_t { 1 } << (SlotBits * (level + 1))))
+        {
+            ++level;
+        }
+
+        levels_[level][(expiry >> (SlotBits * level)) & kMask].LinkBefore(entry);
+    }
+
+    void Cascade(TimerWheelHook& slot) noexcept
+    {
+        //
+        // Slot is detached first, because timers may be placed back into it
+        // (e.g. clamped ones, that still do not fit into the wheel). Cascade
+        // happens before current tick is processed, so timers may land into it.
+        //
+
+        TimerWheelHook pending;
+        pending.MakeHead();
+
+        if (!slot.Empty())
+        {
+            pending.next       = slot.next;
+            pending.prev       = slot.prev;
+            pending.next->prev = &pending;
+            pending.prev->next = &pending;
+
+            slot.MakeHead();
+        }
+
+        while (!pending.Empty())
+        {
+            const auto entry = static_cast<TimerWheelEntry*>(pending.next);
+
+            entry->Unlink();
+            Place(entry, current_);
+        }
+    }
+
+private:
+    // Slots of all levels (each slot is a list head)
+    std::array<std::array<TimerWheelHook, kSlots>, Levels> levels_;
+
+    // The last processed tick
+    std::uint64_t current_;
+
+    // Number of scheduled timers
+    std::size_t size_;
+};
+
+}  // namespace ntp::details
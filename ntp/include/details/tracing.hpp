@@ -0,0 +1,220 @@
+/**
+ * @file tracing.hpp
+ * @brief Recording of callback executions and their export as Chrome or Perfetto traces
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+#include "ntp_config.hpp"
+#include "details/metrics.hpp"
+
+
+namespace ntp::tracing {
+
+/**
+ * @brief Kind of traced callback.
+ */
+enum class CallbackKind : std::uint8_t
+{
+    kWork,  /**< Work callbacks and tasks */
+    kWait,  /**< Wait callbacks (including wait groups) */
+    kTimer, /**< Timer callbacks (including soft timers) */
+    kIo     /**< IO callbacks */
+};
+
+
+/**
+ * @brief Execution of a single callback.
+ */
+struct Event
+{
+    std::uint64_t begin = 0; /**< Timestamp of start (ntp::metrics::details::ReadTimestamp) */
+
+    std::uint64_t end = 0; /**< Timestamp of completion */
+
+    const char* tag = nullptr; /**< Tag of callback (refer to ntp::tracing::ScopedTag) or nullptr */
+
+    CallbackKind kind = CallbackKind::kWork; /**< Kind of callback */
+};
+
+
+/**
+ * @brief Events recorded by a single thread.
+ */
+struct ThreadTrace
+{
+    std::uint64_t thread_id = 0; /**< System identifier of thread */
+
+    std::uint64_t dropped = 0; /**< Number of events, that did not fit into thread's buffer */
+
+    std::vector<Event> events; /**< Recorded events in order of completion */
+};
+
+
+/**
+ * @brief Events recorded by all threads since tracing was started.
+ */
+struct Trace
+{
+    std::uint64_t process_id = 0; /**< System identifier of process */
+
+    double nanoseconds_per_tick = 1.0; /**< Duration of a timestamp unit */
+
+    std::vector<ThreadTrace> threads; /**< Events of threads */
+};
+
+
+/**
+ * @brief Get name of callback kind (it is used as event category).
+ */
+const char* KindName(CallbackKind kind) noexcept;
+
+/**
+ * @brief Discards previously recorded events and starts recording.
+ *        Must not be called concurrently with ntp::tracing::Collect.
+ */
+void Start() noexcept;
+
+/**
+ * @brief Stops recording. Callbacks, that are running right now, may still be recorded.
+ */
+void Stop() noexcept;
+
+/**
+ * @brief Checks if events are being recorded.
+ */
+bool IsStarted() noexcept;
+
+/**
+ * @brief Copies events recorded since the last ntp::tracing::Start.
+ *        Tracing may remain started, events recorded meanwhile may be missed.
+ */
+Trace Collect();
+
+/**
+ * @brief Writes trace in Chrome trace event format (JSON). It can be opened
+ *        with chrome://tracing or https://ui.perfetto.dev. Timestamps are
+ *        relative to the earliest event.
+ *
+ * @param stream Output stream
+ * @param trace Trace to write
+ */
+void WriteChromeTrace(std::ostream& stream, const Trace& trace);
+
+/**
+ * @brief Writes trace in Perfetto protobuf format (serialized perfetto.protos.Trace).
+ *        Every thread is a track, every event is a slice. Timestamps are
+ *        relative to the earliest event.
+ *
+ * @param stream Output stream (must be opened in binary mode)
+ * @param trace Trace to write
+ */
+void WritePerfetto(std::ostream& stream, const Trace& trace);
+
+
+/**
+ * @brief Sets tag of callbacks, that are created by the calling thread in the scope.
+ *        Tag is stored as a pointer, so it must outlive the trace (e.g. a string literal).
+ *
+ * Example:
+ * @code{.cpp}
+ * {
+ *     ntp::tracing::ScopedTag tag { "decode" };
+ *     pool.SubmitWork(&Decode, frame);  // Slice is named "decode" in trace
+ * }
+ * @endcode
+ */
+class ScopedTag final
+{
+    ScopedTag(const ScopedTag&)            = delete;
+    ScopedTag& operator=(const ScopedTag&) = delete;
+
+public:
+    explicit ScopedTag(const char* tag) noexcept;
+    ~ScopedTag();
+
+private:
+    // Tag, that is restored on destruction
+    const char* previous_;
+};
+
+
+namespace details {
+
+/**
+ * @brief Are callbacks traced (tracing is compiled in only if NTP_ENABLE_TRACING is defined).
+ */
+#if defined(NTP_ENABLE_TRACING)
+inline constexpr bool kTracingCompiled = true;
+#else  // !NTP_ENABLE_TRACING
+inline constexpr bool kTracingCompiled = false;
+#endif  // NTP_ENABLE_TRACING
+
+/**
+ * @brief Is recording started (refer to ntp::tracing::Start).
+ */
+inline std::atomic<bool> started { false };
+
+/**
+ * @brief Tag of callbacks created by the calling thread.
+ */
+inline thread_local const char* current_tag = nullptr;
+
+/**
+ * @brief Appends an event to the calling thread's buffer. The buffer is allocated
+ *        on the first event of a thread, then events are written without locks.
+ *        Events, that do not fit into the buffer, are counted as dropped.
+ */
+void Record(const Event& event) noexcept;
+
+
+/**
+ * @brief Records execution of a callback on destruction (so callbacks,
+ *        that have thrown, are recorded as well), if tracing is started.
+ */
+class TraceScope final
+{
+    TraceScope(const TraceScope&)            = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+public:
+    /**
+     * @brief Starts measurement.
+     *
+     * @param kind Kind of callback
+     * @param tag Tag of callback or nullptr
+     */
+    explicit TraceScope(CallbackKind kind, const char* tag) noexcept
+        : event_ { 0, 0, tag, kind }
+        , started_(started.load(std::memory_order_relaxed))
+    {
+        if (started_)
+        {
+            event_.begin = ntp::metrics::details::ReadTimestamp();
+        }
+    }
+
+    ~TraceScope()
+    {
+        if (started_)
+        {
+            event_.end = ntp::metrics::details::ReadTimestamp();
+            Record(event_);
+        }
+    }
+
+private:
+    // Event being measured
+    Event event_;
+
+    // Was tracing started, when callback has started
+    const bool started_;
+};
+
+}  // namespace details
+}  // namespace ntp::tracing
@@ -5,9 +5,17 @@
 
 #pragma once
 
+#include <string>
+#include <utility>
+
 #include "ntp_config.hpp"
-#include "native/ntrtl.h"
-#include "details/allocator.hpp"
+#include "details/windows.hpp"
+
+#if defined(NTP_PLATFORM_WINDOWS)
+#   include "native/ntrtl.h"
+#else  // !NTP_PLATFORM_WINDOWS
+#   include "native/linux/ntrtl.h"
+#endif  // NTP_PLATFORM_WINDOWS
 
 
 namespace ntp::details {
@@ -15,6 +23,8 @@ namespace ntp::details {
 /**
  * @brief Provides SEH-safe way to call functions from Win32 ThreadPool API.
  * 
+ * There is no SEH on Linux, so the function is just called there.
+ * 
  * @tparam function Pointer to function to call
  * @tparam Args... Types of arguments
  * @param args Arbitrary number of arguments passed to the function
@@ -23,6 +33,7 @@ namespace ntp::details {
 template<auto function, typename... Args>
 DWORD SafeThreadpoolCall(Args&&... args) noexcept
 {
+#if defined(NTP_PLATFORM_WINDOWS)
     __try
     {
         function(std::forward<Args>(args)...);
@@ -32,6 +43,10 @@ DWORD SafeThreadpoolCall(Args&&... args) noexcept
     {
         return GetExceptionCode();
     }
+#else  // !NTP_PLATFORM_WINDOWS
+    function(std::forward<Args>(args)...);
+    return ERROR_SUCCESS;
+#endif  // NTP_PLATFORM_WINDOWS
 }
 
 
@@ -68,76 +83,6 @@ std::wstring FormatMessage(DWORD flags, LPCWSTR source, DWORD message_id, ...) n
 std::wstring Convert(const std::string& source) noexcept;
 
 
-/**
- * @brief Wrapper for SLIST_HEADER.
- * 
- * Native lock-free (atomic) single-linked list.
- */
-class NativeSlist final
-{
-    // Allocator for header
-    using allocator_t = allocator::AlignedAllocator<SLIST_HEADER>;
-
-private:
-    NativeSlist(const NativeSlist&)            = delete;
-    NativeSlist& operator=(const NativeSlist&) = delete;
-
-public:
-    explicit NativeSlist();
-    ~NativeSlist();
-
-    /**
-     * @brief Inserts a new item to the list.
-     * 
-     * @param entry New item to insert into the list
-     */
-    void Push(PSLIST_ENTRY entry) noexcept;
-
-    /**
-     * @brief Implicit cast operator to internal list header.
-     * 
-     * @returns Pointer to the internal list headers
-     */
-    operator PSLIST_HEADER() const noexcept { return header_; }
-
-private:
-    // Internal list header
-    PSLIST_HEADER header_;
-};
-
-
-/**
- * @brief Wrapper for SLIST_ENTRY (actually inherits from it).
- */
-class alignas(NTP_ALLOCATION_ALIGNMENT) NativeSlistEntry
-    : public SLIST_ENTRY
-{
-    // Use raw aligned allocator
-    using allocator_t = allocator::AlignedAllocator<void>;
-
-public:
-    /**
-     * @brief Custom new operator, that allocates aligned memory.
-     *
-     * @param bytes Number of bytes to allocate
-     */
-    void* operator new(size_t bytes)
-    {
-        return allocator_t::AllocateBytes<NTP_ALLOCATION_ALIGNMENT>(bytes);
-    }
-
-    /**
-     * @brief Matching custom delete operator.
-     * 
-     * @param ptr Pointer to free
-     */
-    void operator delete(void* ptr) noexcept
-    {
-        return allocator_t::Free(ptr);
-    }
-};
-
-
 /**
  * @brief STL-compatible (in terms of SharedLockable and Lockable 
  * named requirements) wrapper for RTL_RESOURCE.
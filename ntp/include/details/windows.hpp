@@ -3,5 +3,14 @@
 // Config contains some macros for further configuration
 #include "ntp_config.hpp"
 
+#if defined(NTP_PLATFORM_WINDOWS)
+
 // Windows header itself
 #include <Windows.h>
+
+#else  // !NTP_PLATFORM_WINDOWS
+
+// Subset of Windows API implemented by ntp native engine
+#include "native/linux/windows.h"
+
+#endif  // NTP_PLATFORM_WINDOWS
@@ -0,0 +1,120 @@
+/**
+ * @file async_logger.hpp
+ * @brief Asynchronous mode of internal logger
+ */
+
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <cstdint>
+#include <condition_variable>
+
+#include "logger/logger.hpp"
+#include "logger/log_record.hpp"
+
+
+namespace ntp::logger::details {
+
+/**
+ * @brief Asynchronous logger. Implemented as singleton, that is never destroyed.
+ *
+ * Each thread, that traces messages, owns a ring of binary records (it is created
+ * on the first message). A background thread drains the rings, formats records and
+ * forwards them to the installed logger function. Messages of the same thread are
+ * delivered in order, messages of different threads are not ordered.
+ */
+class AsyncLogger final
+{
+    AsyncLogger(const AsyncLogger&)            = delete;
+    AsyncLogger& operator=(const AsyncLogger&) = delete;
+
+    explicit AsyncLogger() noexcept;
+
+public:
+    /**
+     * @brief Instance accessor
+     */
+    static AsyncLogger& Instance() noexcept;
+
+    /**
+     * @brief Checks if messages are delivered asynchronously.
+     */
+    bool Enabled() const noexcept { return enabled_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Turns asynchronous mode on or off. Turning it off flushes queued messages.
+     *
+     * @param enable New mode
+     * @returns true if mode is set (background thread may fail to start)
+     */
+    bool Enable(bool enable) noexcept;
+
+    /**
+     * @brief Stores a message into the calling thread's ring.
+     *
+     * @returns false if message must be delivered synchronously (ring is full or
+     *          unavailable, or the caller is the background thread itself)
+     */
+    template<typename Char, typename... Args>
+    bool Push(Severity severity, const Char* format, const Args&... args) noexcept
+    {
+        const auto ring = LocalRing();
+        if (!ring || !ring->TryPush(severity, format, args...))
+        {
+            overflows_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        if (ring->Size() == RecordRing::kCapacity / 2)
+        {
+            //
+            // Do not wait for the next poll, if ring fills up quickly
+            //
+
+            wake_.notify_one();
+        }
+
+        return true;
+    }
+
+    /**
+     * @brief Waits until messages queued before the call are delivered.
+     *        Does nothing, if it is called by logger function (i.e. from background thread).
+     */
+    void Flush() noexcept;
+
+    /**
+     * @brief Number of messages, that were delivered synchronously, because they could not be queued.
+     */
+    std::uint64_t Overflows() const noexcept { return overflows_.load(std::memory_order_relaxed); }
+
+private:
+    RecordRing* LocalRing() noexcept;
+
+    void Run() noexcept;
+    std::size_t Drain() noexcept;
+
+private:
+    // Is asynchronous mode on
+    std::atomic<bool> enabled_;
+
+    // Number of messages, that could not be queued
+    std::atomic<std::uint64_t> overflows_;
+
+    // Background thread's state (protected by lock_)
+    std::mutex lock_;
+    std::condition_variable wake_;
+    std::condition_variable flushed_;
+    bool started_;
+    std::uint64_t requested_;
+    std::uint64_t completed_;
+
+    // Rings of all threads (protected by rings_lock_) and snapshot of them (used by background thread only)
+    std::mutex rings_lock_;
+    std::vector<RecordRing*> rings_;
+    std::vector<RecordRing*> snapshot_;
+};
+
+}  // namespace ntp::logger::details
@@ -0,0 +1,339 @@
+/**
+ * @file log_record.hpp
+ * @brief Binary log records and per-thread rings of them (used by asynchronous logger)
+ */
+
+#pragma once
+
+#include <array>
+#include <tuple>
+#include <atomic>
+#include <algorithm>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "details/utils.hpp"
+#include "details/queue.hpp"
+#include "details/windows.hpp"
+#include "logger/logger.hpp"
+
+
+namespace ntp::logger::details {
+
+/**
+ * @brief Type, that an argument of trace message is stored as (character
+ *        arrays and pointers to mutable characters are stored as C-strings).
+ */
+template<typename Ty>
+using stored_argument_t = std::conditional_t<std::is_same_v<std::decay_t<Ty>, char*>, const char*,
+    std::conditional_t<std::is_same_v<std::decay_t<Ty>, wchar_t*>, const wchar_t*, std::decay_t<Ty>>>;
+
+/**
+ * @brief Checks if argument is stored as a copy of C-string.
+ */
+template<typename Ty>
+inline constexpr bool is_string_argument_v = std::is_same_v<Ty, const char*> || std::is_same_v<Ty, const wchar_t*>;
+
+
+/**
+ * @brief Fixed-size binary record of a trace message.
+ *
+ * Record keeps severity, pointer to format string (it must have static storage
+ * duration, as all messages of ntp do) and raw bytes of arguments. C-string arguments
+ * are copied into record (and truncated, if they do not fit). Formatting is deferred
+ * until ntp::logger::details::LogRecord::Format is called, it is performed by
+ * a function instantiated for exact types of arguments.
+ */
+class alignas(ntp::details::kCacheLine) LogRecord final
+{
+public:
+    /**
+     * @brief Size of record.
+     */
+    static constexpr std::size_t kSize = 256;
+
+    /**
+     * @brief Size of storage for arguments.
+     */
+    static constexpr std::size_t kPayloadSize = kSize - 3 * sizeof(void*);
+
+    /**
+     * @brief Type of function, that formats record.
+     */
+    using formatter_t = std::wstring (*)(const LogRecord& record);
+
+public:
+    LogRecord() noexcept = default;
+
+    /**
+     * @brief Stores a message into record.
+     *
+     * @param severity Message severity
+     * @param format Format of the message (must outlive record)
+     * @param args Arguments to embed into formatted message (trivially copyable types or C-strings)
+     */
+    template<typename Char, typename... Args>
+    void Encode(Severity severity, const Char* format, const Args&... args) noexcept
+    {
+        static_assert(((is_string_argument_v<stored_argument_t<Args>> || std::is_trivially_copyable_v<stored_argument_t<Args>>) && ...),
+            "[ntp::logger::details::LogRecord::Encode]: arguments must be trivially copyable or C-strings");
+
+        formatter_ = &FormatAs<Char, stored_argument_t<Args>...>;
+        format_    = format;
+        severity_  = severity;
+        size_      = 0;
+
+        (Write<stored_argument_t<Args>>(args), ...);
+    }
+
+    /**
+     * @brief Get message severity.
+     */
+    Severity GetSeverity() const noexcept { return severity_; }
+
+    /**
+     * @brief Formats stored message.
+     *
+     * @returns formatted message (narrow messages are converted with ntp::details::Convert)
+     */
+    std::wstring Format() const { return formatter_(*this); }
+
+private:
+    static constexpr std::size_t Align(std::size_t offset, std::size_t alignment) noexcept
+    {
+        return (offset + alignment - 1) & ~(alignment - 1);
+    }
+
+    template<typename Ty>
+    void Write(const Ty& value) noexcept
+    {
+        if constexpr (is_string_argument_v<Ty>)
+        {
+            using char_t = std::remove_const_t<std::remove_pointer_t<Ty>>;
+
+            const auto offset = Align(size_, alignof(char_t));
+            if (offset + sizeof(char_t) > kPayloadSize)
+            {
+                return;
+            }
+
+            const auto capacity = (kPayloadSize - offset) / sizeof(char_t) - 1;
+            const auto length   = value ? (std::min)(std::char_traits<char_t>::length(value), capacity) : 0;
+            const auto target   = reinterpret_cast<char_t*>(payload_.data() + offset);
+
+            std::memcpy(target, value, length * sizeof(char_t));
+            target[length] = char_t();
+
+            size_ = static_cast<std::uint16_t>(offset + (length + 1) * sizeof(char_t));
+        }
+        else
+        {
+            const auto offset = Align(size_, alignof(Ty));
+            if (offset + sizeof(Ty) > kPayloadSize)
+            {
+                return;
+            }
+
+            std::memcpy(payload_.data() + offset, &value, sizeof(Ty));
+            size_ = static_cast<std::uint16_t>(offset + sizeof(Ty));
+        }
+    }
+
+    template<typename Ty>
+    Ty Read(std::size_t& position) const noexcept
+    {
+        //
+        // Mirrors Write: arguments, that did not fit, are read as empty values
+        //
+
+        if constexpr (is_string_argument_v<Ty>)
+        {
+            using char_t = std::remove_const_t<std::remove_pointer_t<Ty>>;
+
+            static constexpr char_t empty[] = { char_t() };
+
+            const auto offset = Align(position, alignof(char_t));
+            if (offset + sizeof(char_t) > kPayloadSize)
+            {
+                return empty;
+            }
+
+            const auto value = reinterpret_cast<const char_t*>(payload_.data() + offset);
+            position         = offset + (std::char_traits<char_t>::length(value) + 1) * sizeof(char_t);
+
+            return value;
+        }
+        else
+        {
+            Ty value {};
+
+            const auto offset = Align(position, alignof(Ty));
+            if (offset + sizeof(Ty) > kPayloadSize)
+            {
+                return value;
+            }
+
+            std::memcpy(&value, payload_.data() + offset, sizeof(Ty));
+            position = offset + sizeof(Ty);
+
+            return value;
+        }
+    }
+
+    template<typename Char, typename... Args>
+    static std::wstring FormatAs(const LogRecord& record)
+    {
+        //
+        // Braced initialization guarantees left-to-right order of reads
+        //
+
+        [[maybe_unused]] std::size_t position = 0;
+        const std::tuple<Args...> arguments { record.Read<Args>(position)... };
+
+        return std::apply([&record](const auto&... unpacked) {
+            const DWORD format_flags = FORMAT_MESSAGE_FROM_STRING;
+            auto formatted           = ntp::details::FormatMessage(format_flags, static_cast<const Char*>(record.format_), 0, unpacked...);
+
+            if constexpr (std::is_same_v<Char, char>)
+            {
+                return ntp::details::Convert(formatted);
+            }
+            else
+            {
+                return formatted;
+            }
+        }, arguments);
+    }
+
+private:
+    // Function, that formats record
+    formatter_t formatter_ = nullptr;
+
+    // Format of the message
+    const void* format_ = nullptr;
+
+    // Message severity and number of used bytes of payload
+    Severity severity_  = Severity::kExtended;
+    std::uint16_t size_ = 0;
+
+    // Raw arguments
+    alignas(sizeof(void*)) std::array<unsigned char, kPayloadSize> payload_ {};
+};
+
+static_assert(sizeof(LogRecord) == LogRecord::kSize,
+    "[ntp::logger::details::LogRecord]: unexpected size of record");
+
+
+/**
+ * @brief Bounded lock-free single-producer single-consumer ring of log records.
+ *
+ * Producer encodes records right in the ring, consumer formats them right in the ring,
+ * hence neither side copies records or allocates memory.
+ */
+class RecordRing final
+{
+    RecordRing(const RecordRing&)            = delete;
+    RecordRing& operator=(const RecordRing&) = delete;
+
+public:
+    /**
+     * @brief Number of records in ring (power of 2).
+     */
+    static constexpr std::size_t kCapacity = 128;
+
+    static_assert((kCapacity & (kCapacity - 1)) == 0,
+        "[ntp::logger::details::RecordRing]: capacity must be a power of 2");
+
+public:
+    RecordRing() noexcept = default;
+
+    /**
+     * @brief Stores a message into ring. Must be called by the producer only.
+     *
+     * @returns false if ring is full
+     */
+    template<typename Char, typename... Args>
+    bool TryPush(Severity severity, const Char* format, const Args&... args) noexcept
+    {
+        const auto tail = tail_.load(std::memory_order_relaxed);
+
+        if (tail - cached_head_ >= kCapacity)
+        {
+            cached_head_ = head_.load(std::memory_order_acquire);
+
+            if (tail - cached_head_ >= kCapacity)
+            {
+                return false;
+            }
+        }
+
+        records_[tail & (kCapacity - 1)].Encode(severity, format, args...);
+        tail_.store(tail + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    /**
+     * @brief Passes all stored records to a consumer. Must be called by the consumer only.
+     *
+     * @param consumer Callable, that accepts `const LogRecord&`
+     * @returns number of consumed records
+     */
+    template<typename Consumer>
+    std::size_t Drain(Consumer&& consumer) noexcept(noexcept(consumer(std::declval<const LogRecord&>())))
+    {
+        const auto head = head_.load(std::memory_order_relaxed);
+        const auto tail = tail_.load(std::memory_order_acquire);
+
+        for (auto current = head; current != tail; ++current)
+        {
+            consumer(records_[current & (kCapacity - 1)]);
+            head_.store(current + 1, std::memory_order_release);
+        }
+
+        return tail - head;
+    }
+
+    /**
+     * @brief Approximate number of stored records.
+     */
+    std::size_t Size() const noexcept
+    {
+        return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Checks if ring is empty.
+     */
+    bool Empty() const noexcept { return 0 == Size(); }
+
+    /**
+     * @brief Marks ring as abandoned by producer (e.g. producing thread exits).
+     *        Consumer may destroy ring after it drains remaining records.
+     */
+    void Abandon() noexcept { abandoned_.store(true, std::memory_order_release); }
+
+    /**
+     * @brief Checks if ring is abandoned by producer.
+     */
+    bool Abandoned() const noexcept { return abandoned_.load(std::memory_order_acquire); }
+
+private:
+    // Index of the next record to consume (written by consumer)
+    alignas(ntp::details::kCacheLine) std::atomic<std::size_t> head_ { 0 };
+
+    // Index of the next record to produce and the last observed head (producer's side)
+    alignas(ntp::details::kCacheLine) std::atomic<std::size_t> tail_ { 0 };
+    std::size_t cached_head_ = 0;
+
+    // Is ring abandoned by producer
+    std::atomic<bool> abandoned_ { false };
+
+    // Records
+    std::array<LogRecord, kCapacity> records_;
+};
+
+}  // namespace ntp::logger::details
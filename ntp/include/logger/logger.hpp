@@ -29,6 +29,16 @@ enum class Severity : unsigned char
 using logger_t = void (*)(Severity severity, const wchar_t* message);
 
 
+/**
+ * @brief Mode of message delivery
+ */
+enum class Mode : unsigned char
+{
+    kSynchronous  = 0, /**< Messages are formatted and delivered by the tracing thread */
+    kAsynchronous = 1  /**< Messages are queued as binary records and formatted and delivered by a background thread */
+};
+
+
 /**
  * @brief Replaces a logger function
  * 
@@ -37,4 +47,43 @@ using logger_t = void (*)(Severity severity, const wchar_t* message);
  */
 logger_t SetLogger(logger_t new_logger);
 
+
+/**
+ * @brief Sets minimum severity of messages, that are passed to logger function
+ *        (ntp::logger::Severity::kExtended by default, i.e. all messages).
+ *
+ * Messages with lower severity are dropped before formatting. Messages below
+ * NTP_MIN_LOG_SEVERITY (refer to ntp_config.hpp) are never traced regardless
+ * of this threshold.
+ *
+ * @param severity New minimum severity
+ * @returns previous minimum severity
+ */
+Severity SetMinSeverity(Severity severity) noexcept;
+
+
+/**
+ * @brief Sets mode of message delivery (synchronous by default).
+ *
+ * In asynchronous mode tracing threads (e.g. threadpool workers) only copy
+ * arguments into a per-thread lock-free ring, logger function is called by
+ * a background thread. Messages of the same thread are delivered in order.
+ * If a ring is full, message is delivered synchronously. String arguments
+ * longer than about 200 bytes are truncated.
+ *
+ * Switching to synchronous mode flushes queued messages.
+ *
+ * @param mode New mode
+ * @returns previous mode
+ * @throws exception::Win32Exception if background thread cannot be started
+ */
+Mode SetMode(Mode mode);
+
+
+/**
+ * @brief Waits until messages queued before the call are delivered.
+ *        Must not be called from logger function.
+ */
+void Flush();
+
 }  // namespace ntp::logger
@@ -10,20 +10,32 @@
 #include "details/utils.hpp"
 #include "details/windows.hpp"
 #include "logger/logger.hpp"
+#include "logger/async_logger.hpp"
+#include "ntp_config.hpp"
 
 
 namespace ntp::logger::details {
 
+/**
+ * @brief Minimum severity of messages, that are compiled in (refer to NTP_MIN_LOG_SEVERITY).
+ */
+inline constexpr auto kMinCompiledSeverity = static_cast<Severity>(NTP_MIN_LOG_SEVERITY);
+
+
 /**
  * @brief Internal logger class. Implemented as singleton.
  * 
  * By default internal logger function is not defined (set to NULL),
- * hence logger ignores any messages.
+ * hence logger ignores any messages. In asynchronous mode messages are
+ * formatted and delivered by ntp::logger::details::AsyncLogger.
+ *
+ * Messages with severity lower than a threshold are dropped before formatting.
  */
 class Logger final
 {
     explicit Logger() noexcept
         : logger_(nullptr)
+        , min_severity_(Severity::kExtended)
     { }
 
 public:
@@ -53,6 +65,35 @@ public:
         return logger_.exchange(new_logger, std::memory_order_acq_rel);
     }
 
+    /**
+     * @brief Get currently installed logger function
+     */
+    logger_t Current() const noexcept
+    {
+        return logger_.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Replaces minimum severity of traced messages
+     *
+     * @param severity New minimum severity
+     * @returns Previous minimum severity
+     */
+    Severity ExchangeMinSeverity(Severity severity) noexcept
+    {
+        return min_severity_.exchange(severity, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Checks if a message of given severity is traced
+     *
+     * Check against NTP_MIN_LOG_SEVERITY is performed at compile time, if severity is a constant.
+     */
+    bool Enabled(Severity severity) const noexcept
+    {
+        return severity >= kMinCompiledSeverity && severity >= min_severity_.load(std::memory_order_relaxed);
+    }
+
     /**
      * @brief Formats message and forwards formatted message to internal logger function
      * 
@@ -64,8 +105,18 @@ public:
     template<typename... Args>
     void TraceMessage(Severity severity, const wchar_t* message, Args&&... args) const noexcept
     {
+        if (!Enabled(severity))
+        {
+            return;
+        }
+
         if (const auto logger = logger_.load(std::memory_order_acquire); logger)
         {
+            if (auto& async = AsyncLogger::Instance(); async.Enabled() && async.Push(severity, message, args...))
+            {
+                return;
+            }
+
             const DWORD format_flags = FORMAT_MESSAGE_FROM_STRING;
             const auto formatted     = ntp::details::FormatMessage(format_flags, message, 0, std::forward<Args>(args)...);
 
@@ -86,8 +137,18 @@ public:
     template<typename... Args>
     void TraceMessage(Severity severity, const char* message, Args&&... args) const noexcept
     {
+        if (!Enabled(severity))
+        {
+            return;
+        }
+
         if (const auto logger = logger_.load(std::memory_order_acquire); logger)
         {
+            if (auto& async = AsyncLogger::Instance(); async.Enabled() && async.Push(severity, message, args...))
+            {
+                return;
+            }
+
             const DWORD format_flags = FORMAT_MESSAGE_FROM_STRING;
             const auto formatted     = ntp::details::FormatMessage(format_flags, message, 0, std::forward<Args>(args)...);
             const auto converted     = ntp::details::Convert(formatted);
@@ -99,6 +160,9 @@ public:
 private:
     // Pointer to logger is atomic to prevent races
     std::atomic<logger_t> logger_;
+
+    // Messages with lower severity are dropped
+    std::atomic<Severity> min_severity_;
 };
 
 }  // namespace ntp::logger::details
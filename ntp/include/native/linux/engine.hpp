@@ -0,0 +1,534 @@
+/**
+ * @file engine.hpp
+ * @brief ntp native engine for Linux
+ *
+ * Engine consists of the following parts:
+ * - Pool: worker threads, that are parked on a futex-based semaphore while
+ *   there is no queued callbacks.
+ * - Object: base class for all threadpool objects (work, wait, timer, IO),
+ *   that tracks pending and running callbacks.
+ * - CleanupGroup: container of objects, that may be closed at once.
+ * - Reactor: single thread per pool, that multiplexes wait objects and timers
+ *   with epoll. All timers are driven by one timerfd, timers with tolerance
+ *   (window length) are coalesced.
+ * - Ring: io_uring instance per pool for asynchronous IO (refer to uring.hpp).
+ */
+
+#pragma once
+
+#include <mutex>
+#include <deque>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <cstdint>
+#include <unordered_map>
+#include <condition_variable>
+
+#include "native/linux/windows.h"
+#include "details/coalescing.hpp"
+
+
+namespace ntp::native {
+
+/**
+ * @brief Clock used by engine for all deadlines (CLOCK_MONOTONIC).
+ */
+using clock_t = std::chrono::steady_clock;
+
+/**
+ * @brief Point in time on engine's clock.
+ */
+using time_point_t = clock_t::time_point;
+
+
+class Pool;
+class Ring;
+class CleanupGroup;
+
+
+/**
+ * @brief Lightweight counting semaphore, that parks waiting threads on a futex.
+ */
+class Semaphore final
+{
+    Semaphore(const Semaphore&)            = delete;
+    Semaphore& operator=(const Semaphore&) = delete;
+
+public:
+    explicit Semaphore() noexcept = default;
+
+    /**
+     * @brief Increments semaphore count and wakes up to count waiting threads.
+     *
+     * @param count Number of permits to add
+     */
+    void Post(std::int32_t count = 1) noexcept;
+
+    /**
+     * @brief Waits until a permit is available and takes it.
+     */
+    void Wait() noexcept;
+
+    /**
+     * @brief Waits until a permit is available or timeout elapses.
+     *
+     * @param timeout Maximum time to wait
+     * @returns true if permit is taken, false in case of timeout
+     */
+    bool WaitFor(std::chrono::nanoseconds timeout) noexcept;
+
+private:
+    bool TryTake() noexcept;
+
+private:
+    // Number of available permits (never negative)
+    std::atomic<std::int32_t> count_ { 0 };
+
+    // Number of threads, that are going to sleep or sleeping on futex
+    std::atomic<std::int32_t> waiters_ { 0 };
+};
+
+
+/**
+ * @brief Kind-specific parameters of a queued callback.
+ */
+struct Payload
+{
+    PVOID overlapped; /**< OVERLAPPED pointer of completed IO operation */
+
+    ULONG result; /**< Wait result or IO operation result */
+
+    ULONG_PTR bytes_transferred; /**< Number of bytes transferred by IO operation */
+};
+
+
+class Object;
+
+
+/**
+ * @brief Queued callback.
+ */
+struct Task
+{
+    Object* object; /**< Object, which callback is queued (task owns a reference) */
+
+    std::uint64_t generation; /**< Cancellation generation of the object at submission time */
+
+    Payload payload; /**< Callback parameters */
+};
+
+
+/**
+ * @brief Base class for all threadpool objects.
+ *
+ * Object is reference counted: handle returned to user owns one reference and
+ * each queued task owns another one. Object tracks number of queued (pending)
+ * and running callbacks, that allows to wait for callbacks and cancel them.
+ */
+class Object
+{
+    Object(const Object&)            = delete;
+    Object& operator=(const Object&) = delete;
+
+    friend class CleanupGroup;
+
+public:
+    /**
+     * @brief Constructor, that binds object with a pool and cleanup group from the environment.
+     *
+     * @param environment Callback environment (may be NULL)
+     * @param context User-defined context passed to callback
+     */
+    explicit Object(PTP_CALLBACK_ENVIRON environment, PVOID context) noexcept;
+
+    /**
+     * @brief Constructor, that binds object with the specified pool without cleanup group.
+     *
+     * @param pool Owning pool
+     * @param context User-defined context passed to callback
+     */
+    explicit Object(Pool& pool, PVOID context) noexcept;
+
+    virtual ~Object() = default;
+
+    void AddRef() noexcept;
+    void Release() noexcept;
+
+    /**
+     * @brief Queues a callback of the object into its pool.
+     *
+     * @param payload Callback parameters
+     */
+    void Submit(const Payload& payload = {}) noexcept;
+
+    /**
+     * @brief Executes queued callback (called by workers only). Releases task's reference.
+     *
+     * @param task Task to execute
+     */
+    void Execute(const Task& task) noexcept;
+
+    /**
+     * @brief Waits for running callbacks and optionally cancels queued ones.
+     *
+     * @param cancel If true, queued callbacks are cancelled, otherwise they are awaited too
+     */
+    void WaitCallbacks(bool cancel) noexcept;
+
+    /**
+     * @brief Removes object from its cleanup group and releases user's reference.
+     *        Stops further callbacks generation, but does not wait for callbacks.
+     */
+    void Close() noexcept;
+
+    /**
+     * @brief Marks running callback as completed (used by DisassociateCurrentThreadFromCallback).
+     */
+    void EndCallback() noexcept;
+
+    /**
+     * @brief Get owning pool.
+     */
+    Pool& OwningPool() const noexcept { return pool_; }
+
+protected:
+    /**
+     * @brief Invokes user-defined callback.
+     */
+    virtual void Invoke(PTP_CALLBACK_INSTANCE instance, const Payload& payload) noexcept = 0;
+
+    /**
+     * @brief Stops generation of new callbacks (e.g. unregisters wait or timer).
+     *        Called once, when object is closed.
+     */
+    virtual void Shutdown() noexcept { }
+
+    /**
+     * @brief Get user-defined context.
+     */
+    PVOID Context() const noexcept { return context_; }
+
+private:
+    // Owning pool and cleanup group
+    Pool& pool_;
+    CleanupGroup* group_;
+
+    // User-defined context
+    PVOID context_;
+
+    // References count
+    std::atomic<std::uint32_t> references_;
+
+    // State of callbacks
+    std::mutex lock_;
+    std::condition_variable idle_;
+    std::uint64_t generation_;
+    std::uint32_t pending_;
+    std::uint32_t running_;
+
+    // Links in cleanup group (protected by group's lock)
+    Object* previous_;
+    Object* next_;
+    bool member_;
+};
+
+
+/**
+ * @brief Container of objects, that can be closed at once.
+ */
+class CleanupGroup
+{
+    CleanupGroup(const CleanupGroup&)            = delete;
+    CleanupGroup& operator=(const CleanupGroup&) = delete;
+
+public:
+    explicit CleanupGroup() noexcept = default;
+
+    void Add(Object* object) noexcept;
+
+    /**
+     * @brief Removes object from the group.
+     *
+     * @returns true if object was a member of the group
+     */
+    bool Remove(Object* object) noexcept;
+
+    /**
+     * @brief Closes all members, waiting for their callbacks.
+     *
+     * @param cancel If true, queued callbacks are cancelled
+     */
+    void CloseMembers(bool cancel) noexcept;
+
+private:
+    std::mutex lock_;
+    Object* head_ = nullptr;
+};
+
+
+/**
+ * @brief Reactor's registration of a timer or a wait object.
+ *
+ * All fields are protected by reactor's lock.
+ */
+struct ReactorEntry
+{
+    using deadlines_t = ntp::details::CoalescingQueue<time_point_t, ReactorEntry*>;
+
+    Object* owner; /**< Object to submit callback of */
+
+    bool scheduled = false; /**< Is deadline set */
+
+    deadlines_t::handle_t deadline; /**< Position in reactor's deadlines */
+
+    std::chrono::nanoseconds period {}; /**< Timer period (0 for one-shot timers and waits) */
+
+    std::chrono::nanoseconds window {}; /**< Tolerable delay of timer expiration (0 for waits) */
+
+    HANDLE handle = nullptr; /**< Handle to wait for (waits only) */
+
+    int descriptor = -1; /**< Duplicate of handle registered in epoll */
+
+    std::uint64_t watch_id = 0; /**< Current epoll registration identifier (0 if not watched) */
+};
+
+
+/**
+ * @brief Thread that drives timers and waits of a pool.
+ *
+ * All deadlines are stored in an ordered container and the nearest one
+ * is programmed into a single timerfd. Waits are registered in epoll as
+ * one-shot duplicated descriptors.
+ */
+class Reactor final
+{
+    Reactor(const Reactor&)            = delete;
+    Reactor& operator=(const Reactor&) = delete;
+
+public:
+    explicit Reactor();
+    ~Reactor();
+
+    /**
+     * @brief Sets or cancels a timer.
+     *
+     * @param entry Timer's registration
+     * @param due Time of the first expiration (NULL to cancel timer)
+     * @param period Timer period (zero for one-shot timers)
+     * @param window Tolerable delay of each expiration
+     * @returns true if timer was set before the call
+     */
+    bool SetTimer(ReactorEntry& entry, const time_point_t* due, std::chrono::nanoseconds period,
+        std::chrono::nanoseconds window = {}) noexcept;
+
+    /**
+     * @brief Checks if a timer is set.
+     */
+    bool IsTimerSet(const ReactorEntry& entry) noexcept;
+
+    /**
+     * @brief Sets or cancels a wait.
+     *
+     * @param entry Wait's registration
+     * @param handle Handle to wait for (NULL to cancel wait)
+     * @param deadline Wait timeout (NULL for infinite wait)
+     * @returns true if wait was set before the call
+     */
+    bool SetWait(ReactorEntry& entry, HANDLE handle, const time_point_t* deadline) noexcept;
+
+    /**
+     * @brief Sets or cancels several waits at once (reactor is locked only once).
+     *
+     * @param entries Registrations of waits
+     * @param handles Handles to wait for, one per entry (NULL to cancel all waits)
+     * @param count Number of waits
+     * @param deadline Timeout of all waits (NULL for infinite wait)
+     */
+    void SetWaits(ReactorEntry* const* entries, const HANDLE* handles, std::size_t count, const time_point_t* deadline) noexcept;
+
+private:
+    void Routine() noexcept;
+
+    bool SetWaitLocked(ReactorEntry& entry, HANDLE handle, const time_point_t* deadline) noexcept;
+
+    void Schedule(ReactorEntry& entry, time_point_t deadline) noexcept;
+    void Unschedule(ReactorEntry& entry) noexcept;
+
+    bool Watch(ReactorEntry& entry, HANDLE handle) noexcept;
+    void Unwatch(ReactorEntry& entry) noexcept;
+
+    void OnSignaled(std::uint64_t watch_id) noexcept;
+    void OnDeadlines(time_point_t now) noexcept;
+
+    void ProgramTimer() noexcept;
+
+private:
+    std::mutex lock_;
+
+    // Epoll descriptor, timerfd for deadlines and eventfd for shutdown
+    int epoll_;
+    int timer_;
+    int wakeup_;
+
+    // Deadlines of timers and waits (timers with tolerance are coalesced)
+    ReactorEntry::deadlines_t deadlines_;
+
+    // Time, that is programmed into timerfd (max if disarmed)
+    time_point_t programmed_;
+
+    // Currently watched waits
+    std::unordered_map<std::uint64_t, ReactorEntry*> watches_;
+    std::uint64_t next_watch_id_;
+
+    bool stop_;
+    std::thread thread_;
+};
+
+
+/**
+ * @brief Pool of worker threads.
+ *
+ * New workers are spawned on demand, while number of queued callbacks exceeds
+ * number of idle workers. Workers above minimum exit after some idle time.
+ */
+class Pool
+{
+    Pool(const Pool&)            = delete;
+    Pool& operator=(const Pool&) = delete;
+
+public:
+    /**
+     * @brief Constructor.
+     *
+     * @param minimum Minimum number of threads
+     * @param maximum Maximum number of threads
+     */
+    explicit Pool(std::uint32_t minimum, std::uint32_t maximum) noexcept;
+
+    /**
+     * @brief Stops all workers and waits for them to exit. Queued callbacks are executed.
+     */
+    ~Pool();
+
+    /**
+     * @brief Process-wide default pool.
+     */
+    static Pool& Default() noexcept;
+
+    /**
+     * @brief Get pool associated with environment (default pool if environment does not specify one).
+     */
+    static Pool& FromEnvironment(PTP_CALLBACK_ENVIRON environment) noexcept;
+
+    /**
+     * @brief Default maximum number of threads.
+     */
+    static std::uint32_t DefaultMaximum() noexcept;
+
+    bool SetMinimum(std::uint32_t minimum) noexcept;
+    void SetMaximum(std::uint32_t maximum) noexcept;
+
+    /**
+     * @brief Queues a task and wakes up a worker.
+     */
+    void Enqueue(const Task& task) noexcept;
+
+    /**
+     * @brief Spawns a new worker if there is no idle ones.
+     *
+     * @returns true if pool has a worker to handle further callbacks
+     */
+    bool MayRunLong() noexcept;
+
+    /**
+     * @brief Get pool's reactor (created at first call).
+     */
+    Reactor& GetReactor() noexcept;
+
+    /**
+     * @brief Get pool's io_uring instance (created at first call).
+     *
+     * @returns ring or NULL if io_uring is not available
+     */
+    Ring* GetRing() noexcept;
+
+private:
+    void SpawnWorker() noexcept;
+    void WorkerRoutine() noexcept;
+
+private:
+    std::mutex lock_;
+    std::condition_variable exited_;
+
+    // Queued tasks and semaphore with one permit per task
+    std::deque<Task> tasks_;
+    Semaphore semaphore_;
+
+    // Threads accounting
+    std::atomic<std::uint32_t> idle_;
+    std::uint32_t threads_;
+    std::uint32_t minimum_;
+    std::uint32_t maximum_;
+    bool stop_;
+
+    std::once_flag reactor_created_;
+    std::unique_ptr<Reactor> reactor_;
+
+    std::once_flag ring_created_;
+    std::unique_ptr<Ring> ring_;
+};
+
+
+/**
+ * @brief Performs wait-related side effects of a signaled object.
+ *
+ * Auto-reset events are reset here. If another waiter has already consumed
+ * the signal, function returns false.
+ *
+ * @param object Handle to the signaled object
+ * @returns true if object is still signaled
+ */
+bool TryAcquire(HANDLE object) noexcept;
+
+
+/**
+ * @brief Converts FILETIME into a deadline on engine's clock.
+ *
+ * Negative values represent relative time, positive -- absolute UTC time.
+ */
+time_point_t DeadlineFromFileTime(const FILETIME& time) noexcept;
+
+}  // namespace ntp::native
+
+
+/**
+ * @brief Callback instance. Lives on worker's stack while callback is running.
+ */
+struct _TP_CALLBACK_INSTANCE
+{
+    ntp::native::Object* object; /**< Object, which callback is running */
+
+    bool associated; /**< Is callback still associated with object */
+
+    HANDLE event; /**< Event to set, when callback returns */
+};
+
+
+/**
+ * @brief Pool object (PTP_POOL).
+ */
+struct _TP_POOL final
+    : public ntp::native::Pool
+{
+    using Pool::Pool;
+};
+
+
+/**
+ * @brief Cleanup group object (PTP_CLEANUP_GROUP).
+ */
+struct _TP_CLEANUP_GROUP final
+    : public ntp::native::CleanupGroup
+{ };
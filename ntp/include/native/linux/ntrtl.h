@@ -0,0 +1,65 @@
+/**
+ * @file ntrtl.h
+ * @brief Linux implementation of internal windows objects and functions, that are used by ntp
+ */
+
+#pragma once
+
+#include <pthread.h>
+
+#include "native/linux/windows.h"
+
+
+/**
+ * @brief RTL read/write lock structure (implemented with pthread_rwlock_t).
+ *
+ * Unlike Windows version, this lock cannot be acquired recursively.
+ */
+typedef struct _RTL_RESOURCE
+{
+    pthread_rwlock_t Lock;
+} RTL_RESOURCE, *PRTL_RESOURCE;
+
+
+/**
+ * @brief Initializes a read/write lock structure.
+ *
+ * @param pResource A pointer to the caller allocated structure to initialize
+ */
+VOID NTAPI RtlInitializeResource(PRTL_RESOURCE pResource) noexcept;
+
+
+/**
+ * @brief Deallocates and frees the contents of a read/write lock.
+ *
+ * @param pResource A pointer to the resource object to delete
+ */
+VOID NTAPI RtlDeleteResource(PRTL_RESOURCE pResource) noexcept;
+
+
+/**
+ * @brief Acquires a read/write for shared access, optionally waiting until access can be granted.
+ *
+ * @param pResource A pointer to the resource object to acquire for shared access
+ * @param bWait Boolean value specifying whether the function can wait for access to be granted
+ * @returns Nonzero if shared access was granted, zero if not
+ */
+BOOLEAN NTAPI RtlAcquireResourceShared(PRTL_RESOURCE pResource, BOOLEAN bWait) noexcept;
+
+
+/**
+ * @brief Acquires a read/write for exclusive access, optionally waiting until access can be granted.
+ *
+ * @param pResource A pointer to the resource object to exclusively acquire
+ * @param bWait Boolean value specifying whether the function can wait for access to be granted
+ * @returns Nonzero if exclusive access was granted, zero if not
+ */
+BOOLEAN NTAPI RtlAcquireResourceExclusive(PRTL_RESOURCE pResource, BOOLEAN bWait) noexcept;
+
+
+/**
+ * @brief Releases a reference to the lock made by the RtlAcquireResource functions.
+ *
+ * @param pResource A pointer to the resource to release
+ */
+VOID NTAPI RtlReleaseResource(PRTL_RESOURCE pResource) noexcept;
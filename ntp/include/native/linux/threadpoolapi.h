@@ -0,0 +1,267 @@
+/**
+ * @file threadpoolapi.h
+ * @brief Subset of Windows Threadpool API, that is used by ntp, implemented for Linux
+ *
+ * All functions are implemented on top of ntp native engine: futex-parked worker
+ * threads and a reactor thread, that multiplexes wait objects (eventfd, pidfd or any
+ * other pollable descriptor) and timers (single timerfd) with epoll.
+ *
+ * Semantics follow the original API as close as possible:
+ * https://learn.microsoft.com/en-us/windows/win32/procthread/thread-pool-api
+ */
+
+#pragma once
+
+#include "native/linux/windows.h"
+
+
+//
+// Opaque threadpool objects
+//
+
+typedef struct _TP_POOL TP_POOL, *PTP_POOL;
+typedef struct _TP_CLEANUP_GROUP TP_CLEANUP_GROUP, *PTP_CLEANUP_GROUP;
+typedef struct _TP_CALLBACK_INSTANCE TP_CALLBACK_INSTANCE, *PTP_CALLBACK_INSTANCE;
+typedef struct _TP_WORK TP_WORK, *PTP_WORK;
+typedef struct _TP_WAIT TP_WAIT, *PTP_WAIT;
+typedef struct _TP_TIMER TP_TIMER, *PTP_TIMER;
+typedef struct _TP_IO TP_IO, *PTP_IO;
+
+typedef DWORD TP_VERSION, *PTP_VERSION;
+typedef DWORD TP_WAIT_RESULT;
+
+
+//
+// Callback types
+//
+
+typedef VOID (CALLBACK* PTP_SIMPLE_CALLBACK)(PTP_CALLBACK_INSTANCE instance, PVOID context);
+
+typedef VOID (CALLBACK* PTP_CLEANUP_GROUP_CANCEL_CALLBACK)(PVOID object_context, PVOID cleanup_context);
+
+typedef VOID (CALLBACK* PTP_WORK_CALLBACK)(PTP_CALLBACK_INSTANCE instance, PVOID context, PTP_WORK work);
+
+typedef VOID (CALLBACK* PTP_WAIT_CALLBACK)(PTP_CALLBACK_INSTANCE instance, PVOID context, PTP_WAIT wait,
+    TP_WAIT_RESULT wait_result);
+
+typedef VOID (CALLBACK* PTP_TIMER_CALLBACK)(PTP_CALLBACK_INSTANCE instance, PVOID context, PTP_TIMER timer);
+
+typedef VOID (CALLBACK* PTP_WIN32_IO_CALLBACK)(PTP_CALLBACK_INSTANCE instance, PVOID context, PVOID overlapped,
+    ULONG io_result, ULONG_PTR bytes_transferred, PTP_IO io);
+
+
+/**
+ * @brief Callback environment. Binds threadpool objects with a pool and a cleanup group.
+ */
+typedef struct _TP_CALLBACK_ENVIRON_V3
+{
+    TP_VERSION Version;
+    PTP_POOL Pool;
+    PTP_CLEANUP_GROUP CleanupGroup;
+    PTP_CLEANUP_GROUP_CANCEL_CALLBACK CleanupGroupCancelCallback;
+    DWORD Size;
+} TP_CALLBACK_ENVIRON_V3, TP_CALLBACK_ENVIRON, *PTP_CALLBACK_ENVIRON;
+
+
+//
+// Callback environment
+//
+
+/**
+ * @brief Initializes a callback environment (NULL pool means process-wide default pool).
+ */
+inline VOID InitializeThreadpoolEnvironment(PTP_CALLBACK_ENVIRON environment) noexcept
+{
+    *environment         = TP_CALLBACK_ENVIRON {};
+    environment->Version = 3;
+    environment->Size    = sizeof(TP_CALLBACK_ENVIRON);
+}
+
+/**
+ * @brief Deletes the specified callback environment. Does nothing.
+ */
+inline VOID DestroyThreadpoolEnvironment(PTP_CALLBACK_ENVIRON /* environment */) noexcept
+{ }
+
+/**
+ * @brief Sets the thread pool to be used when generating callbacks.
+ */
+inline VOID SetThreadpoolCallbackPool(PTP_CALLBACK_ENVIRON environment, PTP_POOL pool) noexcept
+{
+    environment->Pool = pool;
+}
+
+/**
+ * @brief Associates the specified cleanup group with the specified callback environment.
+ */
+inline VOID SetThreadpoolCallbackCleanupGroup(PTP_CALLBACK_ENVIRON environment, PTP_CLEANUP_GROUP cleanup_group,
+    PTP_CLEANUP_GROUP_CANCEL_CALLBACK cancel_callback) noexcept
+{
+    environment->CleanupGroup               = cleanup_group;
+    environment->CleanupGroupCancelCallback = cancel_callback;
+}
+
+
+//
+// Pools
+//
+
+/**
+ * @brief Allocates a new pool of threads to execute callbacks.
+ */
+PTP_POOL CreateThreadpool(PVOID reserved) noexcept;
+
+/**
+ * @brief Closes the specified thread pool. Waits for worker threads to exit.
+ */
+VOID CloseThreadpool(PTP_POOL pool) noexcept;
+
+/**
+ * @brief Sets the minimum number of threads that the specified thread pool must make available.
+ */
+BOOL SetThreadpoolThreadMinimum(PTP_POOL pool, DWORD minimum) noexcept;
+
+/**
+ * @brief Sets the maximum number of threads that the specified thread pool can allocate.
+ */
+VOID SetThreadpoolThreadMaximum(PTP_POOL pool, DWORD maximum) noexcept;
+
+
+//
+// Cleanup groups
+//
+
+/**
+ * @brief Creates a cleanup group that applications can use to track one or more thread pool callbacks.
+ */
+PTP_CLEANUP_GROUP CreateThreadpoolCleanupGroup() noexcept;
+
+/**
+ * @brief Closes the specified cleanup group.
+ */
+VOID CloseThreadpoolCleanupGroup(PTP_CLEANUP_GROUP cleanup_group) noexcept;
+
+/**
+ * @brief Releases the members of the specified cleanup group, waits for all callback
+ *        functions to complete, and optionally cancels any outstanding callback functions.
+ */
+VOID CloseThreadpoolCleanupGroupMembers(PTP_CLEANUP_GROUP cleanup_group, BOOL cancel_pending_callbacks,
+    PVOID cleanup_context) noexcept;
+
+
+//
+// Callback instance
+//
+
+/**
+ * @brief Requests that the thread pool call the specified callback function on a worker thread.
+ */
+BOOL TrySubmitThreadpoolCallback(PTP_SIMPLE_CALLBACK callback, PVOID context, PTP_CALLBACK_ENVIRON environment) noexcept;
+
+/**
+ * @brief Indicates that the callback may not return quickly. Spawns a new worker if possible.
+ */
+BOOL CallbackMayRunLong(PTP_CALLBACK_INSTANCE instance) noexcept;
+
+/**
+ * @brief Removes the association between the currently executing callback function
+ *        and the object that initiated the callback.
+ */
+VOID DisassociateCurrentThreadFromCallback(PTP_CALLBACK_INSTANCE instance) noexcept;
+
+/**
+ * @brief Specifies the event that the thread pool must set when the current callback function completes.
+ */
+VOID SetEventWhenCallbackReturns(PTP_CALLBACK_INSTANCE instance, HANDLE event) noexcept;
+
+
+//
+// Work objects
+//
+
+PTP_WORK CreateThreadpoolWork(PTP_WORK_CALLBACK callback, PVOID context, PTP_CALLBACK_ENVIRON environment) noexcept;
+
+VOID SubmitThreadpoolWork(PTP_WORK work) noexcept;
+
+VOID WaitForThreadpoolWorkCallbacks(PTP_WORK work, BOOL cancel_pending_callbacks) noexcept;
+
+VOID CloseThreadpoolWork(PTP_WORK work) noexcept;
+
+
+//
+// Wait objects
+//
+
+PTP_WAIT CreateThreadpoolWait(PTP_WAIT_CALLBACK callback, PVOID context, PTP_CALLBACK_ENVIRON environment) noexcept;
+
+VOID SetThreadpoolWait(PTP_WAIT wait, HANDLE handle, PFILETIME timeout) noexcept;
+
+BOOL SetThreadpoolWaitEx(PTP_WAIT wait, HANDLE handle, PFILETIME timeout, PVOID reserved) noexcept;
+
+VOID WaitForThreadpoolWaitCallbacks(PTP_WAIT wait, BOOL cancel_pending_callbacks) noexcept;
+
+VOID CloseThreadpoolWait(PTP_WAIT wait) noexcept;
+
+/**
+ * @brief Sets or cancels several wait objects at once. It is an ntp extension, Windows
+ *        has no such function. All waits are registered during a single reactor lock.
+ *
+ * @param waits Wait objects (all of them must belong to the same pool)
+ * @param handles Handles to wait for, one per wait object (NULL to cancel all waits)
+ * @param count Number of wait objects
+ * @param timeout Timeout of all waits (NULL for infinite wait)
+ */
+VOID SetThreadpoolWaits(PTP_WAIT* waits, const HANDLE* handles, DWORD count, PFILETIME timeout) noexcept;
+
+
+//
+// Timer objects
+//
+
+PTP_TIMER CreateThreadpoolTimer(PTP_TIMER_CALLBACK callback, PVOID context, PTP_CALLBACK_ENVIRON environment) noexcept;
+
+VOID SetThreadpoolTimer(PTP_TIMER timer, PFILETIME due_time, DWORD period, DWORD window_length) noexcept;
+
+BOOL SetThreadpoolTimerEx(PTP_TIMER timer, PFILETIME due_time, DWORD period, DWORD window_length) noexcept;
+
+BOOL IsThreadpoolTimerSet(PTP_TIMER timer) noexcept;
+
+VOID WaitForThreadpoolTimerCallbacks(PTP_TIMER timer, BOOL cancel_pending_callbacks) noexcept;
+
+VOID CloseThreadpoolTimer(PTP_TIMER timer) noexcept;
+
+
+//
+// IO objects
+//
+
+PTP_IO CreateThreadpoolIo(HANDLE file, PTP_WIN32_IO_CALLBACK callback, PVOID context, PTP_CALLBACK_ENVIRON environment) noexcept;
+
+VOID StartThreadpoolIo(PTP_IO io) noexcept;
+
+VOID CancelThreadpoolIo(PTP_IO io) noexcept;
+
+VOID WaitForThreadpoolIoCallbacks(PTP_IO io, BOOL cancel_pending_callbacks) noexcept;
+
+VOID CloseThreadpoolIo(PTP_IO io) noexcept;
+
+/**
+ * @brief Registers a fixed buffer in io_uring instance of IO object's pool. It is an ntp
+ *        extension, Windows has no such function. Operations, which data lies entirely
+ *        within a registered buffer, do not map user pages on each call.
+ *
+ * @param io IO object, which pool uses the buffer
+ * @param buffer Buffer to register (must stay valid until it is unregistered)
+ * @param size Size of buffer
+ * @returns FALSE if buffer cannot be registered (ERROR_NOT_SUPPORTED if io_uring is not available)
+ */
+BOOL RegisterThreadpoolIoBuffer(PTP_IO io, PVOID buffer, SIZE_T size) noexcept;
+
+/**
+ * @brief Removes a buffer registered with RegisterThreadpoolIoBuffer. It is an ntp extension.
+ *
+ * @param io IO object, which pool uses the buffer
+ * @param buffer Registered buffer
+ * @returns FALSE if buffer is not registered
+ */
+BOOL UnregisterThreadpoolIoBuffer(PTP_IO io, PVOID buffer) noexcept;
@@ -0,0 +1,224 @@
+/**
+ * @file uring.hpp
+ * @brief io_uring backend of ntp native engine
+ *
+ * Asynchronous IO on files bound to threadpool IO objects is submitted into
+ * a single io_uring instance per pool. Submission queue entries are batched:
+ * they are pushed by callers and submitted with one io_uring_enter call by
+ * a pool worker. Completion queue is reaped on pool workers too, when reactor
+ * reports, that ring's descriptor is readable. Files bound to IO objects are
+ * registered in the ring, and user may register fixed buffers.
+ */
+
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+#include <linux/io_uring.h>
+
+#include "native/linux/engine.hpp"
+
+
+namespace ntp::native {
+
+/**
+ * @brief Parameters of operation submitted into ring.
+ */
+struct RingRequest
+{
+    std::uint8_t opcode = 0; /**< Operation code (IORING_OP_*) */
+
+    int descriptor = -1; /**< File descriptor or index of registered file */
+
+    bool fixed_file = false; /**< Is descriptor an index of registered file */
+
+    void* buffer = nullptr; /**< Data buffer */
+
+    std::uint32_t size = 0; /**< Size of data buffer */
+
+    std::uint64_t offset = 0; /**< File offset */
+
+    std::uint32_t flags = 0; /**< Operation-specific flags (e.g. flags of accepted socket) */
+
+    int buffer_index = -1; /**< Index of registered buffer, that contains data buffer (or -1) */
+};
+
+
+class RingSubmitter;
+
+
+/**
+ * @brief Operation submitted into ring.
+ */
+class RingOperation
+{
+public:
+    virtual ~RingOperation() = default;
+
+    /**
+     * @brief Called on a pool worker, when operation completes.
+     *
+     * @param result Result of operation (negated errno value in case of failure)
+     */
+    virtual void OnComplete(std::int32_t result) noexcept = 0;
+
+    /**
+     * @brief Parameters of operation. Ring resubmits operations, that are cancelled
+     *        by kernel because submitting thread exited, with the same parameters.
+     */
+    RingRequest request;
+
+    /**
+     * @brief Thread, that has submitted operation into kernel (managed by ring).
+     */
+    RingSubmitter* submitter = nullptr;
+};
+
+
+class RingDriver;
+
+
+/**
+ * @brief io_uring instance of a pool.
+ *
+ * Class is thread-safe.
+ */
+class Ring final
+{
+    Ring(const Ring&)            = delete;
+    Ring& operator=(const Ring&) = delete;
+
+    friend class RingDriver;
+
+public:
+    /**
+     * @brief Creates a ring for the pool.
+     *
+     * @param pool Pool, which workers submit and reap operations
+     * @returns ring or NULL if io_uring is not available (e.g. disabled by kernel or seccomp)
+     */
+    static std::unique_ptr<Ring> Create(Pool& pool) noexcept;
+
+    /**
+     * @brief Cancels operations in flight, waits for their completions and destroys ring.
+     */
+    ~Ring();
+
+    /**
+     * @brief Puts an operation into submission queue. It is submitted by a pool worker
+     *        together with other operations pushed meanwhile.
+     *
+     * @param operation Operation to submit (must stay alive until its completion)
+     * @returns false if operation cannot be queued (e.g. ring is being destroyed)
+     */
+    bool Push(RingOperation* operation) noexcept;
+
+    /**
+     * @brief Registers a file in the ring.
+     *
+     * @param descriptor File descriptor
+     * @returns index of registered file or -1 if file cannot be registered
+     */
+    int RegisterFile(int descriptor) noexcept;
+
+    /**
+     * @brief Removes a file from the ring. Operations in flight are not affected.
+     *
+     * @param index Index of registered file
+     */
+    void UnregisterFile(int index) noexcept;
+
+    /**
+     * @brief Registers a fixed buffer in the ring.
+     *
+     * @param buffer Buffer to register
+     * @param size Size of buffer
+     * @returns false if buffer cannot be registered (last error is set)
+     */
+    bool RegisterBuffer(void* buffer, std::size_t size) noexcept;
+
+    /**
+     * @brief Removes a fixed buffer from the ring.
+     *
+     * @param buffer Registered buffer
+     * @returns false if buffer is not registered
+     */
+    bool UnregisterBuffer(void* buffer) noexcept;
+
+    /**
+     * @brief Finds a registered buffer, that contains the specified region.
+     *
+     * @param data Start of region
+     * @param size Size of region
+     * @returns index of registered buffer or -1
+     */
+    int FindBuffer(const void* data, std::size_t size) noexcept;
+
+private:
+    explicit Ring(Pool& pool) noexcept;
+
+    bool Setup() noexcept;
+
+    bool PushLocked(RingOperation* operation) noexcept;
+
+    void Schedule() noexcept;
+    void Run(bool signaled) noexcept;
+
+    unsigned Flush() noexcept;
+    unsigned SubmitLocked(unsigned count) noexcept;
+    std::size_t Reap() noexcept;
+
+    int Enter(unsigned to_submit, unsigned min_complete, unsigned flags) noexcept;
+
+private:
+    // Owning pool and object, that runs ring's work on pool workers
+    Pool& pool_;
+    RingDriver* driver_;
+
+    // Reactor's registration of ring descriptor
+    ReactorEntry entry_;
+
+    // Ring descriptor and mapped memory (queues share a single mapping)
+    int ring_;
+    void* rings_;
+    std::size_t rings_size_;
+    io_uring_sqe* sqes_;
+    std::size_t sqes_size_;
+
+    // Submission queue (protected by sq_lock_, entries are submitted into kernel under it too)
+    std::mutex sq_lock_;
+    unsigned sq_entries_;
+    unsigned sq_mask_;
+    std::atomic<unsigned>* sq_head_;
+    std::atomic<unsigned>* sq_tail_;
+    std::atomic<unsigned>* sq_flags_;
+    unsigned* sq_array_;
+    unsigned sq_local_tail_;
+    unsigned unsubmitted_;
+
+    // Completion queue and reactor's registration state (protected by run_lock_)
+    std::mutex run_lock_;
+    unsigned cq_mask_;
+    std::atomic<unsigned>* cq_head_;
+    std::atomic<unsigned>* cq_tail_;
+    io_uring_cqe* cqes_;
+    bool armed_;
+
+    // Number of operations in flight, is ring's work queued into pool and is ring being destroyed
+    std::atomic<std::size_t> inflight_;
+    std::atomic<bool> scheduled_;
+    std::atomic<bool> stopping_;
+
+    // Registered files and buffers (protected by resources_lock_)
+    std::mutex resources_lock_;
+    std::vector<int> free_files_;
+    std::vector<std::pair<std::uintptr_t, std::size_t>> buffers_;
+    std::atomic<std::size_t> buffers_count_;
+};
+
+}  // namespace ntp::native
@@ -0,0 +1,355 @@
+/**
+ * @file windows.h
+ * @brief Subset of Windows API, that is used by ntp, implemented for Linux
+ *
+ * This header replaces Windows.h on Linux. It contains only types, constants and
+ * functions, that ntp library uses internally or exposes via its public interface.
+ *
+ * Some important differences from Windows:
+ * - HANDLE is a file descriptor casted to a pointer (refer to HandleFromDescriptor
+ *   and DescriptorFromHandle). Events are implemented with eventfd.
+ * - Win32 error codes are errno values, hence GetLastError returns errno and
+ *   FormatMessage with FORMAT_MESSAGE_FROM_SYSTEM uses strerror.
+ */
+
+#pragma once
+
+#include <cerrno>
+#include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+
+
+//
+// Calling conventions and other decorations (meaningless on Linux)
+//
+
+#define WINAPI
+#define NTAPI
+#define CALLBACK
+
+#define VOID void
+
+
+//
+// Basic types
+//
+
+typedef int BOOL;
+typedef unsigned char BOOLEAN;
+typedef std::uint32_t DWORD, *LPDWORD;
+typedef std::int32_t LONG;
+typedef std::uint32_t ULONG;
+typedef unsigned int UINT;
+typedef std::uintptr_t ULONG_PTR;
+typedef std::size_t SIZE_T;
+
+typedef void *PVOID, *LPVOID;
+typedef void* PVOID64;
+typedef const void* LPCVOID;
+
+typedef char* LPSTR;
+typedef const char* LPCSTR;
+typedef wchar_t* LPWSTR;
+typedef const wchar_t* LPCWSTR;
+
+typedef void* HANDLE;
+typedef HANDLE* PHANDLE;
+typedef HANDLE HLOCAL;
+
+#define TRUE  1
+#define FALSE 0
+
+
+/**
+ * @brief Contains a 64-bit value representing the number of 100-nanosecond intervals.
+ */
+typedef struct _FILETIME
+{
+    DWORD dwLowDateTime;
+    DWORD dwHighDateTime;
+} FILETIME, *PFILETIME, *LPFILETIME;
+
+
+/**
+ * @brief Security attributes are not supported on Linux, type is left for compatibility.
+ */
+typedef struct _SECURITY_ATTRIBUTES SECURITY_ATTRIBUTES, *LPSECURITY_ATTRIBUTES;
+
+
+/**
+ * @brief Contains information used in asynchronous (overlapped) input and output.
+ */
+typedef struct _OVERLAPPED
+{
+    ULONG_PTR Internal;     /**< Error code of completed operation */
+    ULONG_PTR InternalHigh; /**< Number of bytes transferred */
+    DWORD Offset;           /**< Low part of file offset */
+    DWORD OffsetHigh;       /**< High part of file offset */
+    HANDLE hEvent;          /**< Event to set, when operation completes (may be NULL) */
+} OVERLAPPED, *LPOVERLAPPED;
+
+
+/**
+ * @brief Address of a single memory page for ReadFileScatter and WriteFileGather.
+ */
+typedef union _FILE_SEGMENT_ELEMENT
+{
+    PVOID64 Buffer;                /**< Address of page */
+    unsigned long long Alignment;  /**< Ensures 64-bit size of element */
+} FILE_SEGMENT_ELEMENT, *PFILE_SEGMENT_ELEMENT;
+
+
+/**
+ * @brief Buffer of arbitrary size and alignment for ReadFileVector and WriteFileVector.
+ *        Layout matches `struct iovec`.
+ */
+typedef struct _FILE_VECTOR_ELEMENT
+{
+    PVOID Buffer;  /**< Start of buffer */
+    SIZE_T Length; /**< Size of buffer */
+} FILE_VECTOR_ELEMENT, *PFILE_VECTOR_ELEMENT;
+
+
+//
+// Constants
+//
+
+#define INFINITE 0xFFFFFFFF
+
+#define WAIT_OBJECT_0 0x00000000L
+#define WAIT_TIMEOUT  0x00000102L
+#define WAIT_FAILED   0xFFFFFFFF
+
+#define INVALID_HANDLE_VALUE (reinterpret_cast<HANDLE>(static_cast<std::intptr_t>(-1)))
+
+#define MEMORY_ALLOCATION_ALIGNMENT 16
+
+#define HEAP_ZERO_MEMORY 0x00000008
+
+#define FORMAT_MESSAGE_ALLOCATE_BUFFER 0x00000100
+#define FORMAT_MESSAGE_IGNORE_INSERTS  0x00000200
+#define FORMAT_MESSAGE_FROM_STRING     0x00000400
+#define FORMAT_MESSAGE_FROM_SYSTEM     0x00001000
+
+#define LANG_NEUTRAL    0x00
+#define SUBLANG_DEFAULT 0x01
+
+#define MAKELANGID(p, s) ((static_cast<DWORD>(s) << 10) | static_cast<DWORD>(p))
+
+
+//
+// Error codes (mapped to errno values)
+//
+
+#define NO_ERROR                0
+#define ERROR_SUCCESS           0
+#define ERROR_INVALID_PARAMETER EINVAL
+#define ERROR_INVALID_HANDLE    EBADF
+#define ERROR_NOT_ENOUGH_MEMORY ENOMEM
+#define ERROR_NOT_FOUND         ENOENT
+#define ERROR_NO_MORE_ITEMS     ENODATA
+#define ERROR_IO_PENDING        EINPROGRESS
+#define ERROR_OPERATION_ABORTED ECANCELED
+#define ERROR_INVALID_STATE     EBUSY
+#define ERROR_NOT_SUPPORTED     ENOTSUP
+#define ERROR_TOO_MANY_POSTS    EAGAIN
+
+
+/**
+ * @brief Converts a file descriptor into a HANDLE value.
+ *
+ * @param descriptor File descriptor
+ * @returns Handle, that can be passed into ntp
+ */
+inline HANDLE HandleFromDescriptor(int descriptor) noexcept
+{
+    return reinterpret_cast<HANDLE>(static_cast<std::intptr_t>(descriptor));
+}
+
+
+/**
+ * @brief Converts a HANDLE value back into a file descriptor.
+ *
+ * @param handle Handle obtained from HandleFromDescriptor or from ntp
+ * @returns File descriptor
+ */
+inline int DescriptorFromHandle(HANDLE handle) noexcept
+{
+    return static_cast<int>(reinterpret_cast<std::intptr_t>(handle));
+}
+
+
+//
+// Errors
+//
+
+/**
+ * @brief Retrieves the calling thread's last-error code value (errno).
+ */
+DWORD GetLastError() noexcept;
+
+/**
+ * @brief Sets the last-error code (errno) for the calling thread.
+ */
+VOID SetLastError(DWORD code) noexcept;
+
+
+//
+// Memory
+//
+
+/**
+ * @brief Retrieves a handle to the default heap of the calling process.
+ */
+HANDLE GetProcessHeap() noexcept;
+
+/**
+ * @brief Allocates a block of memory from a heap (malloc/calloc).
+ */
+LPVOID HeapAlloc(HANDLE heap, DWORD flags, SIZE_T bytes) noexcept;
+
+/**
+ * @brief Frees a memory block allocated from a heap by HeapAlloc.
+ */
+BOOL HeapFree(HANDLE heap, DWORD flags, LPVOID memory) noexcept;
+
+/**
+ * @brief Frees the specified local memory object (used with FORMAT_MESSAGE_ALLOCATE_BUFFER).
+ */
+HLOCAL LocalFree(HLOCAL memory) noexcept;
+
+/**
+ * @brief Allocates memory on a specified alignment boundary.
+ */
+void* _aligned_malloc(std::size_t size, std::size_t alignment) noexcept;
+
+/**
+ * @brief Frees a block of memory that was allocated with _aligned_malloc.
+ */
+void _aligned_free(void* memory) noexcept;
+
+
+//
+// Strings
+//
+
+/**
+ * @brief Formats a message string.
+ *
+ * Supports FORMAT_MESSAGE_FROM_STRING with %n!format! inserts and
+ * FORMAT_MESSAGE_FROM_SYSTEM (errno description). Language identifier is ignored.
+ */
+DWORD FormatMessageA(DWORD flags, LPCVOID source, DWORD message_id, DWORD language_id,
+    LPSTR buffer, DWORD size, va_list* arguments) noexcept;
+
+/**
+ * @brief Wide character version of FormatMessageA.
+ */
+DWORD FormatMessageW(DWORD flags, LPCVOID source, DWORD message_id, DWORD language_id,
+    LPWSTR buffer, DWORD size, va_list* arguments) noexcept;
+
+/**
+ * @brief Maps a character string to a UTF-32 string.
+ *
+ * Code page is ignored: input string is always treated as UTF-8.
+ */
+int MultiByteToWideChar(UINT code_page, DWORD flags, LPCSTR multi_byte, int multi_byte_size,
+    LPWSTR wide, int wide_size) noexcept;
+
+
+//
+// Synchronization
+//
+
+/**
+ * @brief Creates an event object (eventfd). Name and security attributes are not supported.
+ */
+HANDLE CreateEvent(LPSECURITY_ATTRIBUTES security_attributes, BOOL manual_reset,
+    BOOL initially_signaled, LPCWSTR name) noexcept;
+
+/**
+ * @brief Sets the specified event object to the signaled state.
+ */
+BOOL SetEvent(HANDLE event) noexcept;
+
+/**
+ * @brief Sets the specified event object to the nonsignaled state.
+ */
+BOOL ResetEvent(HANDLE event) noexcept;
+
+/**
+ * @brief Closes an open object handle (file descriptor).
+ */
+BOOL CloseHandle(HANDLE object) noexcept;
+
+/**
+ * @brief Waits until the specified object is in the signaled state or the time-out interval elapses.
+ *
+ * Object is signaled if its descriptor is readable. Auto-reset events are reset
+ * by a successful wait.
+ */
+DWORD WaitForSingleObject(HANDLE object, DWORD milliseconds) noexcept;
+
+
+//
+// Files
+//
+
+/**
+ * @brief Reads data from the specified file.
+ *
+ * If the file is bound to a threadpool IO object and overlapped is not NULL,
+ * the operation is performed asynchronously: function returns FALSE, last error
+ * is set to ERROR_IO_PENDING and completion is delivered to the IO object.
+ */
+BOOL ReadFile(HANDLE file, LPVOID buffer, DWORD bytes_to_read, LPDWORD bytes_read, LPOVERLAPPED overlapped) noexcept;
+
+/**
+ * @brief Writes data to the specified file. Refer to ReadFile for asynchronous operation details.
+ */
+BOOL WriteFile(HANDLE file, LPCVOID buffer, DWORD bytes_to_write, LPDWORD bytes_written, LPOVERLAPPED overlapped) noexcept;
+
+/**
+ * @brief Accepts a connection on the specified listening socket. It is an ntp extension,
+ *        that stands for AcceptEx. Refer to ReadFile for asynchronous operation details.
+ *
+ * Descriptor of accepted socket is returned via accepted parameter for synchronous
+ * operation and as the number of transferred bytes for asynchronous one.
+ */
+BOOL AcceptSocket(HANDLE listener, PHANDLE accepted, LPOVERLAPPED overlapped) noexcept;
+
+/**
+ * @brief Reads data from the specified file into a set of pages. The last page may be
+ *        filled partially. Refer to ReadFile for asynchronous operation details.
+ *
+ * Unlike Windows, neither unbuffered file nor aligned offset is required.
+ *
+ * @param segments Pages to read into (one element per page of bytes_to_read)
+ */
+BOOL ReadFileScatter(HANDLE file, FILE_SEGMENT_ELEMENT segments[], DWORD bytes_to_read, LPDWORD reserved, LPOVERLAPPED overlapped) noexcept;
+
+/**
+ * @brief Writes data from a set of pages to the specified file. Refer to ReadFileScatter for details.
+ */
+BOOL WriteFileGather(HANDLE file, FILE_SEGMENT_ELEMENT segments[], DWORD bytes_to_write, LPDWORD reserved, LPOVERLAPPED overlapped) noexcept;
+
+/**
+ * @brief Reads data from the specified file into a set of buffers of arbitrary size and alignment
+ *        (at most IOV_MAX). It is an ntp extension. Refer to ReadFile for asynchronous operation details.
+ *
+ * Completion reports the total number of bytes transferred into all buffers.
+ */
+BOOL ReadFileVector(HANDLE file, const FILE_VECTOR_ELEMENT* elements, DWORD count, LPDWORD bytes_read, LPOVERLAPPED overlapped) noexcept;
+
+/**
+ * @brief Writes data from a set of buffers to the specified file. Refer to ReadFileVector for details.
+ */
+BOOL WriteFileVector(HANDLE file, const FILE_VECTOR_ELEMENT* elements, DWORD count, LPDWORD bytes_written, LPOVERLAPPED overlapped) noexcept;
+
+
+//
+// Threadpool API
+//
+
+#include "native/linux/threadpoolapi.h"
@@ -1,5 +1,20 @@
 #pragma once
 
+//
+// Target platform detection
+//
+
+#if defined(_WIN32)
+#   define NTP_PLATFORM_WINDOWS 1
+#elif defined(__linux__)
+#   define NTP_PLATFORM_LINUX 1
+#else
+#   error ntp library supports only Windows and Linux
+#endif
+
+
+#if defined(NTP_PLATFORM_WINDOWS)
+
 //
 // Necessary external defines
 //
@@ -20,6 +35,8 @@
 #   define _WIN32_WINNT 0x0601  // Windows 7
 #endif
 
+#endif  // NTP_PLATFORM_WINDOWS
+
 
 //
 // Library configuration
@@ -27,6 +44,58 @@
 
 #define NTP_ALLOCATION_ALIGNMENT MEMORY_ALLOCATION_ALIGNMENT
 
+//
+// Size of inline storage for callbacks (larger callbacks are allocated on heap)
+//
+
+#ifndef NTP_INLINE_CALLBACK_SIZE
+#   define NTP_INLINE_CALLBACK_SIZE 64
+#endif
+
+//
+// Default resolution of soft timers (driven by timing wheel), in microseconds
+//
+
+#ifndef NTP_SOFT_TIMER_RESOLUTION_US
+#   define NTP_SOFT_TIMER_RESOLUTION_US 1000
+#endif
+
+//
+// Minimum severity of traced messages (value of ntp::logger::Severity). Trace calls
+// with lower severity are removed at compile time, their arguments are not formatted
+//
+
+#ifndef NTP_MIN_LOG_SEVERITY
+#   define NTP_MIN_LOG_SEVERITY 0
+#endif
+
+//
+// Linux only: define NTP_DISABLE_IO_URING to perform asynchronous IO
+// on pool workers with pread/pwrite instead of io_uring
+//
+
+//
+// Define NTP_DISABLE_METRICS to compile out recording of metrics
+// (BasicThreadPool::Snapshot reports zero counters then)
+//
+
+//
+// NTP_ENABLE_TRACING CMake option defines NTP_ENABLE_TRACING to record executions of callbacks
+// (refer to ntp::tracing::Start). It is defined for the library and all its users at once
+//
+
+//
+// Coroutine support (awaitables are available only if compiler supports C++20 coroutines)
+//
+
+#if !defined(NTP_DISABLE_COROUTINES) && defined(__cpp_impl_coroutine) && defined(__has_include)
+#   if __has_include(<coroutine>)
+#       define NTP_HAS_COROUTINES 1
+#   endif
+#endif
+
+
+#if defined(NTP_PLATFORM_WINDOWS)
 
 //
 // Check minimum supported Windows version (just to be sure, if no one set it before)
@@ -35,3 +104,5 @@
 #if _WIN32_WINNT < 0x0601
 #   error ntp library requires _WIN32_WINNT to be equal to at least 0x0601 (Windows 7)
 #endif  // Prior to Windows 7
+
+#endif  // NTP_PLATFORM_WINDOWS
@@ -5,8 +5,11 @@
 
 #pragma once
 
-#include <map>
 #include <mutex>
+#include <new>
+#include <atomic>
+#include <thread>
+#include <tuple>
 #include <memory>
 #include <functional>
 #include <type_traits>
@@ -14,15 +17,20 @@
 
 #include "details/windows.hpp"
 #include "details/utils.hpp"
+#include "details/exception.hpp"
+#include "details/allocator.hpp"
+#include "details/registry.hpp"
+#include "details/metrics.hpp"
+#include "details/tracing.hpp"
 
 
 namespace ntp::details {
 
 /**
  * @brief Cancellation test timeout, while waiting for callbacks.
- *        Set to 500 msec.
+ *        Set to 50 msec.
  */
-inline constexpr auto kTestCancelTimeout = 500ul;
+inline constexpr auto kTestCancelTimeout = 50ul;
 
 
 /**
@@ -37,8 +45,62 @@ using test_cancel_t = std::function<bool()>;
  * @brief Interface for callback wrapper
  */
 struct alignas(NTP_ALLOCATION_ALIGNMENT) ICallback
-    : public ntp::details::NativeSlistEntry
 {
+    /**
+     * @brief Custom new operator, that allocates memory from slab allocator.
+     *
+     * @param bytes Number of bytes to allocate
+     */
+    void* operator new(size_t bytes)
+    {
+        return allocator::SlabAllocator::AllocateBytes(bytes);
+    }
+
+    /**
+     * @brief Custom new operator for over-aligned callbacks (e.g. with over-aligned functors).
+     *
+     * @param bytes Number of bytes to allocate
+     * @param alignment Required alignment
+     */
+    void* operator new(size_t bytes, std::align_val_t alignment)
+    {
+        if (static_cast<size_t>(alignment) <= allocator::SlabAllocator::kBlockAlignment)
+        {
+            return allocator::SlabAllocator::AllocateBytes(bytes);
+        }
+
+        return ::operator new(bytes, alignment);
+    }
+
+    /**
+     * @brief Matching custom delete operator. Size is known here, because
+     * destructor is virtual.
+     *
+     * @param ptr Pointer to free
+     * @param bytes Size of object
+     */
+    void operator delete(void* ptr, size_t bytes) noexcept
+    {
+        allocator::SlabAllocator::Free(ptr, bytes);
+    }
+
+    /**
+     * @brief Matching custom delete operator for over-aligned callbacks.
+     *
+     * @param ptr Pointer to free
+     * @param bytes Size of object
+     * @param alignment Alignment of object
+     */
+    void operator delete(void* ptr, size_t bytes, std::align_val_t alignment) noexcept
+    {
+        if (static_cast<size_t>(alignment) <= allocator::SlabAllocator::kBlockAlignment)
+        {
+            return allocator::SlabAllocator::Free(ptr, bytes);
+        }
+
+        ::operator delete(ptr, alignment);
+    }
+
     /**
      * @brief Virtual destructor (generated by compiler)
      */
@@ -55,16 +117,123 @@ struct alignas(NTP_ALLOCATION_ALIGNMENT) ICallback
 
 
 /**
- * @brief Smart pointer to ICallback implementation object
+ * @brief Owning storage for ICallback implementation object with small-buffer optimization.
+ * 
+ * Callbacks, that fit into Capacity bytes and are not over-aligned, are constructed
+ * right inside the storage, so they cost no allocations. Larger callbacks are allocated
+ * with ICallback::operator new. The choice is made at compile time.
+ * 
+ * @tparam Capacity Size of inline buffer
+ */
+template<size_t Capacity = NTP_INLINE_CALLBACK_SIZE>
+class InlineCallback final
+{
+    InlineCallback(const InlineCallback&)            = delete;
+    InlineCallback& operator=(const InlineCallback&) = delete;
+
+public:
+    /**
+     * @brief Checks if callback of specific type is stored inline.
+     */
+    template<typename Callback>
+    static constexpr bool is_inline_v = sizeof(Callback) <= Capacity && alignof(Callback) <= NTP_ALLOCATION_ALIGNMENT;
+
+public:
+    InlineCallback() noexcept = default;
+
+    ~InlineCallback()
+    {
+        Reset();
+    }
+
+    /**
+     * @brief Destroys current callback (if any) and constructs a new one.
+     *
+     * @tparam Callback Type of ICallback implementation
+     * @param args Arguments for Callback's constructor
+     */
+    template<typename Callback, typename... CArgs>
+    void Emplace(CArgs&&... args)
+    {
+        static_assert(std::is_base_of_v<ICallback, Callback>,
+            "[ntp::details::InlineCallback::Emplace]: Callback MUST implement ICallback");
+
+        Reset();
+
+        if constexpr (is_inline_v<Callback>)
+        {
+            callback_ = ::new (static_cast<void*>(storage_)) Callback(std::forward<CArgs>(args)...);
+            inline_   = true;
+        }
+        else
+        {
+            callback_ = new Callback(std::forward<CArgs>(args)...);
+            inline_   = false;
+        }
+    }
+
+    /**
+     * @brief Destroys current callback (if any).
+     */
+    void Reset() noexcept
+    {
+        if (!callback_)
+        {
+            return;
+        }
+
+        if (inline_)
+        {
+            callback_->~ICallback();
+        }
+        else
+        {
+            delete callback_;
+        }
+
+        callback_ = nullptr;
+    }
+
+    /**
+     * @brief Checks if current callback is stored inline.
+     */
+    bool IsInline() const noexcept { return callback_ && inline_; }
+
+    /**
+     * @brief Checks if storage contains a callback.
+     */
+    explicit operator bool() const noexcept { return callback_ != nullptr; }
+
+    /**
+     * @brief Access to stored callback.
+     */
+    ICallback* operator->() const noexcept { return callback_; }
+
+private:
+    // Inline buffer
+    alignas(NTP_ALLOCATION_ALIGNMENT) unsigned char storage_[Capacity];
+
+    // Current callback (points to storage_ or to heap)
+    ICallback* callback_ = nullptr;
+
+    // Is callback_ stored in storage_
+    bool inline_ = false;
+};
+
+
+/**
+ * @brief Default inline storage for callbacks
  */
-using callback_t = std::unique_ptr<ICallback>;
+using callback_t = InlineCallback<>;
 
 
 /**
  * @brief Base class for all callbacks.
  * 
  * All callbacks are inherited from this class, that is used
- * to store callable and its arguments.
+ * to store callable and its arguments. Derived class must declare
+ * static constexpr ntp::tracing::CallbackKind kTraceKind (it is used
+ * only if NTP_ENABLE_TRACING is defined).
  * 
  * @tparam Derived Derived from this class implementation for specific callback type (CRTP)
  * @tparam Functor Arbitrary callable to wrap
@@ -95,8 +264,53 @@ protected:
     explicit BasicCallback(CFunctor&& functor, CArgs&&... args)
         : args_(std::forward<CArgs>(args)...)
         , functor_(std::forward<CFunctor>(functor))
+#if defined(NTP_ENABLE_TRACING)
+        , trace_tag_(ntp::tracing::details::current_tag)
+#endif  // NTP_ENABLE_TRACING
     { }
 
+    /**
+     * @brief Checks if stored callable can be invoked with specific leading 
+     *        parameters followed by stored arguments.
+     */
+    template<typename... Prefix>
+    static constexpr bool is_invocable_with_v = std::is_invocable_v<functor_t&, Prefix..., std::decay_t<Args>&...>;
+
+    /**
+     * @brief Checks if stored callable can be invoked with specific leading parameters
+     *        followed by stored arguments and returns a value of specific type.
+     */
+    template<typename Result, typename... Prefix>
+    static constexpr bool is_invocable_r_with_v = std::is_invocable_r_v<Result, functor_t&, Prefix..., std::decay_t<Args>&...>;
+
+    /**
+     * @brief Invokes stored callable with leading parameters followed by stored arguments.
+     * 
+     * Stored arguments are never copied: they are passed by reference, or, if Move is
+     * true and callable accepts rvalues, callable and arguments are moved into the call
+     * (it is allowed for one-shot callbacks only, because stored state is consumed).
+     * 
+     * @tparam Move Move stored callable and arguments if possible
+     * @param prefix Leading parameters (e.g. PTP_CALLBACK_INSTANCE)
+     * @returns whatever callable returns
+     */
+    template<bool Move, typename... Prefix>
+    decltype(auto) Invoke(Prefix&&... prefix)
+    {
+        if constexpr (Move && std::is_invocable_v<functor_t&&, Prefix..., std::decay_t<Args>&&...>)
+        {
+            return std::apply([this, &prefix...](auto&... args) -> decltype(auto) {
+                return std::invoke(std::move(functor_), std::forward<Prefix>(prefix)..., std::move(args)...);
+            }, args_);
+        }
+        else
+        {
+            return std::apply([this, &prefix...](auto&... args) -> decltype(auto) {
+                return std::invoke(functor_, std::forward<Prefix>(prefix)..., args...);
+            }, args_);
+        }
+    }
+
     /**
      * @brief Get stored callable
      *
@@ -114,6 +328,10 @@ protected:
 private:
     void Call(PTP_CALLBACK_INSTANCE instance, void* parameter) final
     {
+#if defined(NTP_ENABLE_TRACING)
+        ntp::tracing::details::TraceScope scope { Derived::kTraceKind, trace_tag_ };
+#endif  // NTP_ENABLE_TRACING
+
         const auto converted_parameter = AsDerived()->ConvertParameter(parameter);
         return AsDerived()->CallImpl(instance, converted_parameter);
     }
@@ -126,6 +344,11 @@ private:
 
     // Callable
     functor_t functor_;
+
+#if defined(NTP_ENABLE_TRACING)
+    // Tag of callback in traces (captured on construction)
+    const char* trace_tag_;
+#endif  // NTP_ENABLE_TRACING
 };
 
 
@@ -177,6 +400,9 @@ private:
  *   replaces object's callback. Due to template instantiation rules if you never call ntp::details::BasicManager::Replace
  *   for specific threadpool object, you may skip this function implementation.
  * 
+ * - static void StopInternal(object_context_t& user_context) noexcept - optional, prevents callback from resubmitting
+ *   its own object. It is called under container's lock right before CloseInternal or AbortInternal.
+ * 
  * @tparam NativeHandle Type of native object handle (e.g. PTP_WAIT)
  * @tparam ObjectContext Type of context specific for threadpool object kind
  * @tparam Derived Derived from this class implementation for specific callback type (CRTP)
@@ -214,13 +440,10 @@ protected:
 
     /**
      * @brief Container with callbacks represented by their handles.
+     *        It is sharded, so that operations on different objects do
+     *        not contend on a single lock.
      */
-    using callbacks_t = std::map<native_handle_t, context_t>;
-
-    /**
-     * @brief Lock primitive.
-     */
-    using lock_t = ntp::details::RtlResource;
+    using callbacks_t = ntp::details::ShardedRegistry<native_handle_t, context_t>;
 
 private:
     /**
@@ -242,7 +465,7 @@ private:
 
         MetaContext meta_context; /**< Meta information about context */
 
-        ntp::details::callback_t callback; /**< Pointer to callback wrapper */
+        ntp::details::callback_t callback; /**< Callback wrapper (stored inline if small enough) */
     };
 
 protected:
@@ -253,10 +476,26 @@ protected:
      */
     BasicManager(PTP_CALLBACK_ENVIRON environment)
         : TpEnvironmentView(environment)
+        , metrics_()
         , callbacks_()
-        , lock_()
+        , cleanups_(0)
     { }
 
+    /**
+     * @brief Destructor waits for callbacks, that are removing their own
+     *        objects right now (see CleanupContext).
+     *
+     * Such callbacks are already disassociated from their objects, hence
+     * threadpool does not wait for them, but they still access the container.
+     */
+    ~BasicManager()
+    {
+        while (cleanups_.load(std::memory_order_acquire) != 0)
+        {
+            std::this_thread::yield();
+        }
+    }
+
 public:
     /**
      * @brief Replaces an existing threadpool callback with a new one.
@@ -270,16 +509,19 @@ public:
     template<typename Functor, typename... Args>
     native_handle_t Replace(native_handle_t object, Functor&& functor, Args&&... args)
     {
-        std::unique_lock lock { lock_ };
+        native_handle_t replaced = nullptr;
 
-        if (const auto callback = callbacks_.find(object); callback != callbacks_.end())
-        {
-            const auto context = callback->second.get();
-            return AsDerived()->ReplaceInternal(object, context,
+        const auto found = callbacks_.Visit(object, [&](context_t& context) {
+            replaced = AsDerived()->ReplaceInternal(object, context.get(),
                 std::forward<Functor>(functor), std::forward<Args>(args)...);
+        });
+
+        if (!found)
+        {
+            throw exception::Win32Exception(ERROR_NOT_FOUND);
         }
 
-        throw exception::Win32Exception(ERROR_NOT_FOUND);
+        return replaced;
     }
 
     /**
@@ -291,7 +533,10 @@ public:
      */
     void Cancel(native_handle_t object) noexcept
     {
-        CloseAndRemove(object);
+        if (CloseAndRemove(object))
+        {
+            metrics_.Cancelled();
+        }
     }
 
     /**
@@ -301,7 +546,10 @@ public:
      */
     void Abort(native_handle_t object) noexcept
     {
-        AbortAndRemove(object);
+        if (AbortAndRemove(object))
+        {
+            metrics_.Cancelled();
+        }
     }
 
     /**
@@ -312,14 +560,25 @@ public:
         static_assert(noexcept(Derived::CloseInternal(std::declval<native_handle_t>())),
             "[ntp::details::BasicManager::CancelAll]: Derived::CloseInternal MUST be noexcept");
 
-        std::unique_lock lock { lock_ };
-
-        for (auto& [native_handle, _] : callbacks_)
-        {
+        callbacks_.Clear([this](native_handle_t native_handle, context_t& context) {
+            Stop(context);
             Derived::CloseInternal(native_handle);
-        }
 
-        callbacks_.clear();
+            metrics_.Cancelled();
+        });
+    }
+
+    /**
+     * @brief Collects metrics of the manager.
+     *
+     * @returns metrics with number of live objects
+     */
+    ntp::metrics::ManagerMetrics CollectMetrics() const
+    {
+        auto metrics         = metrics_.Collect();
+        metrics.live_objects = callbacks_.Size();
+
+        return metrics;
     }
 
 protected:
@@ -330,18 +589,45 @@ protected:
      * @param context Filled context of callback
      */
     void SubmitContext(native_handle_t native_handle, context_t&& context)
-        noexcept(noexcept(std::declval<Derived>().SubmitInternal(std::declval<native_handle_t>(), std::declval<object_context_t>())))
+        noexcept(noexcept(std::declval<Derived>().SubmitInternal(std::declval<native_handle_t>(), std::declval<object_context_t&>())))
     {
-        std::unique_lock lock { lock_ };
+        callbacks_.Insert(native_handle, std::move(context), [this, native_handle](context_t& inserted) {
+            inserted->meta_context.manager       = this;
+            inserted->meta_context.native_handle = native_handle;
 
-        const auto [iter, _]                     = callbacks_.emplace(native_handle, std::move(context));
-        iter->second->meta_context.manager       = this;
-        iter->second->meta_context.native_handle = native_handle;
+            AsDerived()->SubmitInternal(native_handle, inserted->object_context);
+        });
 
-        AsDerived()->SubmitInternal(native_handle, iter->second->object_context);
+        metrics_.Submitted();
+    }
+
+    /**
+     * @brief Invokes a callable on context of an object. Container is locked in
+     *        shared mode, hence callable may run concurrently for the same context.
+     *
+     * @param native_handle Native handle of threadpool object
+     * @param visitor Callable, that accepts context_pointer_t
+     * @returns true if object is present, false otherwise
+     */
+    template<typename Visitor>
+    bool VisitContext(native_handle_t native_handle, Visitor&& visitor) const
+    {
+        return callbacks_.VisitShared(native_handle, [&visitor](const context_t& context) {
+            visitor(context.get());
+        });
+    }
+
+    /**
+     * @brief Get metrics recorder of a manager, that owns a context.
+     *
+     * @param context Context of submitted object
+     * @returns Reference to the recorder
+     */
+    static ntp::metrics::details::MetricsRecorder& MetricsOf(context_pointer_t context) noexcept
+    {
+        return context->meta_context.manager->metrics_;
     }
 
-protected:
     /**
      * @brief Create new empty context.
      * 
@@ -365,18 +651,29 @@ protected:
      * removes object first, then there will be no object anymore,
      * and this function will do nothing.
      * 
+     * Manager is guaranteed to be alive until callback is disassociated
+     * from its object, therefore the callback is registered as in-flight
+     * cleanup before disassociation, and manager's destructor waits for it.
+     * 
      * @param instance Running callback instance (it is extremely important
      *                 to remove association between object and callback)
      * @param context Context to remove from container
      */
     static void CleanupContext(PTP_CALLBACK_INSTANCE instance, context_pointer_t context)
     {
-        DisassociateCurrentThreadFromCallback(instance);
-
         auto native_handle = context->meta_context.native_handle;
         auto manager       = context->meta_context.manager;
 
-        return manager->CloseAndRemove(native_handle);
+        manager->cleanups_.fetch_add(1, std::memory_order_relaxed);
+
+        DisassociateCurrentThreadFromCallback(instance);
+        manager->CloseAndRemove(native_handle);
+
+        //
+        // Manager must not be touched after this point
+        //
+
+        manager->cleanups_.fetch_sub(1, std::memory_order_release);
     }
 
 private:
@@ -385,19 +682,35 @@ private:
         return static_cast<Derived*>(this);
     }
 
-    template<auto Cleanup>
-    void CleanupAndRemove(native_handle_t native_handle) noexcept
-    {
-        std::unique_lock lock { lock_ };
+    template<typename Manager, typename = void>
+    struct has_stop_internal : std::false_type
+    { };
+
+    template<typename Manager>
+    struct has_stop_internal<Manager, std::void_t<decltype(Manager::StopInternal(std::declval<object_context_t&>()))>> : std::true_type
+    { };
 
-        if (const auto callback = callbacks_.find(native_handle); callback != callbacks_.end())
+    static void Stop(context_t& context) noexcept
+    {
+        if constexpr (has_stop_internal<Derived>::value)
         {
-            Cleanup(native_handle);
-            callbacks_.erase(callback);
+            static_assert(noexcept(Derived::StopInternal(std::declval<object_context_t&>())),
+                "[ntp::details::BasicManager::Stop]: Derived::StopInternal MUST be noexcept");
+
+            Derived::StopInternal(context->object_context);
         }
     }
 
-    void CloseAndRemove(native_handle_t native_handle) noexcept
+    template<auto Cleanup>
+    bool CleanupAndRemove(native_handle_t native_handle) noexcept
+    {
+        return callbacks_.Erase(native_handle, [native_handle](context_t& context) {
+            Stop(context);
+            Cleanup(native_handle);
+        });
+    }
+
+    bool CloseAndRemove(native_handle_t native_handle) noexcept
     {
         static_assert(noexcept(Derived::CloseInternal(std::declval<native_handle_t>())),
             "[ntp::details::BasicManager::CloseAndRemove]: Derived::CloseInternal MUST be noexcept");
@@ -405,7 +718,7 @@ private:
         return CleanupAndRemove<Derived::CloseInternal>(native_handle);
     }
 
-    void AbortAndRemove(native_handle_t native_handle) noexcept
+    bool AbortAndRemove(native_handle_t native_handle) noexcept
     {
         static_assert(noexcept(Derived::AbortInternal(std::declval<native_handle_t>())),
             "[ntp::details::BasicManager::AbortAndRemove]: Derived::AbortInternal MUST be noexcept");
@@ -413,12 +726,16 @@ private:
         return CleanupAndRemove<Derived::AbortInternal>(native_handle);
     }
 
+protected:
+    // Metrics of the manager (synchronized internally)
+    ntp::metrics::details::MetricsRecorder metrics_;
+
 private:
-    // Container with callbacks
+    // Container with callbacks (synchronized internally)
     callbacks_t callbacks_;
 
-    // Syncronization primitive for callbacks container
-    mutable lock_t lock_;
+    // Number of callbacks currently removing their own objects
+    std::atomic<size_t> cleanups_;
 };
 
 
@@ -441,7 +758,12 @@ protected:
      */
 	explicit BasicManager(PTP_CALLBACK_ENVIRON environment) noexcept
 		: TpEnvironmentView(environment)
+		, metrics_()
 	{ }
+
+protected:
+    // Metrics of the manager (synchronized internally)
+    ntp::metrics::details::MetricsRecorder metrics_;
 };
 
 }  // namespace ntp::details
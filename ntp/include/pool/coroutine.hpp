@@ -0,0 +1,532 @@
+/**
+ * @file coroutine.hpp
+ * @brief C++20 coroutine support: awaitables for threadpool objects and coroutine task
+ *
+ * This file is available only if compiler supports coroutines (NTP_HAS_COROUTINES
+ * is defined in ntp_config.hpp). Awaitables submit coroutine handles as usual
+ * callbacks, so suspended coroutines are resumed right from managers' InvokeCallback
+ * functions without any type-erased intermediate wrappers.
+ */
+
+#pragma once
+
+#include "ntp_config.hpp"
+
+#if defined(NTP_HAS_COROUTINES)
+
+#include <mutex>
+#include <chrono>
+#include <utility>
+#include <optional>
+#include <exception>
+#include <coroutine>
+#include <type_traits>
+#include <condition_variable>
+
+#include "details/time.hpp"
+#include "details/windows.hpp"
+#include "pool/work.hpp"
+#include "pool/wait.hpp"
+#include "pool/timer.hpp"
+#include "pool/io.hpp"
+
+
+namespace ntp::coroutine {
+
+/**
+ * @brief Result of asynchronous IO operation, awaited with ntp::coroutine::Io.
+ */
+struct IoResult
+{
+    ULONG result; /**< The result of the I/O operation (NO_ERROR if the I/O is successful) */
+
+    ULONG_PTR bytes_transferred; /**< The number of bytes transferred during the I/O operation */
+};
+
+}  // namespace ntp::coroutine
+
+
+namespace ntp::coroutine::details {
+
+/**
+ * @brief Callable, that resumes a coroutine. It is stored in a callback wrapper directly.
+ */
+struct Resumer
+{
+    std::coroutine_handle<> handle; /**< Suspended coroutine */
+
+    void operator()() const { handle.resume(); }
+};
+
+
+/**
+ * @brief Awaitable, that resumes a coroutine in a threadpool thread (via WorkManager).
+ */
+class ScheduleAwaitable final
+{
+    ScheduleAwaitable(const ScheduleAwaitable&)            = delete;
+    ScheduleAwaitable& operator=(const ScheduleAwaitable&) = delete;
+
+public:
+    explicit ScheduleAwaitable(ntp::work::details::WorkManager& manager) noexcept
+        : manager_(manager)
+    { }
+
+    bool await_ready() const noexcept { return false; }
+
+    void await_suspend(std::coroutine_handle<> handle) { manager_.Submit(Resumer { handle }); }
+
+    void await_resume() const noexcept { }
+
+private:
+    // Manager to submit coroutine into
+    ntp::work::details::WorkManager& manager_;
+};
+
+
+/**
+ * @brief Awaitable, that resumes a coroutine after a timeout (via TimerManager).
+ */
+class SleepAwaitable final
+{
+    SleepAwaitable(const SleepAwaitable&)            = delete;
+    SleepAwaitable& operator=(const SleepAwaitable&) = delete;
+
+public:
+    SleepAwaitable(ntp::timer::details::TimerManager& manager, ntp::time::native_duration_t timeout) noexcept
+        : manager_(manager)
+        , timeout_(timeout)
+    { }
+
+    bool await_ready() const noexcept { return false; }
+
+    void await_suspend(std::coroutine_handle<> handle)
+    {
+        //
+        // Non-periodic timer is closed automatically after its callback
+        //
+
+        manager_.Submit(timeout_, Resumer { handle });
+    }
+
+    void await_resume() const noexcept { }
+
+private:
+    // Manager to submit coroutine into
+    ntp::timer::details::TimerManager& manager_;
+
+    // Timeout to sleep for
+    const ntp::time::native_duration_t timeout_;
+};
+
+
+/**
+ * @brief Awaitable, that resumes a coroutine when handle becomes signaled
+ *        or timeout expires (via WaitManager).
+ */
+class WaitAwaitable final
+{
+    WaitAwaitable(const WaitAwaitable&)            = delete;
+    WaitAwaitable& operator=(const WaitAwaitable&) = delete;
+
+    /**
+     * @brief Callable, that saves wait result and resumes a coroutine.
+     */
+    struct WaitResumer
+    {
+        WaitAwaitable* awaitable;
+        std::coroutine_handle<> handle;
+
+        void operator()(TP_WAIT_RESULT wait_result) const
+        {
+            awaitable->wait_result_ = wait_result;
+            handle.resume();
+        }
+    };
+
+public:
+    WaitAwaitable(ntp::wait::details::WaitManager& manager, HANDLE wait_handle, ntp::time::native_duration_t timeout) noexcept
+        : manager_(manager)
+        , wait_handle_(wait_handle)
+        , timeout_(timeout)
+        , wait_result_(WAIT_TIMEOUT)
+    { }
+
+    bool await_ready() const noexcept { return false; }
+
+    void await_suspend(std::coroutine_handle<> handle)
+    {
+        manager_.Submit(wait_handle_, timeout_, WaitResumer { this, handle });
+    }
+
+    /**
+     * @returns WAIT_OBJECT_0 if handle is signaled, WAIT_TIMEOUT if timeout expired
+     */
+    TP_WAIT_RESULT await_resume() const noexcept { return wait_result_; }
+
+private:
+    // Manager to submit coroutine into
+    ntp::wait::details::WaitManager& manager_;
+
+    // Handle to wait for
+    const HANDLE wait_handle_;
+
+    // Wait timeout
+    const ntp::time::native_duration_t timeout_;
+
+    // Result of wait
+    TP_WAIT_RESULT wait_result_;
+};
+
+
+/**
+ * @brief Awaitable, that starts an asynchronous IO operation and resumes a coroutine
+ *        when it is completed (via IoManager).
+ *
+ * @tparam Starter Type of callable, that starts an operation: BOOL(LPOVERLAPPED)
+ */
+template<typename Starter>
+class IoAwaitable final
+{
+    IoAwaitable(const IoAwaitable&)            = delete;
+    IoAwaitable& operator=(const IoAwaitable&) = delete;
+
+    /**
+     * @brief Callable, that saves IO result and resumes a coroutine.
+     */
+    struct IoResumer
+    {
+        IoAwaitable* awaitable;
+        std::coroutine_handle<> handle;
+
+        void operator()(LPVOID /* overlapped */, ULONG result, ULONG_PTR bytes_transferred) const
+        {
+            awaitable->io_result_ = IoResult { result, bytes_transferred };
+            handle.resume();
+        }
+    };
+
+public:
+    template<typename CStarter>
+    IoAwaitable(ntp::io::details::IoManager& manager, HANDLE io_handle, CStarter&& starter)
+        : manager_(manager)
+        , io_handle_(io_handle)
+        , starter_(std::forward<CStarter>(starter))
+        , overlapped_()
+        , io_result_()
+    { }
+
+    bool await_ready() const noexcept { return false; }
+
+    bool await_suspend(std::coroutine_handle<> handle)
+    {
+        const auto io = manager_.Submit(io_handle_, IoResumer { this, handle });
+
+        //
+        // Completion may resume the coroutine in another thread right after the
+        // operation is started, so awaitable must not be accessed after that
+        //
+
+        const auto started = starter_(&overlapped_);
+        if (const auto error = GetLastError(); !started && error != ERROR_IO_PENDING)
+        {
+            manager_.Abort(io);
+            io_result_ = IoResult { error, 0 };
+
+            return false;
+        }
+
+        return true;
+    }
+
+    /**
+     * @returns Result of IO operation
+     */
+    IoResult await_resume() const noexcept { return io_result_; }
+
+private:
+    // Manager to submit coroutine into
+    ntp::io::details::IoManager& manager_;
+
+    // Handle of an object, which IO is performed on
+    const HANDLE io_handle_;
+
+    // Operation starter
+    std::decay_t<Starter> starter_;
+
+    // Overlapped structure for the operation (lives in coroutine frame)
+    OVERLAPPED overlapped_;
+
+    // Result of the operation
+    IoResult io_result_;
+};
+
+
+/**
+ * @brief State of SyncWait: completion of a task is signalled here.
+ */
+class SyncWaitState final
+{
+public:
+    void Notify()
+    {
+        //
+        // Notification is performed under the lock, because state
+        // is destroyed right after waiting thread wakes up
+        //
+
+        std::lock_guard lock { lock_ };
+
+        done_ = true;
+        done_condition_.notify_all();
+    }
+
+    void Wait()
+    {
+        std::unique_lock lock { lock_ };
+        done_condition_.wait(lock, [this]() { return done_; });
+    }
+
+private:
+    std::mutex lock_;
+    std::condition_variable done_condition_;
+    bool done_ = false;
+};
+
+
+/**
+ * @brief Common part of coroutine task's promise.
+ */
+class PromiseBase
+{
+    /**
+     * @brief Final awaiter: transfers control to awaiting coroutine or notifies SyncWait.
+     */
+    struct FinalAwaiter
+    {
+        bool await_ready() const noexcept { return false; }
+
+        template<typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
+        {
+            auto& promise = handle.promise();
+
+            if (promise.continuation_)
+            {
+                return promise.continuation_;
+            }
+
+            if (promise.sync_wait_)
+            {
+                promise.sync_wait_->Notify();
+            }
+
+            return std::noop_coroutine();
+        }
+
+        void await_resume() const noexcept { }
+    };
+
+public:
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+
+    FinalAwaiter final_suspend() const noexcept { return {}; }
+
+    void unhandled_exception() noexcept { error_ = std::current_exception(); }
+
+    /**
+     * @brief Sets a coroutine, that is resumed when the task completes.
+     */
+    void SetContinuation(std::coroutine_handle<> continuation) noexcept { continuation_ = continuation; }
+
+    /**
+     * @brief Sets a state, that is notified when the task completes.
+     */
+    void SetSyncWait(SyncWaitState* sync_wait) noexcept { sync_wait_ = sync_wait; }
+
+protected:
+    /**
+     * @brief Rethrows an exception thrown by the task (if any).
+     */
+    void RethrowIfFailed() const
+    {
+        if (error_)
+        {
+            std::rethrow_exception(error_);
+        }
+    }
+
+private:
+    // Awaiting coroutine
+    std::coroutine_handle<> continuation_;
+
+    // Synchronously waiting thread
+    SyncWaitState* sync_wait_ = nullptr;
+
+    // Exception thrown by the task
+    std::exception_ptr error_;
+};
+
+
+/**
+ * @brief Promise of a task, that returns a value.
+ */
+template<typename Result>
+class Promise
+    : public PromiseBase
+{
+public:
+    template<typename Value>
+    void return_value(Value&& value) { value_.emplace(std::forward<Value>(value)); }
+
+    /**
+     * @brief Moves a result out of the promise (or rethrows an exception).
+     */
+    Result TakeResult()
+    {
+        RethrowIfFailed();
+        return std::move(*value_);
+    }
+
+private:
+    // Task's result
+    std::optional<Result> value_;
+};
+
+
+/**
+ * @brief Promise of a task, that returns nothing.
+ */
+template<>
+class Promise<void>
+    : public PromiseBase
+{
+public:
+    void return_void() const noexcept { }
+
+    /**
+     * @brief Rethrows an exception (if any).
+     */
+    void TakeResult() { RethrowIfFailed(); }
+};
+
+}  // namespace ntp::coroutine::details
+
+
+namespace ntp::coroutine {
+
+/**
+ * @brief Lazily started coroutine task.
+ *
+ * Task starts when it is awaited with co_await (awaiting coroutine is resumed
+ * right after the task completes, in the same thread) or passed to SyncWait.
+ * Task owns coroutine frame, so it must not be destroyed while it is running.
+ *
+ * Usage example:
+ * @code{.cpp}
+ * ntp::coroutine::Task<int> Handle(ntp::SystemThreadPool& pool)
+ * {
+ *     co_await ntp::coroutine::Schedule(pool);  // now running in the threadpool
+ *     co_await ntp::coroutine::Sleep(pool, std::chrono::milliseconds(10));
+ *
+ *     co_return 42;
+ * }
+ *
+ * const auto result = ntp::coroutine::SyncWait(Handle(pool));
+ * @endcode
+ *
+ * @tparam Result Type of task's result
+ */
+template<typename Result = void>
+class Task final
+{
+    Task(const Task&)            = delete;
+    Task& operator=(const Task&) = delete;
+
+public:
+    /**
+     * @brief Promise type of the coroutine.
+     */
+    class promise_type final
+        : public details::Promise<Result>
+    {
+    public:
+        Task get_return_object() noexcept { return Task { std::coroutine_handle<promise_type>::from_promise(*this) }; }
+    };
+
+public:
+    Task(Task&& other) noexcept
+        : handle_(std::exchange(other.handle_, nullptr))
+    { }
+
+    Task& operator=(Task&& other) noexcept
+    {
+        if (this != &other)
+        {
+            Reset();
+            handle_ = std::exchange(other.handle_, nullptr);
+        }
+
+        return *this;
+    }
+
+    ~Task()
+    {
+        Reset();
+    }
+
+    bool await_ready() const noexcept { return false; }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+    {
+        handle_.promise().SetContinuation(awaiting);
+        return handle_;
+    }
+
+    Result await_resume() { return handle_.promise().TakeResult(); }
+
+private:
+    template<typename TaskResult>
+    friend TaskResult SyncWait(Task<TaskResult> task);
+
+    explicit Task(std::coroutine_handle<promise_type> handle) noexcept
+        : handle_(handle)
+    { }
+
+    void Reset() noexcept
+    {
+        if (handle_)
+        {
+            std::exchange(handle_, nullptr).destroy();
+        }
+    }
+
+private:
+    // Coroutine frame
+    std::coroutine_handle<promise_type> handle_;
+};
+
+
+/**
+ * @brief Starts a task in the calling thread and waits for its completion.
+ *
+ * @param task Task to run
+ * @returns Task's result
+ * @throws Exception thrown by the task
+ */
+template<typename Result>
+Result SyncWait(Task<Result> task)
+{
+    details::SyncWaitState state;
+
+    task.handle_.promise().SetSyncWait(&state);
+    task.handle_.resume();
+
+    state.Wait();
+
+    return task.handle_.promise().TakeResult();
+}
+
+}  // namespace ntp::coroutine
+
+#endif  // NTP_HAS_COROUTINES
@@ -6,22 +6,183 @@
 #pragma once
 
 #include <tuple>
+#include <cstddef>
 #include <utility>
 
 #include "ntp_config.hpp"
 #include "details/time.hpp"
 #include "details/utils.hpp"
 #include "pool/basic_callback.hpp"
+#include "pool/io_buffer.hpp"
+
+
+namespace ntp::io {
+
+#if defined(NTP_PLATFORM_LINUX)
+
+/**
+ * @brief Buffer of a vectored operation (see ntp::io::IoBinding::WriteGather).
+ */
+using IoSegment = FILE_VECTOR_ELEMENT;
+
+#else   // !NTP_PLATFORM_LINUX
+
+/**
+ * @brief Buffer of a vectored operation (see ntp::io::IoBinding::WriteGather).
+ */
+struct IoSegment
+{
+    PVOID Buffer;  /**< Start of buffer */
+    SIZE_T Length; /**< Size of buffer */
+};
+
+#endif  // NTP_PLATFORM_LINUX
+
+
+/**
+ * @brief Long-lived binding of a handle to the threadpool (see ntp::BasicThreadPool::BindIo).
+ *
+ * Binding is a lightweight copyable view of threadpool IO object. Each asynchronous
+ * operation on the bound handle must be preceded by BeginOperation. If operation
+ * fails to start, AbortOperation must be called. Completions are delivered to the
+ * binding's callback with the OVERLAPPED pointer, the operation was started with,
+ * hence callback can find per-operation context by this pointer without any lookup.
+ */
+class IoBinding final
+{
+public:
+    /**
+     * @brief Constructs an empty binding.
+     */
+    IoBinding() noexcept
+        : io_(nullptr)
+    { }
+
+    /**
+     * @brief Constructs binding from threadpool IO object.
+     *
+     * @param io Threadpool IO object
+     */
+    explicit IoBinding(PTP_IO io) noexcept
+        : io_(io)
+    { }
+
+    /**
+     * @brief Notifies threadpool, that an asynchronous operation is about to be started.
+     *        Must be called before each operation on the bound handle.
+     */
+    void BeginOperation() const noexcept
+    {
+        ntp::details::SafeThreadpoolCall<StartThreadpoolIo>(io_);
+    }
+
+    /**
+     * @brief Notifies threadpool, that an operation announced by BeginOperation has
+     *        failed to start (i.e. no completion will be delivered for it).
+     */
+    void AbortOperation() const noexcept
+    {
+        ntp::details::SafeThreadpoolCall<CancelThreadpoolIo>(io_);
+    }
+
+    /**
+     * @brief Registers a fixed buffer for operations on the bound handle (io_uring
+     *        on Linux). Operations, which data lies entirely within a registered
+     *        buffer, skip mapping of user pages. Not supported on Windows.
+     *
+     * @param buffer Buffer to register (must stay valid until it is unregistered)
+     * @param size Size of buffer
+     * @returns true if buffer is registered
+     */
+    bool RegisterBuffer(void* buffer, std::size_t size) const noexcept
+    {
+#if defined(NTP_PLATFORM_LINUX)
+        return RegisterThreadpoolIoBuffer(io_, buffer, size);
+#else   // !NTP_PLATFORM_LINUX
+        static_cast<void>(buffer);
+        static_cast<void>(size);
+
+        return false;
+#endif  // NTP_PLATFORM_LINUX
+    }
+
+    /**
+     * @brief Removes a buffer registered with RegisterBuffer.
+     *
+     * @param buffer Registered buffer
+     * @returns true if buffer was registered
+     */
+    bool UnregisterBuffer(void* buffer) const noexcept
+    {
+#if defined(NTP_PLATFORM_LINUX)
+        return UnregisterThreadpoolIoBuffer(io_, buffer);
+#else   // !NTP_PLATFORM_LINUX
+        static_cast<void>(buffer);
+
+        return false;
+#endif  // NTP_PLATFORM_LINUX
+    }
+
+    /**
+     * @brief Starts a vectored write of several buffers on the bound handle with
+     *        a single system call. BeginOperation and AbortOperation are called
+     *        internally. A single completion reports the total number of bytes.
+     *
+     * On Windows the operation is performed with WriteFileGather, hence handle must
+     * be opened with FILE_FLAG_NO_BUFFERING, and each buffer must be page-aligned
+     * and its size must be a multiple of page size (e.g. buffers of ntp::io::IoBufferPool).
+     * On Linux buffers of any size and alignment are accepted (at most IOV_MAX).
+     *
+     * @param file Bound handle
+     * @param segments Buffers to write (the array may be freed after the call)
+     * @param count Number of buffers
+     * @param overlapped OVERLAPPED structure of the operation (file offset)
+     * @returns true if operation is started, false otherwise (last error is set)
+     */
+    bool WriteGather(HANDLE file, const IoSegment* segments, std::size_t count, LPOVERLAPPED overlapped) const noexcept;
+
+    /**
+     * @brief Starts a vectored read into several buffers on the bound handle.
+     *        Refer to WriteGather for details.
+     *
+     * @param file Bound handle
+     * @param segments Buffers to read into (the array may be freed after the call)
+     * @param count Number of buffers
+     * @param overlapped OVERLAPPED structure of the operation (file offset)
+     * @returns true if operation is started, false otherwise (last error is set)
+     */
+    bool ReadScatter(HANDLE file, const IoSegment* segments, std::size_t count, LPOVERLAPPED overlapped) const noexcept;
+
+    /**
+     * @brief Get native threadpool IO object.
+     */
+    PTP_IO NativeHandle() const noexcept { return io_; }
+
+    /**
+     * @brief Checks if binding is not empty.
+     */
+    explicit operator bool() const noexcept { return io_ != nullptr; }
+
+    friend bool operator==(const IoBinding& lhs, const IoBinding& rhs) noexcept { return lhs.io_ == rhs.io_; }
+    friend bool operator!=(const IoBinding& lhs, const IoBinding& rhs) noexcept { return lhs.io_ != rhs.io_; }
+
+private:
+    // Threadpool IO object
+    PTP_IO io_;
+};
+
+}  // namespace ntp::io
 
 
 namespace ntp::io::details {
 
 /**
  * @brief Specific context for threadpool IO objects.
- *        Empty, because no additional information is needed.
  */
 struct IoContext
-{ };
+{
+    bool io_persistent = false; /**< If true, IO object is a binding, that outlives its completions */
+};
 
 
 /**
@@ -42,6 +203,27 @@ struct IoData
 };
 
 
+/**
+ * @brief Returns pooled operation context into pool, when callback returns (even by exception).
+ */
+class IoOperationGuard final
+{
+    IoOperationGuard(const IoOperationGuard&)            = delete;
+    IoOperationGuard& operator=(const IoOperationGuard&) = delete;
+
+public:
+    explicit IoOperationGuard(IoOperation* operation) noexcept
+        : operation_(operation)
+    { }
+
+    ~IoOperationGuard() { IoBufferPool::Release(operation_); }
+
+private:
+    // Context to release
+    IoOperation* operation_;
+};
+
+
 /**
  * @brief IO callback wrapper (PTP_IO).
  *
@@ -53,6 +235,11 @@ class alignas(NTP_ALLOCATION_ALIGNMENT) IoCallback final
     : public ntp::details::BasicCallback<IoCallback<Functor, Args...>, Functor, Args...>
 {
 public:
+    /**
+     * @brief Kind of callback in traces.
+     */
+    static constexpr ntp::tracing::CallbackKind kTraceKind = ntp::tracing::CallbackKind::kIo;
+
     /**
      * @brief Constructor from callable and its arguments
      *
@@ -61,7 +248,7 @@ public:
      */
     template<typename CFunctor, typename... CArgs>
     explicit IoCallback(CFunctor&& functor, CArgs&&... args)
-        : BasicCallback(std::forward<CFunctor>(functor), std::forward<CArgs>(args)...)
+        : IoCallback::BasicCallback(std::forward<CFunctor>(functor), std::forward<CArgs>(args)...)
     { }
 
     /**
@@ -71,22 +258,35 @@ public:
 
     /**
      * @brief Callback invocation function implementation. Supports invocation of
-     *        callbacks with or without PTP_CALLBACK_INSTANCE parameter. 
+     *        callbacks with or without PTP_CALLBACK_INSTANCE parameter. IO callback
+     *        is invoked for every completed operation, so arguments are passed by reference.
+     *        If callable accepts `IoOperation&` instead of OVERLAPPED pointer, operation must
+     *        be started with a context from ntp::io::IoBufferPool, that is released after the call.
      */
     template<typename = void> /* if constexpr works only for templates */
     void CallImpl(PTP_CALLBACK_INSTANCE instance, IoData* io_data)
     {
-        if constexpr (std::is_invocable_v<std::decay_t<Functor>, PTP_CALLBACK_INSTANCE, LPVOID, ULONG, ULONG_PTR, std::decay_t<Args>...>)
+        if constexpr (IoCallback::template is_invocable_with_v<PTP_CALLBACK_INSTANCE, LPVOID, ULONG, ULONG_PTR>)
+        {
+            this->template Invoke<false>(instance, io_data->overlapped, io_data->result, io_data->bytes_transferred);
+        }
+        else if constexpr (IoCallback::template is_invocable_with_v<PTP_CALLBACK_INSTANCE, IoOperation&, ULONG, ULONG_PTR>)
         {
-            const auto required_args = std::make_tuple(instance, io_data->overlapped, io_data->result, io_data->bytes_transferred);
-            const auto args          = std::tuple_cat(required_args, Arguments());
-            std::apply(Callable(), args);
+            const auto operation = IoOperation::FromOverlapped(io_data->overlapped);
+            IoOperationGuard guard { operation };
+
+            this->template Invoke<false>(instance, *operation, io_data->result, io_data->bytes_transferred);
+        }
+        else if constexpr (IoCallback::template is_invocable_with_v<IoOperation&, ULONG, ULONG_PTR>)
+        {
+            const auto operation = IoOperation::FromOverlapped(io_data->overlapped);
+            IoOperationGuard guard { operation };
+
+            this->template Invoke<false>(*operation, io_data->result, io_data->bytes_transferred);
         }
         else
         {
-            const auto required_args = std::make_tuple(io_data->overlapped, io_data->result, io_data->bytes_transferred);
-            const auto args          = std::tuple_cat(required_args, Arguments());
-            std::apply(Callable(), args);
+            this->template Invoke<false>(io_data->overlapped, io_data->result, io_data->bytes_transferred);
         }
     }
 };
@@ -122,8 +322,34 @@ public:
     template<typename Functor, typename... Args>
     native_handle_t Submit(HANDLE io_handle, Functor&& functor, Args&&... args)
     {
-        auto context      = CreateContext();
-        context->callback = std::make_unique<IoCallback<Functor, Args...>>(std::forward<Functor>(functor), std::forward<Args>(args)...);
+        return SubmitWith(false, io_handle, std::forward<Functor>(functor), std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief Binds a handle to the threadpool with a user-defined callback,
+     *        that is invoked for every completed operation.
+     *
+     * Unlike ntp::io::details::IoManager::Submit, no operation is started and
+     * IO object is not removed after completion: it lives until it is cancelled.
+     *
+     * @param io_handle Handle of an object, which asynchronous IO is performed on
+     * @param functor Callable to invoke
+     * @param args Arguments to pass into callable (they will be copied into wrapper)
+     * @returns binding of the handle
+     */
+    template<typename Functor, typename... Args>
+    IoBinding Bind(HANDLE io_handle, Functor&& functor, Args&&... args)
+    {
+        return IoBinding(SubmitWith(true, io_handle, std::forward<Functor>(functor), std::forward<Args>(args)...));
+    }
+
+private:
+    template<typename Functor, typename... Args>
+    native_handle_t SubmitWith(bool persistent, HANDLE io_handle, Functor&& functor, Args&&... args)
+    {
+        auto context                          = CreateContext();
+        context->callback.template Emplace<IoCallback<Functor, Args...>>(std::forward<Functor>(functor), std::forward<Args>(args)...);
+        context->object_context.io_persistent = persistent;
 
         const auto native_handle = CreateThreadpoolIo(io_handle, reinterpret_cast<PTP_WIN32_IO_CALLBACK>(InvokeCallback),
             context.get(), Environment());
@@ -134,8 +360,8 @@ public:
         }
 
         static_assert(noexcept(SubmitContext(native_handle, std::move(context))),
-            "[ntp::io::details::WaitManager::Submit]: inspect ntp::details::BasicCallback::SubmitContext and "
-            "ntp::io::details::WaitManager::SubmitInternal for noexcept property, because an exception thrown "
+            "[ntp::io::details::IoManager::SubmitWith]: inspect ntp::details::BasicCallback::SubmitContext and "
+            "ntp::io::details::IoManager::SubmitInternal for noexcept property, because an exception thrown "
             "here can lead to handle and memory leaks. SubmitContext is noexcept if and only if SubmitInternal "
             "is noexcept.");
 
@@ -144,7 +370,6 @@ public:
         return native_handle;
     }
 
-private:
     void SubmitInternal(native_handle_t native_handle, object_context_t& user_context) noexcept;
 
 private:
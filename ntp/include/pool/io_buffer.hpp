@@ -0,0 +1,201 @@
+/**
+ * @file io_buffer.hpp
+ * @brief Pool of asynchronous IO operation contexts with embedded data buffers
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "ntp_config.hpp"
+#include "details/windows.hpp"
+#include "details/queue.hpp"
+
+
+namespace ntp::io::details {
+
+struct IoOperationAccess;
+
+}  // namespace ntp::io::details
+
+
+namespace ntp::io {
+
+/**
+ * @brief Context of a single asynchronous IO operation taken from ntp::io::IoBufferPool.
+ *
+ * Context starts with OVERLAPPED structure, so the OVERLAPPED pointer passed into
+ * IO callback converts back into context without any lookup. Context occupies exactly
+ * one cache line, its data buffer is page-aligned (suitable for unbuffered IO).
+ *
+ * If IO callback accepts `IoOperation&` instead of OVERLAPPED pointer, context
+ * is returned into pool automatically, when callback returns. Otherwise (or if
+ * operation fails to start) it must be returned with Release.
+ */
+class alignas(ntp::details::kCacheLine) IoOperation final
+{
+    IoOperation(const IoOperation&)            = delete;
+    IoOperation& operator=(const IoOperation&) = delete;
+
+    friend struct details::IoOperationAccess;
+
+public:
+    /**
+     * @brief Converts OVERLAPPED pointer of an operation started with this context back into context.
+     *
+     * @param overlapped Pointer obtained from Overlapped
+     */
+    static IoOperation* FromOverlapped(LPVOID overlapped) noexcept { return static_cast<IoOperation*>(overlapped); }
+
+    /**
+     * @brief Get OVERLAPPED structure to start operation with.
+     */
+    LPOVERLAPPED Overlapped() noexcept { return &overlapped_; }
+
+    /**
+     * @brief Sets file offset of operation.
+     *
+     * @param offset Offset in bytes
+     */
+    void SetOffset(std::uint64_t offset) noexcept
+    {
+        overlapped_.Offset     = static_cast<DWORD>(offset);
+        overlapped_.OffsetHigh = static_cast<DWORD>(offset >> 32);
+    }
+
+    /**
+     * @brief Get page-aligned data buffer.
+     */
+    void* Data() const noexcept { return data_; }
+
+    /**
+     * @brief Get size of data buffer (at least the size requested from pool).
+     */
+    std::size_t Capacity() const noexcept;
+
+    /**
+     * @brief Get user-defined context of operation (NULL for a new operation).
+     */
+    void* Context() const noexcept { return context_; }
+
+    /**
+     * @brief Sets user-defined context of operation.
+     */
+    void SetContext(void* context) noexcept { context_ = context; }
+
+    /**
+     * @brief Returns context into pool. Context must not be used after this call.
+     */
+    void Release() noexcept;
+
+private:
+    IoOperation() noexcept = default;
+
+private:
+    // OVERLAPPED structure (must be the first member)
+    OVERLAPPED overlapped_;
+
+    // Page-aligned data buffer
+    void* data_;
+
+    // User-defined context
+    void* context_;
+
+    // Next free context in pool's list
+    IoOperation* next_;
+
+    // Size class of data buffer
+    std::uint32_t size_class_;
+};
+
+static_assert(std::is_standard_layout_v<IoOperation>,
+    "[ntp::io::IoOperation]: OVERLAPPED must be convertible into context");
+
+static_assert(sizeof(IoOperation) == ntp::details::kCacheLine,
+    "[ntp::io::IoOperation]: context must occupy exactly one cache line");
+
+
+/**
+ * @brief Counters of IoBufferPool.
+ */
+struct IoBufferStatistics final
+{
+    std::uint64_t acquisitions; /**< Number of acquired contexts */
+    std::uint64_t cache_hits;   /**< Number of acquisitions, served by thread-local cache */
+    std::uint64_t slab_refills; /**< Number of thread-local cache refills from a new slab */
+    std::uint64_t releases;     /**< Number of released contexts */
+};
+
+
+/**
+ * @brief Process-wide pool of IO operation contexts with embedded buffers.
+ *
+ * Buffers are rounded up to the power of 2 (from kMinBufferSize to kMaxBufferSize).
+ * Contexts are taken from a thread-local free list of their size class. Empty lists
+ * are refilled by batches from a global depot or from a new slab, and overfilled
+ * lists (contexts are usually released by workers, that run IO callbacks) return
+ * batches to the depot. Slabs are never returned to the system, hence a steady
+ * stream of operations costs no memory allocations and no page faults.
+ */
+class IoBufferPool final
+{
+public:
+    /**
+     * @brief Alignment of data buffers.
+     */
+    static constexpr std::size_t kPageSize = 4096;
+
+    /**
+     * @brief Size of the smallest buffer.
+     */
+    static constexpr std::size_t kMinBufferSize = kPageSize;
+
+    /**
+     * @brief Size of the largest buffer.
+     */
+    static constexpr std::size_t kMaxBufferSize = 64 * 1024;
+
+    /**
+     * @brief Takes a context from pool.
+     *
+     * @param size Required size of data buffer
+     * @returns Context with zeroed OVERLAPPED structure
+     * @throws exception::Win32Exception if size exceeds kMaxBufferSize or in case of allocation failure
+     */
+    static IoOperation* Acquire(std::size_t size = kMinBufferSize);
+
+    /**
+     * @brief Returns context into pool.
+     *
+     * @param operation Context (may be NULL-pointer)
+     */
+    static void Release(IoOperation* operation) noexcept;
+
+    /**
+     * @brief Get pool counters. Other threads publish their counters
+     * on slow paths only, so the result is approximate.
+     *
+     * @returns Global counters plus counters of the calling thread
+     */
+    static IoBufferStatistics Statistics() noexcept;
+
+    /**
+     * @brief Get size of buffers of a size class.
+     */
+    static constexpr std::size_t BufferSize(std::uint32_t size_class) noexcept { return kMinBufferSize << size_class; }
+};
+
+
+inline std::size_t IoOperation::Capacity() const noexcept
+{
+    return IoBufferPool::BufferSize(size_class_);
+}
+
+inline void IoOperation::Release() noexcept
+{
+    IoBufferPool::Release(this);
+}
+
+}  // namespace ntp::io
@@ -0,0 +1,631 @@
+/**
+ * @file task.hpp
+ * @brief Implementation of work callbacks with a result (tasks and futures)
+ */
+
+#pragma once
+
+#include <mutex>
+#include <tuple>
+#include <atomic>
+#include <chrono>
+#include <utility>
+#include <optional>
+#include <exception>
+#include <functional>
+#include <type_traits>
+#include <condition_variable>
+
+#include "ntp_config.hpp"
+#include "details/windows.hpp"
+#include "details/exception.hpp"
+#include "pool/basic_callback.hpp"
+
+
+namespace ntp::task {
+
+template<typename Result>
+class Future;
+
+}  // namespace ntp::task
+
+
+namespace ntp::task::details {
+
+/**
+ * @brief Shared state of a task and its future.
+ *
+ * State is referenced by a future and by a runner in the work queue. It is
+ * allocated once (from slab allocator, see ntp::details::ICallback) together
+ * with the task's callable and arguments, hence waiting for a result and
+ * continuations require no additional allocations.
+ *
+ * Derived class implements ntp::details::ICallback::Call, that invokes
+ * the callable and completes the state.
+ *
+ * @tparam Result Type of task's result
+ */
+template<typename Result>
+class alignas(NTP_ALLOCATION_ALIGNMENT) TaskState
+    : public ntp::details::ICallback
+{
+    TaskState(const TaskState&)            = delete;
+    TaskState& operator=(const TaskState&) = delete;
+
+    // Stored value type (void results are stored as empty objects)
+    struct Void
+    { };
+
+    using value_t = std::conditional_t<std::is_void_v<Result>, Void, Result>;
+
+public:
+    /**
+     * @brief Adds a reference to the state.
+     *
+     * @returns Pointer to this state
+     */
+    TaskState* AddRef() noexcept
+    {
+        references_.fetch_add(1, std::memory_order_relaxed);
+        return this;
+    }
+
+    /**
+     * @brief Releases a reference and destroys the state if it was the last one.
+     */
+    void Release() noexcept
+    {
+        if (references_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            delete this;
+        }
+    }
+
+    /**
+     * @brief Checks if a value or an exception is set.
+     */
+    bool IsReady() const noexcept { return ready_.load(std::memory_order_acquire); }
+
+    /**
+     * @brief Waits until the state becomes ready.
+     */
+    void Wait()
+    {
+        if (IsReady())
+        {
+            return;
+        }
+
+        std::unique_lock lock { lock_ };
+        ready_condition_.wait(lock, [this]() { return IsReady(); });
+    }
+
+    /**
+     * @brief Waits until the state becomes ready or timeout expires.
+     *
+     * @param timeout Maximum wait duration
+     * @returns true if the state is ready
+     */
+    template<typename Rep, typename Period>
+    bool WaitFor(const std::chrono::duration<Rep, Period>& timeout)
+    {
+        if (IsReady())
+        {
+            return true;
+        }
+
+        std::unique_lock lock { lock_ };
+        return ready_condition_.wait_for(lock, timeout, [this]() { return IsReady(); });
+    }
+
+    /**
+     * @brief Waits for the result and moves it out of the state.
+     *
+     * @returns Task's result
+     * @throws Exception thrown by the task
+     */
+    Result Get()
+    {
+        Wait();
+
+        if (error_)
+        {
+            std::rethrow_exception(error_);
+        }
+
+        if constexpr (!std::is_void_v<Result>)
+        {
+            return std::move(*value_);
+        }
+    }
+
+    /**
+     * @brief Sets a continuation or runs it immediately if the state is ready.
+     *
+     * @param functor Callable, that accepts ntp::task::Future<Result>
+     */
+    template<typename Functor>
+    void SetContinuation(Functor&& functor);
+
+    /**
+     * @brief Stores a value (state must be completed with Complete after that).
+     */
+    template<typename... Value>
+    void SetValue(Value&&... value)
+    {
+        value_.emplace(std::forward<Value>(value)...);
+    }
+
+    /**
+     * @brief Stores an exception (state must be completed with Complete after that).
+     */
+    void SetException(std::exception_ptr error) noexcept
+    {
+        error_ = std::move(error);
+    }
+
+    /**
+     * @brief Makes the state ready, wakes up waiting threads and runs continuation.
+     *
+     * @throws Exception thrown by continuation
+     */
+    void Complete();
+
+protected:
+    /**
+     * @brief Constructor. State is referenced by a future only.
+     */
+    TaskState() noexcept = default;
+
+private:
+    // Number of owners (future, runner and continuation's future)
+    std::atomic<size_t> references_ { 1 };
+
+    // Is value or exception set
+    std::atomic<bool> ready_ { false };
+
+    // Lock and condition for waiting threads and continuation
+    std::mutex lock_;
+    std::condition_variable ready_condition_;
+
+    // Task's result or exception
+    std::optional<value_t> value_;
+    std::exception_ptr error_;
+
+    // Continuation (invoked with ready future)
+    ntp::details::callback_t continuation_;
+};
+
+
+/**
+ * @brief Continuation callback wrapper. It is invoked with a ready future.
+ *
+ * @tparam Result Type of task's result
+ * @tparam Functor Type of callable
+ */
+template<typename Result, typename Functor>
+class alignas(NTP_ALLOCATION_ALIGNMENT) ContinuationCallback final
+    : public ntp::details::BasicCallback<ContinuationCallback<Result, Functor>, Functor>
+{
+public:
+    /**
+     * @brief Kind of callback in traces.
+     */
+    static constexpr ntp::tracing::CallbackKind kTraceKind = ntp::tracing::CallbackKind::kWork;
+
+    /**
+     * @brief Constructor from callable
+     *
+     * @param functor Callable to invoke
+     */
+    template<typename CFunctor>
+    explicit ContinuationCallback(CFunctor&& functor)
+        : ContinuationCallback::BasicCallback(std::forward<CFunctor>(functor))
+    { }
+
+    /**
+     * @brief Parameter conversion function. Parameter is a pointer to ready future.
+     */
+    Future<Result>* ConvertParameter(void* parameter) { return static_cast<Future<Result>*>(parameter); }
+
+    /**
+     * @brief Continuation is invoked once, so future is moved into callable.
+     */
+    template<typename = void> /* if constexpr works only for templates */
+    void CallImpl(PTP_CALLBACK_INSTANCE /* instance */, Future<Result>* future)
+    {
+        std::invoke(this->Callable(), std::move(*future));
+    }
+};
+
+
+/**
+ * @brief Checks if task's callable accepts PTP_CALLBACK_INSTANCE as its first parameter.
+ */
+template<typename Functor, typename... Args>
+inline constexpr bool accepts_instance_v = std::is_invocable_v<std::decay_t<Functor>&&, PTP_CALLBACK_INSTANCE, std::decay_t<Args>&&...>;
+
+
+/**
+ * @brief Result type of task's callable.
+ */
+template<typename Functor, typename... Args>
+using task_result_t = typename std::conditional_t<accepts_instance_v<Functor, Args...>,
+    std::invoke_result<std::decay_t<Functor>&&, PTP_CALLBACK_INSTANCE, std::decay_t<Args>&&...>,
+    std::invoke_result<std::decay_t<Functor>&&, std::decay_t<Args>&&...>>::type;
+
+
+/**
+ * @brief Task: shared state co-allocated with callable and its arguments.
+ *
+ * @tparam Functor Type of callable to invoke in threadpool
+ * @tparam Args... Types of arguments
+ */
+template<typename Functor, typename... Args>
+class alignas(NTP_ALLOCATION_ALIGNMENT) Task final
+    : public TaskState<task_result_t<Functor, Args...>>
+{
+    // Type of packed arguments
+    using tuple_t = std::tuple<std::decay_t<Args>...>;
+
+    // Type of stored functor
+    using functor_t = std::decay_t<Functor>;
+
+public:
+    /**
+     * @brief Type of task's result.
+     */
+    using result_t = task_result_t<Functor, Args...>;
+
+    static_assert(!std::is_reference_v<result_t>,
+        "[ntp::task::details::Task]: tasks returning references are not supported, use std::reference_wrapper");
+
+    /**
+     * @brief Does callable accept PTP_CALLBACK_INSTANCE.
+     */
+    static constexpr bool kAcceptsInstance = accepts_instance_v<Functor, Args...>;
+
+public:
+    /**
+     * @brief Constructor from callable and its arguments
+     *
+     * @param functor Callable to invoke
+     * @param args Arguments to pass into callable (they will be copied into task)
+     */
+    template<typename CFunctor, typename... CArgs>
+    explicit Task(CFunctor&& functor, CArgs&&... args)
+        : args_(std::forward<CArgs>(args)...)
+        , functor_(std::forward<CFunctor>(functor))
+#if defined(NTP_ENABLE_TRACING)
+        , trace_tag_(ntp::tracing::details::current_tag)
+#endif  // NTP_ENABLE_TRACING
+    { }
+
+private:
+    /**
+     * @brief Invokes callable (once, so callable and arguments are moved) and completes state.
+     *        Exceptions are stored in the state.
+     */
+    void Call(PTP_CALLBACK_INSTANCE instance, void* /* parameter */) override
+    {
+#if defined(NTP_ENABLE_TRACING)
+        ntp::tracing::details::TraceScope scope { ntp::tracing::CallbackKind::kWork, trace_tag_ };
+#endif  // NTP_ENABLE_TRACING
+
+        try
+        {
+            if constexpr (std::is_void_v<result_t>)
+            {
+                Invoke(instance);
+                this->SetValue();
+            }
+            else
+            {
+                this->SetValue(Invoke(instance));
+            }
+        }
+        catch (...)
+        {
+            this->SetException(std::current_exception());
+        }
+
+        this->Complete();
+    }
+
+    result_t Invoke(PTP_CALLBACK_INSTANCE instance)
+    {
+        return std::apply([this, instance](auto&... args) -> result_t {
+            if constexpr (kAcceptsInstance)
+            {
+                return std::invoke(std::move(functor_), instance, std::move(args)...);
+            }
+            else
+            {
+                return std::invoke(std::move(functor_), std::move(args)...);
+            }
+        }, args_);
+    }
+
+private:
+    // Packed arguments
+    tuple_t args_;
+
+    // Callable
+    functor_t functor_;
+
+#if defined(NTP_ENABLE_TRACING)
+    // Tag of task in traces (captured on construction)
+    const char* trace_tag_;
+#endif  // NTP_ENABLE_TRACING
+};
+
+
+/**
+ * @brief Callable, that is stored in the work queue and runs a task.
+ *
+ * Runner owns a reference to the task. If runner is destroyed before
+ * invocation (callbacks are cancelled), task is completed with
+ * ERROR_OPERATION_ABORTED exception.
+ *
+ * @tparam Result Type of task's result
+ * @tparam AcceptsInstance Does task accept PTP_CALLBACK_INSTANCE
+ */
+template<typename Result, bool AcceptsInstance>
+class TaskRunner final
+{
+    TaskRunner(const TaskRunner&)            = delete;
+    TaskRunner& operator=(const TaskRunner&) = delete;
+
+public:
+    explicit TaskRunner(TaskState<Result>* state) noexcept
+        : state_(state)
+    { }
+
+    TaskRunner(TaskRunner&& other) noexcept
+        : state_(std::exchange(other.state_, nullptr))
+    { }
+
+    ~TaskRunner()
+    {
+        if (!state_)
+        {
+            return;
+        }
+
+        try
+        {
+            state_->SetException(std::make_exception_ptr(exception::Win32Exception(ERROR_OPERATION_ABORTED)));
+            state_->Complete();
+        }
+        catch (...)
+        {
+            //
+            // Continuation has thrown, nothing to do here
+            //
+        }
+
+        state_->Release();
+    }
+
+    /**
+     * @brief Runs a task, that accepts PTP_CALLBACK_INSTANCE (work draining
+     *        is stopped after such tasks, see ntp::work::details::WorkCallback).
+     */
+    template<bool Enable = AcceptsInstance, typename = std::enable_if_t<Enable>>
+    void operator()(PTP_CALLBACK_INSTANCE instance)
+    {
+        Run(instance);
+    }
+
+    /**
+     * @brief Runs a task, that does not accept PTP_CALLBACK_INSTANCE.
+     */
+    template<bool Enable = !AcceptsInstance, typename = std::enable_if_t<Enable>>
+    void operator()()
+    {
+        Run(nullptr);
+    }
+
+private:
+    void Run(PTP_CALLBACK_INSTANCE instance)
+    {
+        const auto state = std::exchange(state_, nullptr);
+
+        struct Releaser
+        {
+            ~Releaser() { state->Release(); }
+
+            TaskState<Result>* state;
+        } releaser { state };
+
+        state->Call(instance, nullptr);
+    }
+
+private:
+    // Referenced task
+    TaskState<Result>* state_;
+};
+
+}  // namespace ntp::task::details
+
+
+namespace ntp::task {
+
+/**
+ * @brief Lightweight future for a result of ntp::BasicThreadPool::SubmitTask.
+ *
+ * Future is move-only. Its shared state is co-allocated with the task itself,
+ * so it requires no extra allocations. Exceptions thrown by a task are
+ * rethrown from Get.
+ *
+ * @tparam Result Type of task's result
+ */
+template<typename Result>
+class Future final
+{
+    Future(const Future&)            = delete;
+    Future& operator=(const Future&) = delete;
+
+    // Type of shared state
+    using state_t = details::TaskState<Result>;
+
+public:
+    /**
+     * @brief Constructs an invalid future.
+     */
+    Future() noexcept = default;
+
+    /**
+     * @brief Constructor, that adopts a reference to shared state.
+     */
+    explicit Future(state_t* state) noexcept
+        : state_(state)
+    { }
+
+    Future(Future&& other) noexcept
+        : state_(std::exchange(other.state_, nullptr))
+    { }
+
+    Future& operator=(Future&& other) noexcept
+    {
+        if (this != &other)
+        {
+            Reset();
+            state_ = std::exchange(other.state_, nullptr);
+        }
+
+        return *this;
+    }
+
+    ~Future()
+    {
+        Reset();
+    }
+
+    /**
+     * @brief Checks if future refers to a shared state.
+     */
+    bool Valid() const noexcept { return state_ != nullptr; }
+
+    /**
+     * @brief Checks if result is available (future must be valid).
+     */
+    bool IsReady() const noexcept { return state_->IsReady(); }
+
+    /**
+     * @brief Waits until result is available (future must be valid).
+     */
+    void Wait() const { state_->Wait(); }
+
+    /**
+     * @brief Waits until result is available or timeout expires (future must be valid).
+     *
+     * @param timeout Maximum wait duration
+     * @returns true if result is available
+     */
+    template<typename Rep, typename Period>
+    bool WaitFor(const std::chrono::duration<Rep, Period>& timeout) const
+    {
+        return state_->WaitFor(timeout);
+    }
+
+    /**
+     * @brief Waits for result and returns it. Future becomes invalid.
+     *
+     * @returns Task's result
+     * @throws Exception thrown by the task or ntp::exception::Win32Exception
+     *         (ERROR_OPERATION_ABORTED) if the task was cancelled
+     */
+    Result Get()
+    {
+        const Future holder { std::exchange(state_, nullptr) };
+        return holder.state_->Get();
+    }
+
+    /**
+     * @brief Attaches a continuation. Future becomes invalid.
+     *
+     * Continuation is invoked with a ready future right in the thread, that completes
+     * the task. If the task is already completed, continuation is invoked immediately
+     * in the calling thread.
+     *
+     * @param functor Callable, that accepts ntp::task::Future<Result>
+     */
+    template<typename Functor>
+    void Then(Functor&& functor)
+    {
+        const Future holder { std::exchange(state_, nullptr) };
+        holder.state_->SetContinuation(std::forward<Functor>(functor));
+    }
+
+private:
+    void Reset() noexcept
+    {
+        if (state_)
+        {
+            std::exchange(state_, nullptr)->Release();
+        }
+    }
+
+private:
+    // Shared state
+    state_t* state_ = nullptr;
+};
+
+}  // namespace ntp::task
+
+
+namespace ntp::task::details {
+
+template<typename Result>
+template<typename Functor>
+void TaskState<Result>::SetContinuation(Functor&& functor)
+{
+    using callback_t = ContinuationCallback<Result, Functor>;
+
+    {
+        std::lock_guard lock { lock_ };
+
+        if (!IsReady())
+        {
+            continuation_.template Emplace<callback_t>(std::forward<Functor>(functor));
+            return;
+        }
+    }
+
+    Future<Result> future { AddRef() };
+    callback_t continuation { std::forward<Functor>(functor) };
+
+    static_cast<ntp::details::ICallback&>(continuation).Call(nullptr, &future);
+}
+
+template<typename Result>
+void TaskState<Result>::Complete()
+{
+    {
+        std::lock_guard lock { lock_ };
+        ready_.store(true, std::memory_order_release);
+    }
+
+    ready_condition_.notify_all();
+
+    //
+    // Continuation cannot be set after the state became ready
+    //
+
+    if (continuation_)
+    {
+        Future<Result> future { AddRef() };
+
+        struct Resetter
+        {
+            ~Resetter() { continuation.Reset(); }
+
+            ntp::details::callback_t& continuation;
+        } resetter { continuation_ };
+
+        continuation_->Call(nullptr, &future);
+    }
+}
+
+}  // namespace ntp::task::details
@@ -9,6 +9,7 @@
 #pragma once
 
 #include <chrono>
+#include <iterator>
 #include <type_traits>
 
 #include "details/allocator.hpp"
@@ -17,6 +18,14 @@
 #include "pool/wait.hpp"
 #include "pool/timer.hpp"
 #include "pool/io.hpp"
+#include "pool/coroutine.hpp"
+
+
+namespace ntp::coroutine::details {
+
+struct PoolAccess;
+
+}  // namespace ntp::coroutine::details
 
 
 namespace ntp {
@@ -142,6 +151,14 @@ private:
 using wait_t = wait::details::WaitManager::native_handle_t;
 
 
+/**
+ * @brief Opaque threadpool wait group descriptor.
+ *
+ * Intentionally defined as group handle for WaitManager.
+ */
+using wait_group_t = wait::details::WaitManager::group_handle_t;
+
+
 /**
  * @brief Opaque threadpool timer object descriptor.
  *
@@ -150,6 +167,14 @@ using wait_t = wait::details::WaitManager::native_handle_t;
 using timer_t = timer::details::TimerManager::native_handle_t;
 
 
+/**
+ * @brief Opaque soft timer descriptor.
+ *
+ * Intentionally defined as soft timer handle for TimerManager.
+ */
+using soft_timer_t = timer::details::TimerManager::soft_handle_t;
+
+
 /**
  * @brief Opaque threadpool IO object descriptor.
  *
@@ -158,6 +183,12 @@ using timer_t = timer::details::TimerManager::native_handle_t;
 using io_t = io::details::IoManager::native_handle_t;
 
 
+/**
+ * @brief Long-lived binding of a handle to threadpool IO.
+ */
+using io_binding_t = io::IoBinding;
+
+
 /**
  * @brief Basic threadpool class, that provides an interface 
  *        for interacting with a pool.
@@ -175,6 +206,8 @@ using io_t = io::details::IoManager::native_handle_t;
  * - Timer objects, that execute your arbitrary callback, when timer expires. 
  *   They may be scheduled for periodical calls. You may exchange callback 
  *   submitted earlier with a new one, and next time timer will call an updated one.
+ *   Soft timers are lightweight alternative for large numbers of timeouts: all
+ *   of them are driven by a single threadpool timer via a timing wheel.
  * 
  * - IO objects, that execute your arbitrary callback, when asynchronous IO
  *   is completed.
@@ -192,6 +225,10 @@ class BasicThreadPool final
     // Alias for traits type
     using traits_t = ThreadPoolTraits;
 
+    // Awaitables are created by free functions (class definition
+    // must not depend on coroutine support)
+    friend struct coroutine::details::PoolAccess;
+
 private:
     BasicThreadPool(const BasicThreadPool&)            = delete;
     BasicThreadPool& operator=(const BasicThreadPool&) = delete;
@@ -230,7 +267,7 @@ public:
      * @param max_threads Maximum number of threads.
      * @param test_cancel Cancellation test function (defaulted to ntp::details::DefaultTestCancel).
      */
-    template<typename = std::enable_if_t<std::is_same_v<traits_t, details::CustomThreadPoolTraits>>>
+    template<typename Traits = traits_t, typename = std::enable_if_t<std::is_same_v<Traits, details::CustomThreadPoolTraits>>>
     explicit BasicThreadPool(DWORD min_threads, DWORD max_threads, details::test_cancel_t test_cancel = details::DefaultTestCancel)
         : traits_(min_threads, max_threads)
         , cleanup_group_(traits_.Environment())
@@ -248,8 +285,13 @@ public:
     {
         //
         // Managers dont cancel all their pending callbacks. They are cancelled and closed here.
+        // Work callbacks are cancelled first, because running work invocations drain the queue.
+        // Other objects are closed under managers' locks, so callbacks removing their own
+        // objects concurrently will not find them in containers.
         //
 
+        CancelAllCallbacks();
+
         ntp::details::SafeThreadpoolCall<CloseThreadpoolCleanupGroupMembers>(
             cleanup_group_, TRUE, nullptr);
     }
@@ -293,6 +335,87 @@ public:
             std::forward<Args>(args)...);
     }
 
+    /**
+     * @brief Submits a work callback, that returns a result, into threadpool.
+     * 
+     * Usage example:
+     * @code{.cpp}
+     * ntp::SystemThreadPool pool;
+     * 
+     * auto future = pool.SubmitTask([] (int value) {
+     *     return value * 2;
+     * }, 21);
+     * 
+     * future.Then([] (ntp::task::Future<int> ready) {
+     *     //
+     *     // Continuation is invoked right in the worker thread, which completed the task.
+     *     // Get rethrows an exception, if the task has thrown it.
+     *     //
+     * 
+     *     Consume(ready.Get());
+     * });
+     * @endcode
+     * 
+     * Unlike SubmitWork callbacks, exceptions thrown by a task are not reported to logger, 
+     * but rethrown from ntp::task::Future::Get. If the task is cancelled, Get throws
+     * ntp::exception::Win32Exception with ERROR_OPERATION_ABORTED code.
+     *
+     * @param functor  Callable to invoke. It MAY accept `PTP_CALLBACK_INSTANCE` as its first parameter.
+     * @param args     Arguments to pass into callable. They will be copied into the task by default.
+     * @returns ntp::task::Future for the callable's result.
+     */
+    template<typename Functor, typename... Args>
+    auto SubmitTask(Functor&& functor, Args&&... args)
+    {
+        return work_manager_.SubmitTask(std::forward<Functor>(functor),
+            std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief Submits a work callback for every element of a range.
+     *
+     * All callbacks are pushed into the internal queue at once and only as many
+     * threads as there are processors are woken up, therefore it is much cheaper
+     * than SubmitWork in a loop.
+     *
+     * Usage example:
+     * @code{.cpp}
+     * ntp::SystemThreadPool pool;
+     * std::vector<std::string> files = GetFiles();
+     *
+     * pool.SubmitWorkBatch(files, [] (const std::string& file) {
+     *     //
+     *     // Every element is copied into its own callback wrapper
+     *     //
+     * });
+     * @endcode
+     *
+     * @param first    Beginning of the range (forward iterator)
+     * @param last     End of the range
+     * @param functor  Callable to invoke for every element. It MAY accept `PTP_CALLBACK_INSTANCE`
+     *                 as its first parameter. It is copied once and shared by all callbacks
+     *                 of the batch, hence it may be invoked concurrently as a const object.
+     */
+    template<typename Iterator, typename Functor>
+    void SubmitWorkBatch(Iterator first, Iterator last, const Functor& functor)
+    {
+        return work_manager_.SubmitBatch(first, last, functor);
+    }
+
+    /**
+     * @brief Submits a work callback for every element of a range.
+     *
+     * Just calls iterator version of SubmitWorkBatch.
+     *
+     * @param range    Range of elements (std::begin and std::end must be applicable)
+     * @param functor  Callable to invoke for every element
+     */
+    template<typename Range, typename Functor>
+    void SubmitWorkBatch(Range&& range, const Functor& functor)
+    {
+        return SubmitWorkBatch(std::begin(range), std::end(range), functor);
+    }
+
     /**
      * @brief Waits until all work callbacks are completed or cancellation is requested.
      *
@@ -354,6 +477,15 @@ public:
      *         FreeLibraryWhenCallbackReturns(instance, custom_dll);
      *     }
      * });
+     * 
+     * //
+     * // Persistent wait: the same wait object waits for the event again after each callback
+     * //
+     * 
+     * pool.SubmitWait(auto_reset_event, 1min, [] (TP_WAIT_RESULT wait_result) {
+     *     // Handle signal or timeout
+     *     return ntp::wait::WaitAction::kRearm;
+     * });
      * @endcode
      * 
      * @param wait_handle Handle to wait for. May be any handle, that you can pass to `WaitForSingleObject`.
@@ -366,6 +498,9 @@ public:
      *                    - `TP_WAIT_RESULT` wait_result - The result of the wait operation. This parameter can 
      *                                                     be one of the following values from `WaitForMultipleObjects`:
      *                                                     `WAIT_OBJECT_0`, `WAIT_TIMEOUT`.
+     *                    Callable MAY return ntp::wait::WaitAction. If it returns ntp::wait::WaitAction::kRearm,
+     *                    wait object is not closed and waits for the same handle with the same timeout again
+     *                    (arguments are not moved into callable then).
      * @param args        Arguments to pass into callable. They will be copied into wrapper by default.
      *                    You schould use `std::ref` or `std::cref` to pass a parameter by reference,
      *                    but you must guarantee the parameter's validity until the callback is finished.
@@ -403,6 +538,7 @@ public:
      *                    - `TP_WAIT_RESULT` wait_result - The result of the wait operation. This parameter can
      *                                                     be one of the following values from `WaitForMultipleObjects`:
      *                                                     `WAIT_OBJECT_0`, `WAIT_TIMEOUT`.
+     *                    Callable MAY return ntp::wait::WaitAction (see the overload with timeout).
      * @param args        Arguments to pass into callable. They will be copied into wrapper by default.
      *                    You schould use `std::ref` or `std::cref` to pass a parameter by reference,
      *                    but you must guarantee the parameter's validity until the callback is finished.
@@ -439,9 +575,92 @@ public:
     void CancelWait(wait_t wait_object) noexcept { return wait_manager_.Cancel(wait_object); }
 
     /**
-     * @brief Cancel all pending wait callbacks.
+     * @brief Submits a wait callback for each of many handles at once.
+     *
+     * Unlike a sequence of ntp::BasicThreadPool::SubmitWait calls, callback is stored once for
+     * the whole set, storage for handles and wait objects is allocated once, and all waits are
+     * registered under a single lock. The whole set is cancelled as a unit with
+     * ntp::BasicThreadPool::CancelWaitGroup. Group is released automatically, when callbacks
+     * for all handles are completed.
+     *
+     * Usage example:
+     * @code{.cpp}
+     * ntp::SystemThreadPool pool;
+     * std::vector<HANDLE> processes = SpawnWorkers();
+     *
+     * const auto group = pool.SubmitWaits(processes, 10min, [] (HANDLE process, TP_WAIT_RESULT wait_result) {
+     *     if (WAIT_OBJECT_0 == wait_result)
+     *     {
+     *         // Process has exited
+     *     }
+     * });
+     *
+     * //
+     * // Supervisor is stopping, so nobody cares about remaining processes
+     * //
+     *
+     * pool.CancelWaitGroup(group);
+     * @endcode
+     *
+     * @param wait_handles Contiguous range of handles to wait for (e.g. `std::vector<HANDLE>`,
+     *                     `std::array<HANDLE, N>` or `std::span<HANDLE>`). Each of them may be any handle,
+     *                     that you can pass to `WaitForSingleObject` (e.g. process handles or, on Linux,
+     *                     pidfd and eventfd descriptors).
+     * @param timeout      Timeout while each wait object waits for its handle
+     *                     (pass ntp::time::max_native_duration for infinite wait timeout).
+     * @param functor      Callable to invoke. It is shared by all handles and MAY be invoked concurrently.
+     *                     It MAY accept `PTP_CALLBACK_INSTANCE` as its first parameter. However, it MUST
+     *                     accept the following parameters next:
+     *                     - `HANDLE` wait_handle - The handle, which wait is completed.
+     *                     - `TP_WAIT_RESULT` wait_result - The result of the wait operation (`WAIT_OBJECT_0`
+     *                                                      or `WAIT_TIMEOUT`).
+     *                     Callable MAY return ntp::wait::WaitAction. If it returns ntp::wait::WaitAction::kRearm,
+     *                     wait object of this handle waits for it with the same timeout again.
+     * @param args         Arguments to pass into callable. They will be copied into wrapper by default and
+     *                     are passed into every invocation by reference.
+     * @returns            Handle for created wait group.
+     */
+    template<typename Handles, typename Rep, typename Period, typename Functor, typename... Args>
+    wait_group_t SubmitWaits(const Handles& wait_handles, const std::chrono::duration<Rep, Period>& timeout, Functor&& functor, Args&&... args)
+    {
+        return wait_manager_.SubmitGroup(wait_handles, timeout, std::forward<Functor>(functor),
+            std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief Submits a wait callback for each of many handles at once (timeouts never expire).
+     *
+     * @param wait_handles Contiguous range of handles to wait for (see the overload with timeout).
+     * @param functor      Callable to invoke (see the overload with timeout).
+     * @param args         Arguments to pass into callable. They will be copied into wrapper by default and
+     *                     are passed into every invocation by reference.
+     * @returns            Handle for created wait group.
      */
-    void CancelWaits() noexcept { return wait_manager_.CancelAll(); }
+    template<typename Handles, typename Functor, typename... Args>
+    auto SubmitWaits(const Handles& wait_handles, Functor&& functor, Args&&... args)
+        -> std::enable_if_t<
+            !ntp::time::details::is_duration_v<std::decay_t<Functor>>,
+            wait_group_t>
+    {
+        return wait_manager_.SubmitGroup(wait_handles, std::forward<Functor>(functor),
+            std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief Cancel all waits of a group. If all of them are already completed, does nothing.
+     *
+     * @param wait_group Handle for a wait group (obtained from ntp::BasicThreadPool::SubmitWaits).
+     */
+    void CancelWaitGroup(wait_group_t wait_group) noexcept { return wait_manager_.CancelGroup(wait_group); }
+
+    /**
+     * @brief Cancel all pending wait callbacks (including wait groups).
+     */
+    void CancelWaits() noexcept
+    {
+        wait_manager_.CancelAll();
+        wait_manager_.CancelAllGroups();
+    }
 
 
     /**
@@ -460,7 +679,8 @@ public:
      *
      * @param timeout Timeout after which timer object calls the callback for the first time.
      * @param period  Period of the timer. Callback will be triggered after each such interval is elapsed.
-     *                Pass zero, if you want to create a timer, that will be triggered only once.
+     *                Pass zero, if you want to create a timer, that will be triggered only once. Periods, that
+     *                are not whole milliseconds, are handled as in ntp::BasicThreadPool::SubmitPeriodicTimer.
      * @param functor Callable to invoke. It MAY accept `PTP_CALLBACK_INSTANCE` as its first parameter.
      *                If you don't need it, you just don't pass it.
      * @param args    Arguments to pass into callable. They will be copied into wrapper by default.
@@ -469,12 +689,67 @@ public:
      * @returns       Handle for created timer object.
      */
     template<typename Rep1, typename Period1, typename Rep2, typename Period2, typename Functor, typename... Args>
-    timer_t SubmitTimer(const std::chrono::duration<Rep1, Period1>& timeout, const std::chrono::duration<Rep2, Period2>& period, Functor&& functor, Args&&... args)
+    auto SubmitTimer(const std::chrono::duration<Rep1, Period1>& timeout, const std::chrono::duration<Rep2, Period2>& period, Functor&& functor, Args&&... args)
+        -> std::enable_if_t<!ntp::time::details::is_timer_argument_v<std::decay_t<Functor>>, timer_t>
     {
         return timer_manager_.Submit(timeout, period, std::forward<Functor>(functor),
             std::forward<Args>(args)...);
     }
 
+    /**
+     * @brief Submits a threadpool timer object with a user-defined callback and tolerable delay.
+     *
+     * Tolerance is passed to the threadpool as timer's window length, so that the system
+     * may coalesce expirations of timers and wake up less often. Timer is triggered
+     * somewhere between its due time and due time plus tolerance.
+     *
+     * Usage example:
+     * @code{.cpp}
+     * ntp::SystemThreadPool pool;
+     * pool.SubmitTimer(1min, 1min, ntp::time::Tolerance(5s), [] () {
+     *     //
+     *     // Housekeeping, that may be delayed for up to 5 seconds
+     *     //
+     * });
+     * @endcode
+     *
+     * @param timeout   Timeout after which timer object calls the callback for the first time.
+     * @param period    Period of the timer. Pass zero, if you want to create a timer, that will be triggered only once.
+     * @param tolerance Tolerable delay of each expiration.
+     * @param functor   Callable to invoke. It MAY accept `PTP_CALLBACK_INSTANCE` as its first parameter.
+     *                  If you don't need it, you just don't pass it.
+     * @param args      Arguments to pass into callable. They will be copied into wrapper by default.
+     *                  You schould use `std::ref` or `std::cref` to pass a parameter by reference,
+     *                  but you must guarantee the parameter's validity until the callback is finished.
+     * @returns         Handle for created timer object.
+     */
+    template<typename Rep1, typename Period1, typename Rep2, typename Period2, typename Functor, typename... Args>
+    timer_t SubmitTimer(const std::chrono::duration<Rep1, Period1>& timeout, const std::chrono::duration<Rep2, Period2>& period,
+        ntp::time::Tolerance tolerance, Functor&& functor, Args&&... args)
+    {
+        return timer_manager_.Submit(timeout, period, tolerance, std::forward<Functor>(functor),
+            std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief Submits a non-periodic threadpool timer object with a user-defined callback and tolerable delay.
+     *
+     * @param timeout   Timeout after which timer object calls the callback.
+     * @param tolerance Tolerable delay of expiration.
+     * @param functor   Callable to invoke. It MAY accept `PTP_CALLBACK_INSTANCE` as its first parameter.
+     *                  If you don't need it, you just don't pass it.
+     * @param args      Arguments to pass into callable. They will be copied into wrapper by default.
+     *                  You schould use `std::ref` or `std::cref` to pass a parameter by reference,
+     *                  but you must guarantee the parameter's validity until the callback is finished.
+     * @returns         Handle for created timer object.
+     */
+    template<typename Rep, typename Period, typename Functor, typename... Args>
+    timer_t SubmitTimer(const std::chrono::duration<Rep, Period>& timeout, ntp::time::Tolerance tolerance, Functor&& functor, Args&&... args)
+    {
+        return timer_manager_.Submit(timeout, std::chrono::milliseconds(0), tolerance, std::forward<Functor>(functor),
+            std::forward<Args>(args)...);
+    }
+
     /**
      * @brief Submits a non-periodic threadpool timer object with a user-defined callback.
      *
@@ -498,10 +773,7 @@ public:
      */
     template<typename Rep, typename Period, typename Functor, typename... Args>
     auto SubmitTimer(const std::chrono::duration<Rep, Period>& timeout, Functor&& functor, Args&&... args)
-        -> std::enable_if_t<
-            !ntp::time::details::is_duration_v<std::decay_t<Functor>> &&
-                !ntp::time::details::is_time_point_v<std::decay_t<Functor>>,
-            timer_t>
+        -> std::enable_if_t<!ntp::time::details::is_timer_argument_v<std::decay_t<Functor>>, timer_t>
     {
         return timer_manager_.Submit(timeout, std::forward<Functor>(functor),
             std::forward<Args>(args)...);
@@ -544,11 +816,55 @@ public:
      */
     template<typename Clock, typename Duration, typename Rep, typename Period, typename Functor, typename... Args>
     auto SubmitTimer(const ntp::time::deadline_t<Clock, Duration>& deadline, const std::chrono::duration<Rep, Period>& period, Functor&& functor, Args&&... args)
+        -> std::enable_if_t<!ntp::time::details::is_timer_argument_v<std::decay_t<Functor>>, timer_t>
     {
         return timer_manager_.Submit(deadline, period, std::forward<Functor>(functor),
             std::forward<Args>(args)...);
     }
 
+    /**
+     * @brief Submits a threadpool deadline timer object with a user-defined callback and tolerable delay.
+     *
+     * If deadline is already gone, timer expires immediately. Tolerance is passed to the threadpool
+     * as timer's window length (see overload for relative timeouts).
+     *
+     * @param deadline  A specific point in time, which the timer will expire at for the first time.
+     * @param period    Period of the timer. Pass zero, if you want to create a timer, that will be triggered only once.
+     * @param tolerance Tolerable delay of each expiration.
+     * @param functor   Callable to invoke. It MAY accept `PTP_CALLBACK_INSTANCE` as its first parameter.
+     *                  If you don't need it, you just don't pass it.
+     * @param args      Arguments to pass into callable. They will be copied into wrapper by default.
+     *                  You schould use `std::ref` or `std::cref` to pass a parameter by reference,
+     *                  but you must guarantee the parameter's validity until the callback is finished.
+     * @returns         Handle for created timer object.
+     */
+    template<typename Clock, typename Duration, typename Rep, typename Period, typename Functor, typename... Args>
+    timer_t SubmitTimer(const ntp::time::deadline_t<Clock, Duration>& deadline, const std::chrono::duration<Rep, Period>& period,
+        ntp::time::Tolerance tolerance, Functor&& functor, Args&&... args)
+    {
+        return timer_manager_.Submit(deadline, period, tolerance, std::forward<Functor>(functor),
+            std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief Submits a non-periodic threadpool deadline timer object with a user-defined callback and tolerable delay.
+     *
+     * @param deadline  A specific point in time, which the timer will expire at.
+     * @param tolerance Tolerable delay of expiration.
+     * @param functor   Callable to invoke. It MAY accept `PTP_CALLBACK_INSTANCE` as its first parameter.
+     *                  If you don't need it, you just don't pass it.
+     * @param args      Arguments to pass into callable. They will be copied into wrapper by default.
+     *                  You schould use `std::ref` or `std::cref` to pass a parameter by reference,
+     *                  but you must guarantee the parameter's validity until the callback is finished.
+     * @returns         Handle for created timer object.
+     */
+    template<typename Clock, typename Duration, typename Functor, typename... Args>
+    timer_t SubmitTimer(const ntp::time::deadline_t<Clock, Duration>& deadline, ntp::time::Tolerance tolerance, Functor&& functor, Args&&... args)
+    {
+        return timer_manager_.Submit(deadline, std::chrono::milliseconds(0), tolerance, std::forward<Functor>(functor),
+            std::forward<Args>(args)...);
+    }
+
     /**
      * @brief Submits a non-periodic threadpool deadline timer object with a user-defined callback.
      *
@@ -582,18 +898,83 @@ public:
      */
     template<typename Clock, typename Duration, typename Functor, typename... Args>
     auto SubmitTimer(const ntp::time::deadline_t<Clock, Duration>& deadline, Functor&& functor, Args&&... args)
-        -> std::enable_if_t<
-            !ntp::time::details::is_duration_v<std::decay_t<Functor>> &&
-                !ntp::time::details::is_time_point_v<std::decay_t<Functor>>,
-            timer_t>
+        -> std::enable_if_t<!ntp::time::details::is_timer_argument_v<std::decay_t<Functor>>, timer_t>
     {
         return timer_manager_.Submit(deadline, std::forward<Functor>(functor),
             std::forward<Args>(args)...);
     }
 
+    /**
+     * @brief Submits a precise periodic timer with a user-defined callback.
+     *
+     * Unlike ntp::BasicThreadPool::SubmitTimer, period is not limited to whole milliseconds:
+     * ticks are scheduled at absolute deadlines (timeout + N * period) with 100 ns resolution,
+     * so timer does not drift, however late individual callbacks are. Actual precision
+     * depends on system timer resolution. Callbacks of the same timer never overlap: ticks,
+     * that are gone while callback runs, are skipped and reported to the next invocation.
+     *
+     * Usage example:
+     * @code{.cpp}
+     * ntp::SystemThreadPool pool;
+     * auto jitter = std::make_shared<ntp::time::JitterHistogram>();
+     *
+     * pool.SubmitPeriodicTimer(0s, 250us, jitter, [] (const ntp::time::TimerTick& tick) {
+     *     //
+     *     // Sample something every 250 microseconds, tick.missed tells
+     *     // how many samples were skipped
+     *     //
+     * });
+     *
+     * //
+     * // Later: jitter->Percentile(0.99)
+     * //
+     * @endcode
+     *
+     * @param timeout Timeout of the first tick.
+     * @param period  Period of the timer (must be positive).
+     * @param jitter  Histogram to record delays of ticks into. May be empty.
+     * @param functor Callable to invoke. It MAY accept `PTP_CALLBACK_INSTANCE` as its first parameter
+     *                and then `const ntp::time::TimerTick&`. If you don't need them, you just don't pass them.
+     * @param args    Arguments to pass into callable. They will be copied into wrapper by default.
+     *                You schould use `std::ref` or `std::cref` to pass a parameter by reference,
+     *                but you must guarantee the parameter's validity until the callback is finished.
+     * @throws exception::Win32Exception If period is not positive.
+     * @returns       Handle for created timer object.
+     */
+    template<typename Rep1, typename Period1, typename Rep2, typename Period2, typename Functor, typename... Args>
+    timer_t SubmitPeriodicTimer(const std::chrono::duration<Rep1, Period1>& timeout, const std::chrono::duration<Rep2, Period2>& period,
+        std::shared_ptr<ntp::time::JitterHistogram> jitter, Functor&& functor, Args&&... args)
+    {
+        return timer_manager_.SubmitPeriodic(timeout, period, std::move(jitter), std::forward<Functor>(functor),
+            std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief Submits a precise periodic timer with a user-defined callback and without jitter statistics.
+     *
+     * @param timeout Timeout of the first tick.
+     * @param period  Period of the timer (must be positive).
+     * @param functor Callable to invoke. It MAY accept `PTP_CALLBACK_INSTANCE` as its first parameter
+     *                and then `const ntp::time::TimerTick&`. If you don't need them, you just don't pass them.
+     * @param args    Arguments to pass into callable. They will be copied into wrapper by default.
+     *                You schould use `std::ref` or `std::cref` to pass a parameter by reference,
+     *                but you must guarantee the parameter's validity until the callback is finished.
+     * @throws exception::Win32Exception If period is not positive.
+     * @returns       Handle for created timer object.
+     */
+    template<typename Rep1, typename Period1, typename Rep2, typename Period2, typename Functor, typename... Args>
+    auto SubmitPeriodicTimer(const std::chrono::duration<Rep1, Period1>& timeout, const std::chrono::duration<Rep2, Period2>& period,
+        Functor&& functor, Args&&... args)
+        -> std::enable_if_t<!ntp::time::details::is_timer_argument_v<std::decay_t<Functor>>, timer_t>
+    {
+        return timer_manager_.SubmitPeriodic(timeout, period, std::forward<Functor>(functor),
+            std::forward<Args>(args)...);
+    }
+
     /**
      * @brief Replaces an existing timer callback in threadpool.
      *        This method cannot be called concurrently for the same timer object.
+     *        Timer keeps its original deadline and period.
      *
      * Usage example:
      * @code{.cpp}
@@ -625,6 +1006,38 @@ public:
             std::forward<Args>(args)...);
     }
 
+    /**
+     * @brief Sets a new timeout of an existing timer. Callback, period and tolerance are kept.
+     *        This method cannot be called concurrently for the same timer object.
+     *
+     * Nothing is reallocated here and timers container is not locked exclusively,
+     * so it is a cheap way to postpone a timer, that is "touched" frequently
+     * (e.g. idle timeout, that is reset on each received packet).
+     *
+     * Usage example:
+     * @code{.cpp}
+     * ntp::SystemThreadPool pool;
+     * const auto timer = pool.SubmitTimer(30s, [] () { ... });
+     *
+     * //
+     * // Some activity happened, so timer should expire 30 seconds after it
+     * //
+     *
+     * pool.RearmTimer(timer, 30s);
+     * @endcode
+     *
+     * @param timer_object Handle for an existing timer object (obtained from ntp::BasicThreadPool::SubmitTimer).
+     * @param timeout      New timeout, counted from now.
+     * @returns            true if timer is rearmed, false if it is not present anymore or it is a one-shot timer,
+     *                      that has already expired (its callback may be still running). In the latter case
+     *                      a new timer should be submitted.
+     */
+    template<typename Rep, typename Period>
+    bool RearmTimer(timer_t timer_object, const std::chrono::duration<Rep, Period>& timeout) noexcept
+    {
+        return timer_manager_.Rearm(timer_object, timeout);
+    }
+
     /**
      * @brief Cancel threadpool timer.
      *
@@ -649,6 +1062,69 @@ public:
      */
     void CancelTimers() noexcept { return timer_manager_.CancelAll(); }
 
+    /**
+     * @brief Submits a soft timer with a user-defined callback.
+     *
+     * Unlike ntp::BasicThreadPool::SubmitTimer, no threadpool timer object is created:
+     * soft timers are kept in a hierarchical timing wheel, that is driven by a single
+     * threadpool timer. Submission and cancellation are O(1), so soft timers suit
+     * large numbers of timeouts, that are mostly cancelled (e.g. idle timeouts of
+     * connections). Timer expires on the first tick after timeout (see
+     * ntp::BasicThreadPool::SetSoftTimerResolution). Callbacks of soft timers
+     * are invoked one by one from the tick callback, so they should be short.
+     *
+     * Usage example:
+     * @code{.cpp}
+     * ntp::SystemThreadPool pool;
+     * const auto timer = pool.SubmitSoftTimer(30s, [] () { ... });
+     *
+     * //
+     * // Connection is active again, so idle timer is not needed anymore
+     * //
+     *
+     * pool.CancelSoftTimer(timer);
+     * @endcode
+     *
+     * @param timeout  Timeout after which timer expires.
+     * @param functor  Callable to invoke. It MAY accept `PTP_CALLBACK_INSTANCE` as its first parameter.
+     *                 If you don't need it, you just don't pass it.
+     * @param args     Arguments to pass into callable. They will be copied into wrapper by default.
+     *                 You schould use `std::ref` or `std::cref` to pass a parameter by reference,
+     *                 but you must guarantee the parameter's validity until the callback is finished.
+     * @returns        Handle for created soft timer.
+     */
+    template<typename Rep, typename Period, typename Functor, typename... Args>
+    soft_timer_t SubmitSoftTimer(const std::chrono::duration<Rep, Period>& timeout, Functor&& functor, Args&&... args)
+    {
+        return timer_manager_.SubmitSoft(timeout, std::forward<Functor>(functor),
+            std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief Cancel soft timer. If it has already expired, does nothing.
+     *
+     * @param timer_object Handle for a soft timer (obtained from ntp::BasicThreadPool::SubmitSoftTimer).
+     */
+    void CancelSoftTimer(soft_timer_t timer_object) noexcept { return timer_manager_.CancelSoft(timer_object); }
+
+    /**
+     * @brief Cancel all soft timers. Must not be called from soft timer's callback.
+     */
+    void CancelSoftTimers() noexcept { return timer_manager_.CancelAllSoft(); }
+
+    /**
+     * @brief Set resolution of soft timers (tick of the timing wheel).
+     *        Default is NTP_SOFT_TIMER_RESOLUTION_US microseconds.
+     *
+     * @param resolution Positive duration of a tick.
+     * @throws exception::Win32Exception If there are pending soft timers or resolution is not positive.
+     */
+    template<typename Rep, typename Period>
+    void SetSoftTimerResolution(const std::chrono::duration<Rep, Period>& resolution)
+    {
+        timer_manager_.SetSoftResolution(std::chrono::duration_cast<ntp::time::native_duration_t>(resolution));
+    }
+
 
     /**
      * @brief Submits a threadpool IO object with a user-defined callback.
@@ -736,10 +1212,103 @@ public:
     void AbortIo(io_t io_object) noexcept { return io_manager_.Abort(io_object); }
 
     /**
-     * @brief Cancel all pending IO callbacks.
+     * @brief Binds a handle to threadpool IO for any number of asynchronous operations.
+     *
+     * ntp::BasicThreadPool::SubmitIo serves exactly one operation: IO object is removed
+     * after the first completion. Binding lives until ntp::BasicThreadPool::UnbindIo is
+     * called, and its callback is invoked for every completed operation. Each operation
+     * MUST be announced with ntp::io::IoBinding::BeginOperation right before it is started,
+     * and ntp::io::IoBinding::AbortOperation MUST be called, if it fails to start.
+     * Completions do not touch pool's internal containers, so per-operation state
+     * should be reachable from the OVERLAPPED pointer (e.g. OVERLAPPED is the first
+     * member of a per-operation structure).
+     *
+     * Usage example:
+     * @code{.cpp}
+     * struct ReadOperation
+     * {
+     *     OVERLAPPED overlapped;
+     *     std::array<char, 4096> buffer;
+     *     Connection* connection;
+     * };
+     *
+     * ntp::SystemThreadPool pool;
+     * const auto binding = pool.BindIo(socket, [] (LPVOID overlapped, ULONG result, ULONG_PTR bytes_transferred) {
+     *     auto operation = static_cast<ReadOperation*>(overlapped);
+     *     operation->connection->OnRead(operation, result, bytes_transferred);
+     * });
+     *
+     * auto operation = new ReadOperation { {}, {}, connection };
+     * binding.BeginOperation();
+     *
+     * if (!ReadFile(socket, operation->buffer.data(), size, nullptr, &operation->overlapped) &&
+     *     GetLastError() != ERROR_IO_PENDING)
+     * {
+     *     binding.AbortOperation();
+     *     delete operation;
+     * }
+     *
+     * //
+     * // ... and so on for every further operation, until connection is closed
+     * //
+     *
+     * pool.UnbindIo(binding);
+     * @endcode
+     *
+     * @param io_handle Handle of an object, which asynchronous IO is performed on.
+     * @param functor   Callable to invoke on every completion. Accepts the same parameters as callable
+     *                  passed into ntp::BasicThreadPool::SubmitIo.
+     * @param args      Arguments to pass into callable. They will be copied into wrapper by default and
+     *                  are passed into every invocation by reference.
+     * @returns         Binding of the handle.
+     */
+    template<typename Functor, typename... Args>
+    [[nodiscard]] io_binding_t BindIo(HANDLE io_handle, Functor&& functor, Args&&... args)
+    {
+        return io_manager_.Bind(io_handle, std::forward<Functor>(functor),
+            std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief Removes IO binding. Waits for running completion callbacks and cancels queued ones.
+     *        Binding must not be used after this call.
+     *
+     * @param binding Binding of a handle (obtained from ntp::BasicThreadPool::BindIo).
+     */
+    void UnbindIo(io_binding_t binding) noexcept { return io_manager_.Cancel(binding.NativeHandle()); }
+
+    /**
+     * @brief Cancel all pending IO callbacks (including IO bindings).
      */
     void CancelIos() noexcept { return io_manager_.CancelAll(); }
 
+    /**
+     * @brief Collects metrics of all callback kinds.
+     *
+     * Counters are sharded per thread, so recording is cheap, but a snapshot
+     * sums up all shards and is approximate, if callbacks run concurrently.
+     * Enqueue-to-start latency is recorded for work callbacks only (other
+     * callbacks are started by the system, when their objects are signaled).
+     *
+     * Usage example:
+     * @code{.cpp}
+     * ntp::SystemThreadPool pool;
+     *
+     * //
+     * // Submit some callbacks to thread pool
+     * //
+     *
+     * const auto snapshot = pool.Snapshot();
+     * Report(snapshot.work.completed, snapshot.work.queue_latency.Percentile(0.99));
+     * @endcode
+     *
+     * @returns metrics of work, wait, timer and IO callbacks
+     */
+    metrics::Snapshot Snapshot() const
+    {
+        return metrics::Snapshot { work_manager_.CollectMetrics(), wait_manager_.CollectMetrics(),
+            timer_manager_.CollectMetrics(), io_manager_.CollectMetrics() };
+    }
 
     /**
      * @brief Cancel all pending callbacks (of any kind).
@@ -748,6 +1317,8 @@ public:
     {
         work_manager_.CancelAll();
         wait_manager_.CancelAll();
+        wait_manager_.CancelAllGroups();
+        timer_manager_.CancelAllSoft();
         timer_manager_.CancelAll();
         io_manager_.CancelAll();
     }
@@ -781,3 +1352,129 @@ using SystemThreadPool = BasicThreadPool<details::BasicThreadPoolTraits>;
 using ThreadPool = BasicThreadPool<details::CustomThreadPoolTraits>;
 
 }  // namespace ntp
+
+
+#if defined(NTP_HAS_COROUTINES)
+
+namespace ntp::coroutine::details {
+
+/**
+ * @brief Access to managers of a threadpool for awaitables.
+ */
+struct PoolAccess
+{
+    template<typename ThreadPoolTraits>
+    static auto& Works(BasicThreadPool<ThreadPoolTraits>& pool) noexcept { return pool.work_manager_; }
+
+    template<typename ThreadPoolTraits>
+    static auto& Waits(BasicThreadPool<ThreadPoolTraits>& pool) noexcept { return pool.wait_manager_; }
+
+    template<typename ThreadPoolTraits>
+    static auto& Timers(BasicThreadPool<ThreadPoolTraits>& pool) noexcept { return pool.timer_manager_; }
+
+    template<typename ThreadPoolTraits>
+    static auto& Ios(BasicThreadPool<ThreadPoolTraits>& pool) noexcept { return pool.io_manager_; }
+};
+
+}  // namespace ntp::coroutine::details
+
+
+namespace ntp::coroutine {
+
+/**
+ * @brief Returns an awaitable, that resumes a coroutine in a threadpool thread.
+ *
+ * Usage example:
+ * @code{.cpp}
+ * ntp::coroutine::Task<> Handler(ntp::SystemThreadPool& pool)
+ * {
+ *     co_await ntp::coroutine::Schedule(pool);
+ *
+ *     //
+ *     // Here coroutine runs in a threadpool thread
+ *     //
+ * }
+ * @endcode
+ *
+ * Coroutine is submitted as a work callback, so it is never resumed, if work
+ * callbacks are cancelled (e.g. with CancelWorks).
+ *
+ * @param pool Threadpool to resume coroutine in
+ */
+template<typename ThreadPoolTraits>
+[[nodiscard]] auto Schedule(BasicThreadPool<ThreadPoolTraits>& pool) noexcept
+{
+    return details::ScheduleAwaitable(details::PoolAccess::Works(pool));
+}
+
+/**
+ * @brief Returns an awaitable, that resumes a coroutine in a threadpool thread after a timeout.
+ *
+ * @param pool    Threadpool to resume coroutine in
+ * @param timeout Timeout to sleep for
+ */
+template<typename ThreadPoolTraits, typename Rep, typename Period>
+[[nodiscard]] auto Sleep(BasicThreadPool<ThreadPoolTraits>& pool, const std::chrono::duration<Rep, Period>& timeout) noexcept
+{
+    return details::SleepAwaitable(details::PoolAccess::Timers(pool),
+        std::chrono::duration_cast<ntp::time::native_duration_t>(timeout));
+}
+
+/**
+ * @brief Returns an awaitable, that resumes a coroutine in a threadpool thread, when
+ *        handle becomes signaled or timeout expires. Result of co_await is
+ *        WAIT_OBJECT_0 or WAIT_TIMEOUT.
+ *
+ * @param pool        Threadpool to resume coroutine in
+ * @param wait_handle Handle to wait for
+ * @param timeout     Wait timeout
+ */
+template<typename ThreadPoolTraits, typename Rep, typename Period>
+[[nodiscard]] auto WaitFor(BasicThreadPool<ThreadPoolTraits>& pool, HANDLE wait_handle, const std::chrono::duration<Rep, Period>& timeout) noexcept
+{
+    return details::WaitAwaitable(details::PoolAccess::Waits(pool), wait_handle,
+        std::chrono::duration_cast<ntp::time::native_duration_t>(timeout));
+}
+
+/**
+ * @brief Returns an awaitable, that resumes a coroutine in a threadpool thread, when
+ *        handle becomes signaled. It never expires.
+ *
+ * @param pool        Threadpool to resume coroutine in
+ * @param wait_handle Handle to wait for
+ */
+template<typename ThreadPoolTraits>
+[[nodiscard]] auto WaitFor(BasicThreadPool<ThreadPoolTraits>& pool, HANDLE wait_handle) noexcept
+{
+    return details::WaitAwaitable(details::PoolAccess::Waits(pool), wait_handle, ntp::time::max_native_duration);
+}
+
+/**
+ * @brief Returns an awaitable, that starts an asynchronous IO operation and resumes 
+ *        a coroutine in a threadpool thread when the operation is completed.
+ *
+ * Usage example:
+ * @code{.cpp}
+ * const auto [result, bytes_written] = co_await ntp::coroutine::Io(pool, file, [&] (LPOVERLAPPED overlapped) {
+ *     return WriteFile(file, buffer.data(), buffer_size, nullptr, overlapped);
+ * });
+ * @endcode
+ *
+ * If operation fails to start, coroutine is not suspended and the result contains 
+ * an error code.
+ *
+ * @param pool      Threadpool to resume coroutine in
+ * @param io_handle Handle of an object, which asynchronous IO is performed on
+ * @param starter   Callable, that starts an operation with the specified OVERLAPPED 
+ *                  structure and returns BOOL as ReadFile or WriteFile do
+ * @returns Awaitable, co_await on it results in ntp::coroutine::IoResult
+ */
+template<typename ThreadPoolTraits, typename Starter>
+[[nodiscard]] auto Io(BasicThreadPool<ThreadPoolTraits>& pool, HANDLE io_handle, Starter&& starter)
+{
+    return details::IoAwaitable<Starter>(details::PoolAccess::Ios(pool), io_handle, std::forward<Starter>(starter));
+}
+
+}  // namespace ntp::coroutine
+
+#endif  // NTP_HAS_COROUTINES
@@ -6,26 +6,73 @@
 #pragma once
 
 #include <tuple>
+#include <mutex>
+#include <memory>
 #include <utility>
 #include <chrono>
+#include <limits>
+#include <cstdint>
+#include <vector>
 
 #include "ntp_config.hpp"
 #include "details/time.hpp"
 #include "details/utils.hpp"
+#include "details/periodic.hpp"
+#include "details/timer_wheel.hpp"
 #include "pool/basic_callback.hpp"
 
 
 namespace ntp::timer::details {
 
+/**
+ * @brief State of precise periodic timer.
+ *
+ * Such timer is set as a one-shot threadpool timer, that is set again after
+ * each expiration to the next tick of its schedule. Hence period is not limited
+ * to whole milliseconds and errors of expirations do not accumulate.
+ */
+struct PreciseTimer
+{
+    /**
+     * @brief Constructor.
+     *
+     * @param first Deadline of the first tick
+     * @param period Timer period (must be positive)
+     * @param histogram Histogram to record jitter into (may be empty)
+     */
+    PreciseTimer(ntp::time::clock_t::time_point first, ntp::time::native_duration_t period,
+        std::shared_ptr<ntp::time::JitterHistogram> histogram) noexcept
+        : schedule(first, period)
+        , jitter(std::move(histogram))
+    { }
+
+    std::mutex lock; /**< Lock for schedule and stop flag */
+
+    ntp::time::PeriodicSchedule schedule; /**< Absolute schedule of ticks */
+
+    std::shared_ptr<ntp::time::JitterHistogram> jitter; /**< Optional jitter statistics */
+
+    bool stopped = false; /**< If true, callback must not set timer again */
+};
+
+
 /**
  * @brief Specific context for threadpool timer objects.
  *        Contatins timeout and period.
  */
 struct TimerContext
 {
-    ntp::time::native_duration_t timer_timeout; /**< Timeout of first trigger */
+    std::mutex timer_lock; /**< Lock for deadline of non-precise timer (it may be rearmed concurrently) */
 
-    std::chrono::milliseconds timer_period; /**< Timer period (if 0, then timer is non-periodic) */
+    ntp::time::clock_t::time_point timer_deadline; /**< Absolute time of the next trigger */
+
+    std::chrono::milliseconds timer_period; /**< Timer period (if 0, then timer is non-periodic or precise) */
+
+    std::chrono::milliseconds timer_window; /**< Tolerable delay of expiration (window length) */
+
+    std::unique_ptr<PreciseTimer> timer_precise; /**< State of precise periodic timer (null for other timers) */
+
+    bool timer_expired = false; /**< One-shot timer has expired and will be closed by its callback */
 };
 
 
@@ -40,6 +87,11 @@ class alignas(NTP_ALLOCATION_ALIGNMENT) TimerCallback final
     : public ntp::details::BasicCallback<TimerCallback<Functor, Args...>, Functor, Args...>
 {
 public:
+    /**
+     * @brief Kind of callback in traces.
+     */
+    static constexpr ntp::tracing::CallbackKind kTraceKind = ntp::tracing::CallbackKind::kTimer;
+
     /**
      * @brief Constructor from callable and its arguments
      *
@@ -48,42 +100,93 @@ public:
      */
     template<typename CFunctor, typename... CArgs>
     explicit TimerCallback(CFunctor&& functor, CArgs&&... args)
-        : BasicCallback(std::forward<CFunctor>(functor), std::forward<CArgs>(args)...)
+        : TimerCallback::BasicCallback(std::forward<CFunctor>(functor), std::forward<CArgs>(args)...)
     { }
 
     /**
-     * @brief Parameter conversion function. Does nothing.
+     * @brief Parameter conversion function. Converts parameter to a pointer to tick
+     *        information (it is passed by precise periodic timers only).
      */
-    void* ConvertParameter(void*) { return nullptr; }
+    const ntp::time::TimerTick* ConvertParameter(void* parameter) { return static_cast<const ntp::time::TimerTick*>(parameter); }
 
     /**
      * @brief Callback invocation function implementation. Supports invocation of
-     *        callbacks with or without PTP_CALLBACK_INSTANCE parameter.
+     *        callbacks with or without PTP_CALLBACK_INSTANCE parameter. Callbacks,
+     *        that accept neither of them, may accept `const ntp::time::TimerTick&`
+     *        after optional PTP_CALLBACK_INSTANCE (tick is empty for timers, that
+     *        are not precise periodic ones). Timer may be periodic, so arguments
+     *        are passed by reference.
      */
     template<typename = void> /* if constexpr works only for templates */
-    void CallImpl(PTP_CALLBACK_INSTANCE instance, void* /* parameter */)
+    void CallImpl(PTP_CALLBACK_INSTANCE instance, const ntp::time::TimerTick* tick)
     {
-        if constexpr (std::is_invocable_v<std::decay_t<Functor>, PTP_CALLBACK_INSTANCE, std::decay_t<Args>...>)
+        if constexpr (TimerCallback::template is_invocable_with_v<PTP_CALLBACK_INSTANCE>)
         {
-            const auto args = std::tuple_cat(std::make_tuple(instance), Arguments());
-            std::apply(Callable(), args);
+            this->template Invoke<false>(instance);
+        }
+        else if constexpr (TimerCallback::template is_invocable_with_v<>)
+        {
+            this->template Invoke<false>();
+        }
+        else if constexpr (TimerCallback::template is_invocable_with_v<PTP_CALLBACK_INSTANCE, const ntp::time::TimerTick&>)
+        {
+            this->template Invoke<false>(instance, tick ? *tick : ntp::time::TimerTick {});
         }
         else
         {
-            std::apply(Callable(), Arguments());
+            this->template Invoke<false>(tick ? *tick : ntp::time::TimerTick {});
         }
     }
 };
 
 
+/**
+ * @brief Soft timer, that is driven by a timing wheel instead of a separate threadpool timer object.
+ */
+struct SoftTimer final : ntp::details::TimerWheelEntry
+{
+    ntp::details::callback_t callback; /**< Callback wrapper (stored inline if small enough) */
+    std::uint32_t slot = 0;            /**< Index of a slot, that refers to this timer */
+};
+
+
+/**
+ * @brief Handle of soft timer.
+ *
+ * Timer is released when it expires, so handle refers to a slot instead of the timer
+ * itself. Slot's generation is changed every time the slot is freed, hence a stale
+ * handle never matches a timer, that reused the same slot.
+ */
+struct SoftTimerHandle
+{
+    std::uint32_t slot       = 0; /**< Index of timer's slot */
+    std::uint32_t generation = 0; /**< Generation of the slot at the moment timer was scheduled */
+};
+
+
 /**
  * @brief Manager for wait callbacks. Binds callbacks and threadpool implementation.
+ *
+ * Besides usual timers, each of which is a separate threadpool timer object, manager
+ * maintains soft timers: they are kept in a hierarchical timing wheel, that is driven
+ * by a single threadpool timer ticking with configurable resolution.
  */
 class TimerManager final
     : public ntp::details::BasicManager<PTP_TIMER, TimerContext, TimerManager>
 {
     friend class ntp::details::BasicManager<PTP_TIMER, TimerContext, TimerManager>;
 
+public:
+    /**
+     * @brief Handle of soft timer.
+     */
+    using soft_handle_t = SoftTimerHandle;
+
+    /**
+     * @brief Clock, that drives soft timers.
+     */
+    using soft_clock_t = ntp::time::clock_t;
+
 public:
     /**
      * @brief Constructor that initializes all necessary objects.
@@ -92,6 +195,12 @@ public:
      */
     explicit TimerManager(PTP_CALLBACK_ENVIRON environment);
 
+    /**
+     * @brief Destructor releases soft timers, that were not cancelled.
+     *        Tick timer object is closed with threadpool's cleanup group.
+     */
+    ~TimerManager();
+
     /**
      * @brief Submits a threadpool timer object with a user-defined callback.
      * 
@@ -100,37 +209,44 @@ public:
      *
      * @param timeout Timeout after which timer object calls the callback
      * @param period If non-zero, timer object willbe triggered each period after first call
+     * @param tolerance Tolerable delay of expiration (threadpool may coalesce timers within it)
      * @param functor Callable to invoke
      * @param args Arguments to pass into callable (they will be copied into wrapper)
      * @returns handle for created wait object
      */
     template<typename Rep1, typename Period1, typename Rep2, typename Period2, typename Functor, typename... Args>
     native_handle_t Submit(const std::chrono::duration<Rep1, Period1>& timeout, const std::chrono::duration<Rep2, Period2>& period,
-        Functor&& functor, Args&&... args)
+        ntp::time::Tolerance tolerance, Functor&& functor, Args&&... args)
     {
-        auto context      = CreateContext();
-        context->callback = std::make_unique<TimerCallback<Functor, Args...>>(std::forward<Functor>(functor), std::forward<Args>(args)...);
-
-        context->object_context.timer_period  = std::chrono::duration_cast<std::chrono::milliseconds>(period);
-        context->object_context.timer_timeout = std::chrono::duration_cast<ntp::time::native_duration_t>(timeout);
-
-        const auto native_handle = CreateThreadpoolTimer(reinterpret_cast<PTP_TIMER_CALLBACK>(InvokeCallback),
-            context.get(), Environment());
-
-        if (!native_handle)
-        {
-            throw exception::Win32Exception();
-        }
+        //
+        // Threadpool timers have periods in whole milliseconds, that fit into DWORD.
+        // Other periods would be truncated, so such timers become precise periodic ones.
+        //
 
-        static_assert(noexcept(SubmitContext(native_handle, std::move(context))),
-            "[ntp::timer::details::WaitManager::Submit]: inspect ntp::details::BasicCallback::SubmitContext and "
-            "ntp::timer::details::WaitManager::SubmitInternal for noexcept property, because an exception thrown "
-            "here can lead to handle and memory leaks. SubmitContext is noexcept if and only if SubmitInternal "
-            "is noexcept.");
+        const auto native_period = std::chrono::duration_cast<ntp::time::native_duration_t>(period);
 
-        SubmitContext(native_handle, std::move(context));
+        return SubmitWith(timeout, native_period, tolerance, !IsNativePeriod(native_period),
+            nullptr, std::forward<Functor>(functor), std::forward<Args>(args)...);
+    }
 
-        return native_handle;
+    /**
+     * @brief Submits a threadpool timer object with a user-defined callback and no tolerance.
+     *
+     * Just calls generic version of ntp::wait::details::TimerManager::Submit with
+     * zero tolerance.
+     *
+     * @param timeout Timeout after which timer object calls the callback
+     * @param period If non-zero, timer object willbe triggered each period after first call
+     * @param functor Callable to invoke
+     * @param args Arguments to pass into callable (they will be copied into wrapper)
+     * @returns handle for created wait object
+     */
+    template<typename Rep1, typename Period1, typename Rep2, typename Period2, typename Functor, typename... Args>
+    auto Submit(const std::chrono::duration<Rep1, Period1>& timeout, const std::chrono::duration<Rep2, Period2>& period,
+        Functor&& functor, Args&&... args)
+        -> std::enable_if_t<!ntp::time::details::is_timer_argument_v<std::decay_t<Functor>>, native_handle_t>
+    {
+        return Submit(timeout, period, ntp::time::Tolerance(), std::forward<Functor>(functor), std::forward<Args>(args)...);
     }
 
     /**
@@ -146,7 +262,7 @@ public:
      */
     template<typename Rep, typename Period, typename Functor, typename... Args>
     auto Submit(const std::chrono::duration<Rep, Period>& timeout, Functor&& functor, Args&&... args)
-        -> std::enable_if_t<!ntp::time::details::is_duration_v<Functor> && !ntp::time::details::is_time_point_v<Functor>, native_handle_t>
+        -> std::enable_if_t<!ntp::time::details::is_timer_argument_v<std::decay_t<Functor>>, native_handle_t>
     {
         return Submit(timeout, std::chrono::milliseconds(0), std::forward<Functor>(functor), std::forward<Args>(args)...);
     }
@@ -159,12 +275,14 @@ public:
      * 
      * @param deadline A specific point in time, which the timer will expire at
      * @param period If non-zero, timer object willbe triggered each period after first call
+     * @param tolerance Tolerable delay of expiration (threadpool may coalesce timers within it)
      * @param functor Callable to invoke
      * @param args Arguments to pass into callable (they will be copied into wrapper)
      * @returns handle for created wait object
      */
     template<typename Clock, typename Duration, typename Rep, typename Period, typename Functor, typename... Args>
-    auto Submit(const ntp::time::deadline_t<Clock, Duration>& deadline, const std::chrono::duration<Rep, Period>& period, Functor&& functor, Args&&... args)
+    native_handle_t Submit(const ntp::time::deadline_t<Clock, Duration>& deadline, const std::chrono::duration<Rep, Period>& period,
+        ntp::time::Tolerance tolerance, Functor&& functor, Args&&... args)
     {
         using clock_t    = Clock;
         using duration_t = typename clock_t::duration;
@@ -182,7 +300,26 @@ public:
             timeout = clock_t::duration::zero();
         }
 
-        return Submit(timeout, period, std::forward<Functor>(functor), std::forward<Args>(args)...);
+        return Submit(timeout, period, tolerance, std::forward<Functor>(functor), std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief Submits a threadpool deadline timer object with a user-defined callback and no tolerance.
+     *
+     * Just calls generic version of ntp::wait::details::TimerManager::Submit with
+     * zero tolerance.
+     *
+     * @param deadline A specific point in time, which the timer will expire at
+     * @param period If non-zero, timer object willbe triggered each period after first call
+     * @param functor Callable to invoke
+     * @param args Arguments to pass into callable (they will be copied into wrapper)
+     * @returns handle for created wait object
+     */
+    template<typename Clock, typename Duration, typename Rep, typename Period, typename Functor, typename... Args>
+    auto Submit(const ntp::time::deadline_t<Clock, Duration>& deadline, const std::chrono::duration<Rep, Period>& period, Functor&& functor, Args&&... args)
+        -> std::enable_if_t<!ntp::time::details::is_timer_argument_v<std::decay_t<Functor>>, native_handle_t>
+    {
+        return Submit(deadline, period, ntp::time::Tolerance(), std::forward<Functor>(functor), std::forward<Args>(args)...);
     }
 
     /**
@@ -198,20 +335,190 @@ public:
      */
     template<typename Clock, typename Duration, typename Functor, typename... Args>
     auto Submit(const ntp::time::deadline_t<Clock, Duration>& deadline, Functor&& functor, Args&&... args)
-        -> std::enable_if_t<!ntp::time::details::is_duration_v<Functor> && !ntp::time::details::is_time_point_v<Functor>, native_handle_t>
+        -> std::enable_if_t<!ntp::time::details::is_timer_argument_v<std::decay_t<Functor>>, native_handle_t>
     {
         return Submit(deadline, std::chrono::milliseconds(0), std::forward<Functor>(functor), std::forward<Args>(args)...);
     }
 
+    /**
+     * @brief Submits a precise periodic timer with a user-defined callback.
+     *
+     * Timer ticks at absolute deadlines (timeout + N * period) with 100 ns
+     * resolution, so it does not drift. Callbacks of the same timer never
+     * overlap: ticks, that are gone while callback runs, are skipped and
+     * reported as missed to the next invocation.
+     *
+     * @param timeout Timeout of the first tick
+     * @param period Timer period (must be positive)
+     * @param jitter Histogram to record delays of ticks into (may be empty)
+     * @param functor Callable to invoke. It MAY accept `PTP_CALLBACK_INSTANCE` and
+     *                then `const ntp::time::TimerTick&` as its first parameters
+     * @param args Arguments to pass into callable (they will be copied into wrapper)
+     * @throws ntp::exception::Win32Exception if period is not positive
+     * @returns handle for created timer object
+     */
+    template<typename Rep1, typename Period1, typename Rep2, typename Period2, typename Functor, typename... Args>
+    native_handle_t SubmitPeriodic(const std::chrono::duration<Rep1, Period1>& timeout, const std::chrono::duration<Rep2, Period2>& period,
+        std::shared_ptr<ntp::time::JitterHistogram> jitter, Functor&& functor, Args&&... args)
+    {
+        return SubmitWith(timeout, std::chrono::duration_cast<ntp::time::native_duration_t>(period),
+            ntp::time::Tolerance(), true, std::move(jitter), std::forward<Functor>(functor), std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief Submits a precise periodic timer with a user-defined callback and without jitter statistics.
+     *
+     * @param timeout Timeout of the first tick
+     * @param period Timer period (must be positive)
+     * @param functor Callable to invoke
+     * @param args Arguments to pass into callable (they will be copied into wrapper)
+     * @throws ntp::exception::Win32Exception if period is not positive
+     * @returns handle for created timer object
+     */
+    template<typename Rep1, typename Period1, typename Rep2, typename Period2, typename Functor, typename... Args>
+    auto SubmitPeriodic(const std::chrono::duration<Rep1, Period1>& timeout, const std::chrono::duration<Rep2, Period2>& period,
+        Functor&& functor, Args&&... args)
+        -> std::enable_if_t<!ntp::time::details::is_timer_argument_v<std::decay_t<Functor>>, native_handle_t>
+    {
+        return SubmitPeriodic(timeout, period, std::shared_ptr<ntp::time::JitterHistogram>(), std::forward<Functor>(functor),
+            std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief Sets a new timeout of an existing timer. Callback is not changed.
+     *
+     * Unlike ntp::details::BasicManager::Replace, this function does not reallocate
+     * anything and does not lock the container exclusively, so it is suitable for
+     * frequent "touch" of timers. Period and tolerance of the timer are kept.
+     *
+     * @param object Handle for an existing timer object
+     * @param timeout New timeout, counted from now
+     * @returns true if timer was rearmed, false if it is not present or one-shot timer
+     *          has already expired (even if its callback is still running)
+     */
+    template<typename Rep, typename Period>
+    bool Rearm(native_handle_t object, const std::chrono::duration<Rep, Period>& timeout) noexcept
+    {
+        return RearmInternal(object, ntp::time::clock_t::now() + std::chrono::duration_cast<ntp::time::clock_t::duration>(timeout));
+    }
+
+    /**
+     * @brief Submits a soft timer with a user-defined callback.
+     *
+     * Soft timer is put into a timing wheel in O(1) and is triggered by
+     * the nearest tick after timeout expires. Callbacks of soft timers are
+     * invoked sequentially from tick timer's callback, so they should be short.
+     *
+     * @param timeout Timeout after which the callback is called
+     * @param functor Callable to invoke
+     * @param args Arguments to pass into callable (they will be copied into wrapper)
+     * @returns handle for created soft timer
+     */
+    template<typename Rep, typename Period, typename Functor, typename... Args>
+    soft_handle_t SubmitSoft(const std::chrono::duration<Rep, Period>& timeout, Functor&& functor, Args&&... args)
+    {
+        auto timer = std::make_unique<SoftTimer>();
+        timer->callback.template Emplace<TimerCallback<Functor, Args...>>(std::forward<Functor>(functor), std::forward<Args>(args)...);
+
+        return ScheduleSoft(std::move(timer), std::chrono::duration_cast<ntp::time::native_duration_t>(timeout));
+    }
+
+    /**
+     * @brief Cancels a soft timer in O(1). If timer has already expired, does nothing
+     *        (even if another soft timer was scheduled after that).
+     *
+     * @param handle Handle of soft timer
+     */
+    void CancelSoft(soft_handle_t handle) noexcept;
+
+    /**
+     * @brief Cancels all soft timers and waits for the running tick callback.
+     */
+    void CancelAllSoft() noexcept;
+
+    /**
+     * @brief Changes resolution of soft timers. Allowed only if there are no soft timers.
+     *
+     * @param resolution New resolution (must be positive)
+     * @throws ntp::exception::Win32Exception if there are pending soft timers or resolution is invalid
+     */
+    void SetSoftResolution(ntp::time::native_duration_t resolution);
+
+    /**
+     * @brief Get resolution of soft timers.
+     */
+    ntp::time::native_duration_t SoftResolution() const noexcept;
+
+    /**
+     * @brief Collects metrics of the manager.
+     *
+     * @returns metrics with number of live timer objects and soft timers
+     */
+    ntp::metrics::ManagerMetrics CollectMetrics() const;
+
 private:
+    template<typename Rep, typename Period, typename Functor, typename... Args>
+    native_handle_t SubmitWith(const std::chrono::duration<Rep, Period>& timeout, ntp::time::native_duration_t period, ntp::time::Tolerance tolerance,
+        bool precise, std::shared_ptr<ntp::time::JitterHistogram> jitter, Functor&& functor, Args&&... args)
+    {
+        if (precise && period <= ntp::time::native_duration_t::zero())
+        {
+            throw exception::Win32Exception(ERROR_INVALID_PARAMETER);
+        }
+
+        auto context      = CreateContext();
+        context->callback.template Emplace<TimerCallback<Functor, Args...>>(std::forward<Functor>(functor), std::forward<Args>(args)...);
+
+        auto& timer_context          = context->object_context;
+        timer_context.timer_deadline = ntp::time::clock_t::now() + std::chrono::duration_cast<ntp::time::clock_t::duration>(timeout);
+        timer_context.timer_window   = std::chrono::ceil<std::chrono::milliseconds>(tolerance.value);
+
+        if (precise)
+        {
+            timer_context.timer_period  = std::chrono::milliseconds(0);
+            timer_context.timer_precise = std::make_unique<PreciseTimer>(timer_context.timer_deadline, period, std::move(jitter));
+        }
+        else
+        {
+            timer_context.timer_period = std::chrono::duration_cast<std::chrono::milliseconds>(period);
+        }
+
+        const auto native_handle = CreateThreadpoolTimer(reinterpret_cast<PTP_TIMER_CALLBACK>(InvokeCallback),
+            context.get(), Environment());
+
+        if (!native_handle)
+        {
+            throw exception::Win32Exception();
+        }
+
+        static_assert(noexcept(SubmitContext(native_handle, std::move(context))),
+            "[ntp::timer::details::WaitManager::Submit]: inspect ntp::details::BasicCallback::SubmitContext and "
+            "ntp::timer::details::WaitManager::SubmitInternal for noexcept property, because an exception thrown "
+            "here can lead to handle and memory leaks. SubmitContext is noexcept if and only if SubmitInternal "
+            "is noexcept.");
+
+        SubmitContext(native_handle, std::move(context));
+
+        return native_handle;
+    }
+
     template<typename Functor, typename... Args>
     native_handle_t ReplaceInternal(native_handle_t native_handle, context_pointer_t context, Functor&& functor, Args&&... args)
     {
+        const auto precise = context->object_context.timer_precise.get();
+
         //
         // Firstly we need to cancel current pending callback and only
-        // after that we are allowed to replace it with the new one
+        // after that we are allowed to replace it with the new one.
+        // Precise timer must be stopped, because its callback sets it again.
         //
 
+        if (precise)
+        {
+            std::lock_guard lock { precise->lock };
+            precise->stopped = true;
+        }
+
         ntp::details::SafeThreadpoolCall<SetThreadpoolTimerEx>(native_handle, nullptr, 0, 0);
         ntp::details::SafeThreadpoolCall<WaitForThreadpoolTimerCallbacks>(native_handle, TRUE);
 
@@ -220,20 +527,97 @@ private:
         // because it is cancelled.
         //
 
-        context->callback = std::make_unique<TimerCallback<Functor, Args...>>(
+        context->callback.template Emplace<TimerCallback<Functor, Args...>>(
             std::forward<Functor>(functor), std::forward<Args>(args)...);
 
-        SubmitInternal(native_handle, context->object_context);
+        if (precise)
+        {
+            std::lock_guard lock { precise->lock };
+            precise->stopped = false;
+
+            ArmPrecise(native_handle, context->object_context);
+        }
+        else
+        {
+            SubmitInternal(native_handle, context->object_context);
+        }
 
         return native_handle;
     }
 
-    void SubmitInternal(native_handle_t native_handle, object_context_t& user_context) noexcept;
+    static bool IsNativePeriod(ntp::time::native_duration_t period) noexcept
+    {
+        constexpr auto max_period = std::chrono::milliseconds((std::numeric_limits<DWORD>::max)());
+
+        return period >= ntp::time::native_duration_t::zero() && period <= max_period &&
+               period % std::chrono::milliseconds(1) == ntp::time::native_duration_t::zero();
+    }
+
+    static void ArmPrecise(native_handle_t native_handle, object_context_t& user_context) noexcept;
+
+    static void SubmitInternal(native_handle_t native_handle, object_context_t& user_context) noexcept;
+
+    bool RearmInternal(native_handle_t native_handle, ntp::time::clock_t::time_point deadline) noexcept;
+
+    soft_handle_t ScheduleSoft(std::unique_ptr<SoftTimer>&& timer, ntp::time::native_duration_t timeout);
+
+    soft_handle_t AcquireSoftSlot(SoftTimer* timer);
+
+    void ReleaseSoftSlot(std::uint32_t index) noexcept;
+
+    std::uint64_t SoftTick(soft_clock_t::time_point time_point, bool round_up) const noexcept;
+
+    void ArmTick() noexcept;
 
 private:
     static void NTAPI InvokeCallback(PTP_CALLBACK_INSTANCE instance, context_pointer_t context, PTP_TIMER timer) noexcept;
 
+    static void NTAPI InvokeTick(PTP_CALLBACK_INSTANCE instance, TimerManager* self, PTP_TIMER timer) noexcept;
+
+    static void InvokePrecise(PTP_CALLBACK_INSTANCE instance, context_pointer_t context, PTP_TIMER timer);
+
+    static void StopInternal(object_context_t& user_context) noexcept;
+
     static void CloseInternal(native_handle_t native_handle) noexcept;
+
+private:
+    // Timing wheel with soft timers
+    ntp::details::TimerWheel<> wheel_;
+
+    // Slot of soft timer's handle
+    struct SoftSlot
+    {
+        SoftTimer* timer;         // Scheduled timer (owned by the slot) or nullptr if slot is free
+        std::uint32_t generation; // Generation of the slot, changed when it is freed
+        std::uint32_t next_free;  // Index of the next free slot
+    };
+
+    // Index, that terminates list of free slots
+    static constexpr auto kNoSlot = (std::numeric_limits<std::uint32_t>::max)();
+
+    // Slots of scheduled soft timers
+    std::vector<SoftSlot> soft_slots_;
+
+    // Head of list of free slots
+    std::uint32_t soft_free_;
+
+    // Number of scheduled soft timers
+    std::size_t soft_count_;
+
+    // Lock for timing wheel and soft timers
+    mutable std::mutex soft_lock_;
+
+    // Threadpool timer, that drives the timing wheel
+    PTP_TIMER tick_;
+
+    // Is tick timer set now
+    bool tick_armed_;
+
+    // Duration of a single tick
+    ntp::time::native_duration_t resolution_;
+
+    // Time point of tick 0
+    soft_clock_t::time_point origin_;
 };
 
 }  // namespace ntp::timer::details
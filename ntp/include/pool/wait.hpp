@@ -6,15 +6,38 @@
 #pragma once
 
 #include <tuple>
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <memory>
+#include <iterator>
 #include <utility>
 #include <optional>
+#include <type_traits>
 
 #include "ntp_config.hpp"
 #include "details/time.hpp"
 #include "details/utils.hpp"
+#include "details/registry.hpp"
+#include "details/exception.hpp"
 #include "pool/basic_callback.hpp"
 
 
+namespace ntp::wait {
+
+/**
+ * @brief What happens with a wait object after its callback returns.
+ *        Wait callbacks may return it to make wait objects persistent.
+ */
+enum class WaitAction
+{
+    kComplete, /**< Wait object is closed (the same happens, if callback returns nothing) */
+    kRearm     /**< Wait object waits for the same handle with the same timeout again */
+};
+
+}  // namespace ntp::wait
+
+
 namespace ntp::wait::details {
 
 /**
@@ -26,6 +49,21 @@ struct WaitContext
     std::optional<FILETIME> wait_timeout; /**< Wait timeout (pftTimeout parameter of SetThreadpoolWait function) */
 
     HANDLE wait_handle; /**< Handle to wait for */
+
+    std::mutex wait_lock; /**< Lock for stop flag (callback rearms wait object under it) */
+
+    bool wait_stopped = false; /**< If true, callback must not rearm wait object */
+};
+
+
+/**
+ * @brief Parameter of wait callback: result of wait and callback's decision.
+ */
+struct WaitParameter
+{
+    TP_WAIT_RESULT wait_result; /**< Result of wait (e.g. WAIT_OBJECT_0 or WAIT_TIMEOUT) */
+
+    WaitAction action; /**< What to do with wait object after callback */
 };
 
 
@@ -42,6 +80,11 @@ class alignas(NTP_ALLOCATION_ALIGNMENT) WaitCallback final
     friend class ntp::details::BasicCallback<WaitCallback<Functor, Args...>, Functor, Args...>;
 
 public:
+    /**
+     * @brief Kind of callback in traces.
+     */
+    static constexpr ntp::tracing::CallbackKind kTraceKind = ntp::tracing::CallbackKind::kWait;
+
     /**
      * @brief Constructor from callable and its arguments
      *
@@ -50,44 +93,195 @@ public:
      */
     template<typename CFunctor, typename... CArgs>
     explicit WaitCallback(CFunctor&& functor, CArgs&&... args)
-        : BasicCallback(std::forward<CFunctor>(functor), std::forward<CArgs>(args)...)
+        : WaitCallback::BasicCallback(std::forward<CFunctor>(functor), std::forward<CArgs>(args)...)
     { }
 
 private:
     /**
-     * @brief Converts void* parameter into TP_WAIT_RESULT.
+     * @brief Converts void* parameter into WaitParameter.
      */
-    TP_WAIT_RESULT* ConvertParameter(void* parameter) { return static_cast<TP_WAIT_RESULT*>(parameter); }
+    WaitParameter* ConvertParameter(void* parameter) { return static_cast<WaitParameter*>(parameter); }
 
     /**
      * @brief WaitCallback invocation function implementation. Supports invocation of
-     *        callbacks with or without PTP_CALLBACK_INSTANCE parameter.
+     *        callbacks with or without PTP_CALLBACK_INSTANCE parameter. Callback, that
+     *        returns nothing, is invoked only once, so its arguments are moved into
+     *        callable. Callback, that returns ntp::wait::WaitAction, may be invoked
+     *        again, so its arguments are passed by reference.
      */
     template<typename = void> /* if constexpr works only for templates */
-    void CallImpl(PTP_CALLBACK_INSTANCE instance, TP_WAIT_RESULT* wait_result)
+    void CallImpl(PTP_CALLBACK_INSTANCE instance, WaitParameter* parameter)
     {
-        if constexpr (std::is_invocable_v<std::decay_t<Functor>, PTP_CALLBACK_INSTANCE, TP_WAIT_RESULT, std::decay_t<Args>...>)
+        if constexpr (WaitCallback::template is_invocable_with_v<PTP_CALLBACK_INSTANCE, TP_WAIT_RESULT>)
         {
-            const auto args = std::tuple_cat(std::make_tuple(instance, *wait_result), Arguments());
-            std::apply(Callable(), args);
+            if constexpr (WaitCallback::template is_invocable_r_with_v<WaitAction, PTP_CALLBACK_INSTANCE, TP_WAIT_RESULT>)
+            {
+                parameter->action = this->template Invoke<false>(instance, parameter->wait_result);
+            }
+            else
+            {
+                this->template Invoke<true>(instance, parameter->wait_result);
+            }
         }
         else
         {
-            const auto args = std::tuple_cat(std::make_tuple(*wait_result), Arguments());
-            std::apply(Callable(), args);
+            if constexpr (WaitCallback::template is_invocable_r_with_v<WaitAction, TP_WAIT_RESULT>)
+            {
+                parameter->action = this->template Invoke<false>(parameter->wait_result);
+            }
+            else
+            {
+                this->template Invoke<true>(parameter->wait_result);
+            }
         }
     }
 };
 
 
+/**
+ * @brief Parameter of wait group callback: signaled handle, result of wait and callback's decision.
+ */
+struct WaitGroupParameter
+{
+    HANDLE wait_handle; /**< Handle, which wait is completed */
+
+    TP_WAIT_RESULT wait_result; /**< Result of wait (e.g. WAIT_OBJECT_0 or WAIT_TIMEOUT) */
+
+    WaitAction action; /**< What to do with wait object of this handle after callback */
+};
+
+
+/**
+ * @brief Callback wrapper of wait group. It is shared by all waits of the group,
+ *        so it may be invoked concurrently and its arguments are never moved.
+ *
+ * @tparam Functor Type of callable to invoke in threadpool
+ * @tparam Args... Types of arguments
+ */
+template<typename Functor, typename... Args>
+class alignas(NTP_ALLOCATION_ALIGNMENT) WaitGroupCallback final
+    : public ntp::details::BasicCallback<WaitGroupCallback<Functor, Args...>, Functor, Args...>
+{
+    friend class ntp::details::BasicCallback<WaitGroupCallback<Functor, Args...>, Functor, Args...>;
+
+public:
+    /**
+     * @brief Kind of callback in traces.
+     */
+    static constexpr ntp::tracing::CallbackKind kTraceKind = ntp::tracing::CallbackKind::kWait;
+
+    /**
+     * @brief Constructor from callable and its arguments
+     *
+     * @param functor Callable to invoke
+     * @param args Arguments to pass into callable (they will be copied into wrapper)
+     */
+    template<typename CFunctor, typename... CArgs>
+    explicit WaitGroupCallback(CFunctor&& functor, CArgs&&... args)
+        : WaitGroupCallback::BasicCallback(std::forward<CFunctor>(functor), std::forward<CArgs>(args)...)
+    { }
+
+private:
+    /**
+     * @brief Converts void* parameter into WaitGroupParameter.
+     */
+    WaitGroupParameter* ConvertParameter(void* parameter) { return static_cast<WaitGroupParameter*>(parameter); }
+
+    /**
+     * @brief WaitGroupCallback invocation function implementation. Supports invocation of
+     *        callbacks with or without PTP_CALLBACK_INSTANCE parameter, that return nothing
+     *        or ntp::wait::WaitAction.
+     */
+    template<typename = void> /* if constexpr works only for templates */
+    void CallImpl(PTP_CALLBACK_INSTANCE instance, WaitGroupParameter* parameter)
+    {
+        if constexpr (WaitGroupCallback::template is_invocable_with_v<PTP_CALLBACK_INSTANCE, HANDLE, TP_WAIT_RESULT>)
+        {
+            if constexpr (WaitGroupCallback::template is_invocable_r_with_v<WaitAction, PTP_CALLBACK_INSTANCE, HANDLE, TP_WAIT_RESULT>)
+            {
+                parameter->action = this->template Invoke<false>(instance, parameter->wait_handle, parameter->wait_result);
+            }
+            else
+            {
+                this->template Invoke<false>(instance, parameter->wait_handle, parameter->wait_result);
+            }
+        }
+        else
+        {
+            if constexpr (WaitGroupCallback::template is_invocable_r_with_v<WaitAction, HANDLE, TP_WAIT_RESULT>)
+            {
+                parameter->action = this->template Invoke<false>(parameter->wait_handle, parameter->wait_result);
+            }
+            else
+            {
+                this->template Invoke<false>(parameter->wait_handle, parameter->wait_result);
+            }
+        }
+    }
+};
+
+
+class WaitManager;
+struct WaitGroup;
+
+
+/**
+ * @brief Context of a single wait object of a group.
+ */
+struct WaitGroupMember
+{
+    WaitGroup* group; /**< Owning group */
+
+    std::size_t index; /**< Index of wait object and its handle in the group */
+};
+
+
+/**
+ * @brief Group of wait objects, that share a callback and a timeout
+ *        and are submitted and cancelled as a unit.
+ *
+ * Handles and wait objects are stored in contiguous arrays, that
+ * are sized once, when group is created.
+ */
+struct WaitGroup final
+{
+    std::vector<HANDLE> wait_handles; /**< Handles to wait for */
+
+    std::vector<PTP_WAIT> waits; /**< Wait object of each handle */
+
+    std::vector<WaitGroupMember> members; /**< Context of each wait object */
+
+    std::optional<FILETIME> wait_timeout; /**< Wait timeout of every wait object */
+
+    std::atomic<std::size_t> pending { 0 }; /**< Number of wait objects, which callbacks are not completed yet */
+
+    std::mutex wait_lock; /**< Lock for stop flag (callbacks rearm wait objects under it) */
+
+    bool wait_stopped = false; /**< If true, callbacks must not rearm wait objects */
+
+    WaitManager* manager = nullptr; /**< Owning manager */
+
+    ntp::details::callback_t callback; /**< Callback wrapper shared by all wait objects */
+};
+
+
 /**
  * @brief Manager for wait callbacks. Binds callbacks and threadpool implementation.
+ *
+ * Besides single wait objects, manager maintains wait groups: sets of wait objects,
+ * that are registered in one pass and are cancelled as a unit.
  */
 class WaitManager final
     : public ntp::details::BasicManager<PTP_WAIT, WaitContext, WaitManager>
 {
     friend class ntp::details::BasicManager<PTP_WAIT, WaitContext, WaitManager>;
 
+public:
+    /**
+     * @brief Handle of wait group.
+     */
+    using group_handle_t = WaitGroup*;
+
 public:
     /**
      * @brief Constructor that initializes all necessary objects.
@@ -96,12 +290,21 @@ public:
      */
     explicit WaitManager(PTP_CALLBACK_ENVIRON environment);
 
+    /**
+     * @brief Destructor cancels wait groups, that were not cancelled, and waits
+     *        for callbacks, that are removing their own groups right now.
+     */
+    ~WaitManager();
+
     /**
      * @brief Submits a threadpool wait object with a user-defined callback.
      * 
      * Creates a new callback wrapper, new wait object, put 
      * it into a callbacks container and then sets threadpool wait.
      * 
+     * If callable returns ntp::wait::WaitAction::kRearm, the same wait object
+     * waits for the handle again, nothing is recreated.
+     * 
      * @param wait_handle Handle to wait for
      * @param timeout Timeout while wait object waits for the specified handle 
      *                (pass ntp::time::max_native_duration for infinite wait timeout)
@@ -112,21 +315,10 @@ public:
     template<typename Rep, typename Period, typename Functor, typename... Args>
     native_handle_t Submit(HANDLE wait_handle, const std::chrono::duration<Rep, Period>& timeout, Functor&& functor, Args&&... args)
     {
-        auto context                        = CreateContext();
-        context->callback                   = std::make_unique<WaitCallback<Functor, Args...>>(std::forward<Functor>(functor), std::forward<Args>(args)...);
-        context->object_context.wait_handle = wait_handle;
-
-        if (const auto native_timeout = std::chrono::duration_cast<ntp::time::native_duration_t>(timeout);
-            native_timeout != ntp::time::max_native_duration)
-        {
-            //
-            // Here we need relative timeout, so I will invert it (negative timeout represets a relative time interval):
-            // https://learn.microsoft.com/en-us/windows/win32/api/threadpoolapiset/nf-threadpoolapiset-setthreadpoolwait
-            //
-
-            context->object_context.wait_timeout = ntp::time::AsFileTime(native_timeout);
-            context->object_context.wait_timeout = ntp::time::Negate(context->object_context.wait_timeout.value());
-        }
+        auto context                         = CreateContext();
+        context->callback.template Emplace<WaitCallback<Functor, Args...>>(std::forward<Functor>(functor), std::forward<Args>(args)...);
+        context->object_context.wait_handle  = wait_handle;
+        context->object_context.wait_timeout = WaitTimeout(timeout);
 
         const auto native_handle = CreateThreadpoolWait(reinterpret_cast<PTP_WAIT_CALLBACK>(InvokeCallback),
             context.get(), Environment());
@@ -166,13 +358,120 @@ public:
         return Submit(wait_handle, ntp::time::max_native_duration, std::forward<Functor>(functor), std::forward<Args>(args)...);
     }
 
+    /**
+     * @brief Submits a group of threadpool wait objects with a shared user-defined callback.
+     *
+     * Callback wrapper, handles and wait objects are allocated once for the whole
+     * group, then group is put into container and all wait objects are set
+     * under a single lock. Callback is invoked once per handle (or more, if it
+     * returns ntp::wait::WaitAction::kRearm), possibly concurrently. Group is
+     * removed, when callbacks of all handles are completed.
+     *
+     * @param wait_handles Contiguous range of handles to wait for (e.g. std::vector<HANDLE>)
+     * @param timeout Timeout while each wait object waits for its handle
+     *                (pass ntp::time::max_native_duration for infinite wait timeout)
+     * @param functor Callable to invoke
+     * @param args Arguments to pass into callable (they will be copied into wrapper)
+     * @throws ntp::exception::Win32Exception if range is empty or wait objects cannot be created
+     * @returns handle for created wait group
+     */
+    template<typename Handles, typename Rep, typename Period, typename Functor, typename... Args>
+    group_handle_t SubmitGroup(const Handles& wait_handles, const std::chrono::duration<Rep, Period>& timeout, Functor&& functor, Args&&... args)
+    {
+        const auto count = std::size(wait_handles);
+        if (0 == count)
+        {
+            throw exception::Win32Exception(ERROR_INVALID_PARAMETER);
+        }
+
+        auto group = std::make_unique<WaitGroup>();
+        group->callback.template Emplace<WaitGroupCallback<Functor, Args...>>(std::forward<Functor>(functor), std::forward<Args>(args)...);
+        group->wait_handles.assign(std::data(wait_handles), std::data(wait_handles) + count);
+        group->wait_timeout = WaitTimeout(timeout);
+
+        return SubmitGroupInternal(std::move(group));
+    }
+
+    /**
+     * @brief Submits a group of threadpool wait objects with a shared user-defined callback. They never expire.
+     *
+     * Just calls generic version of ntp::wait::details::WaitManager::SubmitGroup with
+     * ntp::time::max_native_duration as timeout parameter.
+     *
+     * @param wait_handles Contiguous range of handles to wait for (e.g. std::vector<HANDLE>)
+     * @param functor Callable to invoke
+     * @param args Arguments to pass into callable (they will be copied into wrapper)
+     * @returns handle for created wait group
+     */
+    template<typename Handles, typename Functor, typename... Args>
+    auto SubmitGroup(const Handles& wait_handles, Functor&& functor, Args&&... args)
+        -> std::enable_if_t<!ntp::time::details::is_duration_v<std::decay_t<Functor>>, group_handle_t>
+    {
+        return SubmitGroup(wait_handles, ntp::time::max_native_duration, std::forward<Functor>(functor), std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief Cancels all wait objects of a group and removes it.
+     *        If group is already completed, does nothing.
+     *
+     * @param group Handle of wait group
+     */
+    void CancelGroup(group_handle_t group) noexcept;
+
+    /**
+     * @brief Cancels all wait groups.
+     */
+    void CancelAllGroups() noexcept;
+
+    /**
+     * @brief Collects metrics of the manager.
+     *
+     * @returns metrics with number of live wait objects and wait groups
+     */
+    ntp::metrics::ManagerMetrics CollectMetrics() const;
+
 private:
-    void SubmitInternal(native_handle_t native_handle, object_context_t& user_context) noexcept;
+    template<typename Rep, typename Period>
+    static std::optional<FILETIME> WaitTimeout(const std::chrono::duration<Rep, Period>& timeout) noexcept
+    {
+        const auto native_timeout = std::chrono::duration_cast<ntp::time::native_duration_t>(timeout);
+        if (native_timeout == ntp::time::max_native_duration)
+        {
+            return std::nullopt;
+        }
+
+        //
+        // Here we need relative timeout, so I will invert it (negative timeout represets a relative time interval):
+        // https://learn.microsoft.com/en-us/windows/win32/api/threadpoolapiset/nf-threadpoolapiset-setthreadpoolwait
+        //
+
+        return ntp::time::Negate(ntp::time::AsFileTime(native_timeout));
+    }
+
+    group_handle_t SubmitGroupInternal(std::unique_ptr<WaitGroup>&& group);
+
+    static void SetGroupWaits(WaitGroup& group, bool set) noexcept;
+
+    static void CloseGroup(WaitGroup& group) noexcept;
+
+    static void NTAPI InvokeGroupCallback(PTP_CALLBACK_INSTANCE instance, WaitGroupMember* member, PTP_WAIT wait, TP_WAIT_RESULT wait_result) noexcept;
+
+private:
+    static void SubmitInternal(native_handle_t native_handle, object_context_t& user_context) noexcept;
 
 private:
     static void NTAPI InvokeCallback(PTP_CALLBACK_INSTANCE instance, context_pointer_t context, PTP_WAIT wait, TP_WAIT_RESULT wait_result) noexcept;
 
+    static void StopInternal(object_context_t& user_context) noexcept;
+
     static void CloseInternal(native_handle_t native_handle) noexcept;
+
+private:
+    // Wait groups (owned by this container)
+    ntp::details::ShardedRegistry<group_handle_t, std::unique_ptr<WaitGroup>> groups_;
+
+    // Number of callbacks currently removing their own groups
+    std::atomic<std::size_t> group_cleanups_;
 };
 
 }  // namespace ntp::wait::details
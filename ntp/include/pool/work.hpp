@@ -6,11 +6,23 @@
 #pragma once
 
 #include <tuple>
+#include <mutex>
+#include <atomic>
 #include <utility>
+#include <condition_variable>
+#include <cstdint>
+#include <iterator>
+#include <algorithm>
+#include <functional>
+#include <type_traits>
 
 #include "details/windows.hpp"
 #include "details/utils.hpp"
+#include "details/queue.hpp"
+#include "details/exception.hpp"
+#include "details/metrics.hpp"
 #include "pool/basic_callback.hpp"
+#include "pool/task.hpp"
 
 
 namespace ntp::work::details {
@@ -28,6 +40,11 @@ class alignas(NTP_ALLOCATION_ALIGNMENT) WorkCallback final
     friend class ntp::details::BasicCallback<WorkCallback<Functor, Args...>, Functor, Args...>;
 
 public:
+    /**
+     * @brief Kind of callback in traces.
+     */
+    static constexpr ntp::tracing::CallbackKind kTraceKind = ntp::tracing::CallbackKind::kWork;
+
     /**
      * @brief Constructor from callable and its arguments
      * 
@@ -36,32 +53,190 @@ public:
      */
     template<typename CFunctor, typename... CArgs>
     explicit WorkCallback(CFunctor&& functor, CArgs&&... args)
-        : BasicCallback(std::forward<CFunctor>(functor), std::forward<CArgs>(args)...)
+        : WorkCallback::BasicCallback(std::forward<CFunctor>(functor), std::forward<CArgs>(args)...)
     { }
 
 private:
     /**
-     * @brief Parameter conversion function. Does nothing.
+     * @brief Parameter conversion function. Parameter is an optional 
+     *        pointer to flag "callback received PTP_CALLBACK_INSTANCE".
      */
-    void* ConvertParameter(void*) { return nullptr; }
+    bool* ConvertParameter(void* parameter) { return static_cast<bool*>(parameter); }
 
     /**
      * @brief WorkCallback invocation function implementation. Supports invocation of 
-     *        callbacks with or without PTP_CALLBACK_INSTANCE parameter.
+     *        callbacks with or without PTP_CALLBACK_INSTANCE parameter. Work callback
+     *        is invoked only once, so its arguments are moved into callable.
      */
     template<typename = void> /* if constexpr works only for templates */
-    void CallImpl(PTP_CALLBACK_INSTANCE instance, void* /* parameter */)
+    void CallImpl(PTP_CALLBACK_INSTANCE instance, bool* instance_used)
     {
-        if constexpr (std::is_invocable_v<std::decay_t<Functor>, PTP_CALLBACK_INSTANCE, std::decay_t<Args>...>)
+        if constexpr (WorkCallback::template is_invocable_with_v<PTP_CALLBACK_INSTANCE>)
         {
-            const auto args = std::tuple_cat(std::make_tuple(instance), Arguments());
-            std::apply(Callable(), args);
+            if (instance_used)
+            {
+                *instance_used = true;
+            }
+
+            this->template Invoke<true>(instance);
         }
         else
         {
-            std::apply(Callable(), Arguments());
+            this->template Invoke<true>();
+        }
+    }
+};
+
+
+/**
+ * @brief Callable, that is shared by all callbacks of a batch (see WorkManager::SubmitBatch).
+ *
+ * Batch is referenced by every its callback, so callable is copied only once
+ * and queue slots contain only elements of the range.
+ *
+ * @tparam Functor Type of callable
+ */
+template<typename Functor>
+class WorkBatch final
+{
+    WorkBatch(const WorkBatch&)            = delete;
+    WorkBatch& operator=(const WorkBatch&) = delete;
+
+public:
+    /**
+     * @brief Constructor. Batch is referenced by submitting thread only.
+     *
+     * @param functor Callable to invoke for every element
+     */
+    explicit WorkBatch(const Functor& functor)
+        : functor_(functor)
+    { }
+
+    /**
+     * @brief Adds a reference to the batch.
+     */
+    void AddRef() noexcept
+    {
+        references_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Releases a reference and destroys the batch if it was the last one.
+     */
+    void Release() noexcept
+    {
+        if (references_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            delete this;
         }
     }
+
+    /**
+     * @brief Get shared callable (callbacks may invoke it concurrently).
+     */
+    const Functor& Callable() const noexcept { return functor_; }
+
+private:
+    // Number of owners (submitting thread and callbacks)
+    std::atomic<size_t> references_ { 1 };
+
+    // Callable
+    const Functor functor_;
+};
+
+
+/**
+ * @brief Callable, that is stored in the work queue and invokes callable
+ *        of a batch for a single element. Runner owns a reference to the batch.
+ *
+ * @tparam Functor Type of batch's callable
+ * @tparam Argument Type of element
+ */
+template<typename Functor, typename Argument>
+class BatchRunner final
+{
+    BatchRunner(const BatchRunner&)            = delete;
+    BatchRunner& operator=(const BatchRunner&) = delete;
+
+    // Does batch's callable accept PTP_CALLBACK_INSTANCE
+    static constexpr bool kAcceptsInstance = std::is_invocable_v<const Functor&, PTP_CALLBACK_INSTANCE, Argument&>;
+
+public:
+    template<typename CArgument>
+    BatchRunner(WorkBatch<Functor>* batch, CArgument&& argument)
+        : argument_(std::forward<CArgument>(argument))
+        , batch_(batch)
+    {
+        batch_->AddRef();
+    }
+
+    BatchRunner(BatchRunner&& other) noexcept(std::is_nothrow_move_constructible_v<Argument>)
+        : argument_(std::move(other.argument_))
+        , batch_(std::exchange(other.batch_, nullptr))
+    { }
+
+    ~BatchRunner()
+    {
+        if (batch_)
+        {
+            batch_->Release();
+        }
+    }
+
+    /**
+     * @brief Runs a callable, that accepts PTP_CALLBACK_INSTANCE (work draining
+     *        is stopped after such callbacks, see ntp::work::details::WorkCallback).
+     */
+    template<bool Enable = kAcceptsInstance, typename = std::enable_if_t<Enable>>
+    void operator()(PTP_CALLBACK_INSTANCE instance)
+    {
+        Run(instance);
+    }
+
+    /**
+     * @brief Runs a callable, that does not accept PTP_CALLBACK_INSTANCE.
+     */
+    template<bool Enable = !kAcceptsInstance, typename = std::enable_if_t<Enable>>
+    void operator()()
+    {
+        Run();
+    }
+
+private:
+    template<typename... Prefix>
+    void Run(Prefix... prefix)
+    {
+        //
+        // Runner is invoked once, so element is moved into callable if possible
+        //
+
+        if constexpr (std::is_invocable_v<const Functor&, Prefix..., Argument&&>)
+        {
+            std::invoke(batch_->Callable(), prefix..., std::move(argument_));
+        }
+        else
+        {
+            std::invoke(batch_->Callable(), prefix..., argument_);
+        }
+    }
+
+private:
+    // Element of the range
+    Argument argument_;
+
+    // Referenced batch
+    WorkBatch<Functor>* batch_;
+};
+
+
+/**
+ * @brief Work callback in queue of WorkManager with timestamp of its submission.
+ */
+struct QueuedCallback
+{
+    ntp::details::callback_t callback; /**< Callback wrapper (stored inline if small enough) */
+
+    std::uint64_t enqueued = 0; /**< Timestamp of submission (refer to ntp::metrics::details::ReadTicks) */
 };
 
 
@@ -71,6 +246,12 @@ private:
 class WorkManager final
     : public ntp::details::BasicManager<>
 {
+    // Type of internal callbacks queue (callbacks are stored right in queue slots)
+    using queue_t = ntp::details::MpmcQueue<QueuedCallback, 256, 4096>;
+
+    // Maximum number of callbacks pushed into queue at once by SubmitBatch
+    static constexpr size_t kMaxBatchSize = 64 * 1024;
+
     WorkManager(const WorkManager&)            = delete;
     WorkManager& operator=(const WorkManager&) = delete;
 
@@ -85,30 +266,176 @@ public:
     /**
      * @brief Submits a callback into threadpool.
      * 
-     * Creates a callback wrapper and pushes it into a queue,
-     * then submits PTP_WORK into corresponding threadpool.
+     * Creates a callback wrapper right in a FIFO queue slot (small callbacks
+     * require no allocations), then submits PTP_WORK into corresponding threadpool.
      *
      * @tparam Functor Type of callable to invoke in threadpool
      * @tparam Args... Types of arguments
      * @param functor Callable to invoke
      * @param args Arguments to pass into callable (they will be copied into wrapper)
+     * @throws exception::Win32Exception with ERROR_TOO_MANY_POSTS if the queue is full
+     *         (callbacks are submitted much faster, than they are invoked) and with
+     *         ERROR_NOT_ENOUGH_MEMORY if the queue cannot allocate a segment
      */
     template<typename Functor, typename... Args>
     void Submit(Functor&& functor, Args&&... args)
     {
-        const auto callback = new WorkCallback<Functor, Args...>(
-            std::forward<Functor>(functor), std::forward<Args>(args)...);
+        //
+        // Callback is counted before it becomes visible to workers,
+        // otherwise counter may underflow
+        //
+
+        outstanding_.fetch_add(1, std::memory_order_relaxed);
+
+        auto pushed = ntp::details::PushResult::kPushed;
+
+        try
+        {
+            pushed = queue_.TryPushWith([&](QueuedCallback& queued) {
+                queued.callback.template Emplace<WorkCallback<Functor, Args...>>(
+                    std::forward<Functor>(functor), std::forward<Args>(args)...);
+
+                queued.enqueued = ntp::metrics::details::ReadTicks();
+            });
+        }
+        catch (...)
+        {
+            Complete(1);
+            throw;
+        }
+
+        if (pushed != ntp::details::PushResult::kPushed)
+        {
+            Complete(1);
+            ThrowPushFailure(pushed);
+        }
+
+        metrics_.Submitted();
 
-        queue_.Push(callback);
         ntp::details::SafeThreadpoolCall<SubmitThreadpoolWork>(work_);
     }
 
+    /**
+     * @brief Submits a callback with a result into threadpool.
+     * 
+     * Creates a task (callable and arguments co-allocated with shared state),
+     * then submits a runner, that references the task, as a usual callback.
+     *
+     * @tparam Functor Type of callable to invoke in threadpool
+     * @tparam Args... Types of arguments
+     * @param functor Callable to invoke
+     * @param args Arguments to pass into callable (they will be copied into task)
+     * @returns Future for the callable's result
+     */
+    template<typename Functor, typename... Args>
+    auto SubmitTask(Functor&& functor, Args&&... args)
+    {
+        using task_t   = ntp::task::details::Task<Functor, Args...>;
+        using result_t = typename task_t::result_t;
+        using runner_t = ntp::task::details::TaskRunner<result_t, task_t::kAcceptsInstance>;
+
+        const auto task = new task_t(std::forward<Functor>(functor), std::forward<Args>(args)...);
+        ntp::task::Future<result_t> future { task };
+
+        Submit(runner_t { task->AddRef() });
+
+        return future;
+    }
+
+    /**
+     * @brief Submits a callback for every element of a range.
+     * 
+     * Callbacks are pushed into the queue by batches with a single atomic
+     * operation, then PTP_WORK is submitted only as many times as there 
+     * are processors (every work invocation drains the queue).
+     *
+     * @tparam Iterator Type of forward iterator
+     * @tparam Functor Type of callable to invoke in threadpool
+     * @param first Beginning of the range
+     * @param last End of the range
+     * @param functor Callable to invoke for every element (it is copied once and shared by all wrappers)
+     * @throws exception::Win32Exception with ERROR_TOO_MANY_POSTS if the queue has
+     *         no room for a batch and with ERROR_NOT_ENOUGH_MEMORY if the queue cannot
+     *         allocate a segment (previous batches remain submitted in both cases)
+     */
+    template<typename Iterator, typename Functor>
+    void SubmitBatch(Iterator first, Iterator last, const Functor& functor)
+    {
+        using functor_t  = std::decay_t<Functor>;
+        using argument_t = std::decay_t<typename std::iterator_traits<Iterator>::reference>;
+        using runner_t   = BatchRunner<functor_t, argument_t>;
+        using callback_t = WorkCallback<runner_t>;
+
+        auto left = static_cast<size_t>(std::distance(first, last));
+        if (!left)
+        {
+            return;
+        }
+
+        //
+        // Callable is shared by all callbacks, submitting thread holds
+        // its own reference until all callbacks are pushed
+        //
+
+        const auto batch = new WorkBatch<functor_t>(functor);
+
+        struct Releaser
+        {
+            ~Releaser() { batch->Release(); }
+
+            WorkBatch<functor_t>* batch;
+        } releaser { batch };
+
+        while (left)
+        {
+            const auto count    = (std::min)(left, kMaxBatchSize);
+            const auto enqueued = ntp::metrics::details::ReadTicks();
+            size_t filled       = 0;
+
+            outstanding_.fetch_add(count, std::memory_order_relaxed);
+
+            auto pushed = ntp::details::PushResult::kPushed;
+
+            try
+            {
+                pushed = queue_.TryPushBatch(count, [&first, &filled, batch, enqueued](QueuedCallback& queued) {
+                    queued.callback.template Emplace<callback_t>(runner_t { batch, *first });
+                    queued.enqueued = enqueued;
+
+                    ++first;
+                    ++filled;
+                });
+            }
+            catch (...)
+            {
+                //
+                // Callbacks, that are already in queue, must be invoked
+                //
+
+                Complete(count - filled);
+                SubmitWorkers(filled);
+
+                metrics_.Submitted(filled);
+                throw;
+            }
+
+            if (pushed != ntp::details::PushResult::kPushed)
+            {
+                Complete(count);
+                ThrowPushFailure(pushed);
+            }
+
+            metrics_.Submitted(count);
+            SubmitWorkers(count);
+            left -= count;
+        }
+    }
+
     /**
      * @brief Wait for all callbacks to complete
      * 
-     * Wait is performed in separate thread if possible with periodical cancellation checks.
-     * If waiting in separate thread is not possible, wait is performed in caller thread,
-     * cancellation checks are impossible in this case (error message is reported to logger).
+     * Waiting thread is woken up by the last completed callback or by cancellation.
+     * Cancellation test is checked every ntp::details::kTestCancelTimeout milliseconds.
      * 
      * @param test_cancel Reference to cancellation test function
      * 
@@ -121,23 +448,49 @@ public:
      */
     void CancelAll() noexcept;
 
+    /**
+     * @brief Collects metrics of the manager.
+     *
+     * @returns metrics with queue depth and number of outstanding callbacks
+     */
+    ntp::metrics::ManagerMetrics CollectMetrics() const noexcept;
+
 private:
+    [[noreturn]] static void ThrowPushFailure(ntp::details::PushResult result);
+
     size_t ClearList() noexcept;
 
-private:
-    static void NTAPI InvokeCallback(PTP_CALLBACK_INSTANCE instance, PSLIST_HEADER queue, PTP_WORK work) noexcept;
+    void SubmitWorkers(size_t callbacks) noexcept;
+
+    void Complete(size_t callbacks) noexcept;
 
-    static void CALLBACK WaitAllCallback(PTP_CALLBACK_INSTANCE instance, WorkManager* self) noexcept;
+    void InvokePending(PTP_CALLBACK_INSTANCE instance, bool& instance_used);
+
+private:
+    static void NTAPI InvokeCallback(PTP_CALLBACK_INSTANCE instance, WorkManager* self, PTP_WORK work) noexcept;
 
 private:
-    // Internal queue with callbacks
-    ntp::details::NativeSlist queue_;
+    // Internal queue with callbacks (callbacks are invoked in submission order)
+    queue_t queue_;
 
-    // Internal callback descriptor (one for every callback in the pool)
+    // Internal callback descriptor (every invocation drains the queue)
     PTP_WORK work_;
 
-    // Event: all tasks completed
-    ntp::details::Event done_event_;
+    // Maximum number of work invocations submitted for a batch
+    const size_t max_workers_;
+
+    // Stop draining queue (set while callbacks are being cancelled)
+    std::atomic<bool> cancelling_;
+
+    // Number of submitted, but not yet completed or cancelled callbacks
+    std::atomic<size_t> outstanding_;
+
+    // Number of threads in WaitAll (completion is signalled only if there are any)
+    std::atomic<size_t> waiters_;
+
+    // Lock and condition for waiting threads
+    std::mutex done_lock_;
+    std::condition_variable done_condition_;
 };
 
 }  // namespace ntp::work::details
@@ -0,0 +1,218 @@
+/**
+ * @file allocator.cpp
+ * @brief Implementation of SlabAllocator
+ */
+
+#include <atomic>
+
+#include "details/allocator.hpp"
+
+
+namespace ntp::allocator {
+namespace {
+
+/**
+ * @brief Free block is a node of intrusive list.
+ */
+struct FreeBlock
+{
+    FreeBlock* next;
+};
+
+
+/**
+ * @brief Global counters, updated by threads on slow paths.
+ */
+struct GlobalStatistics
+{
+    using counters_t = SlabStatistics;
+
+    std::atomic<uint64_t> allocations       = 0;
+    std::atomic<uint64_t> cache_hits        = 0;
+    std::atomic<uint64_t> depot_hits        = 0;
+    std::atomic<uint64_t> slab_refills      = 0;
+    std::atomic<uint64_t> large_allocations = 0;
+    std::atomic<uint64_t> frees             = 0;
+
+    void Add(const SlabStatistics& local) noexcept
+    {
+        allocations.fetch_add(local.allocations, std::memory_order_relaxed);
+        cache_hits.fetch_add(local.cache_hits, std::memory_order_relaxed);
+        depot_hits.fetch_add(local.depot_hits, std::memory_order_relaxed);
+        slab_refills.fetch_add(local.slab_refills, std::memory_order_relaxed);
+        large_allocations.fetch_add(local.large_allocations, std::memory_order_relaxed);
+        frees.fetch_add(local.frees, std::memory_order_relaxed);
+    }
+
+    SlabStatistics Load() const noexcept
+    {
+        return SlabStatistics {
+            allocations.load(std::memory_order_relaxed),
+            cache_hits.load(std::memory_order_relaxed),
+            depot_hits.load(std::memory_order_relaxed),
+            slab_refills.load(std::memory_order_relaxed),
+            large_allocations.load(std::memory_order_relaxed),
+            frees.load(std::memory_order_relaxed)
+        };
+    }
+
+    static void Merge(SlabStatistics& statistics, const SlabStatistics& local) noexcept
+    {
+        statistics.allocations       += local.allocations;
+        statistics.cache_hits        += local.cache_hits;
+        statistics.depot_hits        += local.depot_hits;
+        statistics.slab_refills      += local.slab_refills;
+        statistics.large_allocations += local.large_allocations;
+        statistics.frees             += local.frees;
+    }
+
+    static void Allocated(SlabStatistics& local) noexcept { ++local.allocations; }
+
+    static void CacheHit(SlabStatistics& local) noexcept { ++local.cache_hits; }
+
+    static void Refilled(SlabStatistics& local, bool from_slab) noexcept { ++(from_slab ? local.slab_refills : local.depot_hits); }
+
+    static void Freed(SlabStatistics& local) noexcept { ++local.frees; }
+};
+
+
+/**
+ * @brief Traits of blocks of SlabAllocator (refer to details::SlabCache).
+ */
+struct BlockTraits
+{
+    using block_t = FreeBlock;
+    using sink_t  = GlobalStatistics;
+
+    /**
+     * @brief Number of size classes (32, 64, ..., 1024 bytes)
+     */
+    static constexpr std::uint32_t kClasses = 6;
+
+    /**
+     * @brief Number of blocks moved between thread-local cache and depot at once
+     */
+    static constexpr std::uint32_t kBatchSize = 32;
+
+    static FreeBlock*& Next(FreeBlock* block) noexcept { return block->next; }
+
+    /**
+     * @brief Slabs of 64 KiB, that are split into blocks of the same size class.
+     */
+    class Slab final
+    {
+        static constexpr size_t kSlabSize = 64 * 1024;
+
+    public:
+        explicit Slab(std::uint32_t size_class) noexcept
+            : block_size_(SlabAllocator::kMinBlockSize << size_class)
+        { }
+
+        void Carve(details::FreeList<BlockTraits>& batch) noexcept
+        {
+            for (uint32_t i = 0; i < kBatchSize; ++i)
+            {
+                if (cursor_ == end_)
+                {
+                    const auto slab = static_cast<char*>(::operator new(kSlabSize,
+                        std::align_val_t { SlabAllocator::kBlockAlignment }, std::nothrow));
+
+                    if (!slab)
+                    {
+                        break;
+                    }
+
+                    cursor_ = slab;
+                    end_    = slab + kSlabSize;
+                }
+
+                batch.Push(reinterpret_cast<FreeBlock*>(cursor_));
+                cursor_ += block_size_;
+            }
+        }
+
+    private:
+        // Size of blocks
+        const size_t block_size_;
+
+        // Unused part of the current slab
+        char* cursor_ = nullptr;
+        char* end_    = nullptr;
+    };
+};
+
+using cache_t = details::SlabCache<BlockTraits>;
+
+static_assert(SlabAllocator::kMinBlockSize << (BlockTraits::kClasses - 1) == SlabAllocator::kMaxBlockSize,
+    "[ntp::allocator]: number of size classes does not match block sizes");
+
+static_assert(SlabAllocator::kMinBlockSize % SlabAllocator::kBlockAlignment == 0,
+    "[ntp::allocator]: blocks must be aligned");
+
+
+/**
+ * @brief Get size class for a block
+ *
+ * @param bytes Size of block (must not be greater than SlabAllocator::kMaxBlockSize)
+ * @returns Index of size class
+ */
+std::uint32_t SizeClass(size_t bytes) noexcept
+{
+    std::uint32_t size_class = 0;
+
+    for (auto block_size = SlabAllocator::kMinBlockSize; block_size < bytes; block_size <<= 1)
+    {
+        ++size_class;
+    }
+
+    return size_class;
+}
+
+}  // namespace
+
+
+void* SlabAllocator::AllocateBytes(size_t bytes)
+{
+    void* allocated = nullptr;
+
+    if (bytes > kMaxBlockSize)
+    {
+        allocated = ::operator new(bytes, std::align_val_t { kBlockAlignment }, std::nothrow);
+        cache_t::Sink().large_allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    else
+    {
+        allocated = cache_t::Allocate(SizeClass(bytes));
+    }
+
+    if (!allocated)
+    {
+        throw exception::Win32Exception(ERROR_NOT_ENOUGH_MEMORY);
+    }
+
+    return allocated;
+}
+
+void SlabAllocator::Free(void* ptr, size_t bytes) noexcept
+{
+    if (!ptr)
+    {
+        return;
+    }
+
+    if (bytes > kMaxBlockSize)
+    {
+        ::operator delete(ptr, std::align_val_t { kBlockAlignment });
+    }
+    else
+    {
+        cache_t::Free(static_cast<FreeBlock*>(ptr), SizeClass(bytes));
+    }
+}
+
+SlabStatistics SlabAllocator::Statistics() noexcept
+{
+    return cache_t::Statistics();
+}
+
+}  // namespace ntp::allocator
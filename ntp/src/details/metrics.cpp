@@ -0,0 +1,284 @@
+/**
+ * @file metrics.cpp
+ * @brief Implementation of metrics of threadpool object managers
+ */
+
+#include <new>
+#include <cmath>
+#include <algorithm>
+
+#include "details/metrics.hpp"
+
+
+namespace ntp::metrics {
+namespace details {
+namespace {
+
+/**
+ * @brief Duration of TSC calibration
+ */
+constexpr std::chrono::microseconds kCalibrationInterval { 2000 };
+
+
+double CalibrateTicks() noexcept
+{
+#if defined(NTP_METRICS_HAS_TSC)
+    //
+    // Steady clock and TSC are sampled at the same points, and their
+    // rates are compared. The thread spins, sleep may be too coarse.
+    //
+
+    const auto clock_begin = std::chrono::steady_clock::now();
+    const auto ticks_begin = __rdtsc();
+
+    auto clock_end = clock_begin;
+    while (clock_end - clock_begin < kCalibrationInterval)
+    {
+        clock_end = std::chrono::steady_clock::now();
+    }
+
+    const auto ticks_end = __rdtsc();
+    const auto elapsed   = std::chrono::duration_cast<std::chrono::nanoseconds>(clock_end - clock_begin);
+
+    if (ticks_end <= ticks_begin)
+    {
+        return 1.0;
+    }
+
+    return static_cast<double>(elapsed.count()) / static_cast<double>(ticks_end - ticks_begin);
+#else  // !NTP_METRICS_HAS_TSC
+    using period_t = std::chrono::steady_clock::period;
+    return 1e9 * static_cast<double>(period_t::num) / static_cast<double>(period_t::den);
+#endif  // NTP_METRICS_HAS_TSC
+}
+
+
+/**
+ * @brief Owner of the calling thread's slot. Releases slot, when thread exits.
+ */
+class SlotHolder final
+{
+public:
+    SlotHolder() noexcept
+        : slot_(kSharedSlot)
+    {
+        for (std::size_t word = 0; word < kSlotWords && slot_ == kSharedSlot; ++word)
+        {
+            auto free = ~taken[word].load(std::memory_order_relaxed);
+
+            while (free)
+            {
+                const auto bit = LowestBit(free);
+                const auto was = taken[word].fetch_or(std::uint64_t { 1 } << bit, std::memory_order_acquire);
+
+                if (!(was & (std::uint64_t { 1 } << bit)))
+                {
+                    slot_ = word * 64 + bit;
+                    break;
+                }
+
+                free = ~was;
+            }
+        }
+    }
+
+    ~SlotHolder()
+    {
+        //
+        // The next owner of the slot continues writing to the same
+        // shards, so it must observe all counters written by this thread
+        //
+
+        if (slot_ != kSharedSlot)
+        {
+            taken[slot_ / 64].fetch_and(~(std::uint64_t { 1 } << (slot_ % 64)), std::memory_order_release);
+        }
+    }
+
+    std::size_t Slot() const noexcept { return slot_; }
+
+private:
+    static std::size_t LowestBit(std::uint64_t value) noexcept
+    {
+        std::size_t bit = 0;
+        while (!(value & 1))
+        {
+            value >>= 1;
+            ++bit;
+        }
+
+        return bit;
+    }
+
+private:
+    static constexpr std::size_t kSlotWords = (kThreadSlots + 63) / 64;
+
+    // Bitmap of taken slots
+    static inline std::array<std::atomic<std::uint64_t>, kSlotWords> taken {};
+
+    // Slot of the calling thread
+    std::size_t slot_;
+};
+
+}  // namespace
+
+
+std::size_t ThreadSlot() noexcept
+{
+    thread_local const SlotHolder holder;
+    return holder.Slot();
+}
+
+double NanosecondsPerTick() noexcept
+{
+    static const auto nanoseconds_per_tick = CalibrateTicks();
+    return nanoseconds_per_tick;
+}
+
+MetricsRecorder::MetricsRecorder() noexcept
+    : shards_()
+    , shared_()
+{
+    for (auto& shard : shards_)
+    {
+        shard.store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+MetricsRecorder::~MetricsRecorder()
+{
+    for (auto& shard : shards_)
+    {
+        delete shard.load(std::memory_order_acquire);
+    }
+}
+
+MetricsRecorder::Shard& MetricsRecorder::AllocateShard(std::size_t slot) noexcept
+{
+    if (slot == kSharedSlot)
+    {
+        return shared_;
+    }
+
+    //
+    // Only the owner of a slot allocates its shard, hence no race here
+    //
+
+    const auto shard = new (std::nothrow) Shard();
+    if (!shard)
+    {
+        return shared_;
+    }
+
+    shard->exclusive = true;
+    shards_[slot].store(shard, std::memory_order_release);
+
+    return *shard;
+}
+
+ManagerMetrics MetricsRecorder::Collect() const noexcept
+{
+    ManagerMetrics metrics;
+
+    Histogram::buckets_t queue_latency {};
+    Histogram::buckets_t run_time {};
+
+    const auto collect = [&metrics, &queue_latency, &run_time](const Shard& shard) {
+        metrics.submitted += shard.submitted.load(std::memory_order_relaxed);
+        metrics.cancelled += shard.cancelled.load(std::memory_order_relaxed);
+
+        for (std::size_t bucket = 0; bucket < Histogram::kBuckets; ++bucket)
+        {
+            queue_latency[bucket] += shard.queue_latency[bucket].load(std::memory_order_relaxed);
+            run_time[bucket] += shard.run_time[bucket].load(std::memory_order_relaxed);
+        }
+    };
+
+    for (const auto& shard : shards_)
+    {
+        if (const auto allocated = shard.load(std::memory_order_acquire); allocated)
+        {
+            collect(*allocated);
+        }
+    }
+
+    collect(shared_);
+
+    const auto nanoseconds_per_tick = NanosecondsPerTick();
+
+    metrics.queue_latency = Histogram(queue_latency, nanoseconds_per_tick);
+    metrics.run_time      = Histogram(run_time, nanoseconds_per_tick);
+    metrics.completed     = metrics.run_time.Count();
+
+    return metrics;
+}
+
+}  // namespace details
+
+
+Histogram::Histogram(const buckets_t& buckets, double nanoseconds_per_unit) noexcept
+    : buckets_(buckets)
+    , count_(0)
+    , nanoseconds_per_unit_(nanoseconds_per_unit)
+{
+    for (const auto count : buckets_)
+    {
+        count_ += count;
+    }
+}
+
+std::chrono::nanoseconds Histogram::LowerBound(std::size_t bucket) const noexcept
+{
+    const auto units = static_cast<double>(LowerBoundOf(bucket));
+    return std::chrono::nanoseconds(static_cast<std::chrono::nanoseconds::rep>(std::llround(units * nanoseconds_per_unit_)));
+}
+
+std::chrono::nanoseconds Histogram::Percentile(double fraction) const noexcept
+{
+    if (!count_)
+    {
+        return std::chrono::nanoseconds::zero();
+    }
+
+    //
+    // Rank of the value is rounded up, so that 1.0 is the maximum value
+    //
+
+    const auto bounded = (std::min)((std::max)(fraction, 0.0), 1.0);
+    const auto rank    = (std::max)(static_cast<std::uint64_t>(std::ceil(bounded * static_cast<double>(count_))), std::uint64_t { 1 });
+
+    std::uint64_t seen = 0;
+    for (std::size_t bucket = 0; bucket < kBuckets; ++bucket)
+    {
+        seen += buckets_[bucket];
+
+        if (seen >= rank)
+        {
+            return bucket + 1 < kBuckets ? LowerBound(bucket + 1) : LowerBound(bucket);
+        }
+    }
+
+    return LowerBound(kBuckets - 1);
+}
+
+Histogram& Histogram::operator+=(const Histogram& other) noexcept
+{
+    //
+    // Histograms of the same process share the unit, empty ones take the other's unit
+    //
+
+    if (!count_)
+    {
+        nanoseconds_per_unit_ = other.nanoseconds_per_unit_;
+    }
+
+    for (std::size_t bucket = 0; bucket < kBuckets; ++bucket)
+    {
+        buckets_[bucket] += other.buckets_[bucket];
+    }
+
+    count_ += other.count_;
+    return *this;
+}
+
+}  // namespace ntp::metrics
@@ -0,0 +1,583 @@
+/**
+ * @file tracing.cpp
+ * @brief Implementation of recording and export of callback traces
+ */
+
+#include <new>
+#include <array>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <algorithm>
+
+#include "details/tracing.hpp"
+
+#if defined(NTP_PLATFORM_WINDOWS)
+#   include "details/windows.hpp"
+#else  // !NTP_PLATFORM_WINDOWS
+#   include <unistd.h>
+#   include <sys/syscall.h>
+#endif  // NTP_PLATFORM_WINDOWS
+
+
+namespace ntp::tracing {
+namespace details {
+namespace {
+
+/**
+ * @brief Capacity of a thread's buffer
+ */
+constexpr std::size_t kBufferEvents = 8192;
+
+
+std::uint64_t CurrentThreadId() noexcept
+{
+#if defined(NTP_PLATFORM_WINDOWS)
+    return GetCurrentThreadId();
+#else  // !NTP_PLATFORM_WINDOWS
+    return static_cast<std::uint64_t>(::syscall(SYS_gettid));
+#endif  // NTP_PLATFORM_WINDOWS
+}
+
+std::uint64_t CurrentProcessId() noexcept
+{
+#if defined(NTP_PLATFORM_WINDOWS)
+    return GetCurrentProcessId();
+#else  // !NTP_PLATFORM_WINDOWS
+    return static_cast<std::uint64_t>(::getpid());
+#endif  // NTP_PLATFORM_WINDOWS
+}
+
+
+/**
+ * @brief Events of a thread. Events are written by the owning thread only
+ *        and published by a release store of size.
+ */
+struct ThreadBuffer final
+{
+    std::array<Event, kBufferEvents> events; /**< Recorded events */
+
+    std::atomic<std::size_t> size { 0 }; /**< Number of published events */
+
+    std::atomic<std::uint64_t> dropped { 0 }; /**< Number of events, that did not fit */
+
+    std::atomic<std::uint64_t> generation { 0 }; /**< Generation of tracing, that events belong to */
+
+    std::atomic<bool> owned { true }; /**< Is owning thread alive */
+
+    std::uint64_t thread_id = 0; /**< System identifier of owning thread */
+};
+
+
+/**
+ * @brief Registry of all thread buffers. Every ntp::tracing::Start begins a new
+ *        generation: buffers of the previous one are reset by their owners
+ *        lazily, buffers of exited threads are freed.
+ */
+class Registry final
+{
+public:
+    static Registry& Instance() noexcept
+    {
+        //
+        // Registry is never destroyed: threads may exit
+        // (and release their buffers) after static destruction
+        //
+
+        static const auto instance = new Registry();
+        return *instance;
+    }
+
+    std::uint64_t Generation() const noexcept { return generation_.load(std::memory_order_acquire); }
+
+    ThreadBuffer* Allocate() noexcept
+    {
+        std::unique_ptr<ThreadBuffer> buffer { new (std::nothrow) ThreadBuffer() };
+        if (!buffer)
+        {
+            return nullptr;
+        }
+
+        buffer->thread_id = CurrentThreadId();
+
+        std::lock_guard lock { lock_ };
+
+        try
+        {
+            buffers_.push_back(std::move(buffer));
+        }
+        catch (const std::bad_alloc&)
+        {
+            return nullptr;
+        }
+
+        buffers_.back()->generation.store(Generation(), std::memory_order_relaxed);
+        return buffers_.back().get();
+    }
+
+    void Restart() noexcept
+    {
+        std::lock_guard lock { lock_ };
+
+        buffers_.erase(std::remove_if(buffers_.begin(), buffers_.end(), [](const std::unique_ptr<ThreadBuffer>& buffer) {
+            return !buffer->owned.load(std::memory_order_acquire);
+        }), buffers_.end());
+
+        generation_.fetch_add(1, std::memory_order_acq_rel);
+    }
+
+    Trace Collect()
+    {
+        Trace trace;
+        trace.process_id           = CurrentProcessId();
+        trace.nanoseconds_per_tick = ntp::metrics::details::NanosecondsPerTick();
+
+        std::lock_guard lock { lock_ };
+
+        const auto generation = Generation();
+
+        for (const auto& buffer : buffers_)
+        {
+            if (buffer->generation.load(std::memory_order_acquire) != generation)
+            {
+                //
+                // Owner has recorded nothing since tracing was restarted
+                //
+
+                continue;
+            }
+
+            const auto size = buffer->size.load(std::memory_order_acquire);
+            if (!size)
+            {
+                continue;
+            }
+
+            auto& thread     = trace.threads.emplace_back();
+            thread.thread_id = buffer->thread_id;
+            thread.dropped   = buffer->dropped.load(std::memory_order_relaxed);
+            thread.events.assign(buffer->events.begin(), buffer->events.begin() + size);
+        }
+
+        return trace;
+    }
+
+private:
+    Registry() = default;
+
+private:
+    // Lock of buffers_ (taken on the first event of a thread only)
+    std::mutex lock_;
+
+    // Buffers of all threads
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers_;
+
+    // Current generation of tracing
+    std::atomic<std::uint64_t> generation_ { 0 };
+};
+
+
+/**
+ * @brief Owner of the calling thread's buffer. Buffer is left in registry,
+ *        when thread exits, so its events can still be collected.
+ */
+class BufferHolder final
+{
+public:
+    ~BufferHolder()
+    {
+        if (buffer_)
+        {
+            buffer_->owned.store(false, std::memory_order_release);
+        }
+    }
+
+    ThreadBuffer* Buffer() noexcept
+    {
+        if (!buffer_)
+        {
+            buffer_ = Registry::Instance().Allocate();
+        }
+
+        return buffer_;
+    }
+
+private:
+    // Buffer of the calling thread
+    ThreadBuffer* buffer_ = nullptr;
+};
+
+
+/**
+ * @brief Minimal protobuf encoder (varint and length-delimited fields only).
+ */
+class ProtoWriter final
+{
+public:
+    void Varint(std::uint32_t field, std::uint64_t value)
+    {
+        Raw((static_cast<std::uint64_t>(field) << 3) | 0);
+        Raw(value);
+    }
+
+    void Bytes(std::uint32_t field, std::string_view value)
+    {
+        Raw((static_cast<std::uint64_t>(field) << 3) | 2);
+        Raw(value.size());
+        buffer_.append(value);
+    }
+
+    void Message(std::uint32_t field, const ProtoWriter& message)
+    {
+        Bytes(field, message.buffer_);
+    }
+
+    const std::string& Data() const noexcept { return buffer_; }
+
+private:
+    void Raw(std::uint64_t value)
+    {
+        for (; value >= 0x80; value >>= 7)
+        {
+            buffer_.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        }
+
+        buffer_.push_back(static_cast<char>(value));
+    }
+
+private:
+    // Encoded message
+    std::string buffer_;
+};
+
+
+/**
+ * @brief Field numbers of Perfetto messages (perfetto/protos/perfetto/trace)
+ */
+namespace perfetto {
+
+constexpr std::uint32_t kTracePacket = 1;
+
+constexpr std::uint32_t kPacketTimestamp    = 8;
+constexpr std::uint32_t kPacketSequenceId   = 10;
+constexpr std::uint32_t kPacketTrackEvent   = 11;
+constexpr std::uint32_t kPacketSequenceFlag = 13;
+constexpr std::uint32_t kPacketDescriptor   = 60;
+
+constexpr std::uint32_t kDescriptorUuid   = 1;
+constexpr std::uint32_t kDescriptorThread = 4;
+
+constexpr std::uint32_t kThreadPid = 1;
+constexpr std::uint32_t kThreadTid = 2;
+
+constexpr std::uint32_t kEventType       = 9;
+constexpr std::uint32_t kEventTrackUuid  = 11;
+constexpr std::uint32_t kEventCategories = 22;
+constexpr std::uint32_t kEventName       = 23;
+
+constexpr std::uint64_t kSliceBegin = 1;
+constexpr std::uint64_t kSliceEnd   = 2;
+
+constexpr std::uint64_t kIncrementalStateCleared = 1;
+constexpr std::uint64_t kSequenceId              = 1;
+
+}  // namespace perfetto
+
+
+/**
+ * @brief Converts timestamps to nanoseconds since the earliest event.
+ */
+class TimeBase final
+{
+public:
+    explicit TimeBase(const Trace& trace) noexcept
+        : origin_(~std::uint64_t { 0 })
+        , nanoseconds_per_tick_(trace.nanoseconds_per_tick)
+    {
+        for (const auto& thread : trace.threads)
+        {
+            for (const auto& event : thread.events)
+            {
+                origin_ = (std::min)(origin_, event.begin);
+            }
+        }
+    }
+
+    std::uint64_t Nanoseconds(std::uint64_t ticks) const noexcept
+    {
+        return ticks > origin_
+                 ? static_cast<std::uint64_t>(static_cast<double>(ticks - origin_) * nanoseconds_per_tick_ + 0.5)
+                 : 0;
+    }
+
+private:
+    // Timestamp of the earliest event
+    std::uint64_t origin_;
+
+    // Duration of a timestamp unit
+    const double nanoseconds_per_tick_;
+};
+
+
+const char* EventName(const Event& event) noexcept
+{
+    return event.tag ? event.tag : KindName(event.kind);
+}
+
+void WriteJsonString(std::ostream& stream, std::string_view value)
+{
+    constexpr char kHex[] = "0123456789abcdef";
+
+    stream << '"';
+
+    for (const auto symbol : value)
+    {
+        const auto code = static_cast<unsigned char>(symbol);
+
+        if (symbol == '"' || symbol == '\\')
+        {
+            stream << '\\' << symbol;
+        }
+        else if (code < 0x20)
+        {
+            stream << "\\u00" << kHex[code >> 4] << kHex[code & 0xf];
+        }
+        else
+        {
+            stream << symbol;
+        }
+    }
+
+    stream << '"';
+}
+
+void WriteMicroseconds(std::ostream& stream, std::uint64_t nanoseconds)
+{
+    const auto fraction = nanoseconds % 1000;
+
+    stream << nanoseconds / 1000 << '.'
+           << static_cast<char>('0' + fraction / 100)
+           << static_cast<char>('0' + fraction / 10 % 10)
+           << static_cast<char>('0' + fraction % 10);
+}
+
+}  // namespace
+
+
+void Record(const Event& event) noexcept
+{
+    thread_local BufferHolder holder;
+
+    const auto buffer = holder.Buffer();
+    if (!buffer)
+    {
+        return;
+    }
+
+    //
+    // Buffer of the previous generation is reset by its owner, so
+    // only the owning thread ever writes to the buffer
+    //
+
+    const auto generation = Registry::Instance().Generation();
+
+    if (buffer->generation.load(std::memory_order_relaxed) != generation)
+    {
+        buffer->size.store(0, std::memory_order_relaxed);
+        buffer->dropped.store(0, std::memory_order_relaxed);
+        buffer->generation.store(generation, std::memory_order_release);
+    }
+
+    const auto size = buffer->size.load(std::memory_order_relaxed);
+
+    if (size == kBufferEvents)
+    {
+        buffer->dropped.store(buffer->dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return;
+    }
+
+    buffer->events[size] = event;
+    buffer->size.store(size + 1, std::memory_order_release);
+}
+
+}  // namespace details
+
+
+const char* KindName(CallbackKind kind) noexcept
+{
+    switch (kind)
+    {
+    case CallbackKind::kWork:
+        return "work";
+    case CallbackKind::kWait:
+        return "wait";
+    case CallbackKind::kTimer:
+        return "timer";
+    case CallbackKind::kIo:
+        return "io";
+    }
+
+    return "unknown";
+}
+
+void Start() noexcept
+{
+    details::Registry::Instance().Restart();
+    details::started.store(true, std::memory_order_release);
+}
+
+void Stop() noexcept
+{
+    details::started.store(false, std::memory_order_release);
+}
+
+bool IsStarted() noexcept
+{
+    return details::started.load(std::memory_order_acquire);
+}
+
+Trace Collect()
+{
+    return details::Registry::Instance().Collect();
+}
+
+void WriteChromeTrace(std::ostream& stream, const Trace& trace)
+{
+    const details::TimeBase time_base { trace };
+
+    stream << "{\"traceEvents\":[";
+
+    bool first = true;
+
+    for (const auto& thread : trace.threads)
+    {
+        for (const auto& event : thread.events)
+        {
+            const auto begin = time_base.Nanoseconds(event.begin);
+            const auto end   = (std::max)(time_base.Nanoseconds(event.end), begin);
+
+            stream << (first ? "\n" : ",\n") << "{\"name\":";
+            details::WriteJsonString(stream, details::EventName(event));
+
+            stream << ",\"cat\":\"" << KindName(event.kind) << "\",\"ph\":\"X\",\"pid\":" << trace.process_id
+                   << ",\"tid\":" << thread.thread_id << ",\"ts\":";
+            details::WriteMicroseconds(stream, begin);
+
+            stream << ",\"dur\":";
+            details::WriteMicroseconds(stream, end - begin);
+
+            stream << '}';
+            first = false;
+        }
+    }
+
+    stream << "\n],\"displayTimeUnit\":\"ns\"}\n";
+}
+
+void WritePerfetto(std::ostream& stream, const Trace& trace)
+{
+    namespace perfetto = details::perfetto;
+
+    const details::TimeBase time_base { trace };
+
+    const auto write_packet = [&stream](const details::ProtoWriter& packet) {
+        details::ProtoWriter wrapper;
+        wrapper.Message(perfetto::kTracePacket, packet);
+
+        stream.write(wrapper.Data().data(), static_cast<std::streamsize>(wrapper.Data().size()));
+    };
+
+    //
+    // Slices of a thread are emitted in order of timestamps (ends first at
+    // the same time), because events are recorded in order of completion
+    //
+
+    struct Boundary
+    {
+        std::uint64_t timestamp;
+        std::uint64_t type;
+        const Event* event;
+    };
+
+    std::vector<Boundary> boundaries;
+    bool first = true;
+
+    for (std::size_t index = 0; index < trace.threads.size(); ++index)
+    {
+        const auto& thread = trace.threads[index];
+        const auto uuid    = static_cast<std::uint64_t>(index) + 1;
+
+        {
+            details::ProtoWriter thread_descriptor;
+            thread_descriptor.Varint(perfetto::kThreadPid, trace.process_id);
+            thread_descriptor.Varint(perfetto::kThreadTid, thread.thread_id);
+
+            details::ProtoWriter descriptor;
+            descriptor.Varint(perfetto::kDescriptorUuid, uuid);
+            descriptor.Message(perfetto::kDescriptorThread, thread_descriptor);
+
+            details::ProtoWriter packet;
+            packet.Varint(perfetto::kPacketSequenceId, perfetto::kSequenceId);
+
+            if (first)
+            {
+                packet.Varint(perfetto::kPacketSequenceFlag, perfetto::kIncrementalStateCleared);
+                first = false;
+            }
+
+            packet.Message(perfetto::kPacketDescriptor, descriptor);
+            write_packet(packet);
+        }
+
+        boundaries.clear();
+
+        for (const auto& event : thread.events)
+        {
+            const auto begin = time_base.Nanoseconds(event.begin);
+            const auto end   = (std::max)(time_base.Nanoseconds(event.end), begin);
+
+            boundaries.push_back(Boundary { begin, perfetto::kSliceBegin, &event });
+            boundaries.push_back(Boundary { end, perfetto::kSliceEnd, &event });
+        }
+
+        std::stable_sort(boundaries.begin(), boundaries.end(), [](const Boundary& left, const Boundary& right) {
+            return left.timestamp < right.timestamp ||
+                   (left.timestamp == right.timestamp && left.type == perfetto::kSliceEnd && right.type == perfetto::kSliceBegin);
+        });
+
+        for (const auto& boundary : boundaries)
+        {
+            details::ProtoWriter track_event;
+            track_event.Varint(perfetto::kEventType, boundary.type);
+            track_event.Varint(perfetto::kEventTrackUuid, uuid);
+
+            if (boundary.type == perfetto::kSliceBegin)
+            {
+                track_event.Bytes(perfetto::kEventCategories, KindName(boundary.event->kind));
+                track_event.Bytes(perfetto::kEventName, details::EventName(*boundary.event));
+            }
+
+            details::ProtoWriter packet;
+            packet.Varint(perfetto::kPacketTimestamp, boundary.timestamp);
+            packet.Varint(perfetto::kPacketSequenceId, perfetto::kSequenceId);
+            packet.Message(perfetto::kPacketTrackEvent, track_event);
+
+            write_packet(packet);
+        }
+    }
+}
+
+
+ScopedTag::ScopedTag(const char* tag) noexcept
+    : previous_(details::current_tag)
+{
+    details::current_tag = tag;
+}
+
+ScopedTag::~ScopedTag()
+{
+    details::current_tag = previous_;
+}
+
+}  // namespace ntp::tracing
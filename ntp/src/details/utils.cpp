@@ -6,7 +6,6 @@
 #include <vector>
 
 #include "ntp_config.hpp"
-#include "native/ntrtl.h"
 #include "details/utils.hpp"
 #include "details/exception.hpp"
 
@@ -128,31 +127,6 @@ std::wstring Convert(const std::string& source) noexcept
 }
 
 
-NativeSlist::NativeSlist()
-    : header_(allocator_t::Allocate<NTP_ALLOCATION_ALIGNMENT>())
-{
-    if (!header_)
-    {
-        throw exception::Win32Exception(ERROR_NOT_ENOUGH_MEMORY);
-    }
-
-    InitializeSListHead(header_);
-}
-
-NativeSlist::~NativeSlist()
-{
-    if (header_)
-    {
-        allocator_t::Free(header_);
-    }
-}
-
-void NativeSlist::Push(PSLIST_ENTRY entry) noexcept
-{
-    InterlockedPushEntrySList(header_, entry);
-}
-
-
 RtlResource::RtlResource()
     : resource_()
 {
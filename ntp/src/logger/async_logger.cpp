@@ -0,0 +1,275 @@
+/**
+ * @file async_logger.cpp
+ * @brief Implementation of AsyncLogger
+ */
+
+#include <new>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <system_error>
+
+#include "logger/async_logger.hpp"
+#include "logger/logger_internal.hpp"
+
+
+namespace ntp::logger::details {
+namespace {
+
+/**
+ * @brief Background thread checks rings at least so often
+ */
+constexpr std::chrono::milliseconds kPollInterval { 10 };
+
+
+/**
+ * @brief Owner of the calling thread's ring. Abandons ring, when thread exits.
+ */
+struct RingHolder
+{
+    ~RingHolder();
+
+    RecordRing* ring = nullptr;
+};
+
+// Holder is never accessed after its destruction (abandoned ring
+// is destroyed by background thread, once it becomes empty)
+thread_local bool holder_destroyed = false;
+
+// Ring of the calling thread
+thread_local RingHolder holder;
+
+
+RingHolder::~RingHolder()
+{
+    holder_destroyed = true;
+
+    if (ring)
+    {
+        ring->Abandon();
+        ring = nullptr;
+    }
+}
+
+// Is the calling thread a background thread of AsyncLogger
+thread_local bool is_background = false;
+
+}  // namespace
+
+
+AsyncLogger::AsyncLogger() noexcept
+    : enabled_(false)
+    , overflows_(0)
+    , lock_()
+    , wake_()
+    , flushed_()
+    , started_(false)
+    , requested_(0)
+    , completed_(0)
+    , rings_lock_()
+    , rings_()
+    , snapshot_()
+{ }
+
+/* static */
+AsyncLogger& AsyncLogger::Instance() noexcept
+{
+    //
+    // Threads may trace messages while the process is terminating
+    //
+
+    static const auto logger = new AsyncLogger();
+    return *logger;
+}
+
+bool AsyncLogger::Enable(bool enable) noexcept
+{
+    if (!enable)
+    {
+        enabled_.store(false, std::memory_order_relaxed);
+        Flush();
+
+        return true;
+    }
+
+    {
+        std::lock_guard lock { lock_ };
+
+        if (!started_)
+        {
+            try
+            {
+                std::thread(&AsyncLogger::Run, this).detach();
+            }
+            catch (const std::system_error&)
+            {
+                return false;
+            }
+
+            started_ = true;
+        }
+
+        enabled_.store(true, std::memory_order_relaxed);
+    }
+
+    wake_.notify_one();
+    return true;
+}
+
+void AsyncLogger::Flush() noexcept
+{
+    if (is_background)
+    {
+        return;
+    }
+
+    std::unique_lock lock { lock_ };
+
+    if (!started_)
+    {
+        return;
+    }
+
+    const auto target = ++requested_;
+    wake_.notify_one();
+
+    flushed_.wait(lock, [this, target]() { return completed_ >= target; });
+}
+
+RecordRing* AsyncLogger::LocalRing() noexcept
+{
+    //
+    // Messages traced by destructors of other thread-local
+    // objects are written synchronously
+    //
+
+    if (holder_destroyed)
+    {
+        return nullptr;
+    }
+
+    if (holder.ring)
+    {
+        return holder.ring;
+    }
+
+    if (is_background)
+    {
+        return nullptr;
+    }
+
+    const auto ring = new (std::nothrow) RecordRing();
+    if (!ring)
+    {
+        return nullptr;
+    }
+
+    try
+    {
+        std::lock_guard lock { rings_lock_ };
+        rings_.push_back(ring);
+    }
+    catch (const std::bad_alloc&)
+    {
+        delete ring;
+        return nullptr;
+    }
+
+    holder.ring = ring;
+    return ring;
+}
+
+void AsyncLogger::Run() noexcept
+{
+    is_background = true;
+
+    std::unique_lock lock { lock_ };
+
+    for (;;)
+    {
+        const auto generation = requested_;
+
+        lock.unlock();
+        const auto drained = Drain();
+        lock.lock();
+
+        completed_ = generation;
+        flushed_.notify_all();
+
+        if (drained || requested_ != generation)
+        {
+            continue;
+        }
+
+        //
+        // In synchronous mode rings are drained only on flush requests
+        //
+
+        if (enabled_.load(std::memory_order_relaxed))
+        {
+            wake_.wait_for(lock, kPollInterval);
+        }
+        else
+        {
+            wake_.wait(lock);
+        }
+    }
+}
+
+std::size_t AsyncLogger::Drain() noexcept
+{
+    try
+    {
+        std::lock_guard lock { rings_lock_ };
+        snapshot_ = rings_;
+    }
+    catch (const std::bad_alloc&)
+    {
+        return 0;
+    }
+
+    const auto logger = Logger::Instance().Current();
+    std::size_t drained = 0;
+
+    for (const auto ring : snapshot_)
+    {
+        drained += ring->Drain([logger](const LogRecord& record) noexcept {
+            if (!logger)
+            {
+                return;
+            }
+
+            try
+            {
+                const auto message = record.Format();
+                logger(record.GetSeverity(), message.c_str());
+            }
+            catch (...)
+            {
+                //
+                // Nothing to report to
+                //
+            }
+        });
+    }
+
+    //
+    // Rings of exited threads are destroyed, when they become empty
+    //
+
+    std::lock_guard lock { rings_lock_ };
+
+    rings_.erase(std::remove_if(rings_.begin(), rings_.end(), [](RecordRing* ring) {
+        if (ring->Abandoned() && ring->Empty())
+        {
+            delete ring;
+            return true;
+        }
+
+        return false;
+    }), rings_.end());
+
+    return drained;
+}
+
+}  // namespace ntp::logger::details
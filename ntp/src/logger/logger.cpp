@@ -1,5 +1,7 @@
 #include "logger/logger.hpp"
 #include "logger/logger_internal.hpp"
+#include "logger/async_logger.hpp"
+#include "details/exception.hpp"
 
 
 namespace ntp::logger {
@@ -13,4 +15,27 @@ logger_t SetLogger(logger_t new_logger)
     return details::Logger::InstanceMut().Exchange(new_logger);
 }
 
+Severity SetMinSeverity(Severity severity) noexcept
+{
+    return details::Logger::InstanceMut().ExchangeMinSeverity(severity);
+}
+
+Mode SetMode(Mode mode)
+{
+    auto& async         = details::AsyncLogger::Instance();
+    const auto previous = async.Enabled() ? Mode::kAsynchronous : Mode::kSynchronous;
+
+    if (!async.Enable(mode == Mode::kAsynchronous))
+    {
+        throw exception::Win32Exception(ERROR_NOT_ENOUGH_MEMORY);
+    }
+
+    return previous;
+}
+
+void Flush()
+{
+    details::AsyncLogger::Instance().Flush();
+}
+
 }  // namespace ntp::logger
@@ -0,0 +1,1001 @@
+/**
+ * @file engine.cpp
+ * @brief Implementation of ntp native engine for Linux
+ */
+
+#include <array>
+#include <limits>
+#include <algorithm>
+#include <system_error>
+
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#include "native/linux/engine.hpp"
+#include "native/linux/uring.hpp"
+
+
+namespace ntp::native {
+namespace {
+
+/**
+ * @brief Time, after which idle worker above minimum exits.
+ */
+constexpr auto kIdleTimeout = std::chrono::seconds(20);
+
+/**
+ * @brief Reserved epoll identifiers (watch identifiers start from 1).
+ */
+constexpr std::uint64_t kTimerEvent  = std::numeric_limits<std::uint64_t>::max();
+constexpr std::uint64_t kWakeupEvent = kTimerEvent - 1;
+
+/**
+ * @brief Number of 100-nanosecond intervals between 1601-01-01 and 1970-01-01.
+ */
+constexpr std::int64_t kUnixEpochInFileTime = 116444736000000000ll;
+
+
+long Futex(std::atomic<std::int32_t>* address, int operation, std::int32_t value, const timespec* timeout) noexcept
+{
+    static_assert(sizeof(std::atomic<std::int32_t>) == sizeof(std::int32_t),
+        "[ntp::native::Futex]: std::atomic<std::int32_t> cannot be used as futex word");
+
+    return syscall(SYS_futex, reinterpret_cast<std::int32_t*>(address), operation, value, timeout, nullptr, 0);
+}
+
+
+timespec ToTimespec(std::chrono::nanoseconds duration) noexcept
+{
+    const auto seconds = std::chrono::duration_cast<std::chrono::seconds>(duration);
+
+    timespec result {};
+    result.tv_sec  = static_cast<time_t>(seconds.count());
+    result.tv_nsec = static_cast<long>((duration - seconds).count());
+
+    return result;
+}
+
+
+void Drain(int descriptor) noexcept
+{
+    std::uint64_t value = 0;
+    while (read(descriptor, &value, sizeof(value)) > 0)
+    { }
+}
+
+}  // namespace
+
+
+//
+// Semaphore
+//
+
+void Semaphore::Post(std::int32_t count /* = 1 */) noexcept
+{
+    count_.fetch_add(count, std::memory_order_seq_cst);
+
+    if (waiters_.load(std::memory_order_seq_cst) > 0)
+    {
+        Futex(&count_, FUTEX_WAKE_PRIVATE, count, nullptr);
+    }
+}
+
+void Semaphore::Wait() noexcept
+{
+    while (!TryTake())
+    {
+        waiters_.fetch_add(1, std::memory_order_seq_cst);
+        Futex(&count_, FUTEX_WAIT_PRIVATE, 0, nullptr);
+        waiters_.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+bool Semaphore::WaitFor(std::chrono::nanoseconds timeout) noexcept
+{
+    const auto deadline = clock_t::now() + timeout;
+
+    while (!TryTake())
+    {
+        const auto left = deadline - clock_t::now();
+        if (left <= std::chrono::nanoseconds::zero())
+        {
+            return false;
+        }
+
+        const auto relative = ToTimespec(left);
+
+        waiters_.fetch_add(1, std::memory_order_seq_cst);
+        Futex(&count_, FUTEX_WAIT_PRIVATE, 0, &relative);
+        waiters_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    return true;
+}
+
+bool Semaphore::TryTake() noexcept
+{
+    auto count = count_.load(std::memory_order_acquire);
+    while (count > 0)
+    {
+        if (count_.compare_exchange_weak(count, count - 1, std::memory_order_acquire))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+//
+// Object
+//
+
+Object::Object(PTP_CALLBACK_ENVIRON environment, PVOID context) noexcept
+    : pool_(Pool::FromEnvironment(environment))
+    , group_(environment ? environment->CleanupGroup : nullptr)
+    , context_(context)
+    , references_(1)
+    , lock_()
+    , idle_()
+    , generation_(0)
+    , pending_(0)
+    , running_(0)
+    , previous_(nullptr)
+    , next_(nullptr)
+    , member_(false)
+{
+    if (group_)
+    {
+        group_->Add(this);
+    }
+}
+
+Object::Object(Pool& pool, PVOID context) noexcept
+    : pool_(pool)
+    , group_(nullptr)
+    , context_(context)
+    , references_(1)
+    , lock_()
+    , idle_()
+    , generation_(0)
+    , pending_(0)
+    , running_(0)
+    , previous_(nullptr)
+    , next_(nullptr)
+    , member_(false)
+{ }
+
+void Object::AddRef() noexcept
+{
+    references_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Object::Release() noexcept
+{
+    if (references_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        delete this;
+    }
+}
+
+void Object::Submit(const Payload& payload /* = {} */) noexcept
+{
+    std::uint64_t generation = 0;
+
+    {
+        std::lock_guard lock { lock_ };
+
+        ++pending_;
+        generation = generation_;
+    }
+
+    AddRef();
+    pool_.Enqueue(Task { this, generation, payload });
+}
+
+void Object::Execute(const Task& task) noexcept
+{
+    bool cancelled = true;
+
+    {
+        std::lock_guard lock { lock_ };
+
+        if (task.generation == generation_)
+        {
+            --pending_;
+            ++running_;
+
+            cancelled = false;
+        }
+    }
+
+    if (!cancelled)
+    {
+        _TP_CALLBACK_INSTANCE instance { this, true, nullptr };
+        Invoke(&instance, task.payload);
+
+        if (instance.associated)
+        {
+            EndCallback();
+        }
+
+        if (instance.event)
+        {
+            SetEvent(instance.event);
+        }
+    }
+
+    Release();
+}
+
+void Object::WaitCallbacks(bool cancel) noexcept
+{
+    std::unique_lock lock { lock_ };
+
+    if (cancel)
+    {
+        //
+        // Tasks with previous generation will be skipped by workers
+        //
+
+        ++generation_;
+        pending_ = 0;
+    }
+
+    idle_.wait(lock, [this]() { return !running_ && !pending_; });
+}
+
+void Object::Close() noexcept
+{
+    //
+    // If object is not a member of its group anymore, it
+    // has already been closed by CloseThreadpoolCleanupGroupMembers
+    //
+
+    if (group_ && !group_->Remove(this))
+    {
+        return;
+    }
+
+    Shutdown();
+    Release();
+}
+
+void Object::EndCallback() noexcept
+{
+    std::lock_guard lock { lock_ };
+
+    if (!--running_)
+    {
+        idle_.notify_all();
+    }
+}
+
+
+//
+// CleanupGroup
+//
+
+void CleanupGroup::Add(Object* object) noexcept
+{
+    std::lock_guard lock { lock_ };
+
+    object->previous_ = nullptr;
+    object->next_     = head_;
+    object->member_   = true;
+
+    if (head_)
+    {
+        head_->previous_ = object;
+    }
+
+    head_ = object;
+}
+
+bool CleanupGroup::Remove(Object* object) noexcept
+{
+    std::lock_guard lock { lock_ };
+
+    if (!object->member_)
+    {
+        return false;
+    }
+
+    if (object->previous_)
+    {
+        object->previous_->next_ = object->next_;
+    }
+    else
+    {
+        head_ = object->next_;
+    }
+
+    if (object->next_)
+    {
+        object->next_->previous_ = object->previous_;
+    }
+
+    object->previous_ = nullptr;
+    object->next_     = nullptr;
+    object->member_   = false;
+
+    return true;
+}
+
+void CleanupGroup::CloseMembers(bool cancel) noexcept
+{
+    Object* members = nullptr;
+
+    {
+        std::lock_guard lock { lock_ };
+
+        members = head_;
+        head_   = nullptr;
+
+        for (auto member = members; member; member = member->next_)
+        {
+            member->member_ = false;
+        }
+    }
+
+    for (auto member = members; member;)
+    {
+        const auto next = member->next_;
+
+        member->Shutdown();
+        member->WaitCallbacks(cancel);
+        member->Release();
+
+        member = next;
+    }
+}
+
+
+//
+// Reactor
+//
+
+Reactor::Reactor()
+    : lock_()
+    , epoll_(epoll_create1(EPOLL_CLOEXEC))
+    , timer_(timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC))
+    , wakeup_(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC))
+    , deadlines_()
+    , programmed_((time_point_t::max)())
+    , watches_()
+    , next_watch_id_(1)
+    , stop_(false)
+    , thread_()
+{
+    const auto error = errno;
+
+    auto subscribe = [this](int descriptor, std::uint64_t id) {
+        epoll_event event {};
+        event.events   = EPOLLIN;
+        event.data.u64 = id;
+
+        return 0 == epoll_ctl(epoll_, EPOLL_CTL_ADD, descriptor, &event);
+    };
+
+    if (epoll_ < 0 || timer_ < 0 || wakeup_ < 0 || !subscribe(timer_, kTimerEvent) || !subscribe(wakeup_, kWakeupEvent))
+    {
+        const auto last_error = (epoll_ < 0 || timer_ < 0 || wakeup_ < 0) ? error : errno;
+
+        for (const auto descriptor : { epoll_, timer_, wakeup_ })
+        {
+            if (descriptor >= 0)
+            {
+                close(descriptor);
+            }
+        }
+
+        throw std::system_error(last_error, std::system_category());
+    }
+
+    thread_ = std::thread(&Reactor::Routine, this);
+}
+
+Reactor::~Reactor()
+{
+    {
+        std::lock_guard lock { lock_ };
+        stop_ = true;
+    }
+
+    const std::uint64_t value = 1;
+    [[maybe_unused]] const auto written = write(wakeup_, &value, sizeof(value));
+
+    thread_.join();
+
+    for (auto& [_, entry] : watches_)
+    {
+        close(entry->descriptor);
+    }
+
+    close(wakeup_);
+    close(timer_);
+    close(epoll_);
+}
+
+bool Reactor::SetTimer(ReactorEntry& entry, const time_point_t* due, std::chrono::nanoseconds period,
+    std::chrono::nanoseconds window) noexcept
+{
+    std::lock_guard lock { lock_ };
+
+    const auto was_set = entry.scheduled;
+    Unschedule(entry);
+
+    if (due)
+    {
+        entry.period = period;
+        entry.window = window;
+        Schedule(entry, *due);
+    }
+
+    return was_set;
+}
+
+bool Reactor::IsTimerSet(const ReactorEntry& entry) noexcept
+{
+    std::lock_guard lock { lock_ };
+    return entry.scheduled;
+}
+
+bool Reactor::SetWait(ReactorEntry& entry, HANDLE handle, const time_point_t* deadline) noexcept
+{
+    std::lock_guard lock { lock_ };
+    return SetWaitLocked(entry, handle, deadline);
+}
+
+void Reactor::SetWaits(ReactorEntry* const* entries, const HANDLE* handles, std::size_t count, const time_point_t* deadline) noexcept
+{
+    std::lock_guard lock { lock_ };
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        SetWaitLocked(*entries[i], handles ? handles[i] : nullptr, deadline);
+    }
+}
+
+bool Reactor::SetWaitLocked(ReactorEntry& entry, HANDLE handle, const time_point_t* deadline) noexcept
+{
+    const auto was_set = (0 != entry.watch_id);
+
+    Unwatch(entry);
+    Unschedule(entry);
+
+    if (handle)
+    {
+        if (!Watch(entry, handle))
+        {
+            //
+            // Descriptor cannot be polled (e.g. it is a regular file)
+            //
+
+            entry.owner->Submit(Payload { nullptr, WAIT_FAILED, 0 });
+        }
+        else if (deadline)
+        {
+            Schedule(entry, *deadline);
+        }
+    }
+
+    return was_set;
+}
+
+void Reactor::Routine() noexcept
+{
+    std::array<epoll_event, 64> events;
+
+    for (;;)
+    {
+        const auto count = epoll_wait(epoll_, events.data(), static_cast<int>(events.size()), -1);
+        if (count < 0 && errno != EINTR)
+        {
+            return;
+        }
+
+        std::lock_guard lock { lock_ };
+
+        if (stop_)
+        {
+            return;
+        }
+
+        for (int i = 0; i < count; ++i)
+        {
+            const auto id = events[i].data.u64;
+
+            if (id == kTimerEvent)
+            {
+                //
+                // Expired timerfd is disarmed
+                //
+
+                Drain(timer_);
+                programmed_ = (time_point_t::max)();
+            }
+            else if (id == kWakeupEvent)
+            {
+                Drain(wakeup_);
+            }
+            else
+            {
+                OnSignaled(id);
+            }
+        }
+
+        OnDeadlines(clock_t::now());
+    }
+}
+
+void Reactor::Schedule(ReactorEntry& entry, time_point_t deadline) noexcept
+{
+    Unschedule(entry);
+
+    entry.deadline  = deadlines_.Insert(deadline, entry.window, &entry);
+    entry.scheduled = true;
+
+    ProgramTimer();
+}
+
+void Reactor::Unschedule(ReactorEntry& entry) noexcept
+{
+    if (!entry.scheduled)
+    {
+        return;
+    }
+
+    deadlines_.Erase(entry.deadline);
+    entry.scheduled = false;
+
+    ProgramTimer();
+}
+
+bool Reactor::Watch(ReactorEntry& entry, HANDLE handle) noexcept
+{
+    //
+    // Descriptor is duplicated, because the same descriptor can be
+    // waited by several wait objects, but epoll allows only one
+    // registration per descriptor
+    //
+
+    const auto descriptor = fcntl(DescriptorFromHandle(handle), F_DUPFD_CLOEXEC, 0);
+    if (descriptor < 0)
+    {
+        return false;
+    }
+
+    const auto id = next_watch_id_++;
+
+    epoll_event event {};
+    event.events   = EPOLLIN | EPOLLONESHOT;
+    event.data.u64 = id;
+
+    if (0 != epoll_ctl(epoll_, EPOLL_CTL_ADD, descriptor, &event))
+    {
+        close(descriptor);
+        return false;
+    }
+
+    entry.handle     = handle;
+    entry.descriptor = descriptor;
+    entry.watch_id   = id;
+
+    watches_.emplace(id, &entry);
+
+    return true;
+}
+
+void Reactor::Unwatch(ReactorEntry& entry) noexcept
+{
+    if (!entry.watch_id)
+    {
+        return;
+    }
+
+    epoll_ctl(epoll_, EPOLL_CTL_DEL, entry.descriptor, nullptr);
+    close(entry.descriptor);
+
+    watches_.erase(entry.watch_id);
+
+    entry.handle     = nullptr;
+    entry.descriptor = -1;
+    entry.watch_id   = 0;
+}
+
+void Reactor::OnSignaled(std::uint64_t watch_id) noexcept
+{
+    const auto watch = watches_.find(watch_id);
+    if (watch == watches_.end())
+    {
+        //
+        // Wait has been cancelled or reset after event was reported
+        //
+
+        return;
+    }
+
+    auto& entry = *watch->second;
+
+    if (!TryAcquire(entry.handle))
+    {
+        //
+        // Signal has already been consumed by someone else, rearm the wait
+        //
+
+        epoll_event event {};
+        event.events   = EPOLLIN | EPOLLONESHOT;
+        event.data.u64 = watch_id;
+
+        epoll_ctl(epoll_, EPOLL_CTL_MOD, entry.descriptor, &event);
+        return;
+    }
+
+    Unwatch(entry);
+    Unschedule(entry);
+
+    entry.owner->Submit(Payload { nullptr, WAIT_OBJECT_0, 0 });
+}
+
+void Reactor::OnDeadlines(time_point_t now) noexcept
+{
+    //
+    // All timers, whose due time is gone, expire during this wakeup, even if
+    // their tolerance allows to wait more (this is how timers are coalesced)
+    //
+
+    deadlines_.Expire(now, [this, now](time_point_t due, ReactorEntry* expired) {
+        auto& entry     = *expired;
+        entry.scheduled = false;
+
+        if (entry.watch_id)
+        {
+            Unwatch(entry);
+            entry.owner->Submit(Payload { nullptr, WAIT_TIMEOUT, 0 });
+        }
+        else
+        {
+            entry.owner->Submit();
+
+            if (entry.period > std::chrono::nanoseconds::zero())
+            {
+                //
+                // Next expiration is counted from the previous due time, not
+                // from now, hence periodic timer does not drift. Missed
+                // periods are skipped.
+                //
+
+                auto next = due + entry.period;
+                if (next <= now)
+                {
+                    next += ((now - next) / entry.period + 1) * entry.period;
+                }
+
+                entry.deadline  = deadlines_.Insert(next, entry.window, &entry);
+                entry.scheduled = true;
+            }
+        }
+    });
+
+    ProgramTimer();
+}
+
+void Reactor::ProgramTimer() noexcept
+{
+    //
+    // Timerfd is reprogrammed only if the nearest wakeup moves earlier. If it moves
+    // later (e.g. timer is postponed or cancelled), reactor just wakes up early and
+    // reprograms timerfd then, so frequently postponed timers cost no syscalls.
+    //
+
+    const auto wakeup = deadlines_.Empty() ? (time_point_t::max)() : deadlines_.Wakeup();
+    if (wakeup >= programmed_)
+    {
+        return;
+    }
+
+    programmed_ = wakeup;
+
+    itimerspec specification {};
+
+    if (!deadlines_.Empty())
+    {
+        const auto since_epoch = wakeup.time_since_epoch();
+
+        //
+        // Zero value disarms timer, hence use at least one nanosecond
+        //
+
+        specification.it_value = ToTimespec(std::max<std::chrono::nanoseconds>(since_epoch, std::chrono::nanoseconds(1)));
+    }
+
+    timerfd_settime(timer_, TFD_TIMER_ABSTIME, &specification, nullptr);
+}
+
+
+//
+// Pool
+//
+
+Pool::Pool(std::uint32_t minimum, std::uint32_t maximum) noexcept
+    : lock_()
+    , exited_()
+    , tasks_()
+    , semaphore_()
+    , idle_(0)
+    , threads_(0)
+    , minimum_(minimum)
+    , maximum_(std::max({ maximum, minimum, 1u }))
+    , stop_(false)
+    , reactor_created_()
+    , reactor_()
+    , ring_created_()
+    , ring_()
+{
+    std::lock_guard lock { lock_ };
+
+    while (threads_ < minimum_)
+    {
+        SpawnWorker();
+    }
+}
+
+Pool::~Pool()
+{
+    //
+    // Stop generating new callbacks first (ring uses reactor)
+    //
+
+    ring_.reset();
+    reactor_.reset();
+
+    std::unique_lock lock { lock_ };
+
+    stop_ = true;
+    semaphore_.Post(static_cast<std::int32_t>(threads_));
+
+    exited_.wait(lock, [this]() { return !threads_; });
+}
+
+/* static */
+Pool& Pool::Default() noexcept
+{
+    //
+    // Default pool is never destroyed: objects of the default
+    // pool may be used even by static objects' destructors
+    //
+
+    static auto pool = new Pool(0, DefaultMaximum());
+    return *pool;
+}
+
+/* static */
+Pool& Pool::FromEnvironment(PTP_CALLBACK_ENVIRON environment) noexcept
+{
+    return (environment && environment->Pool)
+             ? *environment->Pool
+             : Default();
+}
+
+/* static */
+std::uint32_t Pool::DefaultMaximum() noexcept
+{
+    auto threads = std::thread::hardware_concurrency();
+    if (!threads)
+    {
+        threads = 4;
+    }
+
+    return (threads < 8) ? (threads * 4) : (threads * 2);
+}
+
+bool Pool::SetMinimum(std::uint32_t minimum) noexcept
+{
+    std::lock_guard lock { lock_ };
+
+    minimum_ = minimum;
+    maximum_ = std::max(maximum_, minimum_);
+
+    while (threads_ < minimum_)
+    {
+        const auto threads = threads_;
+
+        SpawnWorker();
+
+        if (threads == threads_)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void Pool::SetMaximum(std::uint32_t maximum) noexcept
+{
+    std::lock_guard lock { lock_ };
+
+    maximum_ = std::max(maximum, 1u);
+    minimum_ = std::min(minimum_, maximum_);
+}
+
+void Pool::Enqueue(const Task& task) noexcept
+{
+    {
+        std::lock_guard lock { lock_ };
+
+        tasks_.push_back(task);
+
+        if (!stop_ && tasks_.size() > idle_.load(std::memory_order_relaxed) && threads_ < maximum_)
+        {
+            SpawnWorker();
+        }
+    }
+
+    semaphore_.Post();
+}
+
+bool Pool::MayRunLong() noexcept
+{
+    std::lock_guard lock { lock_ };
+
+    if (idle_.load(std::memory_order_relaxed))
+    {
+        return true;
+    }
+
+    if (stop_ || threads_ >= maximum_)
+    {
+        return false;
+    }
+
+    const auto threads = threads_;
+    SpawnWorker();
+
+    return threads != threads_;
+}
+
+Reactor& Pool::GetReactor() noexcept
+{
+    std::call_once(reactor_created_, [this]() { reactor_ = std::make_unique<Reactor>(); });
+    return *reactor_;
+}
+
+Ring* Pool::GetRing() noexcept
+{
+    std::call_once(ring_created_, [this]() { ring_ = Ring::Create(*this); });
+    return ring_.get();
+}
+
+void Pool::SpawnWorker() noexcept
+{
+    //
+    // Called with lock held
+    //
+
+    try
+    {
+        std::thread(&Pool::WorkerRoutine, this).detach();
+        ++threads_;
+    }
+    catch (const std::system_error&)
+    {
+        //
+        // Thread cannot be created, existing workers will handle callbacks
+        //
+    }
+}
+
+void Pool::WorkerRoutine() noexcept
+{
+    for (;;)
+    {
+        bool excessive = false;
+
+        {
+            std::lock_guard lock { lock_ };
+            excessive = threads_ > minimum_;
+        }
+
+        idle_.fetch_add(1, std::memory_order_relaxed);
+
+        bool taken = true;
+        if (excessive)
+        {
+            taken = semaphore_.WaitFor(kIdleTimeout);
+        }
+        else
+        {
+            semaphore_.Wait();
+        }
+
+        idle_.fetch_sub(1, std::memory_order_relaxed);
+
+        std::unique_lock lock { lock_ };
+
+        if (tasks_.empty())
+        {
+            //
+            // Either stop is requested or idle timeout elapsed
+            //
+
+            if (stop_ || (!taken && threads_ > minimum_))
+            {
+                --threads_;
+
+                std::notify_all_at_thread_exit(exited_, std::move(lock));
+                return;
+            }
+
+            continue;
+        }
+
+        if (!taken)
+        {
+            //
+            // Task was pushed while this worker was counted as idle,
+            // so stay alive and take its permit on the next iteration
+            //
+
+            continue;
+        }
+
+        const auto task = tasks_.front();
+        tasks_.pop_front();
+
+        lock.unlock();
+
+        task.object->Execute(task);
+    }
+}
+
+
+//
+// Free functions
+//
+
+time_point_t DeadlineFromFileTime(const FILETIME& time) noexcept
+{
+    const auto value = static_cast<std::int64_t>(
+        (static_cast<std::uint64_t>(time.dwHighDateTime) << 32) | time.dwLowDateTime);
+
+    const auto now = clock_t::now();
+
+    if (value < 0)
+    {
+        //
+        // Relative time in 100-nanosecond intervals
+        //
+
+        return now + std::chrono::nanoseconds(-value * 100);
+    }
+
+    //
+    // Absolute UTC time since 1601-01-01, convert to our clock
+    //
+
+    const auto system_now = std::chrono::system_clock::now().time_since_epoch();
+    const auto now_ticks  = std::chrono::duration_cast<std::chrono::nanoseconds>(system_now).count() / 100 + kUnixEpochInFileTime;
+
+    if (value <= now_ticks)
+    {
+        //
+        // Deadline is already gone (e.g. zero due time), difference
+        // may not fit into nanoseconds, so it is not computed
+        //
+
+        return now;
+    }
+
+    return now + std::chrono::nanoseconds((value - now_ticks) * 100);
+}
+
+}  // namespace ntp::native
@@ -0,0 +1,40 @@
+/**
+ * @file ntrtl.cpp
+ * @brief Implementation of internal windows objects and functions for Linux
+ */
+
+#include "native/linux/ntrtl.h"
+
+
+VOID NTAPI RtlInitializeResource(PRTL_RESOURCE pResource) noexcept
+{
+    pthread_rwlock_init(&pResource->Lock, nullptr);
+}
+
+VOID NTAPI RtlDeleteResource(PRTL_RESOURCE pResource) noexcept
+{
+    pthread_rwlock_destroy(&pResource->Lock);
+}
+
+BOOLEAN NTAPI RtlAcquireResourceShared(PRTL_RESOURCE pResource, BOOLEAN bWait) noexcept
+{
+    const auto result = bWait
+                          ? pthread_rwlock_rdlock(&pResource->Lock)
+                          : pthread_rwlock_tryrdlock(&pResource->Lock);
+
+    return (0 == result) ? TRUE : FALSE;
+}
+
+BOOLEAN NTAPI RtlAcquireResourceExclusive(PRTL_RESOURCE pResource, BOOLEAN bWait) noexcept
+{
+    const auto result = bWait
+                          ? pthread_rwlock_wrlock(&pResource->Lock)
+                          : pthread_rwlock_trywrlock(&pResource->Lock);
+
+    return (0 == result) ? TRUE : FALSE;
+}
+
+VOID NTAPI RtlReleaseResource(PRTL_RESOURCE pResource) noexcept
+{
+    pthread_rwlock_unlock(&pResource->Lock);
+}
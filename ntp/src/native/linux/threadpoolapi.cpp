@@ -0,0 +1,1226 @@
+/**
+ * @file threadpoolapi.cpp
+ * @brief Implementation of Windows Threadpool API subset on top of ntp native engine
+ */
+
+#include <new>
+#include <array>
+#include <memory>
+#include <algorithm>
+#include <mutex>
+#include <unordered_map>
+
+#include <limits.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include <sys/socket.h>
+
+#include "native/linux/engine.hpp"
+#include "native/linux/uring.hpp"
+
+
+//
+// Threadpool objects
+//
+
+/**
+ * @brief Work object (PTP_WORK).
+ */
+struct _TP_WORK final
+    : public ntp::native::Object
+{
+    explicit _TP_WORK(PTP_WORK_CALLBACK callback, PVOID context, PTP_CALLBACK_ENVIRON environment) noexcept
+        : Object(environment, context)
+        , callback(callback)
+    { }
+
+    void Invoke(PTP_CALLBACK_INSTANCE instance, const ntp::native::Payload& /* payload */) noexcept override
+    {
+        callback(instance, Context(), this);
+    }
+
+    PTP_WORK_CALLBACK callback;
+};
+
+
+/**
+ * @brief Wait object (PTP_WAIT).
+ */
+struct _TP_WAIT final
+    : public ntp::native::Object
+{
+    explicit _TP_WAIT(PTP_WAIT_CALLBACK callback, PVOID context, PTP_CALLBACK_ENVIRON environment) noexcept
+        : Object(environment, context)
+        , callback(callback)
+        , entry()
+    {
+        entry.owner = this;
+    }
+
+    void Invoke(PTP_CALLBACK_INSTANCE instance, const ntp::native::Payload& payload) noexcept override
+    {
+        callback(instance, Context(), this, payload.result);
+    }
+
+    void Shutdown() noexcept override
+    {
+        OwningPool().GetReactor().SetWait(entry, nullptr, nullptr);
+    }
+
+    PTP_WAIT_CALLBACK callback;
+    ntp::native::ReactorEntry entry;
+};
+
+
+/**
+ * @brief Timer object (PTP_TIMER).
+ */
+struct _TP_TIMER final
+    : public ntp::native::Object
+{
+    explicit _TP_TIMER(PTP_TIMER_CALLBACK callback, PVOID context, PTP_CALLBACK_ENVIRON environment) noexcept
+        : Object(environment, context)
+        , callback(callback)
+        , entry()
+    {
+        entry.owner = this;
+    }
+
+    void Invoke(PTP_CALLBACK_INSTANCE instance, const ntp::native::Payload& /* payload */) noexcept override
+    {
+        callback(instance, Context(), this);
+    }
+
+    void Shutdown() noexcept override
+    {
+        OwningPool().GetReactor().SetTimer(entry, nullptr, {});
+    }
+
+    PTP_TIMER_CALLBACK callback;
+    ntp::native::ReactorEntry entry;
+};
+
+
+/**
+ * @brief IO object (PTP_IO). Receives completions of operations started
+ *        with ReadFile/WriteFile/AcceptSocket on the bound file.
+ */
+struct _TP_IO final
+    : public ntp::native::Object
+{
+    explicit _TP_IO(HANDLE file, PTP_WIN32_IO_CALLBACK callback, PVOID context, PTP_CALLBACK_ENVIRON environment) noexcept
+        : Object(environment, context)
+        , callback(callback)
+        , file(file)
+        , ring(nullptr)
+        , slot(-1)
+        , lock()
+        , expected(0)
+        , closed(false)
+    { }
+
+    ~_TP_IO() override
+    {
+        //
+        // Operations in flight own references to IO object, hence
+        // registered file is not used by anyone at this point
+        //
+
+        if (ring && slot >= 0)
+        {
+            ring->UnregisterFile(slot);
+        }
+    }
+
+    void Invoke(PTP_CALLBACK_INSTANCE instance, const ntp::native::Payload& payload) noexcept override
+    {
+        callback(instance, Context(), payload.overlapped, payload.result, payload.bytes_transferred, this);
+    }
+
+    void Shutdown() noexcept override;
+
+    /**
+     * @brief Delivers completion of an operation. Callback is queued only
+     *        if completion was expected (refer to StartThreadpoolIo).
+     */
+    void Complete(const ntp::native::Payload& payload) noexcept
+    {
+        {
+            std::lock_guard guard { lock };
+
+            if (closed || !expected)
+            {
+                return;
+            }
+
+            --expected;
+        }
+
+        Submit(payload);
+    }
+
+    PTP_WIN32_IO_CALLBACK callback;
+    HANDLE file;
+
+    // Pool's ring and index of file registered in it (-1 if not registered)
+    ntp::native::Ring* ring;
+    int slot;
+
+    // Number of expected completions and closed flag
+    std::mutex lock;
+    std::uint32_t expected;
+    bool closed;
+};
+
+
+namespace ntp::native {
+namespace {
+
+/**
+ * @brief Simple callback, that closes itself after invocation (TrySubmitThreadpoolCallback).
+ */
+class SimpleCallback final
+    : public Object
+{
+public:
+    explicit SimpleCallback(PTP_SIMPLE_CALLBACK callback, PVOID context, PTP_CALLBACK_ENVIRON environment) noexcept
+        : Object(environment, context)
+        , callback_(callback)
+    { }
+
+private:
+    void Invoke(PTP_CALLBACK_INSTANCE instance, const Payload& /* payload */) noexcept override
+    {
+        callback_(instance, Context());
+        Close();
+    }
+
+private:
+    PTP_SIMPLE_CALLBACK callback_;
+};
+
+
+static_assert(sizeof(FILE_VECTOR_ELEMENT) == sizeof(iovec) &&
+              offsetof(FILE_VECTOR_ELEMENT, Buffer) == offsetof(iovec, iov_base) &&
+              offsetof(FILE_VECTOR_ELEMENT, Length) == offsetof(iovec, iov_len),
+    "[ntp::native]: FILE_VECTOR_ELEMENT must be layout-compatible with iovec");
+
+
+/**
+ * @brief Buffers of a vectored operation (owned by operation until its completion).
+ */
+struct IoVector
+{
+    std::unique_ptr<iovec[]> segments; /**< Buffers (the first one is advanced after short transfers) */
+    std::size_t count = 0;             /**< Number of buffers */
+};
+
+
+/**
+ * @brief Asynchronous operation on a file bound to IO object.
+ *
+ * Operation is submitted into pool's ring, if io_uring is available.
+ * Otherwise it is performed synchronously by a pool worker.
+ */
+class IoRequest final
+    : public Object
+    , public RingOperation
+{
+public:
+    enum class Kind
+    {
+        kRead,
+        kWrite,
+        kAccept,
+        kReadVector,
+        kWriteVector
+    };
+
+public:
+    explicit IoRequest(PTP_IO io, Kind kind, PVOID buffer, std::size_t size, LPOVERLAPPED overlapped, IoVector&& vector) noexcept
+        : Object(io->OwningPool(), nullptr)
+        , io_(io)
+        , kind_(kind)
+        , buffer_(buffer)
+        , size_(size)
+        , overlapped_(overlapped)
+        , vector_(std::move(vector))
+        , segment_(0)
+        , total_(0)
+    {
+        io_->AddRef();
+    }
+
+    ~IoRequest() override
+    {
+        io_->Release();
+    }
+
+    /**
+     * @brief Starts (or continues after a short transfer) the operation.
+     */
+    void Start() noexcept
+    {
+        if (const auto ring = io_->ring; ring)
+        {
+            Prepare(*ring);
+
+            if (ring->Push(this))
+            {
+                return;
+            }
+        }
+
+        Submit();
+    }
+
+private:
+    void Prepare(Ring& ring) noexcept
+    {
+        request.fixed_file   = (io_->slot >= 0);
+        request.descriptor   = request.fixed_file ? io_->slot : DescriptorFromHandle(io_->file);
+        request.buffer_index = -1;
+
+        if (kind_ == Kind::kAccept)
+        {
+            request.opcode = IORING_OP_ACCEPT;
+            request.buffer = nullptr;
+            request.size   = 0;
+            request.offset = 0;
+            request.flags  = SOCK_CLOEXEC;
+
+            return;
+        }
+
+        if (IsVectored())
+        {
+            //
+            // Registered buffers are not used for vectored operations
+            //
+
+            request.opcode = (kind_ == Kind::kReadVector) ? IORING_OP_READV : IORING_OP_WRITEV;
+            request.buffer = vector_.segments.get() + segment_;
+            request.size   = static_cast<std::uint32_t>(vector_.count - segment_);
+            request.offset = Offset() + total_;
+            request.flags  = 0;
+
+            return;
+        }
+
+        const auto data      = static_cast<char*>(buffer_) + total_;
+        const auto remaining = static_cast<std::uint32_t>(size_ - total_);
+
+        request.buffer_index = ring.FindBuffer(data, remaining);
+
+        const auto fixed = (request.buffer_index >= 0);
+
+        request.opcode = (kind_ == Kind::kRead)
+                           ? (fixed ? IORING_OP_READ_FIXED : IORING_OP_READ)
+                           : (fixed ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE);
+        request.buffer = data;
+        request.size   = remaining;
+        request.offset = Offset() + total_;
+        request.flags  = 0;
+    }
+
+    void OnComplete(std::int32_t result) noexcept override
+    {
+        if (result < 0)
+        {
+            Finish(static_cast<ULONG>(-result), static_cast<ULONG_PTR>(total_));
+            return;
+        }
+
+        if (kind_ == Kind::kAccept)
+        {
+            Finish(NO_ERROR, static_cast<ULONG_PTR>(result));
+            return;
+        }
+
+        Advance(static_cast<std::size_t>(result));
+
+        if (result == 0 || total_ >= size_)
+        {
+            Finish(NO_ERROR, static_cast<ULONG_PTR>(total_));
+            return;
+        }
+
+        //
+        // Short transfer, request the rest
+        //
+
+        Start();
+    }
+
+    void Invoke(PTP_CALLBACK_INSTANCE /* instance */, const Payload& /* payload */) noexcept override
+    {
+        const auto descriptor = DescriptorFromHandle(io_->file);
+
+        if (kind_ == Kind::kAccept)
+        {
+            int accepted = -1;
+
+            do
+            {
+                accepted = accept4(descriptor, nullptr, nullptr, SOCK_CLOEXEC);
+            } while (accepted < 0 && errno == EINTR);
+
+            accepted < 0
+                ? Finish(static_cast<ULONG>(errno), 0)
+                : Finish(NO_ERROR, static_cast<ULONG_PTR>(accepted));
+
+            return;
+        }
+
+        const auto offset = static_cast<off_t>(Offset());
+        ULONG result      = NO_ERROR;
+
+        //
+        // Transfer everything, that was requested (or up to the end of file)
+        //
+
+        while (total_ < size_)
+        {
+            const auto chunk = TransferChunk(descriptor, offset);
+
+            if (chunk < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+
+                result = static_cast<ULONG>(errno);
+                break;
+            }
+
+            if (chunk == 0)
+            {
+                break;
+            }
+
+            Advance(static_cast<std::size_t>(chunk));
+        }
+
+        Finish(result, static_cast<ULONG_PTR>(total_));
+    }
+
+    ssize_t TransferChunk(int descriptor, off_t offset) noexcept
+    {
+        const auto position = static_cast<off_t>(offset + total_);
+
+        switch (kind_)
+        {
+        case Kind::kRead:
+            return pread(descriptor, static_cast<char*>(buffer_) + total_, size_ - total_, position);
+
+        case Kind::kWrite:
+            return pwrite(descriptor, static_cast<const char*>(buffer_) + total_, size_ - total_, position);
+
+        case Kind::kReadVector:
+            return preadv(descriptor, vector_.segments.get() + segment_, static_cast<int>(vector_.count - segment_), position);
+
+        default:
+            return pwritev(descriptor, vector_.segments.get() + segment_, static_cast<int>(vector_.count - segment_), position);
+        }
+    }
+
+    /**
+     * @brief Accounts transferred bytes and skips filled buffers of vectored operation.
+     */
+    void Advance(std::size_t bytes) noexcept
+    {
+        total_ += bytes;
+
+        if (!IsVectored())
+        {
+            return;
+        }
+
+        while (bytes && segment_ < vector_.count)
+        {
+            auto& segment = vector_.segments[segment_];
+
+            if (bytes < segment.iov_len)
+            {
+                segment.iov_base = static_cast<char*>(segment.iov_base) + bytes;
+                segment.iov_len -= bytes;
+                break;
+            }
+
+            bytes -= segment.iov_len;
+            ++segment_;
+        }
+    }
+
+    bool IsVectored() const noexcept
+    {
+        return kind_ == Kind::kReadVector || kind_ == Kind::kWriteVector;
+    }
+
+    void Finish(ULONG result, ULONG_PTR bytes) noexcept
+    {
+        overlapped_->Internal     = result;
+        overlapped_->InternalHigh = bytes;
+
+        if (overlapped_->hEvent)
+        {
+            SetEvent(overlapped_->hEvent);
+        }
+
+        io_->Complete(Payload { overlapped_, result, bytes });
+
+        Close();
+    }
+
+    std::uint64_t Offset() const noexcept
+    {
+        return (static_cast<std::uint64_t>(overlapped_->OffsetHigh) << 32) | overlapped_->Offset;
+    }
+
+private:
+    PTP_IO io_;
+    Kind kind_;
+    PVOID buffer_;
+    std::size_t size_;
+    LPOVERLAPPED overlapped_;
+
+    // Buffers of vectored operation and index of the first unfilled one
+    IoVector vector_;
+    std::size_t segment_;
+
+    // Number of already transferred bytes
+    std::size_t total_;
+};
+
+
+/**
+ * @brief Registry of files bound to IO objects.
+ */
+class IoRegistry final
+{
+public:
+    static IoRegistry& Instance() noexcept
+    {
+        static auto registry = new IoRegistry();
+        return *registry;
+    }
+
+    bool Bind(HANDLE file, PTP_IO io) noexcept
+    {
+        std::lock_guard lock { lock_ };
+
+        try
+        {
+            return bindings_.emplace(DescriptorFromHandle(file), io).second;
+        }
+        catch (const std::bad_alloc&)
+        {
+            return false;
+        }
+    }
+
+    void Unbind(HANDLE file, PTP_IO io) noexcept
+    {
+        std::lock_guard lock { lock_ };
+
+        if (const auto binding = bindings_.find(DescriptorFromHandle(file));
+            binding != bindings_.end() && binding->second == io)
+        {
+            bindings_.erase(binding);
+        }
+    }
+
+    /**
+     * @brief Finds IO object bound to the file.
+     *
+     * @returns referenced IO object or NULL
+     */
+    PTP_IO Find(HANDLE file) noexcept
+    {
+        std::lock_guard lock { lock_ };
+
+        if (const auto binding = bindings_.find(DescriptorFromHandle(file)); binding != bindings_.end())
+        {
+            binding->second->AddRef();
+            return binding->second;
+        }
+
+        return nullptr;
+    }
+
+private:
+    std::mutex lock_;
+    std::unordered_map<int, PTP_IO> bindings_;
+};
+
+
+template<typename Object, typename... Args>
+Object* CreateObject(Args&&... args) noexcept
+{
+    const auto object = new (std::nothrow) Object(std::forward<Args>(args)...);
+    if (!object)
+    {
+        SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+    }
+
+    return object;
+}
+
+
+/**
+ * @brief Starts an asynchronous operation, if overlapped is specified and file is bound to IO object.
+ *
+ * @param result Result of the calling function (set only if function returns true)
+ * @returns true if operation is handled asynchronously, false if it must be performed synchronously
+ */
+bool StartRequest(IoRequest::Kind kind, HANDLE file, PVOID buffer, std::size_t size, LPOVERLAPPED overlapped, BOOL& result,
+    IoVector&& vector = {}) noexcept
+{
+    if (!overlapped)
+    {
+        return false;
+    }
+
+    const auto io = IoRegistry::Instance().Find(file);
+    if (!io)
+    {
+        return false;
+    }
+
+    const auto request = new (std::nothrow) IoRequest(io, kind, buffer, size, overlapped, std::move(vector));
+    io->Release();
+
+    result = FALSE;
+
+    if (!request)
+    {
+        SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+        return true;
+    }
+
+    overlapped->Internal     = ERROR_IO_PENDING;
+    overlapped->InternalHigh = 0;
+
+    request->Start();
+
+    SetLastError(ERROR_IO_PENDING);
+    return true;
+}
+
+
+BOOL TransferFile(IoRequest::Kind kind, HANDLE file, PVOID buffer, DWORD size, LPDWORD transferred, LPOVERLAPPED overlapped) noexcept
+{
+    if (BOOL started = FALSE; StartRequest(kind, file, buffer, size, overlapped, started))
+    {
+        return started;
+    }
+
+    //
+    // Synchronous operation
+    //
+
+    const auto descriptor = DescriptorFromHandle(file);
+    ssize_t result        = 0;
+
+    if (overlapped)
+    {
+        const auto offset = static_cast<off_t>(
+            (static_cast<std::uint64_t>(overlapped->OffsetHigh) << 32) | overlapped->Offset);
+
+        result = (kind == IoRequest::Kind::kRead)
+                   ? pread(descriptor, buffer, size, offset)
+                   : pwrite(descriptor, buffer, size, offset);
+    }
+    else
+    {
+        result = (kind == IoRequest::Kind::kRead)
+                   ? read(descriptor, buffer, size)
+                   : write(descriptor, buffer, size);
+    }
+
+    if (result < 0)
+    {
+        return FALSE;
+    }
+
+    if (transferred)
+    {
+        *transferred = static_cast<DWORD>(result);
+    }
+
+    if (overlapped)
+    {
+        overlapped->Internal     = NO_ERROR;
+        overlapped->InternalHigh = static_cast<ULONG_PTR>(result);
+
+        if (overlapped->hEvent)
+        {
+            SetEvent(overlapped->hEvent);
+        }
+    }
+
+    return TRUE;
+}
+
+
+/**
+ * @brief Performs vectored operation (asynchronously, if file is bound to IO object).
+ *
+ * @param vector Buffers of operation
+ */
+BOOL TransferVector(IoRequest::Kind kind, HANDLE file, IoVector&& vector, LPDWORD transferred, LPOVERLAPPED overlapped) noexcept
+{
+    std::size_t size = 0;
+    for (std::size_t i = 0; i < vector.count; ++i)
+    {
+        size += vector.segments[i].iov_len;
+    }
+
+    const auto descriptor = DescriptorFromHandle(file);
+    const auto segments   = vector.segments.get();
+    const auto count      = static_cast<int>(vector.count);
+
+    if (BOOL started = FALSE; StartRequest(kind, file, nullptr, size, overlapped, started, std::move(vector)))
+    {
+        return started;
+    }
+
+    //
+    // Synchronous operation
+    //
+
+    ssize_t result = 0;
+
+    if (overlapped)
+    {
+        const auto offset = static_cast<off_t>(
+            (static_cast<std::uint64_t>(overlapped->OffsetHigh) << 32) | overlapped->Offset);
+
+        result = (kind == IoRequest::Kind::kReadVector)
+                   ? preadv(descriptor, segments, count, offset)
+                   : pwritev(descriptor, segments, count, offset);
+    }
+    else
+    {
+        result = (kind == IoRequest::Kind::kReadVector)
+                   ? readv(descriptor, segments, count)
+                   : writev(descriptor, segments, count);
+    }
+
+    if (result < 0)
+    {
+        return FALSE;
+    }
+
+    if (transferred)
+    {
+        *transferred = static_cast<DWORD>(result);
+    }
+
+    if (overlapped)
+    {
+        overlapped->Internal     = NO_ERROR;
+        overlapped->InternalHigh = static_cast<ULONG_PTR>(result);
+
+        if (overlapped->hEvent)
+        {
+            SetEvent(overlapped->hEvent);
+        }
+    }
+
+    return TRUE;
+}
+
+
+/**
+ * @brief Copies buffers of vectored operation.
+ *
+ * @returns false if arguments are invalid or memory cannot be allocated (last error is set)
+ */
+bool CopyVector(const FILE_VECTOR_ELEMENT* elements, DWORD count, IoVector& vector) noexcept
+{
+    if (!elements || !count || count > IOV_MAX)
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+        return false;
+    }
+
+    vector.segments.reset(new (std::nothrow) iovec[count]);
+    vector.count = count;
+
+    if (!vector.segments)
+    {
+        SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+        return false;
+    }
+
+    for (DWORD i = 0; i < count; ++i)
+    {
+        vector.segments[i] = { elements[i].Buffer, elements[i].Length };
+    }
+
+    return true;
+}
+
+
+/**
+ * @brief Converts pages of scatter/gather operation into buffers of vectored one.
+ *
+ * @returns false if arguments are invalid or memory cannot be allocated (last error is set)
+ */
+bool CopySegments(const FILE_SEGMENT_ELEMENT* segments, DWORD size, IoVector& vector) noexcept
+{
+    static const auto page_size = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+
+    const auto count = (static_cast<std::size_t>(size) + page_size - 1) / page_size;
+
+    if (!segments || !count || count > IOV_MAX)
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+        return false;
+    }
+
+    vector.segments.reset(new (std::nothrow) iovec[count]);
+    vector.count = count;
+
+    if (!vector.segments)
+    {
+        SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+        return false;
+    }
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        vector.segments[i] = { segments[i].Buffer, (std::min)(page_size, size - i * page_size) };
+    }
+
+    return true;
+}
+
+}  // namespace
+}  // namespace ntp::native
+
+
+void _TP_IO::Shutdown() noexcept
+{
+    ntp::native::IoRegistry::Instance().Unbind(file, this);
+
+    std::lock_guard guard { lock };
+    closed = true;
+}
+
+
+//
+// Pools
+//
+
+PTP_POOL CreateThreadpool(PVOID /* reserved */) noexcept
+{
+    return ntp::native::CreateObject<_TP_POOL>(0, ntp::native::Pool::DefaultMaximum());
+}
+
+VOID CloseThreadpool(PTP_POOL pool) noexcept
+{
+    delete pool;
+}
+
+BOOL SetThreadpoolThreadMinimum(PTP_POOL pool, DWORD minimum) noexcept
+{
+    return pool->SetMinimum(minimum) ? TRUE : FALSE;
+}
+
+VOID SetThreadpoolThreadMaximum(PTP_POOL pool, DWORD maximum) noexcept
+{
+    pool->SetMaximum(maximum);
+}
+
+
+//
+// Cleanup groups
+//
+
+PTP_CLEANUP_GROUP CreateThreadpoolCleanupGroup() noexcept
+{
+    return ntp::native::CreateObject<_TP_CLEANUP_GROUP>();
+}
+
+VOID CloseThreadpoolCleanupGroup(PTP_CLEANUP_GROUP cleanup_group) noexcept
+{
+    delete cleanup_group;
+}
+
+VOID CloseThreadpoolCleanupGroupMembers(PTP_CLEANUP_GROUP cleanup_group, BOOL cancel_pending_callbacks,
+    PVOID /* cleanup_context */) noexcept
+{
+    cleanup_group->CloseMembers(cancel_pending_callbacks);
+}
+
+
+//
+// Callback instance
+//
+
+BOOL TrySubmitThreadpoolCallback(PTP_SIMPLE_CALLBACK callback, PVOID context, PTP_CALLBACK_ENVIRON environment) noexcept
+{
+    const auto object = ntp::native::CreateObject<ntp::native::SimpleCallback>(callback, context, environment);
+    if (!object)
+    {
+        return FALSE;
+    }
+
+    object->Submit();
+    return TRUE;
+}
+
+BOOL CallbackMayRunLong(PTP_CALLBACK_INSTANCE instance) noexcept
+{
+    return instance->object->OwningPool().MayRunLong() ? TRUE : FALSE;
+}
+
+VOID DisassociateCurrentThreadFromCallback(PTP_CALLBACK_INSTANCE instance) noexcept
+{
+    if (instance->associated)
+    {
+        instance->associated = false;
+        instance->object->EndCallback();
+    }
+}
+
+VOID SetEventWhenCallbackReturns(PTP_CALLBACK_INSTANCE instance, HANDLE event) noexcept
+{
+    instance->event = event;
+}
+
+
+//
+// Work objects
+//
+
+PTP_WORK CreateThreadpoolWork(PTP_WORK_CALLBACK callback, PVOID context, PTP_CALLBACK_ENVIRON environment) noexcept
+{
+    return ntp::native::CreateObject<_TP_WORK>(callback, context, environment);
+}
+
+VOID SubmitThreadpoolWork(PTP_WORK work) noexcept
+{
+    work->Submit();
+}
+
+VOID WaitForThreadpoolWorkCallbacks(PTP_WORK work, BOOL cancel_pending_callbacks) noexcept
+{
+    work->WaitCallbacks(cancel_pending_callbacks);
+}
+
+VOID CloseThreadpoolWork(PTP_WORK work) noexcept
+{
+    work->Close();
+}
+
+
+//
+// Wait objects
+//
+
+PTP_WAIT CreateThreadpoolWait(PTP_WAIT_CALLBACK callback, PVOID context, PTP_CALLBACK_ENVIRON environment) noexcept
+{
+    return ntp::native::CreateObject<_TP_WAIT>(callback, context, environment);
+}
+
+VOID SetThreadpoolWait(PTP_WAIT wait, HANDLE handle, PFILETIME timeout) noexcept
+{
+    SetThreadpoolWaitEx(wait, handle, timeout, nullptr);
+}
+
+BOOL SetThreadpoolWaitEx(PTP_WAIT wait, HANDLE handle, PFILETIME timeout, PVOID /* reserved */) noexcept
+{
+    ntp::native::time_point_t deadline;
+
+    if (timeout)
+    {
+        deadline = ntp::native::DeadlineFromFileTime(*timeout);
+    }
+
+    const auto was_set = wait->OwningPool().GetReactor().SetWait(wait->entry, handle, timeout ? &deadline : nullptr);
+    return was_set ? TRUE : FALSE;
+}
+
+VOID WaitForThreadpoolWaitCallbacks(PTP_WAIT wait, BOOL cancel_pending_callbacks) noexcept
+{
+    wait->WaitCallbacks(cancel_pending_callbacks);
+}
+
+VOID CloseThreadpoolWait(PTP_WAIT wait) noexcept
+{
+    wait->Close();
+}
+
+VOID SetThreadpoolWaits(PTP_WAIT* waits, const HANDLE* handles, DWORD count, PFILETIME timeout) noexcept
+{
+    if (0 == count)
+    {
+        return;
+    }
+
+    ntp::native::time_point_t deadline;
+
+    if (timeout)
+    {
+        deadline = ntp::native::DeadlineFromFileTime(*timeout);
+    }
+
+    //
+    // Entries are passed to reactor in batches: reactor is locked once per batch
+    // instead of once per wait, but is not stalled while a huge set is registered
+    //
+
+    constexpr DWORD kBatch = 256;
+    std::array<ntp::native::ReactorEntry*, kBatch> entries;
+
+    auto& reactor = waits[0]->OwningPool().GetReactor();
+
+    for (DWORD first = 0; first < count; first += kBatch)
+    {
+        const auto size = (std::min)(kBatch, count - first);
+
+        for (DWORD i = 0; i < size; ++i)
+        {
+            entries[i] = &waits[first + i]->entry;
+        }
+
+        reactor.SetWaits(entries.data(), handles ? handles + first : nullptr, size, timeout ? &deadline : nullptr);
+    }
+}
+
+
+//
+// Timer objects
+//
+
+PTP_TIMER CreateThreadpoolTimer(PTP_TIMER_CALLBACK callback, PVOID context, PTP_CALLBACK_ENVIRON environment) noexcept
+{
+    return ntp::native::CreateObject<_TP_TIMER>(callback, context, environment);
+}
+
+VOID SetThreadpoolTimer(PTP_TIMER timer, PFILETIME due_time, DWORD period, DWORD window_length) noexcept
+{
+    SetThreadpoolTimerEx(timer, due_time, period, window_length);
+}
+
+BOOL SetThreadpoolTimerEx(PTP_TIMER timer, PFILETIME due_time, DWORD period, DWORD window_length) noexcept
+{
+    ntp::native::time_point_t due;
+
+    if (due_time)
+    {
+        due = ntp::native::DeadlineFromFileTime(*due_time);
+    }
+
+    const auto was_set = timer->OwningPool().GetReactor().SetTimer(
+        timer->entry, due_time ? &due : nullptr, std::chrono::milliseconds(period), std::chrono::milliseconds(window_length));
+
+    return was_set ? TRUE : FALSE;
+}
+
+BOOL IsThreadpoolTimerSet(PTP_TIMER timer) noexcept
+{
+    return timer->OwningPool().GetReactor().IsTimerSet(timer->entry) ? TRUE : FALSE;
+}
+
+VOID WaitForThreadpoolTimerCallbacks(PTP_TIMER timer, BOOL cancel_pending_callbacks) noexcept
+{
+    timer->WaitCallbacks(cancel_pending_callbacks);
+}
+
+VOID CloseThreadpoolTimer(PTP_TIMER timer) noexcept
+{
+    timer->Close();
+}
+
+
+//
+// IO objects
+//
+
+PTP_IO CreateThreadpoolIo(HANDLE file, PTP_WIN32_IO_CALLBACK callback, PVOID context, PTP_CALLBACK_ENVIRON environment) noexcept
+{
+    const auto io = ntp::native::CreateObject<_TP_IO>(file, callback, context, environment);
+    if (!io)
+    {
+        return nullptr;
+    }
+
+    if (!ntp::native::IoRegistry::Instance().Bind(file, io))
+    {
+        //
+        // Only one IO object can be bound to a file
+        //
+
+        io->Close();
+
+        SetLastError(ERROR_INVALID_PARAMETER);
+        return nullptr;
+    }
+
+    if (io->ring = io->OwningPool().GetRing(); io->ring)
+    {
+        //
+        // Registered file saves reference counting of the file on each
+        // operation. If table is full, descriptor is used as is.
+        //
+
+        io->slot = io->ring->RegisterFile(DescriptorFromHandle(file));
+    }
+
+    return io;
+}
+
+VOID StartThreadpoolIo(PTP_IO io) noexcept
+{
+    std::lock_guard guard { io->lock };
+    ++io->expected;
+}
+
+VOID CancelThreadpoolIo(PTP_IO io) noexcept
+{
+    std::lock_guard guard { io->lock };
+
+    if (io->expected)
+    {
+        --io->expected;
+    }
+}
+
+VOID WaitForThreadpoolIoCallbacks(PTP_IO io, BOOL cancel_pending_callbacks) noexcept
+{
+    io->WaitCallbacks(cancel_pending_callbacks);
+}
+
+VOID CloseThreadpoolIo(PTP_IO io) noexcept
+{
+    io->Close();
+}
+
+BOOL RegisterThreadpoolIoBuffer(PTP_IO io, PVOID buffer, SIZE_T size) noexcept
+{
+    const auto ring = io->OwningPool().GetRing();
+    if (!ring)
+    {
+        SetLastError(ERROR_NOT_SUPPORTED);
+        return FALSE;
+    }
+
+    return ring->RegisterBuffer(buffer, size);
+}
+
+BOOL UnregisterThreadpoolIoBuffer(PTP_IO io, PVOID buffer) noexcept
+{
+    const auto ring = io->OwningPool().GetRing();
+    if (!ring)
+    {
+        SetLastError(ERROR_NOT_SUPPORTED);
+        return FALSE;
+    }
+
+    return ring->UnregisterBuffer(buffer);
+}
+
+
+//
+// Files
+//
+
+BOOL ReadFile(HANDLE file, LPVOID buffer, DWORD bytes_to_read, LPDWORD bytes_read, LPOVERLAPPED overlapped) noexcept
+{
+    return ntp::native::TransferFile(ntp::native::IoRequest::Kind::kRead, file, buffer,
+        bytes_to_read, bytes_read, overlapped);
+}
+
+BOOL WriteFile(HANDLE file, LPCVOID buffer, DWORD bytes_to_write, LPDWORD bytes_written, LPOVERLAPPED overlapped) noexcept
+{
+    return ntp::native::TransferFile(ntp::native::IoRequest::Kind::kWrite, file, const_cast<LPVOID>(buffer),
+        bytes_to_write, bytes_written, overlapped);
+}
+
+BOOL ReadFileScatter(HANDLE file, FILE_SEGMENT_ELEMENT segments[], DWORD bytes_to_read, LPDWORD /* reserved */, LPOVERLAPPED overlapped) noexcept
+{
+    ntp::native::IoVector vector;
+    if (!ntp::native::CopySegments(segments, bytes_to_read, vector))
+    {
+        return FALSE;
+    }
+
+    return ntp::native::TransferVector(ntp::native::IoRequest::Kind::kReadVector, file, std::move(vector), nullptr, overlapped);
+}
+
+BOOL WriteFileGather(HANDLE file, FILE_SEGMENT_ELEMENT segments[], DWORD bytes_to_write, LPDWORD /* reserved */, LPOVERLAPPED overlapped) noexcept
+{
+    ntp::native::IoVector vector;
+    if (!ntp::native::CopySegments(segments, bytes_to_write, vector))
+    {
+        return FALSE;
+    }
+
+    return ntp::native::TransferVector(ntp::native::IoRequest::Kind::kWriteVector, file, std::move(vector), nullptr, overlapped);
+}
+
+BOOL ReadFileVector(HANDLE file, const FILE_VECTOR_ELEMENT* elements, DWORD count, LPDWORD bytes_read, LPOVERLAPPED overlapped) noexcept
+{
+    ntp::native::IoVector vector;
+    if (!ntp::native::CopyVector(elements, count, vector))
+    {
+        return FALSE;
+    }
+
+    return ntp::native::TransferVector(ntp::native::IoRequest::Kind::kReadVector, file, std::move(vector), bytes_read, overlapped);
+}
+
+BOOL WriteFileVector(HANDLE file, const FILE_VECTOR_ELEMENT* elements, DWORD count, LPDWORD bytes_written, LPOVERLAPPED overlapped) noexcept
+{
+    ntp::native::IoVector vector;
+    if (!ntp::native::CopyVector(elements, count, vector))
+    {
+        return FALSE;
+    }
+
+    return ntp::native::TransferVector(ntp::native::IoRequest::Kind::kWriteVector, file, std::move(vector), bytes_written, overlapped);
+}
+
+BOOL AcceptSocket(HANDLE listener, PHANDLE accepted, LPOVERLAPPED overlapped) noexcept
+{
+    if (BOOL started = FALSE; ntp::native::StartRequest(ntp::native::IoRequest::Kind::kAccept,
+            listener, nullptr, 0, overlapped, started))
+    {
+        return started;
+    }
+
+    int descriptor = -1;
+
+    do
+    {
+        descriptor = accept4(DescriptorFromHandle(listener), nullptr, nullptr, SOCK_CLOEXEC);
+    } while (descriptor < 0 && errno == EINTR);
+
+    if (descriptor < 0)
+    {
+        return FALSE;
+    }
+
+    if (accepted)
+    {
+        *accepted = HandleFromDescriptor(descriptor);
+    }
+
+    if (overlapped)
+    {
+        overlapped->Internal     = NO_ERROR;
+        overlapped->InternalHigh = static_cast<ULONG_PTR>(descriptor);
+
+        if (overlapped->hEvent)
+        {
+            SetEvent(overlapped->hEvent);
+        }
+    }
+
+    return TRUE;
+}
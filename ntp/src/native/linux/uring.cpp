@@ -0,0 +1,809 @@
+/**
+ * @file uring.cpp
+ * @brief Implementation of io_uring backend of ntp native engine
+ */
+
+#include <new>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <utility>
+#include <algorithm>
+
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <sys/syscall.h>
+
+#include "ntp_config.hpp"
+#include "native/linux/uring.hpp"
+
+
+namespace ntp::native {
+namespace {
+
+/**
+ * @brief Number of submission queue entries.
+ */
+constexpr unsigned kSubmissionEntries = 256;
+
+/**
+ * @brief Number of completion queue entries (operations in flight are not limited
+ *        by this value, because kernel buffers overflown completions).
+ */
+constexpr unsigned kCompletionEntries = 4096;
+
+/**
+ * @brief Size of registered files table.
+ */
+constexpr unsigned kRegisteredFiles = 1024;
+
+/**
+ * @brief Size of registered buffers table.
+ */
+constexpr unsigned kRegisteredBuffers = 64;
+
+/**
+ * @brief Number of completions copied from completion queue at once.
+ */
+constexpr std::size_t kReapBatch = 64;
+
+/**
+ * @brief Result of driver's callback queued by ring itself (reactor uses WAIT_OBJECT_0).
+ */
+constexpr ULONG kScheduledRun = WAIT_TIMEOUT;
+
+
+int RingSetup(unsigned entries, io_uring_params* params) noexcept
+{
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int RingEnter(int ring, unsigned to_submit, unsigned min_complete, unsigned flags) noexcept
+{
+    return static_cast<int>(syscall(__NR_io_uring_enter, ring, to_submit, min_complete, flags, nullptr, 0));
+}
+
+int RingRegister(int ring, unsigned opcode, const void* argument, unsigned count) noexcept
+{
+    return static_cast<int>(syscall(__NR_io_uring_register, ring, opcode, argument, count));
+}
+
+template<typename Type>
+Type* RingField(void* rings, std::uint32_t offset) noexcept
+{
+    return reinterpret_cast<Type*>(static_cast<char*>(rings) + offset);
+}
+
+}  // namespace
+
+
+/**
+ * @brief Thread, that submits operations into kernel. Kernel cancels operations
+ *        of a thread, when it exits, so that ring resubmits them, and only them.
+ *
+ * Submitter is referenced by its thread and by operations, that it has submitted.
+ */
+class RingSubmitter final
+{
+public:
+    /**
+     * @brief Get submitter of the calling thread.
+     *
+     * @returns submitter or NULL if it cannot be allocated
+     */
+    static RingSubmitter* Current() noexcept
+    {
+        thread_local const Holder holder;
+        return holder.submitter;
+    }
+
+    /**
+     * @brief Records submission of an operation by this thread.
+     */
+    static void Assign(RingOperation& operation, RingSubmitter* submitter) noexcept
+    {
+        if (operation.submitter == submitter)
+        {
+            return;
+        }
+
+        Release(operation);
+
+        if (submitter)
+        {
+            submitter->references_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        operation.submitter = submitter;
+    }
+
+    /**
+     * @brief Forgets submitter of a completed operation.
+     */
+    static void Release(RingOperation& operation) noexcept
+    {
+        if (const auto submitter = std::exchange(operation.submitter, nullptr); submitter)
+        {
+            submitter->Release();
+        }
+    }
+
+    /**
+     * @brief Checks if operation was submitted by a thread, that has exited.
+     */
+    static bool Exited(const RingOperation& operation) noexcept
+    {
+        return operation.submitter && operation.submitter->exited_.load(std::memory_order_acquire);
+    }
+
+private:
+    struct Holder
+    {
+        Holder() noexcept
+            : submitter(new (std::nothrow) RingSubmitter())
+        { }
+
+        ~Holder()
+        {
+            //
+            // Thread-local objects are destroyed before kernel
+            // cancels operations of exiting thread
+            //
+
+            if (submitter)
+            {
+                submitter->exited_.store(true, std::memory_order_release);
+                submitter->Release();
+            }
+        }
+
+        RingSubmitter* const submitter;
+    };
+
+    void Release() noexcept
+    {
+        if (references_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            delete this;
+        }
+    }
+
+private:
+    // References of thread and operations
+    std::atomic<std::size_t> references_ { 1 };
+
+    // Has thread exited
+    std::atomic<bool> exited_ { false };
+};
+
+
+/**
+ * @brief Object, that runs ring's work (submission and reaping) on pool workers.
+ */
+class RingDriver final
+    : public Object
+{
+public:
+    explicit RingDriver(Ring& ring) noexcept
+        : Object(ring.pool_, nullptr)
+        , ring_(ring)
+    { }
+
+private:
+    void Invoke(PTP_CALLBACK_INSTANCE /* instance */, const Payload& payload) noexcept override
+    {
+        ring_.Run(payload.result == WAIT_OBJECT_0);
+    }
+
+private:
+    Ring& ring_;
+};
+
+
+/* static */
+std::unique_ptr<Ring> Ring::Create(Pool& pool) noexcept
+{
+#if defined(NTP_DISABLE_IO_URING)
+    static_cast<void>(pool);
+    return nullptr;
+#else   // !NTP_DISABLE_IO_URING
+    std::unique_ptr<Ring> ring { new (std::nothrow) Ring(pool) };
+    if (!ring || !ring->Setup())
+    {
+        return nullptr;
+    }
+
+    return ring;
+#endif  // NTP_DISABLE_IO_URING
+}
+
+Ring::Ring(Pool& pool) noexcept
+    : pool_(pool)
+    , driver_(nullptr)
+    , entry_()
+    , ring_(-1)
+    , rings_(MAP_FAILED)
+    , rings_size_(0)
+    , sqes_(static_cast<io_uring_sqe*>(MAP_FAILED))
+    , sqes_size_(0)
+    , sq_lock_()
+    , sq_entries_(0)
+    , sq_mask_(0)
+    , sq_head_(nullptr)
+    , sq_tail_(nullptr)
+    , sq_flags_(nullptr)
+    , sq_array_(nullptr)
+    , sq_local_tail_(0)
+    , unsubmitted_(0)
+    , run_lock_()
+    , cq_mask_(0)
+    , cq_head_(nullptr)
+    , cq_tail_(nullptr)
+    , cqes_(nullptr)
+    , armed_(false)
+    , inflight_(0)
+    , scheduled_(false)
+    , stopping_(false)
+    , resources_lock_()
+    , free_files_()
+    , buffers_()
+    , buffers_count_(0)
+{ }
+
+Ring::~Ring()
+{
+    stopping_.store(true, std::memory_order_release);
+
+    if (driver_)
+    {
+        //
+        // Stop reaping on workers first, then cancel everything in flight
+        // and reap remaining completions right here. Callbacks of cancelled
+        // operations receive ERROR_OPERATION_ABORTED.
+        //
+
+        pool_.GetReactor().SetWait(entry_, nullptr, nullptr);
+        driver_->WaitCallbacks(true);
+
+        if (inflight_.load(std::memory_order_acquire))
+        {
+            std::lock_guard lock { sq_lock_ };
+
+            if (sq_local_tail_ - sq_head_->load(std::memory_order_acquire) < sq_entries_)
+            {
+                const auto index = sq_local_tail_ & sq_mask_;
+                auto& sqe        = sqes_[index];
+
+                std::memset(&sqe, 0, sizeof(sqe));
+                sqe.opcode       = IORING_OP_ASYNC_CANCEL;
+                sqe.fd           = -1;
+                sqe.cancel_flags = IORING_ASYNC_CANCEL_ALL | IORING_ASYNC_CANCEL_ANY;
+                sqe.user_data    = 0;
+
+                sq_array_[index] = index;
+                sq_tail_->store(++sq_local_tail_, std::memory_order_release);
+                ++unsubmitted_;
+            }
+        }
+
+        while (inflight_.load(std::memory_order_acquire))
+        {
+            Flush();
+
+            if (!Reap())
+            {
+                Enter(0, 1, IORING_ENTER_GETEVENTS);
+            }
+        }
+
+        driver_->Close();
+    }
+
+    if (sqes_ != MAP_FAILED)
+    {
+        munmap(sqes_, sqes_size_);
+    }
+
+    if (rings_ != MAP_FAILED)
+    {
+        munmap(rings_, rings_size_);
+    }
+
+    if (ring_ >= 0)
+    {
+        close(ring_);
+    }
+}
+
+bool Ring::Push(RingOperation* operation) noexcept
+{
+    if (stopping_.load(std::memory_order_acquire))
+    {
+        return false;
+    }
+
+    inflight_.fetch_add(1, std::memory_order_relaxed);
+
+    {
+        std::lock_guard lock { sq_lock_ };
+
+        if (!PushLocked(operation))
+        {
+            inflight_.fetch_sub(1, std::memory_order_relaxed);
+            return false;
+        }
+    }
+
+    Schedule();
+    return true;
+}
+
+int Ring::RegisterFile(int descriptor) noexcept
+{
+    std::lock_guard lock { resources_lock_ };
+
+    if (free_files_.empty())
+    {
+        return -1;
+    }
+
+    const auto index = free_files_.back();
+
+    io_uring_rsrc_update2 update {};
+    update.offset = static_cast<std::uint32_t>(index);
+    update.data   = reinterpret_cast<std::uintptr_t>(&descriptor);
+    update.nr     = 1;
+
+    if (1 != RingRegister(ring_, IORING_REGISTER_FILES_UPDATE2, &update, sizeof(update)))
+    {
+        return -1;
+    }
+
+    free_files_.pop_back();
+    return index;
+}
+
+void Ring::UnregisterFile(int index) noexcept
+{
+    std::lock_guard lock { resources_lock_ };
+
+    //
+    // Kernel keeps the file referenced by operations in flight
+    //
+
+    int descriptor = -1;
+
+    io_uring_rsrc_update2 update {};
+    update.offset = static_cast<std::uint32_t>(index);
+    update.data   = reinterpret_cast<std::uintptr_t>(&descriptor);
+    update.nr     = 1;
+
+    RingRegister(ring_, IORING_REGISTER_FILES_UPDATE2, &update, sizeof(update));
+
+    try
+    {
+        free_files_.push_back(index);
+    }
+    catch (const std::bad_alloc&)
+    {
+        //
+        // Capacity is reserved in Setup, never happens
+        //
+    }
+}
+
+bool Ring::RegisterBuffer(void* buffer, std::size_t size) noexcept
+{
+    if (!buffer || !size)
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+        return false;
+    }
+
+    std::lock_guard lock { resources_lock_ };
+
+    const auto slot = std::find_if(buffers_.begin(), buffers_.end(), [](const auto& registered) { return !registered.second; });
+    if (slot == buffers_.end())
+    {
+        SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+        return false;
+    }
+
+    iovec vector { buffer, size };
+
+    io_uring_rsrc_update2 update {};
+    update.offset = static_cast<std::uint32_t>(slot - buffers_.begin());
+    update.data   = reinterpret_cast<std::uintptr_t>(&vector);
+    update.nr     = 1;
+
+    if (1 != RingRegister(ring_, IORING_REGISTER_BUFFERS_UPDATE, &update, sizeof(update)))
+    {
+        //
+        // Last error is set by kernel (e.g. ENOMEM, if locked memory limit is exceeded)
+        //
+
+        return false;
+    }
+
+    *slot = { reinterpret_cast<std::uintptr_t>(buffer), size };
+    buffers_count_.fetch_add(1, std::memory_order_relaxed);
+
+    return true;
+}
+
+bool Ring::UnregisterBuffer(void* buffer) noexcept
+{
+    std::lock_guard lock { resources_lock_ };
+
+    const auto slot = std::find_if(buffers_.begin(), buffers_.end(), [buffer](const auto& registered) {
+        return registered.second && registered.first == reinterpret_cast<std::uintptr_t>(buffer);
+    });
+
+    if (slot == buffers_.end())
+    {
+        SetLastError(ERROR_NOT_FOUND);
+        return false;
+    }
+
+    //
+    // Kernel keeps the buffer pinned until operations in flight complete
+    //
+
+    iovec vector { nullptr, 0 };
+
+    io_uring_rsrc_update2 update {};
+    update.offset = static_cast<std::uint32_t>(slot - buffers_.begin());
+    update.data   = reinterpret_cast<std::uintptr_t>(&vector);
+    update.nr     = 1;
+
+    RingRegister(ring_, IORING_REGISTER_BUFFERS_UPDATE, &update, sizeof(update));
+
+    *slot = { 0, 0 };
+    buffers_count_.fetch_sub(1, std::memory_order_relaxed);
+
+    return true;
+}
+
+int Ring::FindBuffer(const void* data, std::size_t size) noexcept
+{
+    if (!buffers_count_.load(std::memory_order_relaxed))
+    {
+        return -1;
+    }
+
+    const auto begin = reinterpret_cast<std::uintptr_t>(data);
+
+    std::lock_guard lock { resources_lock_ };
+
+    for (std::size_t index = 0; index < buffers_.size(); ++index)
+    {
+        const auto& [address, length] = buffers_[index];
+
+        if (length && begin >= address && begin - address + size <= length)
+        {
+            return static_cast<int>(index);
+        }
+    }
+
+    return -1;
+}
+
+bool Ring::Setup() noexcept
+{
+    io_uring_params params {};
+    params.flags      = IORING_SETUP_CQSIZE | IORING_SETUP_CLAMP;
+    params.cq_entries = kCompletionEntries;
+
+    ring_ = RingSetup(kSubmissionEntries, &params);
+    if (ring_ < 0)
+    {
+        return false;
+    }
+
+    //
+    // Single mapping of both queues and lossless completion queue are required
+    //
+
+    if (!(params.features & IORING_FEAT_SINGLE_MMAP) || !(params.features & IORING_FEAT_NODROP))
+    {
+        return false;
+    }
+
+    rings_size_ = (std::max)(params.sq_off.array + params.sq_entries * sizeof(unsigned),
+        params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+
+    rings_ = mmap(nullptr, rings_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_, IORING_OFF_SQ_RING);
+    if (rings_ == MAP_FAILED)
+    {
+        return false;
+    }
+
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+
+    const auto sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED)
+    {
+        return false;
+    }
+
+    sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+    sq_entries_    = params.sq_entries;
+    sq_mask_       = *RingField<unsigned>(rings_, params.sq_off.ring_mask);
+    sq_head_       = RingField<std::atomic<unsigned>>(rings_, params.sq_off.head);
+    sq_tail_       = RingField<std::atomic<unsigned>>(rings_, params.sq_off.tail);
+    sq_flags_      = RingField<std::atomic<unsigned>>(rings_, params.sq_off.flags);
+    sq_array_      = RingField<unsigned>(rings_, params.sq_off.array);
+    sq_local_tail_ = sq_tail_->load(std::memory_order_relaxed);
+
+    cq_mask_ = *RingField<unsigned>(rings_, params.cq_off.ring_mask);
+    cq_head_ = RingField<std::atomic<unsigned>>(rings_, params.cq_off.head);
+    cq_tail_ = RingField<std::atomic<unsigned>>(rings_, params.cq_off.tail);
+    cqes_    = RingField<io_uring_cqe>(rings_, params.cq_off.cqes);
+
+    //
+    // Sparse tables of files and buffers (kernel 5.19+, it also
+    // guarantees support of all operations used by ntp)
+    //
+
+    io_uring_rsrc_register files {};
+    files.nr    = kRegisteredFiles;
+    files.flags = IORING_RSRC_REGISTER_SPARSE;
+
+    io_uring_rsrc_register buffers {};
+    buffers.nr    = kRegisteredBuffers;
+    buffers.flags = IORING_RSRC_REGISTER_SPARSE;
+
+    if (0 != RingRegister(ring_, IORING_REGISTER_FILES2, &files, sizeof(files)) ||
+        0 != RingRegister(ring_, IORING_REGISTER_BUFFERS2, &buffers, sizeof(buffers)))
+    {
+        return false;
+    }
+
+    try
+    {
+        free_files_.reserve(kRegisteredFiles);
+        for (auto index = static_cast<int>(kRegisteredFiles); index > 0; --index)
+        {
+            free_files_.push_back(index - 1);
+        }
+
+        buffers_.resize(kRegisteredBuffers);
+    }
+    catch (const std::bad_alloc&)
+    {
+        return false;
+    }
+
+    driver_      = new (std::nothrow) RingDriver(*this);
+    entry_.owner = driver_;
+
+    return driver_ != nullptr;
+}
+
+bool Ring::PushLocked(RingOperation* operation) noexcept
+{
+    if (sq_local_tail_ - sq_head_->load(std::memory_order_acquire) >= sq_entries_)
+    {
+        //
+        // Submission queue is full, submit it right here
+        //
+
+        SubmitLocked(unsubmitted_);
+
+        if (sq_local_tail_ - sq_head_->load(std::memory_order_acquire) >= sq_entries_)
+        {
+            return false;
+        }
+    }
+
+    const auto& request = operation->request;
+    const auto index    = sq_local_tail_ & sq_mask_;
+    auto& sqe           = sqes_[index];
+
+    std::memset(&sqe, 0, sizeof(sqe));
+    sqe.opcode    = request.opcode;
+    sqe.flags     = request.fixed_file ? IOSQE_FIXED_FILE : 0;
+    sqe.fd        = request.descriptor;
+    sqe.addr      = reinterpret_cast<std::uintptr_t>(request.buffer);
+    sqe.len       = request.size;
+    sqe.off       = request.offset;
+    sqe.rw_flags  = static_cast<__kernel_rwf_t>(request.flags);
+    sqe.user_data = reinterpret_cast<std::uintptr_t>(operation);
+
+    if (request.buffer_index >= 0)
+    {
+        sqe.buf_index = static_cast<std::uint16_t>(request.buffer_index);
+    }
+
+    sq_array_[index] = index;
+    sq_tail_->store(++sq_local_tail_, std::memory_order_release);
+    ++unsubmitted_;
+
+    return true;
+}
+
+void Ring::Schedule() noexcept
+{
+    //
+    // Operations pushed until driver's callback starts are submitted together
+    //
+
+    if (!scheduled_.exchange(true, std::memory_order_acq_rel))
+    {
+        driver_->Submit(Payload { nullptr, kScheduledRun, 0 });
+    }
+}
+
+void Ring::Run(bool signaled) noexcept
+{
+    scheduled_.store(false, std::memory_order_release);
+
+    std::lock_guard lock { run_lock_ };
+
+    if (signaled)
+    {
+        //
+        // Reactor's wait is one-shot
+        //
+
+        armed_ = false;
+    }
+
+    //
+    // Operations on cached data often complete during submission,
+    // hence completions are reaped right after each submission
+    //
+
+    for (;;)
+    {
+        const auto submitted = Flush();
+        const auto reaped    = Reap();
+
+        if (!submitted && !reaped)
+        {
+            break;
+        }
+    }
+
+    if (!armed_ && inflight_.load(std::memory_order_acquire) && !stopping_.load(std::memory_order_acquire))
+    {
+        //
+        // Ring descriptor becomes readable, when completion queue is not empty
+        //
+
+        pool_.GetReactor().SetWait(entry_, HandleFromDescriptor(ring_), nullptr);
+        armed_ = true;
+    }
+}
+
+unsigned Ring::Flush() noexcept
+{
+    std::lock_guard lock { sq_lock_ };
+
+    if (!unsubmitted_)
+    {
+        return 0;
+    }
+
+    //
+    // If kernel is busy (e.g. completion queue is overflown), the rest
+    // is submitted after completions are reaped
+    //
+
+    return SubmitLocked(unsubmitted_);
+}
+
+unsigned Ring::SubmitLocked(unsigned count) noexcept
+{
+    //
+    // Entries are consumed by kernel in order and only here (under the lock),
+    // so every operation is assigned to the thread, that actually submits it
+    //
+
+    const auto submitter = RingSubmitter::Current();
+    const auto first     = sq_local_tail_ - unsubmitted_;
+
+    for (unsigned position = first; position != first + count; ++position)
+    {
+        const auto user_data = sqes_[sq_array_[position & sq_mask_]].user_data;
+
+        if (const auto operation = reinterpret_cast<RingOperation*>(static_cast<std::uintptr_t>(user_data)); operation)
+        {
+            RingSubmitter::Assign(*operation, submitter);
+        }
+    }
+
+    const auto submitted = static_cast<unsigned>((std::max)(Enter(count, 0, 0), 0));
+    unsubmitted_ -= submitted;
+
+    return submitted;
+}
+
+std::size_t Ring::Reap() noexcept
+{
+    if (sq_flags_->load(std::memory_order_relaxed) & IORING_SQ_CQ_OVERFLOW)
+    {
+        //
+        // Move overflown completions into completion queue
+        //
+
+        Enter(0, 0, IORING_ENTER_GETEVENTS);
+    }
+
+    std::size_t reaped = 0;
+    std::array<io_uring_cqe, kReapBatch> batch;
+
+    for (;;)
+    {
+        auto head        = cq_head_->load(std::memory_order_relaxed);
+        const auto tail  = cq_tail_->load(std::memory_order_acquire);
+        const auto count = (std::min)(static_cast<std::size_t>(tail - head), batch.size());
+
+        if (!count)
+        {
+            break;
+        }
+
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            batch[i] = cqes_[head++ & cq_mask_];
+        }
+
+        //
+        // Completion queue entries are released before callbacks
+        // are invoked, so that kernel can post new completions
+        //
+
+        cq_head_->store(head, std::memory_order_release);
+
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            const auto operation = reinterpret_cast<RingOperation*>(static_cast<std::uintptr_t>(batch[i].user_data));
+            if (!operation)
+            {
+                continue;
+            }
+
+            if (batch[i].res == -ECANCELED && RingSubmitter::Exited(*operation) && !stopping_.load(std::memory_order_acquire))
+            {
+                //
+                // Operation was cancelled by kernel, because thread,
+                // that had submitted it, exited. Resubmit it. Other
+                // cancellations are reported to the operation.
+                //
+
+                std::lock_guard lock { sq_lock_ };
+
+                if (PushLocked(operation))
+                {
+                    continue;
+                }
+            }
+
+            RingSubmitter::Release(*operation);
+
+            operation->OnComplete(batch[i].res);
+            inflight_.fetch_sub(1, std::memory_order_acq_rel);
+        }
+
+        reaped += count;
+    }
+
+    return reaped;
+}
+
+int Ring::Enter(unsigned to_submit, unsigned min_complete, unsigned flags) noexcept
+{
+    for (;;)
+    {
+        const auto result = RingEnter(ring_, to_submit, min_complete, flags);
+        if (result >= 0 || errno != EINTR)
+        {
+            return result;
+        }
+    }
+}
+
+}  // namespace ntp::native
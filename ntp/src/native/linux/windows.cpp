@@ -0,0 +1,908 @@
+/**
+ * @file windows.cpp
+ * @brief Implementation of Windows API subset for Linux
+ */
+
+#include <array>
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <algorithm>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cwchar>
+#include <unordered_set>
+
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+#include "native/linux/engine.hpp"
+
+
+namespace ntp::native {
+namespace {
+
+/**
+ * @brief Registry of auto-reset events. Signal of such events is consumed by a wait.
+ */
+class AutoResetEvents final
+{
+public:
+    static AutoResetEvents& Instance() noexcept
+    {
+        static auto events = new AutoResetEvents();
+        return *events;
+    }
+
+    bool Add(int descriptor) noexcept
+    {
+        std::lock_guard lock { lock_ };
+
+        try
+        {
+            descriptors_.insert(descriptor);
+            return true;
+        }
+        catch (const std::bad_alloc&)
+        {
+            return false;
+        }
+    }
+
+    void Remove(int descriptor) noexcept
+    {
+        std::lock_guard lock { lock_ };
+        descriptors_.erase(descriptor);
+    }
+
+    bool Contains(int descriptor) noexcept
+    {
+        std::lock_guard lock { lock_ };
+        return descriptors_.count(descriptor) != 0;
+    }
+
+private:
+    std::mutex lock_;
+    std::unordered_set<int> descriptors_;
+};
+
+
+//
+// Character type dependent helpers for FormatMessage
+//
+
+template<typename Char>
+struct FormatTraits;
+
+template<>
+struct FormatTraits<char>
+{
+    // Conversion for string insert (%1!s!), that matches character type
+    static constexpr const char* kNativeString = "s";
+    static constexpr const char* kOtherString  = "ls";
+    static constexpr const char* kNativeChar   = "c";
+    static constexpr const char* kOtherChar    = "lc";
+
+    template<typename... Args>
+    static int Print(char* buffer, std::size_t size, const char* format, Args... args) noexcept
+    {
+        return std::snprintf(buffer, size, format, args...);
+    }
+};
+
+template<>
+struct FormatTraits<wchar_t>
+{
+    static constexpr const char* kNativeString = "ls";
+    static constexpr const char* kOtherString  = "s";
+    static constexpr const char* kNativeChar   = "lc";
+    static constexpr const char* kOtherChar    = "c";
+
+    template<typename... Args>
+    static int Print(wchar_t* buffer, std::size_t size, const char* format, Args... args) noexcept
+    {
+        //
+        // Wide format string is needed for swprintf
+        //
+
+        std::array<wchar_t, 64> wide_format {};
+        for (std::size_t i = 0; format[i] && i + 1 < wide_format.size(); ++i)
+        {
+            wide_format[i] = static_cast<wchar_t>(format[i]);
+        }
+
+        //
+        // Unlike snprintf, swprintf returns -1 if buffer is too small
+        //
+
+        std::vector<wchar_t> temporary;
+        if (!buffer)
+        {
+            for (std::size_t capacity = 256;; capacity *= 2)
+            {
+                temporary.resize(capacity);
+
+                const auto written = std::swprintf(temporary.data(), capacity, wide_format.data(), args...);
+                if (written >= 0)
+                {
+                    return written;
+                }
+
+                if (capacity > (1u << 24))
+                {
+                    return -1;
+                }
+            }
+        }
+
+        return std::swprintf(buffer, size, wide_format.data(), args...);
+    }
+};
+
+
+/**
+ * @brief Kind of argument, that is read from va_list.
+ */
+enum class ArgumentKind
+{
+    kInt,
+    kLong,
+    kLongLong,
+    kSize,
+    kDouble,
+    kPointer
+};
+
+
+/**
+ * @brief Parsed insert specification (%n!spec!).
+ */
+struct Insert
+{
+    std::string format;    /**< printf-compatible format of the insert */
+    ArgumentKind kind;     /**< How to read argument from va_list */
+};
+
+
+/**
+ * @brief Argument read from va_list.
+ */
+union Argument
+{
+    int int_value;
+    long long_value;
+    long long long_long_value;
+    std::size_t size_value;
+    double double_value;
+    const void* pointer_value;
+};
+
+
+/**
+ * @brief Translates Windows insert specification into printf format.
+ */
+template<typename Char>
+Insert ParseInsert(const std::string& specification) noexcept
+{
+    using traits_t = FormatTraits<Char>;
+
+    Insert insert { "%", ArgumentKind::kInt };
+
+    std::string length;
+    std::size_t position = 0;
+
+    //
+    // Flags, width and precision are passed as is
+    //
+
+    while (position < specification.size() && std::strchr("-+ #0123456789.*", specification[position]))
+    {
+        insert.format += specification[position++];
+    }
+
+    //
+    // Length modifiers (including Microsoft-specific ones)
+    //
+
+    bool wide   = false;
+    bool narrow = false;
+
+    while (position < specification.size())
+    {
+        const auto rest = specification.substr(position);
+
+        if (rest.rfind("I64", 0) == 0)
+        {
+            length = "ll";
+            position += 3;
+        }
+        else if (rest.rfind("I32", 0) == 0)
+        {
+            position += 3;
+        }
+        else if (rest[0] == 'I')
+        {
+            length = "z";
+            position += 1;
+        }
+        else if (rest[0] == 'w')
+        {
+            wide = true;
+            position += 1;
+        }
+        else if (std::strchr("hlzjtL", rest[0]))
+        {
+            if (rest[0] == 'h')
+            {
+                narrow = true;
+            }
+            else if (rest[0] == 'l')
+            {
+                wide = true;
+            }
+
+            length += rest[0];
+            position += 1;
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    const auto conversion = (position < specification.size()) ? specification[position] : 's';
+
+    switch (conversion)
+    {
+    case 's':
+    case 'S':
+    case 'c':
+    case 'C':
+    {
+        const auto is_string = (conversion == 's' || conversion == 'S');
+        const auto is_upper  = (conversion == 'S' || conversion == 'C');
+        const auto other     = narrow ? std::is_same_v<Char, wchar_t>
+                             : wide   ? std::is_same_v<Char, char>
+                                      : is_upper;
+
+        if (is_string)
+        {
+            insert.format += other ? traits_t::kOtherString : traits_t::kNativeString;
+            insert.kind = ArgumentKind::kPointer;
+        }
+        else
+        {
+            insert.format += other ? traits_t::kOtherChar : traits_t::kNativeChar;
+            insert.kind = ArgumentKind::kInt;
+        }
+
+        return insert;
+    }
+
+    case 'p':
+        insert.format += 'p';
+        insert.kind = ArgumentKind::kPointer;
+        return insert;
+
+    case 'f':
+    case 'F':
+    case 'e':
+    case 'E':
+    case 'g':
+    case 'G':
+    case 'a':
+    case 'A':
+        insert.format += conversion;
+        insert.kind = ArgumentKind::kDouble;
+        return insert;
+
+    default:
+        break;
+    }
+
+    //
+    // Integral conversions
+    //
+
+    insert.format += length;
+    insert.format += conversion;
+
+    if (length == "ll" || length == "j")
+    {
+        insert.kind = ArgumentKind::kLongLong;
+    }
+    else if (length == "l")
+    {
+        insert.kind = ArgumentKind::kLong;
+    }
+    else if (length == "z" || length == "t")
+    {
+        insert.kind = ArgumentKind::kSize;
+    }
+
+    return insert;
+}
+
+
+template<typename Char>
+int PrintArgument(Char* buffer, std::size_t size, const Insert& insert, const Argument& argument) noexcept
+{
+    using traits_t = FormatTraits<Char>;
+
+    const auto format = insert.format.c_str();
+
+    switch (insert.kind)
+    {
+    case ArgumentKind::kInt:
+        return traits_t::Print(buffer, size, format, argument.int_value);
+
+    case ArgumentKind::kLong:
+        return traits_t::Print(buffer, size, format, argument.long_value);
+
+    case ArgumentKind::kLongLong:
+        return traits_t::Print(buffer, size, format, argument.long_long_value);
+
+    case ArgumentKind::kSize:
+        return traits_t::Print(buffer, size, format, argument.size_value);
+
+    case ArgumentKind::kDouble:
+        return traits_t::Print(buffer, size, format, argument.double_value);
+
+    case ArgumentKind::kPointer:
+        return traits_t::Print(buffer, size, format, argument.pointer_value);
+    }
+
+    return -1;
+}
+
+
+template<typename Char>
+void AppendArgument(std::basic_string<Char>& result, const Insert& insert, const Argument& argument)
+{
+    const auto length = PrintArgument<Char>(nullptr, 0, insert, argument);
+    if (length <= 0)
+    {
+        return;
+    }
+
+    std::vector<Char> buffer(static_cast<std::size_t>(length) + 1);
+    PrintArgument<Char>(buffer.data(), buffer.size(), insert, argument);
+
+    result.append(buffer.data(), static_cast<std::size_t>(length));
+}
+
+
+std::wstring Widen(const std::string& source)
+{
+    if (source.empty())
+    {
+        return {};
+    }
+
+    const auto size = MultiByteToWideChar(0, 0, source.c_str(), static_cast<int>(source.size()), nullptr, 0);
+
+    std::wstring result(static_cast<std::size_t>(size), L'\0');
+    MultiByteToWideChar(0, 0, source.c_str(), static_cast<int>(source.size()), result.data(), size);
+
+    return result;
+}
+
+
+template<typename Char>
+std::basic_string<Char> SystemMessage(DWORD message_id)
+{
+    std::array<char, 256> buffer {};
+    const auto message = std::string(strerror_r(static_cast<int>(message_id), buffer.data(), buffer.size()));
+
+    if constexpr (std::is_same_v<Char, char>)
+    {
+        return message;
+    }
+    else
+    {
+        return Widen(message);
+    }
+}
+
+
+/**
+ * @brief Expands escape sequences and inserts of a message.
+ */
+template<typename Char>
+std::basic_string<Char> ExpandMessage(const Char* source, bool ignore_inserts, va_list* arguments)
+{
+    std::basic_string<Char> result;
+
+    //
+    // First pass: collect inserts' specifications by their numbers
+    //
+
+    struct Occurrence
+    {
+        std::size_t begin;
+        std::size_t end;
+        std::size_t number;
+    };
+
+    std::vector<Occurrence> occurrences;
+    std::vector<Insert> inserts;
+
+    const std::basic_string<Char> message(source);
+
+    for (std::size_t position = 0; position < message.size(); ++position)
+    {
+        if (message[position] != Char('%') || position + 1 >= message.size())
+        {
+            continue;
+        }
+
+        const auto next = message[position + 1];
+
+        if (next < Char('1') || next > Char('9') || ignore_inserts)
+        {
+            ++position;
+            continue;
+        }
+
+        auto end            = position + 1;
+        std::size_t number  = 0;
+
+        while (end < message.size() && message[end] >= Char('0') && message[end] <= Char('9') && number < 10)
+        {
+            number = number * 10 + static_cast<std::size_t>(message[end] - Char('0'));
+            ++end;
+        }
+
+        std::string specification = "s";
+
+        if (end < message.size() && message[end] == Char('!'))
+        {
+            const auto closing = message.find(Char('!'), end + 1);
+            if (closing != std::basic_string<Char>::npos)
+            {
+                specification.clear();
+                for (auto i = end + 1; i < closing; ++i)
+                {
+                    specification += static_cast<char>(message[i]);
+                }
+
+                end = closing + 1;
+            }
+        }
+
+        if (inserts.size() < number)
+        {
+            inserts.resize(number, Insert { "%s", ArgumentKind::kPointer });
+        }
+
+        inserts[number - 1] = ParseInsert<Char>(specification);
+        occurrences.push_back(Occurrence { position, end, number });
+
+        position = end - 1;
+    }
+
+    //
+    // Read arguments in order of their numbers
+    //
+
+    std::vector<Argument> values(inserts.size());
+
+    if (arguments)
+    {
+        for (std::size_t i = 0; i < inserts.size(); ++i)
+        {
+            switch (inserts[i].kind)
+            {
+            case ArgumentKind::kInt:
+                values[i].int_value = va_arg(*arguments, int);
+                break;
+
+            case ArgumentKind::kLong:
+                values[i].long_value = va_arg(*arguments, long);
+                break;
+
+            case ArgumentKind::kLongLong:
+                values[i].long_long_value = va_arg(*arguments, long long);
+                break;
+
+            case ArgumentKind::kSize:
+                values[i].size_value = va_arg(*arguments, std::size_t);
+                break;
+
+            case ArgumentKind::kDouble:
+                values[i].double_value = va_arg(*arguments, double);
+                break;
+
+            case ArgumentKind::kPointer:
+                values[i].pointer_value = va_arg(*arguments, const void*);
+                break;
+            }
+        }
+    }
+
+    //
+    // Second pass: build the message
+    //
+
+    auto occurrence = occurrences.begin();
+
+    for (std::size_t position = 0; position < message.size(); ++position)
+    {
+        if (occurrence != occurrences.end() && occurrence->begin == position)
+        {
+            if (arguments)
+            {
+                AppendArgument(result, inserts[occurrence->number - 1], values[occurrence->number - 1]);
+            }
+
+            position = occurrence->end - 1;
+            ++occurrence;
+
+            continue;
+        }
+
+        const auto current = message[position];
+
+        if (current != Char('%') || position + 1 >= message.size())
+        {
+            result += current;
+            continue;
+        }
+
+        const auto next = message[++position];
+
+        if (ignore_inserts && next >= Char('1') && next <= Char('9'))
+        {
+            result += current;
+            result += next;
+            continue;
+        }
+
+        switch (next)
+        {
+        case Char('0'):
+            return result;
+
+        case Char('n'):
+        case Char('r'):
+            result += Char('\n');
+            break;
+
+        case Char('t'):
+            result += Char('\t');
+            break;
+
+        case Char('b'):
+            result += Char(' ');
+            break;
+
+        default:
+            // %%, %., %! and any other character are replaced with character itself
+            result += next;
+            break;
+        }
+    }
+
+    return result;
+}
+
+
+template<typename Char>
+DWORD BasicFormatMessage(DWORD flags, LPCVOID source, DWORD message_id, Char* buffer, DWORD size, va_list* arguments) noexcept
+{
+    try
+    {
+        std::basic_string<Char> message;
+
+        if (flags & FORMAT_MESSAGE_FROM_SYSTEM)
+        {
+            message = SystemMessage<Char>(message_id);
+        }
+        else if ((flags & FORMAT_MESSAGE_FROM_STRING) && source)
+        {
+            message = ExpandMessage(static_cast<const Char*>(source),
+                0 != (flags & FORMAT_MESSAGE_IGNORE_INSERTS), arguments);
+        }
+        else
+        {
+            SetLastError(ERROR_INVALID_PARAMETER);
+            return 0;
+        }
+
+        if (flags & FORMAT_MESSAGE_ALLOCATE_BUFFER)
+        {
+            const auto allocated = static_cast<Char*>(std::malloc((message.size() + 1) * sizeof(Char)));
+            if (!allocated)
+            {
+                SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+                return 0;
+            }
+
+            std::memcpy(allocated, message.c_str(), (message.size() + 1) * sizeof(Char));
+            *reinterpret_cast<Char**>(buffer) = allocated;
+        }
+        else
+        {
+            if (message.size() + 1 > size)
+            {
+                SetLastError(ENOBUFS);
+                return 0;
+            }
+
+            std::memcpy(buffer, message.c_str(), (message.size() + 1) * sizeof(Char));
+        }
+
+        return static_cast<DWORD>(message.size());
+    }
+    catch (const std::bad_alloc&)
+    {
+        SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+        return 0;
+    }
+}
+
+}  // namespace
+
+
+bool TryAcquire(HANDLE object) noexcept
+{
+    const auto descriptor = DescriptorFromHandle(object);
+
+    if (AutoResetEvents::Instance().Contains(descriptor))
+    {
+        //
+        // Reading eventfd resets it, only one waiter succeeds
+        //
+
+        std::uint64_t value = 0;
+        return read(descriptor, &value, sizeof(value)) == sizeof(value);
+    }
+
+    pollfd request { descriptor, POLLIN, 0 };
+    return poll(&request, 1, 0) == 1 && (request.revents & POLLIN);
+}
+
+}  // namespace ntp::native
+
+
+//
+// Errors
+//
+
+DWORD GetLastError() noexcept
+{
+    return static_cast<DWORD>(errno);
+}
+
+VOID SetLastError(DWORD code) noexcept
+{
+    errno = static_cast<int>(code);
+}
+
+
+//
+// Memory
+//
+
+HANDLE GetProcessHeap() noexcept
+{
+    static int heap = 0;
+    return &heap;
+}
+
+LPVOID HeapAlloc(HANDLE /* heap */, DWORD flags, SIZE_T bytes) noexcept
+{
+    return (flags & HEAP_ZERO_MEMORY)
+             ? std::calloc(1, bytes)
+             : std::malloc(bytes);
+}
+
+BOOL HeapFree(HANDLE /* heap */, DWORD /* flags */, LPVOID memory) noexcept
+{
+    std::free(memory);
+    return TRUE;
+}
+
+HLOCAL LocalFree(HLOCAL memory) noexcept
+{
+    std::free(memory);
+    return nullptr;
+}
+
+void* _aligned_malloc(std::size_t size, std::size_t alignment) noexcept
+{
+    void* memory = nullptr;
+    if (0 != posix_memalign(&memory, std::max(alignment, sizeof(void*)), size))
+    {
+        return nullptr;
+    }
+
+    return memory;
+}
+
+void _aligned_free(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+
+//
+// Strings
+//
+
+DWORD FormatMessageA(DWORD flags, LPCVOID source, DWORD message_id, DWORD /* language_id */,
+    LPSTR buffer, DWORD size, va_list* arguments) noexcept
+{
+    return ntp::native::BasicFormatMessage(flags, source, message_id, buffer, size, arguments);
+}
+
+DWORD FormatMessageW(DWORD flags, LPCVOID source, DWORD message_id, DWORD /* language_id */,
+    LPWSTR buffer, DWORD size, va_list* arguments) noexcept
+{
+    return ntp::native::BasicFormatMessage(flags, source, message_id, buffer, size, arguments);
+}
+
+int MultiByteToWideChar(UINT /* code_page */, DWORD /* flags */, LPCSTR multi_byte, int multi_byte_size,
+    LPWSTR wide, int wide_size) noexcept
+{
+    const auto input = reinterpret_cast<const unsigned char*>(multi_byte);
+    const auto size  = (multi_byte_size < 0)
+                         ? std::strlen(multi_byte) + 1
+                         : static_cast<std::size_t>(multi_byte_size);
+
+    int written = 0;
+
+    for (std::size_t position = 0; position < size;)
+    {
+        //
+        // Decode one UTF-8 sequence (invalid bytes are replaced with U+FFFD)
+        //
+
+        std::uint32_t code_point = 0xFFFD;
+        std::size_t length       = 1;
+
+        const auto lead = input[position];
+
+        if (lead < 0x80)
+        {
+            code_point = lead;
+        }
+        else if ((lead >> 5) == 0x6 && position + 1 < size)
+        {
+            code_point = ((lead & 0x1Fu) << 6) | (input[position + 1] & 0x3Fu);
+            length     = 2;
+        }
+        else if ((lead >> 4) == 0xE && position + 2 < size)
+        {
+            code_point = ((lead & 0x0Fu) << 12) | ((input[position + 1] & 0x3Fu) << 6) | (input[position + 2] & 0x3Fu);
+            length     = 3;
+        }
+        else if ((lead >> 3) == 0x1E && position + 3 < size)
+        {
+            code_point = ((lead & 0x07u) << 18) | ((input[position + 1] & 0x3Fu) << 12) |
+                         ((input[position + 2] & 0x3Fu) << 6) | (input[position + 3] & 0x3Fu);
+            length     = 4;
+        }
+
+        position += length;
+
+        if (wide_size)
+        {
+            if (written >= wide_size)
+            {
+                SetLastError(ENOBUFS);
+                return 0;
+            }
+
+            wide[written] = static_cast<wchar_t>(code_point);
+        }
+
+        ++written;
+    }
+
+    return written;
+}
+
+
+//
+// Synchronization
+//
+
+HANDLE CreateEvent(LPSECURITY_ATTRIBUTES /* security_attributes */, BOOL manual_reset,
+    BOOL initially_signaled, LPCWSTR /* name */) noexcept
+{
+    const auto descriptor = eventfd(initially_signaled ? 1 : 0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (descriptor < 0)
+    {
+        return nullptr;
+    }
+
+    if (!manual_reset && !ntp::native::AutoResetEvents::Instance().Add(descriptor))
+    {
+        close(descriptor);
+
+        SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+        return nullptr;
+    }
+
+    return HandleFromDescriptor(descriptor);
+}
+
+BOOL SetEvent(HANDLE event) noexcept
+{
+    const std::uint64_t value = 1;
+    const auto written        = write(DescriptorFromHandle(event), &value, sizeof(value));
+
+    //
+    // EAGAIN means counter overflow, event is signaled anyway
+    //
+
+    return (written == sizeof(value) || errno == EAGAIN) ? TRUE : FALSE;
+}
+
+BOOL ResetEvent(HANDLE event) noexcept
+{
+    std::uint64_t value = 0;
+    const auto read_    = read(DescriptorFromHandle(event), &value, sizeof(value));
+
+    return (read_ == sizeof(value) || errno == EAGAIN) ? TRUE : FALSE;
+}
+
+BOOL CloseHandle(HANDLE object) noexcept
+{
+    const auto descriptor = DescriptorFromHandle(object);
+
+    ntp::native::AutoResetEvents::Instance().Remove(descriptor);
+    return (0 == close(descriptor)) ? TRUE : FALSE;
+}
+
+DWORD WaitForSingleObject(HANDLE object, DWORD milliseconds) noexcept
+{
+    const auto deadline = ntp::native::clock_t::now() + std::chrono::milliseconds(milliseconds);
+
+    for (;;)
+    {
+        int timeout = -1;
+
+        if (milliseconds != INFINITE)
+        {
+            const auto left = std::chrono::ceil<std::chrono::milliseconds>(deadline - ntp::native::clock_t::now());
+            timeout         = static_cast<int>(std::max<std::chrono::milliseconds::rep>(left.count(), 0));
+        }
+
+        pollfd request { DescriptorFromHandle(object), POLLIN, 0 };
+        const auto result = poll(&request, 1, timeout);
+
+        if (result < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            return WAIT_FAILED;
+        }
+
+        if (result == 0)
+        {
+            return WAIT_TIMEOUT;
+        }
+
+        if (request.revents & (POLLERR | POLLNVAL))
+        {
+            return WAIT_FAILED;
+        }
+
+        if (ntp::native::TryAcquire(object))
+        {
+            return WAIT_OBJECT_0;
+        }
+
+        //
+        // Signal was consumed by another waiter
+        //
+    }
+}
@@ -1,8 +1,121 @@
+#include <limits>
+#include <vector>
+
 #include "pool/io.hpp"
 #include "details/utils.hpp"
 #include "logger/logger_internal.hpp"
 
 
+namespace ntp::io {
+namespace {
+
+/**
+ * @brief Starts vectored operation on a bound handle.
+ *
+ * @param read Is operation a read or a write
+ */
+bool TransferSegments(const IoBinding& binding, bool read, HANDLE file, const IoSegment* segments,
+    std::size_t count, LPOVERLAPPED overlapped) noexcept
+{
+#if defined(NTP_PLATFORM_LINUX)
+    if (count > (std::numeric_limits<DWORD>::max)())
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+        return false;
+    }
+
+    binding.BeginOperation();
+
+    const auto started = read
+                           ? ReadFileVector(file, segments, static_cast<DWORD>(count), nullptr, overlapped)
+                           : WriteFileVector(file, segments, static_cast<DWORD>(count), nullptr, overlapped);
+#else   // !NTP_PLATFORM_LINUX
+    SYSTEM_INFO system_info;
+    GetSystemInfo(&system_info);
+
+    const std::size_t page_size = system_info.dwPageSize;
+
+    //
+    // Scatter/gather operations accept a NULL-terminated array of pages
+    //
+
+    std::vector<FILE_SEGMENT_ELEMENT> elements;
+    std::size_t total = 0;
+
+    try
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            const auto buffer = static_cast<char*>(segments[i].Buffer);
+
+            if (reinterpret_cast<std::uintptr_t>(buffer) % page_size || segments[i].Length % page_size)
+            {
+                SetLastError(ERROR_INVALID_PARAMETER);
+                return false;
+            }
+
+            for (std::size_t offset = 0; offset < segments[i].Length; offset += page_size)
+            {
+                FILE_SEGMENT_ELEMENT element {};
+                element.Buffer = PtrToPtr64(buffer + offset);
+
+                elements.push_back(element);
+            }
+
+            total += segments[i].Length;
+        }
+
+        elements.push_back(FILE_SEGMENT_ELEMENT {});
+    }
+    catch (const std::bad_alloc&)
+    {
+        SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+        return false;
+    }
+
+    if (!total || total > (std::numeric_limits<DWORD>::max)())
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+        return false;
+    }
+
+    binding.BeginOperation();
+
+    const auto started = read
+                           ? ReadFileScatter(file, elements.data(), static_cast<DWORD>(total), nullptr, overlapped)
+                           : WriteFileGather(file, elements.data(), static_cast<DWORD>(total), nullptr, overlapped);
+#endif  // NTP_PLATFORM_LINUX
+
+    if (!started)
+    {
+        if (const auto error = GetLastError(); error != ERROR_IO_PENDING)
+        {
+            binding.AbortOperation();
+            SetLastError(error);
+
+            return false;
+        }
+    }
+
+    return true;
+}
+
+}  // namespace
+
+
+bool IoBinding::WriteGather(HANDLE file, const IoSegment* segments, std::size_t count, LPOVERLAPPED overlapped) const noexcept
+{
+    return TransferSegments(*this, false, file, segments, count, overlapped);
+}
+
+bool IoBinding::ReadScatter(HANDLE file, const IoSegment* segments, std::size_t count, LPOVERLAPPED overlapped) const noexcept
+{
+    return TransferSegments(*this, true, file, segments, count, overlapped);
+}
+
+}  // namespace ntp::io
+
+
 namespace ntp::io::details {
 
 IoManager::IoManager(PTP_CALLBACK_ENVIRON environment)
@@ -11,6 +124,15 @@ IoManager::IoManager(PTP_CALLBACK_ENVIRON environment)
 
 void IoManager::SubmitInternal(native_handle_t native_handle, object_context_t& object_context) noexcept
 {
+    if (object_context.io_persistent)
+    {
+        //
+        // Operations on bound handle are started by IoBinding::BeginOperation
+        //
+
+        return;
+    }
+
     ntp::details::SafeThreadpoolCall<StartThreadpoolIo>(native_handle);
 }
 
@@ -31,7 +153,20 @@ void NTAPI IoManager::InvokeCallback(PTP_CALLBACK_INSTANCE instance, context_poi
         //
 
         IoData io_data { overlapped, result, bytes_transferred };
-        context->callback->Call(instance, &io_data);
+
+        {
+            ntp::metrics::details::CallbackScope scope { MetricsOf(context) };
+            context->callback->Call(instance, &io_data);
+        }
+
+        if (context->object_context.io_persistent)
+        {
+            //
+            // Binding serves further operations, it is removed only by cancellation
+            //
+
+            return;
+        }
 
         //
         // Clean object here
@@ -41,7 +176,7 @@ void NTAPI IoManager::InvokeCallback(PTP_CALLBACK_INSTANCE instance, context_poi
     }
     catch (const std::exception& error)
     {
-        logger::details::Logger::Instance().TraceMessage(logger::Severity::kError, error.what());
+        logger::details::Logger::Instance().TraceMessage(logger::Severity::kError, "%1", error.what());
     }
     catch (...)
     {
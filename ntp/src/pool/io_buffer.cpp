@@ -0,0 +1,236 @@
+/**
+ * @file io_buffer.cpp
+ * @brief Implementation of IoBufferPool
+ */
+
+#include <new>
+#include <atomic>
+
+#include "pool/io_buffer.hpp"
+#include "details/allocator.hpp"
+#include "details/exception.hpp"
+
+
+namespace ntp::io::details {
+
+/**
+ * @brief Access to private state of IoOperation for pool's implementation.
+ */
+struct IoOperationAccess
+{
+    static IoOperation* Construct(void* place, void* data, std::uint32_t size_class) noexcept
+    {
+        const auto operation = new (place) IoOperation();
+
+        operation->overlapped_ = {};
+        operation->data_       = data;
+        operation->context_    = nullptr;
+        operation->next_       = nullptr;
+        operation->size_class_ = size_class;
+
+        return operation;
+    }
+
+    static void Reset(IoOperation* operation) noexcept
+    {
+        operation->overlapped_ = {};
+        operation->context_    = nullptr;
+    }
+
+    static IoOperation*& Next(IoOperation* operation) noexcept { return operation->next_; }
+
+    static std::uint32_t SizeClass(const IoOperation* operation) noexcept { return operation->size_class_; }
+};
+
+}  // namespace ntp::io::details
+
+
+namespace ntp::io {
+namespace {
+
+using Access = details::IoOperationAccess;
+
+
+/**
+ * @brief Global counters, updated by threads on slow paths.
+ */
+struct GlobalStatistics
+{
+    using counters_t = IoBufferStatistics;
+
+    std::atomic<std::uint64_t> acquisitions = 0;
+    std::atomic<std::uint64_t> cache_hits   = 0;
+    std::atomic<std::uint64_t> slab_refills = 0;
+    std::atomic<std::uint64_t> releases     = 0;
+
+    void Add(const IoBufferStatistics& local) noexcept
+    {
+        acquisitions.fetch_add(local.acquisitions, std::memory_order_relaxed);
+        cache_hits.fetch_add(local.cache_hits, std::memory_order_relaxed);
+        slab_refills.fetch_add(local.slab_refills, std::memory_order_relaxed);
+        releases.fetch_add(local.releases, std::memory_order_relaxed);
+    }
+
+    IoBufferStatistics Load() const noexcept
+    {
+        return IoBufferStatistics {
+            acquisitions.load(std::memory_order_relaxed),
+            cache_hits.load(std::memory_order_relaxed),
+            slab_refills.load(std::memory_order_relaxed),
+            releases.load(std::memory_order_relaxed)
+        };
+    }
+
+    static void Merge(IoBufferStatistics& statistics, const IoBufferStatistics& local) noexcept
+    {
+        statistics.acquisitions += local.acquisitions;
+        statistics.cache_hits   += local.cache_hits;
+        statistics.slab_refills += local.slab_refills;
+        statistics.releases     += local.releases;
+    }
+
+    static void Allocated(IoBufferStatistics& local) noexcept { ++local.acquisitions; }
+
+    static void CacheHit(IoBufferStatistics& local) noexcept { ++local.cache_hits; }
+
+    static void Refilled(IoBufferStatistics& local, bool from_slab) noexcept
+    {
+        if (from_slab)
+        {
+            ++local.slab_refills;
+        }
+    }
+
+    static void Freed(IoBufferStatistics& local) noexcept { ++local.releases; }
+};
+
+
+/**
+ * @brief Traits of contexts of IoBufferPool (refer to allocator::details::SlabCache).
+ */
+struct OperationTraits
+{
+    using block_t = IoOperation;
+    using sink_t  = GlobalStatistics;
+
+    /**
+     * @brief Number of size classes (4, 8, ..., 64 KiB)
+     */
+    static constexpr std::uint32_t kClasses = 5;
+
+    /**
+     * @brief Number of contexts moved between thread-local cache and depot at once
+     */
+    static constexpr std::uint32_t kBatchSize = 8;
+
+    static IoOperation*& Next(IoOperation* operation) noexcept { return Access::Next(operation); }
+
+    /**
+     * @brief Every batch of contexts is carved from its own slab.
+     */
+    class Slab final
+    {
+    public:
+        explicit Slab(std::uint32_t size_class) noexcept
+            : size_class_(size_class)
+        { }
+
+        void Carve(allocator::details::FreeList<OperationTraits>& batch) noexcept
+        {
+            //
+            // Contexts and buffers are allocated separately: contexts are
+            // packed into cache lines, buffers are packed into pages
+            //
+
+            const auto buffer_size = IoBufferPool::BufferSize(size_class_);
+
+            const auto contexts = ::operator new(kBatchSize * sizeof(IoOperation),
+                std::align_val_t { ntp::details::kCacheLine }, std::nothrow);
+
+            const auto buffers = static_cast<char*>(::operator new(kBatchSize * buffer_size,
+                std::align_val_t { IoBufferPool::kPageSize }, std::nothrow));
+
+            if (!contexts || !buffers)
+            {
+                ::operator delete(contexts, std::align_val_t { ntp::details::kCacheLine }, std::nothrow);
+                ::operator delete(buffers, std::align_val_t { IoBufferPool::kPageSize }, std::nothrow);
+
+                return;
+            }
+
+            for (std::uint32_t i = 0; i < kBatchSize; ++i)
+            {
+                batch.Push(Access::Construct(static_cast<IoOperation*>(contexts) + i, buffers + i * buffer_size, size_class_));
+            }
+        }
+
+    private:
+        // Size class of contexts
+        const std::uint32_t size_class_;
+    };
+};
+
+using cache_t = allocator::details::SlabCache<OperationTraits>;
+
+static_assert(IoBufferPool::BufferSize(OperationTraits::kClasses - 1) == IoBufferPool::kMaxBufferSize,
+    "[ntp::io]: number of size classes does not match buffer sizes");
+
+
+/**
+ * @brief Get size class for a buffer
+ *
+ * @param bytes Size of buffer (must not be greater than IoBufferPool::kMaxBufferSize)
+ * @returns Index of size class
+ */
+std::uint32_t SizeClass(std::size_t bytes) noexcept
+{
+    std::uint32_t size_class = 0;
+
+    while (IoBufferPool::BufferSize(size_class) < bytes)
+    {
+        ++size_class;
+    }
+
+    return size_class;
+}
+
+}  // namespace
+
+
+/* static */
+IoOperation* IoBufferPool::Acquire(std::size_t size /* = kMinBufferSize */)
+{
+    if (size > kMaxBufferSize)
+    {
+        throw exception::Win32Exception(ERROR_INVALID_PARAMETER);
+    }
+
+    const auto operation = cache_t::Allocate(SizeClass(size));
+
+    if (!operation)
+    {
+        throw exception::Win32Exception(ERROR_NOT_ENOUGH_MEMORY);
+    }
+
+    Access::Reset(operation);
+    return operation;
+}
+
+/* static */
+void IoBufferPool::Release(IoOperation* operation) noexcept
+{
+    if (!operation)
+    {
+        return;
+    }
+
+    cache_t::Free(operation, Access::SizeClass(operation));
+}
+
+/* static */
+IoBufferStatistics IoBufferPool::Statistics() noexcept
+{
+    return cache_t::Statistics();
+}
+
+}  // namespace ntp::io
@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include "pool/timer.hpp"
 #include "details/time.hpp"
 #include "details/utils.hpp"
@@ -8,29 +10,316 @@ namespace ntp::timer::details {
 
 TimerManager::TimerManager(PTP_CALLBACK_ENVIRON environment)
     : BasicManager(environment)
-{ }
+    , wheel_()
+    , soft_slots_()
+    , soft_free_(kNoSlot)
+    , soft_count_(0)
+    , soft_lock_()
+    , tick_()
+    , tick_armed_(false)
+    , resolution_(std::chrono::microseconds(NTP_SOFT_TIMER_RESOLUTION_US))
+    , origin_(soft_clock_t::now())
+{
+    tick_ = CreateThreadpoolTimer(reinterpret_cast<PTP_TIMER_CALLBACK>(InvokeTick),
+        this, Environment());
+
+    if (!tick_)
+    {
+        throw exception::Win32Exception();
+    }
+}
+
+TimerManager::~TimerManager()
+{
+    wheel_.Clear([](ntp::details::TimerWheelEntry*) {});
+
+    for (const auto& slot : soft_slots_)
+    {
+        delete slot.timer;
+    }
+}
+
+void TimerManager::CancelSoft(soft_handle_t handle) noexcept
+{
+    SoftTimer* timer = nullptr;
+
+    {
+        std::lock_guard lock { soft_lock_ };
+
+        if (handle.slot >= soft_slots_.size() ||
+            soft_slots_[handle.slot].generation != handle.generation ||
+            !soft_slots_[handle.slot].timer)
+        {
+            //
+            // Timer has already expired (or it was cancelled before)
+            //
+
+            return;
+        }
+
+        timer = soft_slots_[handle.slot].timer;
+
+        ReleaseSoftSlot(handle.slot);
+        wheel_.Cancel(timer);
+    }
+
+    metrics_.Cancelled();
+    delete timer;
+}
+
+void TimerManager::CancelAllSoft() noexcept
+{
+    ntp::details::TimerWheelHook cancelled;
+    cancelled.MakeHead();
+
+    std::size_t count = 0;
+
+    {
+        std::lock_guard lock { soft_lock_ };
+
+        wheel_.Clear([this, &cancelled, &count](ntp::details::TimerWheelEntry* entry) {
+            ReleaseSoftSlot(static_cast<SoftTimer*>(entry)->slot);
+            cancelled.LinkBefore(entry);
+            ++count;
+        });
+
+        tick_armed_ = false;
+        ntp::details::SafeThreadpoolCall<SetThreadpoolTimerEx>(tick_, nullptr, 0, 0);
+    }
+
+    //
+    // Tick callback may be invoking expired timers right now
+    //
+
+    ntp::details::SafeThreadpoolCall<WaitForThreadpoolTimerCallbacks>(tick_, TRUE);
+
+    metrics_.Cancelled(count);
+
+    while (!cancelled.Empty())
+    {
+        const auto timer = static_cast<SoftTimer*>(cancelled.next);
+        timer->Unlink();
+
+        delete timer;
+    }
+}
+
+ntp::metrics::ManagerMetrics TimerManager::CollectMetrics() const
+{
+    auto metrics = BasicManager::CollectMetrics();
+
+    std::lock_guard lock { soft_lock_ };
+    metrics.live_objects += soft_count_;
+
+    return metrics;
+}
+
+void TimerManager::SetSoftResolution(ntp::time::native_duration_t resolution)
+{
+    if (resolution <= ntp::time::native_duration_t::zero())
+    {
+        throw exception::Win32Exception(ERROR_INVALID_PARAMETER);
+    }
+
+    std::lock_guard lock { soft_lock_ };
+
+    if (!wheel_.Empty())
+    {
+        throw exception::Win32Exception(ERROR_INVALID_STATE);
+    }
+
+    resolution_ = resolution;
+    origin_     = soft_clock_t::now();
 
+    wheel_.Reset(0);
+}
+
+ntp::time::native_duration_t TimerManager::SoftResolution() const noexcept
+{
+    std::lock_guard lock { soft_lock_ };
+    return resolution_;
+}
+
+TimerManager::soft_handle_t TimerManager::ScheduleSoft(std::unique_ptr<SoftTimer>&& timer, ntp::time::native_duration_t timeout)
+{
+    const auto now = soft_clock_t::now();
+
+    std::lock_guard lock { soft_lock_ };
+
+    metrics_.Submitted();
+
+    //
+    // Wheel does not advance while it is empty, so it is moved to the current tick first
+    //
+
+    wheel_.Reset(SoftTick(now, false));
+
+    const auto handle = AcquireSoftSlot(timer.get());
+    wheel_.Insert(timer.release(), SoftTick(now + timeout, true));
+
+    if (!tick_armed_)
+    {
+        ArmTick();
+        tick_armed_ = true;
+    }
+
+    return handle;
+}
+
+TimerManager::soft_handle_t TimerManager::AcquireSoftSlot(SoftTimer* timer)
+{
+    if (soft_free_ == kNoSlot)
+    {
+        if (soft_slots_.size() >= kNoSlot)
+        {
+            throw exception::Win32Exception(ERROR_NOT_ENOUGH_MEMORY);
+        }
+
+        soft_slots_.push_back({ nullptr, 0, kNoSlot });
+        soft_free_ = static_cast<std::uint32_t>(soft_slots_.size() - 1);
+    }
+
+    auto& slot = soft_slots_[soft_free_];
+
+    timer->slot = soft_free_;
+    slot.timer  = timer;
+    soft_free_  = slot.next_free;
+
+    ++soft_count_;
+
+    return { timer->slot, slot.generation };
+}
+
+void TimerManager::ReleaseSoftSlot(std::uint32_t index) noexcept
+{
+    auto& slot = soft_slots_[index];
+
+    slot.timer     = nullptr;
+    slot.next_free = soft_free_;
+    soft_free_     = index;
+
+    //
+    // Handles, that refer to the slot, become stale
+    //
+
+    ++slot.generation;
+    --soft_count_;
+}
+
+std::uint64_t TimerManager::SoftTick(soft_clock_t::time_point time_point, bool round_up) const noexcept
+{
+    const auto elapsed = std::chrono::duration_cast<ntp::time::native_duration_t>(time_point - origin_);
+    if (elapsed <= ntp::time::native_duration_t::zero())
+    {
+        return 0;
+    }
+
+    const auto ticks = static_cast<std::uint64_t>(elapsed.count() / resolution_.count());
+    return (round_up && elapsed.count() % resolution_.count()) ? ticks + 1 : ticks;
+}
+
+void TimerManager::ArmTick() noexcept
+{
+    //
+    // Tick timer is not periodic: it is set to the beginning of the next tick each time,
+    // so ticks do not drift, even if callbacks are late. Relative time is negative.
+    //
+
+    const auto next    = origin_ + resolution_ * static_cast<long long>(wheel_.Now() + 1);
+    const auto timeout = (std::max)(std::chrono::duration_cast<ntp::time::native_duration_t>(next - soft_clock_t::now()),
+        ntp::time::native_duration_t::zero());
+
+    FILETIME due_time = ntp::time::Negate(ntp::time::AsFileTime(timeout));
+    ntp::details::SafeThreadpoolCall<SetThreadpoolTimer>(tick_, &due_time, 0, 0);
+}
+
+/* static */
 void TimerManager::SubmitInternal(native_handle_t native_handle, object_context_t& object_context) noexcept
 {
     //
-    // Here we need to decrease timeout, because this function may be called in replacement
-    // function and some time was elapsed since this handle was submitted. If current timer
-    // is being submitted for the first time, this step handles some delays elapsed after
-    // callback creation.
-    // BUGBUG: not implemented for now
+    // Timer keeps its absolute deadline, so time elapsed since submission (e.g. when callback
+    // is replaced, or just some delay after creation) is taken into account here. Periodic
+    // timers, whose deadline is gone, continue their original schedule.
     //
 
+    const auto now = ntp::time::clock_t::now();
+
+    object_context.timer_deadline = ntp::time::NextExpiration(object_context.timer_deadline, object_context.timer_period, now);
+
+    const auto remaining = (std::max)(std::chrono::duration_cast<ntp::time::native_duration_t>(object_context.timer_deadline - now),
+        ntp::time::native_duration_t::zero());
+
     //
     // Here we need relative timeout, so I will invert it (negative timeout represets a relative time interval):
     // https://learn.microsoft.com/en-us/windows/win32/api/threadpoolapiset/nf-threadpoolapiset-setthreadpooltimerex
     //
 
-    FILETIME timeout = ntp::time::AsFileTime(object_context.timer_timeout);
+    FILETIME timeout = ntp::time::AsFileTime(remaining);
     timeout          = ntp::time::Negate(timeout);
 
     const auto period = static_cast<DWORD>(object_context.timer_period.count());
+    const auto window = static_cast<DWORD>(object_context.timer_window.count());
 
-    ntp::details::SafeThreadpoolCall<SetThreadpoolTimer>(native_handle, &timeout, period, 0);
+    ntp::details::SafeThreadpoolCall<SetThreadpoolTimer>(native_handle, &timeout, period, window);
+}
+
+bool TimerManager::RearmInternal(native_handle_t native_handle, ntp::time::clock_t::time_point deadline) noexcept
+{
+    //
+    // Only the deadline is changed, callback stays in place. Container is locked
+    // in shared mode, so timers may be rearmed concurrently with each other, hence
+    // deadline of the same timer is serialized by its own lock.
+    //
+
+    bool rearmed = false;
+
+    const auto found = VisitContext(native_handle, [native_handle, deadline, &rearmed](context_pointer_t context) {
+        auto& object_context = context->object_context;
+
+        if (const auto precise = object_context.timer_precise.get())
+        {
+            std::lock_guard lock { precise->lock };
+            precise->schedule.Reset(deadline);
+
+            if (!precise->stopped)
+            {
+                ArmPrecise(native_handle, object_context);
+            }
+
+            rearmed = true;
+            return;
+        }
+
+        std::lock_guard lock { object_context.timer_lock };
+
+        if (object_context.timer_expired)
+        {
+            //
+            // Callback of one-shot timer is running, it closes the timer
+            // after it returns, so the new deadline would be lost
+            //
+
+            return;
+        }
+
+        object_context.timer_deadline = deadline;
+        SubmitInternal(native_handle, object_context);
+
+        rearmed = true;
+    });
+
+    return found && rearmed;
+}
+
+/* static */
+void TimerManager::ArmPrecise(native_handle_t native_handle, object_context_t& object_context) noexcept
+{
+    //
+    // Must be called under lock of precise timer
+    //
+
+    object_context.timer_deadline = object_context.timer_precise->schedule.Deadline();
+    SubmitInternal(native_handle, object_context);
 }
 
 /* static */
@@ -43,25 +332,56 @@ void NTAPI TimerManager::InvokeCallback(PTP_CALLBACK_INSTANCE instance, context_
             throw exception::Win32Exception(ERROR_INVALID_PARAMETER);
         }
 
+        auto& object_context = context->object_context;
+
+        if (object_context.timer_precise)
+        {
+            return InvokePrecise(instance, context, timer);
+        }
+
+        if (0 == object_context.timer_period.count())
+        {
+            std::lock_guard lock { object_context.timer_lock };
+
+            if (object_context.timer_deadline > ntp::time::clock_t::now())
+            {
+                //
+                // Timer is rearmed after threadpool has picked its expiration
+                // (or threadpool woke up a bit earlier), so it is set again
+                //
+
+                return SubmitInternal(timer, object_context);
+            }
+
+            //
+            // Since now timer cannot be rearmed, it is closed after callback
+            //
+
+            object_context.timer_expired = true;
+        }
+
         //
         // BUGBUG: need to think about exceptions in user-defined callback
         // Probably need to implement something like std::async here
         //
 
-        context->callback->Call(instance, nullptr);
+        {
+            ntp::metrics::details::CallbackScope scope { MetricsOf(context) };
+            context->callback->Call(instance, nullptr);
+        }
 
         //
         // Clean object here
         //
 
-        if (0 == context->object_context.timer_period.count())
+        if (0 == object_context.timer_period.count())
         {
             CleanupContext(instance, context);
         }
     }
     catch (const std::exception& error)
     {
-        logger::details::Logger::Instance().TraceMessage(logger::Severity::kError, error.what());
+        logger::details::Logger::Instance().TraceMessage(logger::Severity::kError, "%1", error.what());
     }
     catch (...)
     {
@@ -70,6 +390,138 @@ void NTAPI TimerManager::InvokeCallback(PTP_CALLBACK_INSTANCE instance, context_
     }
 }
 
+/* static */
+void NTAPI TimerManager::InvokeTick(PTP_CALLBACK_INSTANCE instance, TimerManager* self, PTP_TIMER /* timer */) noexcept
+{
+    if (!self)
+    {
+        logger::details::Logger::Instance().TraceMessage(logger::Severity::kCritical,
+            L"[TimerManager::InvokeTick]: pointer to manager is NULL");
+
+        return;
+    }
+
+    //
+    // Expired timers are collected under the lock and invoked without it,
+    // therefore callbacks are free to submit and cancel soft timers
+    //
+
+    ntp::details::TimerWheelHook expired;
+    expired.MakeHead();
+
+    {
+        std::lock_guard lock { self->soft_lock_ };
+
+        self->wheel_.Advance(self->SoftTick(soft_clock_t::now(), false), [self, &expired](ntp::details::TimerWheelEntry* entry) {
+            self->ReleaseSoftSlot(static_cast<SoftTimer*>(entry)->slot);
+            expired.LinkBefore(entry);
+        });
+
+        if (self->tick_armed_ && !self->wheel_.Empty())
+        {
+            self->ArmTick();
+        }
+        else
+        {
+            self->tick_armed_ = false;
+        }
+    }
+
+    while (!expired.Empty())
+    {
+        std::unique_ptr<SoftTimer> soft_timer { static_cast<SoftTimer*>(expired.next) };
+        soft_timer->Unlink();
+
+        try
+        {
+            ntp::metrics::details::CallbackScope scope { self->metrics_ };
+            soft_timer->callback->Call(instance, nullptr);
+        }
+        catch (const std::exception& error)
+        {
+            logger::details::Logger::Instance().TraceMessage(logger::Severity::kError, "%1", error.what());
+        }
+        catch (...)
+        {
+            logger::details::Logger::Instance().TraceMessage(logger::Severity::kCritical,
+                L"[TimerManager::InvokeTick]: unknown error");
+        }
+    }
+}
+
+/* static */
+void TimerManager::InvokePrecise(PTP_CALLBACK_INSTANCE instance, context_pointer_t context, PTP_TIMER timer)
+{
+    auto& object_context = context->object_context;
+    auto& precise        = *object_context.timer_precise;
+
+    ntp::time::TimerTick tick;
+
+    {
+        std::lock_guard lock { precise.lock };
+
+        if (precise.stopped)
+        {
+            return;
+        }
+
+        const auto now = ntp::time::clock_t::now();
+        if (!precise.schedule.Due(now))
+        {
+            //
+            // Timer is rearmed concurrently or threadpool woke up a bit earlier
+            //
+
+            return ArmPrecise(timer, object_context);
+        }
+
+        tick = precise.schedule.Expire(now);
+    }
+
+    if (precise.jitter)
+    {
+        precise.jitter->Record(tick.lateness);
+    }
+
+    //
+    // Timer is set again only after callback returns (even if it throws),
+    // so callbacks of the same timer never overlap. Ticks, that are gone
+    // meanwhile, are reported to the next invocation as missed.
+    //
+
+    const auto resume = [&precise, &object_context, timer]() {
+        std::lock_guard lock { precise.lock };
+
+        if (!precise.stopped)
+        {
+            ArmPrecise(timer, object_context);
+        }
+    };
+
+    try
+    {
+        ntp::metrics::details::CallbackScope scope { MetricsOf(context) };
+        context->callback->Call(instance, &tick);
+    }
+    catch (...)
+    {
+        resume();
+        throw;
+    }
+
+    resume();
+}
+
+/* static */
+void TimerManager::StopInternal(object_context_t& object_context) noexcept
+{
+    if (const auto precise = object_context.timer_precise.get())
+    {
+        std::lock_guard lock { precise->lock };
+        precise->stopped = true;
+    }
+}
+
 /* static */
 void TimerManager::CloseInternal(native_handle_t native_handle) noexcept
 {
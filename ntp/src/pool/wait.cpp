@@ -1,3 +1,5 @@
+#include <thread>
+
 #include "pool/wait.hpp"
 #include "details/utils.hpp"
 #include "logger/logger_internal.hpp"
@@ -7,8 +9,232 @@ namespace ntp::wait::details {
 
 WaitManager::WaitManager(PTP_CALLBACK_ENVIRON environment)
     : BasicManager(environment)
+    , groups_()
+    , group_cleanups_(0)
 { }
 
+WaitManager::~WaitManager()
+{
+    CancelAllGroups();
+
+    while (group_cleanups_.load(std::memory_order_acquire) != 0)
+    {
+        std::this_thread::yield();
+    }
+}
+
+void WaitManager::CancelGroup(group_handle_t group) noexcept
+{
+    groups_.Erase(group, [this](std::unique_ptr<WaitGroup>& erased) {
+        CloseGroup(*erased);
+        metrics_.Cancelled(erased->pending.load(std::memory_order_acquire));
+    });
+}
+
+void WaitManager::CancelAllGroups() noexcept
+{
+    groups_.Clear([this](group_handle_t /* group */, std::unique_ptr<WaitGroup>& erased) {
+        CloseGroup(*erased);
+        metrics_.Cancelled(erased->pending.load(std::memory_order_acquire));
+    });
+}
+
+ntp::metrics::ManagerMetrics WaitManager::CollectMetrics() const
+{
+    auto metrics = BasicManager::CollectMetrics();
+    metrics.live_objects += groups_.Size();
+
+    return metrics;
+}
+
+WaitManager::group_handle_t WaitManager::SubmitGroupInternal(std::unique_ptr<WaitGroup>&& group)
+{
+    const auto count = group->wait_handles.size();
+
+    group->waits.reserve(count);
+    group->members.reserve(count);
+    group->manager = this;
+    group->pending.store(count, std::memory_order_relaxed);
+
+    //
+    // Wait objects are created before the group becomes visible, so that
+    // creation failure is reported without touching the container
+    //
+
+    for (std::size_t index = 0; index < count; ++index)
+    {
+        group->members.push_back(WaitGroupMember { group.get(), index });
+
+        const auto native_handle = CreateThreadpoolWait(reinterpret_cast<PTP_WAIT_CALLBACK>(InvokeGroupCallback),
+            &group->members.back(), Environment());
+
+        if (!native_handle)
+        {
+            const auto error = GetLastError();
+            CloseGroup(*group);
+
+            throw exception::Win32Exception(error);
+        }
+
+        group->waits.push_back(native_handle);
+    }
+
+    //
+    // Waits are set under container's lock: if some of them completes immediately,
+    // its callback cannot remove the group before all waits are set
+    //
+
+    const auto handle = group.get();
+
+    groups_.Insert(handle, std::move(group), [](std::unique_ptr<WaitGroup>& inserted) {
+        SetGroupWaits(*inserted, true);
+    });
+
+    metrics_.Submitted(count);
+
+    return handle;
+}
+
+/* static */
+void WaitManager::SetGroupWaits(WaitGroup& group, bool set) noexcept
+{
+    PFILETIME wait_timeout = (group.wait_timeout.has_value())
+                               ? &group.wait_timeout.value()
+                               : nullptr;
+
+#if defined(NTP_PLATFORM_LINUX)
+    //
+    // Native engine registers a batch of waits during a single lock of its reactor
+    //
+
+    ntp::details::SafeThreadpoolCall<SetThreadpoolWaits>(group.waits.data(),
+        set ? group.wait_handles.data() : nullptr, static_cast<DWORD>(group.waits.size()), wait_timeout);
+#else  // !NTP_PLATFORM_LINUX
+    for (std::size_t index = 0; index < group.waits.size(); ++index)
+    {
+        ntp::details::SafeThreadpoolCall<SetThreadpoolWait>(group.waits[index],
+            set ? group.wait_handles[index] : nullptr, set ? wait_timeout : nullptr);
+    }
+#endif  // NTP_PLATFORM_LINUX
+}
+
+/* static */
+void WaitManager::CloseGroup(WaitGroup& group) noexcept
+{
+    {
+        std::lock_guard lock { group.wait_lock };
+        group.wait_stopped = true;
+    }
+
+    //
+    // All waits are reset first, so that no new callbacks are
+    // queued, while the rest of wait objects are being closed
+    //
+
+    SetGroupWaits(group, false);
+
+    for (const auto native_handle : group.waits)
+    {
+        ntp::details::SafeThreadpoolCall<WaitForThreadpoolWaitCallbacks>(native_handle, TRUE);
+        ntp::details::SafeThreadpoolCall<CloseThreadpoolWait>(native_handle);
+    }
+
+    group.waits.clear();
+}
+
+/* static */
+void NTAPI WaitManager::InvokeGroupCallback(PTP_CALLBACK_INSTANCE instance, WaitGroupMember* member, PTP_WAIT wait, TP_WAIT_RESULT wait_result) noexcept
+{
+    try
+    {
+        if (!member)
+        {
+            throw exception::Win32Exception(ERROR_INVALID_PARAMETER);
+        }
+
+        auto& group = *member->group;
+
+        WaitGroupParameter parameter { group.wait_handles[member->index], wait_result, WaitAction::kComplete };
+
+        //
+        // Member, whose callback has thrown, is counted as completed,
+        // otherwise the group would stay alive until it is cancelled
+        //
+
+        const auto complete = [instance, member]() {
+            auto& group = *member->group;
+
+            if (group.pending.fetch_sub(1, std::memory_order_acq_rel) != 1)
+            {
+                //
+                // Other waits of the group are still pending, the last
+                // completed one removes the group
+                //
+
+                return;
+            }
+
+            //
+            // The same as BasicManager::CleanupContext: callback is disassociated from its
+            // object (canceller must not wait for it), and then group is removed by value
+            //
+
+            const auto manager = group.manager;
+            const auto handle  = member->group;
+
+            manager->group_cleanups_.fetch_add(1, std::memory_order_relaxed);
+
+            DisassociateCurrentThreadFromCallback(instance);
+            manager->CancelGroup(handle);
+
+            //
+            // Manager must not be touched after this point
+            //
+
+            manager->group_cleanups_.fetch_sub(1, std::memory_order_release);
+        };
+
+        try
+        {
+            ntp::metrics::details::CallbackScope scope { group.manager->metrics_ };
+            group.callback->Call(instance, &parameter);
+        }
+        catch (...)
+        {
+            complete();
+            throw;
+        }
+
+        if (parameter.action == WaitAction::kRearm)
+        {
+            std::lock_guard lock { group.wait_lock };
+
+            if (!group.wait_stopped)
+            {
+                PFILETIME wait_timeout = (group.wait_timeout.has_value())
+                                           ? &group.wait_timeout.value()
+                                           : nullptr;
+
+                ntp::details::SafeThreadpoolCall<SetThreadpoolWait>(wait, parameter.wait_handle, wait_timeout);
+            }
+
+            return;
+        }
+
+        complete();
+    }
+    catch (const std::exception& error)
+    {
+        logger::details::Logger::Instance().TraceMessage(logger::Severity::kError, "%1", error.what());
+    }
+    catch (...)
+    {
+        logger::details::Logger::Instance().TraceMessage(logger::Severity::kCritical,
+            L"[WaitManager::InvokeGroupCallback]: unknown error");
+    }
+}
+
+/* static */
 void WaitManager::SubmitInternal(native_handle_t native_handle, object_context_t& object_context) noexcept
 {
     PFILETIME wait_timeout = (object_context.wait_timeout.has_value())
@@ -34,7 +260,30 @@ void NTAPI WaitManager::InvokeCallback(PTP_CALLBACK_INSTANCE instance, context_p
         // Probably need to implement something like std::async here
         //
 
-        context->callback->Call(instance, &wait_result);
+        WaitParameter parameter { wait_result, WaitAction::kComplete };
+
+        {
+            ntp::metrics::details::CallbackScope scope { MetricsOf(context) };
+            context->callback->Call(instance, &parameter);
+        }
+
+        if (parameter.action == WaitAction::kRearm)
+        {
+            //
+            // Persistent wait object is reused. If it is being cancelled
+            // right now, canceller closes it, so nothing to do here.
+            //
+
+            auto& object_context = context->object_context;
+            std::lock_guard lock { object_context.wait_lock };
+
+            if (!object_context.wait_stopped)
+            {
+                SubmitInternal(wait, object_context);
+            }
+
+            return;
+        }
 
         //
         // Clean object here
@@ -44,7 +293,7 @@ void NTAPI WaitManager::InvokeCallback(PTP_CALLBACK_INSTANCE instance, context_p
     }
     catch (const std::exception& error)
     {
-        logger::details::Logger::Instance().TraceMessage(logger::Severity::kError, error.what());
+        logger::details::Logger::Instance().TraceMessage(logger::Severity::kError, "%1", error.what());
     }
     catch (...)
     {
@@ -53,6 +302,13 @@ void NTAPI WaitManager::InvokeCallback(PTP_CALLBACK_INSTANCE instance, context_p
     }
 }
 
+/* static */
+void WaitManager::StopInternal(object_context_t& object_context) noexcept
+{
+    std::lock_guard lock { object_context.wait_lock };
+    object_context.wait_stopped = true;
+}
+
 /* static */
 void WaitManager::CloseInternal(native_handle_t native_handle) noexcept
 {
@@ -1,3 +1,6 @@
+#include <chrono>
+#include <thread>
+
 #include "pool/work.hpp"
 #include "details/exception.hpp"
 #include "logger/logger_internal.hpp"
@@ -9,10 +12,15 @@ WorkManager::WorkManager(PTP_CALLBACK_ENVIRON environment)
     : BasicManager(environment)
     , queue_()
     , work_()
-    , done_event_(TRUE, FALSE)
+    , max_workers_((std::max)(std::thread::hardware_concurrency(), 1u))
+    , cancelling_(false)
+    , outstanding_(0)
+    , waiters_(0)
+    , done_lock_()
+    , done_condition_()
 {
     work_ = CreateThreadpoolWork(reinterpret_cast<PTP_WORK_CALLBACK>(InvokeCallback),
-        static_cast<PSLIST_HEADER>(queue_), Environment());
+        this, Environment());
 
     if (!work_)
     {
@@ -22,43 +30,39 @@ WorkManager::WorkManager(PTP_CALLBACK_ENVIRON environment)
 
 bool WorkManager::WaitAll(const ntp::details::test_cancel_t& test_cancel) noexcept
 {
-    //
-    // Suppose we have something working...
-    //
-
-    done_event_.Reset();
-
-    //
-    // Now try to submit waiting callback
-    //
+    const auto completed = [this]() { return !outstanding_.load(std::memory_order_acquire); };
 
-    const auto submitted = TrySubmitThreadpoolCallback(
-        reinterpret_cast<PTP_SIMPLE_CALLBACK>(WaitAllCallback), this, Environment());
-
-    if /* [[unlikely]] */ (!submitted)
+    if (completed())
     {
-        logger::details::Logger::Instance().TraceMessage(logger::Severity::kError,
-            L"[WorkManager::WaitAll]: cannot wait in separate thread, waiting in current one, cancellation is unavailable");
-
-        ntp::details::SafeThreadpoolCall<WaitForThreadpoolWorkCallbacks>(work_, FALSE);
-        done_event_.Set();
+        return true;
     }
 
     //
-    // And... Wait for everithing to complete :)
+    // Waiter is registered before the counter is checked under the lock,
+    // therefore the last completed callback either notifies it or is
+    // observed by the check (notification is performed under the lock)
     //
 
     bool cancelled = false;
 
-    while (WAIT_TIMEOUT == WaitForSingleObject(done_event_, ntp::details::kTestCancelTimeout))
+    waiters_.fetch_add(1, std::memory_order_seq_cst);
+
+    for (std::unique_lock lock { done_lock_ };
+         !done_condition_.wait_for(lock, std::chrono::milliseconds(ntp::details::kTestCancelTimeout), completed);)
     {
-        if (test_cancel())
+        if (!cancelled && test_cancel())
         {
+            lock.unlock();
+
             CancelAll();
             cancelled = true;
+
+            lock.lock();
         }
     }
 
+    waiters_.fetch_sub(1, std::memory_order_relaxed);
+
     logger::details::Logger::Instance().TraceMessage(logger::Severity::kExtended,
         L"[WorkManager::WaitAll]: wait completed");
 
@@ -67,84 +71,215 @@ bool WorkManager::WaitAll(const ntp::details::test_cancel_t& test_cancel) noexce
 
 void WorkManager::CancelAll() noexcept
 {
+    //
+    // Running invocations drain the queue, so they must
+    // stop after current callback
+    //
+
+    cancelling_.store(true, std::memory_order_release);
+
     ntp::details::SafeThreadpoolCall<WaitForThreadpoolWorkCallbacks>(work_, TRUE);
-    done_event_.Set();
 
     size_t left_unprocessed = ClearList();
-    logger::details::Logger::Instance().TraceMessage(logger::Severity::kNormal,
-        L"[WorkManager::CancelAll]: tasks cancelled and %1!zu! left unprocessed", left_unprocessed);
-}
+    Complete(left_unprocessed);
 
-size_t WorkManager::ClearList() noexcept
-{
-    PSLIST_ENTRY entry = nullptr;
-    size_t entries     = 0;
+    metrics_.Cancelled(left_unprocessed);
 
-    for (entry = InterlockedPopEntrySList(queue_); entry;
-         entry = InterlockedPopEntrySList(queue_), ++entries)
+    cancelling_.store(false, std::memory_order_release);
+
+    //
+    // Callbacks could be submitted concurrently after the queue was cleared,
+    // but their invocations might be cancelled, so submit them again
+    //
+
+    SubmitWorkers(queue_.Size());
+
+    //
+    // Pool is cancelled on every destruction, so
+    // only cancellation of pending callbacks is worth tracing
+    //
+
+    if (left_unprocessed)
     {
-        delete static_cast<ntp::details::ICallback*>(entry);
+        logger::details::Logger::Instance().TraceMessage(logger::Severity::kNormal,
+            L"[WorkManager::CancelAll]: tasks cancelled and %1!zu! left unprocessed", left_unprocessed);
     }
+}
 
-    return entries;
+ntp::metrics::ManagerMetrics WorkManager::CollectMetrics() const noexcept
+{
+    auto metrics         = metrics_.Collect();
+    metrics.queue_depth  = queue_.Size();
+    metrics.live_objects = outstanding_.load(std::memory_order_relaxed);
+
+    return metrics;
 }
 
 /* static */
-void NTAPI WorkManager::InvokeCallback(PTP_CALLBACK_INSTANCE instance, PSLIST_HEADER queue, PTP_WORK work) noexcept
+void WorkManager::ThrowPushFailure(ntp::details::PushResult result)
 {
-    try
-    {
-        if (!queue)
-        {
-            throw exception::Win32Exception(ERROR_INVALID_PARAMETER);
-        }
+    //
+    // Full queue is reported separately: caller may retry,
+    // when callbacks are invoked
+    //
+
+    throw exception::Win32Exception(result == ntp::details::PushResult::kFull
+        ? ERROR_TOO_MANY_POSTS : ERROR_NOT_ENOUGH_MEMORY);
+}
 
-        auto entry = InterlockedPopEntrySList(queue);
-        if (!entry)
+size_t WorkManager::ClearList() noexcept
+{
+    size_t entries = 0;
+
+    while (queue_.TryConsume([&entries](QueuedCallback& queued) noexcept {
+        if (queued.callback)
         {
-            throw exception::Win32Exception(ERROR_NO_MORE_ITEMS);
+            queued.callback.Reset();
+            ++entries;
         }
+    }))
+    { }
 
-        ntp::details::callback_t(
-            static_cast<ntp::details::ICallback*>(entry))
-            ->Call(instance, nullptr);
+    return entries;
+}
+
+void WorkManager::SubmitWorkers(size_t callbacks) noexcept
+{
+    //
+    // Every invocation drains the queue, so it makes no sense
+    // to wake up more threads than the system has processors
+    //
+
+    const auto workers = (std::min)(callbacks, max_workers_);
+
+    for (size_t worker = 0; worker < workers; ++worker)
+    {
+        ntp::details::SafeThreadpoolCall<SubmitThreadpoolWork>(work_);
     }
-    catch (const std::exception& error)
+}
+
+void WorkManager::Complete(size_t callbacks) noexcept
+{
+    if (!callbacks)
     {
-        logger::details::Logger::Instance().TraceMessage(logger::Severity::kError, error.what());
+        return;
     }
-    catch (...)
+
+    if (outstanding_.fetch_sub(callbacks, std::memory_order_seq_cst) == callbacks &&
+        waiters_.load(std::memory_order_seq_cst))
     {
-        logger::details::Logger::Instance().TraceMessage(logger::Severity::kCritical,
-            L"[WorkManager::InvokeCallback]: unknown error");
+        //
+        // Lock is acquired to be sure, that waiter either already sleeps
+        // or has not checked the counter yet
+        //
+
+        {
+            std::lock_guard lock { done_lock_ };
+        }
+
+        done_condition_.notify_all();
     }
 }
 
-/* static */
-void CALLBACK WorkManager::WaitAllCallback(PTP_CALLBACK_INSTANCE instance, WorkManager* self) noexcept
+void WorkManager::InvokePending(PTP_CALLBACK_INSTANCE instance, bool& instance_used)
 {
-    logger::details::Logger::Instance().TraceMessage(logger::Severity::kExtended,
-        L"[WorkManager::WaitAllCallback]: wait started");
+    //
+    // Slot may be empty, if callback construction has thrown
+    // in Submit or SubmitBatch, so just skip such slots
+    //
 
-    if (self)
-    {
-        ntp::details::SafeThreadpoolCall<SetEventWhenCallbackReturns>(instance, self->done_event_);
-        ntp::details::SafeThreadpoolCall<CallbackMayRunLong>(instance);
+    const auto consume = [this, instance, &instance_used](QueuedCallback& queued) {
+        auto& callback = queued.callback;
+
+        if (!callback)
+        {
+            return;
+        }
 
         //
-        // And now I wait for callbacks
+        // Callback is completed only after its destruction, because
+        // it may hold references to objects, that are valid until
+        // WaitAll returns
         //
 
-        ntp::details::SafeThreadpoolCall<WaitForThreadpoolWorkCallbacks>(self->work_, FALSE);
-    }
-    else
+        try
+        {
+            ntp::metrics::details::CallbackScope scope { metrics_, queued.enqueued };
+            callback->Call(instance, &instance_used);
+        }
+        catch (...)
+        {
+            callback.Reset();
+            Complete(1);
+
+            throw;
+        }
+
+        callback.Reset();
+        Complete(1);
+    };
+
+    //
+    // Callback could change the instance state (e.g. call SetEventWhenCallbackReturns
+    // or CallbackMayRunLong), so the rest of callbacks must be executed in
+    // another invocation. Queue is drained until it is actually empty: its
+    // size counts callbacks, that are not published yet.
+    //
+
+    while (!instance_used && !cancelling_.load(std::memory_order_acquire) && queue_.TryConsume(consume))
+    { }
+}
+
+/* static */
+void NTAPI WorkManager::InvokeCallback(PTP_CALLBACK_INSTANCE instance, WorkManager* self, PTP_WORK work) noexcept
+{
+    if (!self)
     {
         logger::details::Logger::Instance().TraceMessage(logger::Severity::kError,
-            L"[WorkManager::WaitAllCallback]: pointer to manager is NULL");
+            L"[WorkManager::InvokeCallback]: pointer to manager is NULL");
+
+        return;
     }
 
-    logger::details::Logger::Instance().TraceMessage(logger::Severity::kExtended,
-        L"[WorkManager::WaitAllCallback]: wait finished");
+    //
+    // Every invocation drains the queue (that may become
+    // empty, because other invocations drain it too)
+    //
+
+    bool instance_used = false;
+
+    for (bool drained = false; !drained;)
+    {
+        try
+        {
+            //
+            // Returns normally only when the queue is drained, cancellation
+            // is requested or callback has used the instance
+            //
+
+            self->InvokePending(instance, instance_used);
+            drained = true;
+        }
+        catch (const std::exception& error)
+        {
+            logger::details::Logger::Instance().TraceMessage(logger::Severity::kError, "%1", error.what());
+        }
+        catch (...)
+        {
+            logger::details::Logger::Instance().TraceMessage(logger::Severity::kCritical,
+                L"[WorkManager::InvokeCallback]: unknown error");
+        }
+    }
+
+    //
+    // Only a consumed callback can use the instance, the rest of the queue (if any)
+    // is drained by another invocation, that returns at once if the queue is empty
+    //
+
+    if (instance_used)
+    {
+        ntp::details::SafeThreadpoolCall<SubmitThreadpoolWork>(work);
+    }
 }
 
 }  // namespace ntp::work::details
@@ -0,0 +1,152 @@
+#include "test_config.hpp"
+
+namespace {
+
+using ntp::allocator::SlabAllocator;
+
+bool IsAligned(void* ptr, size_t alignment)
+{
+    return reinterpret_cast<std::uintptr_t>(ptr) % alignment == 0;
+}
+
+}  // namespace
+
+TEST(SlabAllocator, SizeClasses)
+{
+    static constexpr std::array<size_t, 9> kSizes = { 1, 16, 32, 33, 100, 256, 511, 1000, 1024 };
+
+    std::vector<void*> blocks;
+
+    for (const auto size : kSizes)
+    {
+        const auto block = SlabAllocator::AllocateBytes(size);
+
+        EXPECT_TRUE(IsAligned(block, SlabAllocator::kBlockAlignment));
+        std::memset(block, 0xcc, size);
+
+        blocks.push_back(block);
+    }
+
+    for (size_t i = 0; i < kSizes.size(); ++i)
+    {
+        SlabAllocator::Free(blocks[i], kSizes[i]);
+    }
+}
+
+TEST(SlabAllocator, CacheHits)
+{
+    static constexpr auto kAllocations = 1000;
+    static constexpr auto kSize        = 64;
+
+    //
+    // Warm up thread-local cache
+    //
+
+    SlabAllocator::Free(SlabAllocator::AllocateBytes(kSize), kSize);
+
+    const auto before = SlabAllocator::Statistics();
+
+    for (auto i = 0; i < kAllocations; ++i)
+    {
+        SlabAllocator::Free(SlabAllocator::AllocateBytes(kSize), kSize);
+    }
+
+    const auto after = SlabAllocator::Statistics();
+
+    EXPECT_EQ(after.allocations - before.allocations, kAllocations);
+    EXPECT_EQ(after.cache_hits - before.cache_hits, kAllocations);
+    EXPECT_EQ(after.frees - before.frees, kAllocations);
+}
+
+TEST(SlabAllocator, BlocksReuse)
+{
+    static constexpr auto kSize = 128;
+
+    const auto first = SlabAllocator::AllocateBytes(kSize);
+    SlabAllocator::Free(first, kSize);
+
+    const auto second = SlabAllocator::AllocateBytes(kSize);
+    SlabAllocator::Free(second, kSize);
+
+    EXPECT_EQ(first, second);
+}
+
+TEST(SlabAllocator, LargeBlocks)
+{
+    static constexpr auto kSize = SlabAllocator::kMaxBlockSize + 1;
+
+    const auto before = SlabAllocator::Statistics();
+
+    const auto block = SlabAllocator::AllocateBytes(kSize);
+    EXPECT_TRUE(IsAligned(block, SlabAllocator::kBlockAlignment));
+
+    std::memset(block, 0xcc, kSize);
+    SlabAllocator::Free(block, kSize);
+
+    const auto after = SlabAllocator::Statistics();
+
+    EXPECT_EQ(after.large_allocations - before.large_allocations, 1);
+    EXPECT_EQ(after.allocations, before.allocations);
+}
+
+TEST(SlabAllocator, CrossThreadFree)
+{
+    //
+    // Blocks are allocated in one thread and freed in another one,
+    // so they have to travel through depot
+    //
+
+    static constexpr auto kBlocks = 10000;
+    static constexpr auto kSize   = 48;
+
+    std::vector<void*> blocks;
+
+    for (auto round = 0; round < 3; ++round)
+    {
+        for (auto i = 0; i < kBlocks; ++i)
+        {
+            const auto block = SlabAllocator::AllocateBytes(kSize);
+            *static_cast<int*>(block) = i;
+
+            blocks.push_back(block);
+        }
+
+        std::thread([&blocks]() {
+            for (auto i = 0; i < kBlocks; ++i)
+            {
+                EXPECT_EQ(*static_cast<int*>(blocks[i]), i);
+                SlabAllocator::Free(blocks[i], kSize);
+            }
+        }).join();
+
+        blocks.clear();
+    }
+
+    const auto statistics = SlabAllocator::Statistics();
+
+    EXPECT_GT(statistics.depot_hits, 0);
+    EXPECT_GT(statistics.HitRate(), 0.0);
+}
+
+TEST(SlabAllocator, Callbacks)
+{
+    struct alignas(64) OverAligned
+    {
+        void operator()(std::atomic_int& counter) { counter++; }
+    };
+
+    static constexpr auto kWorkers = 100;
+
+    std::atomic_int counter = 0;
+    ntp::SystemThreadPool pool;
+
+    for (auto i = 0; i < kWorkers; ++i)
+    {
+        pool.SubmitWork([](std::atomic_int& counter) { counter++; }, std::ref(counter));
+        pool.SubmitWork(OverAligned {}, std::ref(counter));
+    }
+
+    pool.WaitWorks();
+
+    EXPECT_EQ(counter, 2 * kWorkers);
+}
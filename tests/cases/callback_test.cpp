@@ -0,0 +1,223 @@
+#include "test_config.hpp"
+
+namespace {
+
+/**
+ * @brief Counts constructed and destroyed instances.
+ */
+struct Counted
+{
+    static inline int alive = 0;
+
+    Counted() noexcept { ++alive; }
+    Counted(const Counted&) noexcept { ++alive; }
+    ~Counted() { --alive; }
+};
+
+/**
+ * @brief Minimal ICallback implementation with arbitrary payload size.
+ */
+template<size_t PayloadSize>
+struct TestCallback final
+    : ntp::details::ICallback
+{
+    explicit TestCallback(int& calls) noexcept
+        : calls(calls)
+    { }
+
+    void Call(PTP_CALLBACK_INSTANCE, void*) override { ++calls; }
+
+    int& calls;
+    Counted counted;
+    std::array<char, PayloadSize> payload {};
+};
+
+using SmallCallback = TestCallback<8>;
+using LargeCallback = TestCallback<NTP_INLINE_CALLBACK_SIZE>;
+
+}  // namespace
+
+TEST(InlineCallback, Small)
+{
+    static_assert(ntp::details::callback_t::is_inline_v<SmallCallback>);
+
+    int calls = 0;
+
+    {
+        ntp::details::callback_t callback;
+        EXPECT_FALSE(callback);
+
+        callback.Emplace<SmallCallback>(calls);
+        EXPECT_TRUE(callback);
+        EXPECT_TRUE(callback.IsInline());
+        EXPECT_EQ(Counted::alive, 1);
+
+        callback->Call(nullptr, nullptr);
+        EXPECT_EQ(calls, 1);
+    }
+
+    EXPECT_EQ(Counted::alive, 0);
+}
+
+TEST(InlineCallback, Large)
+{
+    static_assert(!ntp::details::callback_t::is_inline_v<LargeCallback>);
+
+    int calls = 0;
+
+    {
+        ntp::details::callback_t callback;
+
+        callback.Emplace<LargeCallback>(calls);
+        EXPECT_TRUE(callback);
+        EXPECT_FALSE(callback.IsInline());
+        EXPECT_EQ(Counted::alive, 1);
+
+        callback->Call(nullptr, nullptr);
+        EXPECT_EQ(calls, 1);
+    }
+
+    EXPECT_EQ(Counted::alive, 0);
+}
+
+TEST(InlineCallback, Replace)
+{
+    int calls = 0;
+
+    ntp::details::callback_t callback;
+
+    callback.Emplace<LargeCallback>(calls);
+    callback.Emplace<SmallCallback>(calls);
+    EXPECT_TRUE(callback.IsInline());
+    EXPECT_EQ(Counted::alive, 1);
+
+    callback.Reset();
+    EXPECT_FALSE(callback);
+    EXPECT_EQ(Counted::alive, 0);
+}
+
+TEST(InlineCallback, LargeWork)
+{
+    static constexpr auto kWorkers = 50;
+
+    //
+    // Callback with large state is allocated on heap
+    //
+
+    std::array<int, 64> state {};
+    state.fill(1);
+
+    std::atomic_int counter = 0;
+    ntp::SystemThreadPool pool;
+
+    for (auto i = 0; i < kWorkers; ++i)
+    {
+        pool.SubmitWork([state, &counter]() {
+            counter += state.back();
+        });
+    }
+
+    pool.WaitWorks();
+
+    EXPECT_EQ(counter, kWorkers);
+}
+
+namespace {
+
+/**
+ * @brief Counts copies of itself.
+ */
+struct CopyCounter
+{
+    CopyCounter(std::atomic_int& copies) noexcept
+        : copies(&copies)
+    { }
+
+    CopyCounter(const CopyCounter& other) noexcept
+        : copies(other.copies)
+    {
+        ++*copies;
+    }
+
+    CopyCounter(CopyCounter&& other) noexcept = default;
+
+    std::atomic_int* copies;
+};
+
+}  // namespace
+
+TEST(Invocation, MoveOnlyWork)
+{
+    std::atomic_int result = 0;
+    ntp::SystemThreadPool pool;
+
+    auto value = std::make_unique<int>(42);
+
+    pool.SubmitWork([owned = std::make_unique<int>(1)](std::unique_ptr<int> value, std::atomic_int& result) {
+        result = *value + *owned;
+    }, std::move(value), std::ref(result));
+
+    pool.WaitWorks();
+
+    EXPECT_EQ(result, 43);
+}
+
+TEST(Invocation, MoveOnlyWait)
+{
+    using namespace std::chrono_literals;
+
+    std::atomic_int result = 0;
+    ntp::details::Event event(TRUE, TRUE);
+    ntp::SystemThreadPool pool;
+
+    pool.SubmitWait(event, [&result](TP_WAIT_RESULT, std::unique_ptr<int> value) {
+        result = *value;
+    }, std::make_unique<int>(42));
+
+    std::this_thread::sleep_for(40ms);
+
+    EXPECT_EQ(result, 42);
+}
+
+TEST(Invocation, NoCopies)
+{
+    using namespace std::chrono_literals;
+
+    std::atomic_int copies = 0;
+    std::atomic_int calls  = 0;
+
+    {
+        ntp::SystemThreadPool pool;
+
+        pool.SubmitWork([&calls](const CopyCounter&) { ++calls; }, CopyCounter(copies));
+        pool.SubmitWork([&calls](CopyCounter) { ++calls; }, CopyCounter(copies));
+        pool.WaitWorks();
+
+        pool.SubmitTimer(1ms, 1ms, [&calls](const CopyCounter&) { ++calls; }, CopyCounter(copies));
+        std::this_thread::sleep_for(40ms);
+    }
+
+    EXPECT_GT(calls, 3);
+    EXPECT_EQ(copies, 0);
+}
+
+TEST(Invocation, PeriodicState)
+{
+    using namespace std::chrono_literals;
+
+    //
+    // Periodic timer receives its stored arguments by
+    // reference, so it can keep state between calls
+    //
+
+    std::atomic_int last = 0;
+
+    {
+        ntp::SystemThreadPool pool;
+
+        pool.SubmitTimer(1ms, 1ms, [&last](int& ticks) { last = ++ticks; }, 0);
+        std::this_thread::sleep_for(40ms);
+    }
+
+    EXPECT_GT(last, 1);
+}
@@ -0,0 +1,93 @@
+#include "test_config.hpp"
+#include "details/coalescing.hpp"
+
+namespace {
+
+using time_point_t = std::chrono::steady_clock::time_point;
+using queue_t      = ntp::details::CoalescingQueue<time_point_t, int>;
+
+}  // namespace
+
+
+TEST(Coalescing, WithoutTolerance)
+{
+    using namespace std::chrono_literals;
+
+    const time_point_t now {};
+    queue_t queue;
+
+    queue.Insert(now + 30ms, 0ms, 3);
+    queue.Insert(now + 10ms, 0ms, 1);
+    queue.Insert(now + 20ms, 0ms, 2);
+
+    EXPECT_EQ(queue.Wakeup(), now + 10ms);
+
+    std::vector<int> expired;
+    const auto collect = [&expired](time_point_t, int value) { expired.push_back(value); };
+
+    EXPECT_EQ(queue.Expire(now + 10ms, collect), 1);
+    EXPECT_EQ(queue.Wakeup(), now + 20ms);
+
+    EXPECT_EQ(queue.Expire(now + 30ms, collect), 2);
+    EXPECT_TRUE(queue.Empty());
+
+    EXPECT_EQ(expired, (std::vector<int> { 1, 2, 3 }));
+}
+
+TEST(Coalescing, OverlappingWindows)
+{
+    using namespace std::chrono_literals;
+
+    const time_point_t now {};
+    queue_t queue;
+
+    //
+    // Windows: [10, 40], [20, 30], [25, 60], [50, 50]
+    // The first wakeup is at 30 and expires three timers at once
+    //
+
+    queue.Insert(now + 10ms, 30ms, 1);
+    queue.Insert(now + 20ms, 10ms, 2);
+    queue.Insert(now + 25ms, 35ms, 3);
+    queue.Insert(now + 50ms, 0ms, 4);
+
+    EXPECT_EQ(queue.Wakeup(), now + 30ms);
+
+    std::vector<int> expired;
+    EXPECT_EQ(queue.Expire(queue.Wakeup(), [&expired](time_point_t, int value) { expired.push_back(value); }), 3);
+    EXPECT_EQ(expired, (std::vector<int> { 1, 2, 3 }));
+
+    EXPECT_EQ(queue.Size(), 1);
+    EXPECT_EQ(queue.Wakeup(), now + 50ms);
+}
+
+TEST(Coalescing, Erase)
+{
+    using namespace std::chrono_literals;
+
+    const time_point_t now {};
+    queue_t queue;
+
+    const auto first = queue.Insert(now + 10ms, 5ms, 1);
+    queue.Insert(now + 20ms, 5ms, 2);
+
+    EXPECT_EQ(queue.Wakeup(), now + 15ms);
+
+    queue.Erase(first);
+    EXPECT_EQ(queue.Wakeup(), now + 25ms);
+
+    //
+    // Expired callback may insert new items
+    //
+
+    auto rearmed = 0;
+    queue.Expire(now + 25ms, [&queue, &rearmed](time_point_t due, int value) {
+        if (!rearmed++)
+        {
+            queue.Insert(due + 100ms, 0ms, value);
+        }
+    });
+
+    EXPECT_EQ(rearmed, 1);
+    EXPECT_EQ(queue.Wakeup(), now + 120ms);
+}
@@ -0,0 +1,113 @@
+#include "test_config.hpp"
+
+#if defined(NTP_HAS_COROUTINES)
+
+namespace {
+
+ntp::coroutine::Task<std::thread::id> ScheduledThread(ntp::SystemThreadPool& pool)
+{
+    co_await ntp::coroutine::Schedule(pool);
+    co_return std::this_thread::get_id();
+}
+
+ntp::coroutine::Task<int> Nested(ntp::SystemThreadPool& pool, int value)
+{
+    co_await ntp::coroutine::Schedule(pool);
+    co_return value * 2;
+}
+
+ntp::coroutine::Task<int> Outer(ntp::SystemThreadPool& pool)
+{
+    const auto first  = co_await Nested(pool, 1);
+    const auto second = co_await Nested(pool, 20);
+
+    co_return first + second;
+}
+
+ntp::coroutine::Task<> Throwing(ntp::SystemThreadPool& pool)
+{
+    co_await ntp::coroutine::Schedule(pool);
+    throw std::runtime_error("coroutine error");
+}
+
+ntp::coroutine::Task<std::chrono::steady_clock::duration> Sleeping(ntp::SystemThreadPool& pool, std::chrono::milliseconds timeout)
+{
+    const auto start = std::chrono::steady_clock::now();
+    co_await ntp::coroutine::Sleep(pool, timeout);
+
+    co_return std::chrono::steady_clock::now() - start;
+}
+
+ntp::coroutine::Task<TP_WAIT_RESULT> Waiting(ntp::SystemThreadPool& pool, HANDLE handle, std::chrono::milliseconds timeout)
+{
+    co_return co_await ntp::coroutine::WaitFor(pool, handle, timeout);
+}
+
+}  // namespace
+
+
+TEST(Coroutine, Schedule)
+{
+    ntp::SystemThreadPool pool;
+
+    const auto thread = ntp::coroutine::SyncWait(ScheduledThread(pool));
+    EXPECT_NE(thread, std::this_thread::get_id());
+}
+
+TEST(Coroutine, Nested)
+{
+    ntp::SystemThreadPool pool;
+    EXPECT_EQ(ntp::coroutine::SyncWait(Outer(pool)), 42);
+}
+
+TEST(Coroutine, Exception)
+{
+    ntp::SystemThreadPool pool;
+    EXPECT_THROW(ntp::coroutine::SyncWait(Throwing(pool)), std::runtime_error);
+}
+
+TEST(Coroutine, Sleep)
+{
+    using namespace std::chrono_literals;
+
+    ntp::SystemThreadPool pool;
+
+    const auto elapsed = ntp::coroutine::SyncWait(Sleeping(pool, 50ms));
+    EXPECT_GE(elapsed, 45ms);
+}
+
+TEST(Coroutine, WaitFor)
+{
+    using namespace std::chrono_literals;
+
+    ntp::details::Event event(TRUE, TRUE);
+    ntp::SystemThreadPool pool;
+
+    EXPECT_EQ(ntp::coroutine::SyncWait(Waiting(pool, event, 10s)), WAIT_OBJECT_0);
+
+    event.Reset();
+
+    EXPECT_EQ(ntp::coroutine::SyncWait(Waiting(pool, event, 20ms)), WAIT_TIMEOUT);
+}
+
+TEST(Coroutine, Many)
+{
+    static constexpr auto kCoroutines = 100;
+
+    ntp::SystemThreadPool pool;
+
+    const auto fan_out = [](ntp::SystemThreadPool& pool) -> ntp::coroutine::Task<int> {
+        int sum = 0;
+
+        for (auto i = 0; i < kCoroutines; ++i)
+        {
+            sum += co_await Nested(pool, 1);
+        }
+
+        co_return sum;
+    };
+
+    EXPECT_EQ(ntp::coroutine::SyncWait(fan_out(pool)), 2 * kCoroutines);
+}
+
+#endif  // NTP_HAS_COROUTINES
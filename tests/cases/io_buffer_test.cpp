@@ -0,0 +1,127 @@
+#include "test_config.hpp"
+
+namespace {
+
+using ntp::io::IoBufferPool;
+using ntp::io::IoOperation;
+
+bool IsAligned(const void* ptr, size_t alignment)
+{
+    return reinterpret_cast<std::uintptr_t>(ptr) % alignment == 0;
+}
+
+}  // namespace
+
+TEST(IoBufferPool, Alignment)
+{
+    static constexpr std::array<size_t, 7> kSizes = { 1, 4096, 4097, 10000, 16384, 40000, 65536 };
+
+    std::vector<IoOperation*> operations;
+
+    for (const auto size : kSizes)
+    {
+        const auto operation = IoBufferPool::Acquire(size);
+
+        EXPECT_TRUE(IsAligned(operation, ntp::details::kCacheLine));
+        EXPECT_TRUE(IsAligned(operation->Data(), IoBufferPool::kPageSize));
+        EXPECT_GE(operation->Capacity(), size);
+        EXPECT_EQ(operation->Capacity() & (operation->Capacity() - 1), 0u);
+
+        EXPECT_EQ(IoOperation::FromOverlapped(operation->Overlapped()), operation);
+        EXPECT_EQ(operation->Context(), nullptr);
+
+        std::memset(operation->Data(), 0xcc, operation->Capacity());
+        operations.push_back(operation);
+    }
+
+    for (const auto operation : operations)
+    {
+        operation->Release();
+    }
+}
+
+TEST(IoBufferPool, Reuse)
+{
+    const auto first = IoBufferPool::Acquire();
+
+    first->SetOffset(0x100000002ull);
+    first->SetContext(first);
+    first->Release();
+
+    //
+    // The same context is returned, but its state is reset
+    //
+
+    const auto second = IoBufferPool::Acquire();
+
+    EXPECT_EQ(first, second);
+    EXPECT_EQ(second->Overlapped()->Offset, 0u);
+    EXPECT_EQ(second->Overlapped()->OffsetHigh, 0u);
+    EXPECT_EQ(second->Context(), nullptr);
+
+    second->Release();
+}
+
+TEST(IoBufferPool, CacheHits)
+{
+    static constexpr auto kAcquisitions = 1000;
+
+    //
+    // Warm up thread-local cache
+    //
+
+    IoBufferPool::Release(IoBufferPool::Acquire());
+
+    const auto before = IoBufferPool::Statistics();
+
+    for (auto i = 0; i < kAcquisitions; ++i)
+    {
+        IoBufferPool::Release(IoBufferPool::Acquire());
+    }
+
+    const auto after = IoBufferPool::Statistics();
+
+    EXPECT_EQ(after.acquisitions - before.acquisitions, kAcquisitions);
+    EXPECT_EQ(after.cache_hits - before.cache_hits, kAcquisitions);
+    EXPECT_EQ(after.releases - before.releases, kAcquisitions);
+}
+
+TEST(IoBufferPool, CrossThreadRelease)
+{
+    static constexpr auto kOperations = 1000;
+
+    //
+    // Contexts are acquired by one thread and released by another one,
+    // i.e. they travel through the global depot
+    //
+
+    std::vector<IoOperation*> operations;
+
+    for (auto i = 0; i < kOperations; ++i)
+    {
+        const auto operation = IoBufferPool::Acquire(8192);
+        std::memset(operation->Data(), i, operation->Capacity());
+
+        operations.push_back(operation);
+    }
+
+    std::thread([&operations]() {
+        for (const auto operation : operations)
+        {
+            operation->Release();
+        }
+    }).join();
+
+    std::sort(operations.begin(), operations.end());
+    EXPECT_EQ(std::adjacent_find(operations.begin(), operations.end()), operations.end());
+
+    for (auto i = 0; i < kOperations; ++i)
+    {
+        IoBufferPool::Acquire(8192)->Release();
+    }
+}
+
+TEST(IoBufferPool, TooLarge)
+{
+    EXPECT_THROW(IoBufferPool::Acquire(IoBufferPool::kMaxBufferSize + 1), ntp::exception::Win32Exception);
+}
@@ -115,3 +115,65 @@ TEST(Io, Cancel)
         FAIL();
     }
 }
+
+
+TEST(Io, Binding)
+{
+    //
+    // Create temporary file to write in
+    //
+
+    test::details::TempFileName file_name;
+    ATL::CAtlFile file;
+
+    HRESULT hr = file.Create(file_name, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ,
+        CREATE_ALWAYS, FILE_FLAG_OVERLAPPED);
+
+    EXPECT_TRUE(SUCCEEDED(hr));
+
+    //
+    // A single binding serves many operations
+    //
+
+    constexpr size_t kOperations = 64;
+    constexpr size_t kChunk      = 4096;
+
+    std::vector<unsigned char> buffer(kOperations * kChunk, 0);
+    std::vector<OVERLAPPED> operations(kOperations);
+
+    ATL::CEvent all_completed(TRUE, FALSE);
+    std::atomic<size_t> completed = 0;
+    std::atomic<size_t> bytes_written = 0;
+
+    ntp::SystemThreadPool pool;
+    const auto binding = pool.BindIo(file, [&](LPVOID /*overlapped*/, ULONG /*result*/, ULONG_PTR bytes_transferred) {
+        bytes_written += static_cast<size_t>(bytes_transferred);
+
+        if (++completed == kOperations)
+        {
+            all_completed.Set();
+        }
+    });
+
+    for (size_t i = 0; i < kOperations; ++i)
+    {
+        operations[i].Offset = static_cast<DWORD>(i * kChunk);
+
+        binding.BeginOperation();
+        hr = file.Write(buffer.data() + i * kChunk, static_cast<DWORD>(kChunk), &operations[i]);
+
+        if (FAILED(hr) && hr != HRESULT_FROM_WIN32(ERROR_IO_PENDING))
+        {
+            binding.AbortOperation();
+            pool.UnbindIo(binding);
+
+            FAIL();
+        }
+    }
+
+    WaitForSingleObject(all_completed, INFINITE);
+
+    EXPECT_EQ(bytes_written, buffer.size());
+
+    pool.UnbindIo(binding);
+}
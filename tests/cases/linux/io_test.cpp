@@ -0,0 +1,802 @@
+#include "test_config.hpp"
+
+#include <cstdlib>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+
+namespace {
+
+class TempFile final
+{
+public:
+    explicit TempFile()
+        : path_("/tmp/~ntpXXXXXX")
+        , descriptor_(mkstemp(path_.data()))
+    { }
+
+    ~TempFile()
+    {
+        if (descriptor_ >= 0)
+        {
+            close(descriptor_);
+            unlink(path_.c_str());
+        }
+    }
+
+    operator HANDLE() const noexcept { return HandleFromDescriptor(descriptor_); }
+
+    bool IsValid() const noexcept { return descriptor_ >= 0; }
+
+private:
+    std::string path_;
+    int descriptor_;
+};
+
+}  // namespace
+
+
+TEST(Io, Submit)
+{
+    //
+    // Create temporary file to write in
+    //
+
+    TempFile file;
+    EXPECT_TRUE(file.IsValid());
+
+    //
+    // Now submit an IO callback
+    //
+
+    ntp::details::Event event(TRUE, FALSE);
+    size_t bytes_written = 0;
+
+    ntp::SystemThreadPool pool;
+    const auto io = pool.SubmitIo(file, [&bytes_written, &event](PTP_CALLBACK_INSTANCE instance, LPVOID /*overlapped*/, ULONG /*result*/, ULONG_PTR bytes_transferred) {
+        SetEventWhenCallbackReturns(instance, event);
+        bytes_written = static_cast<size_t>(bytes_transferred);
+    });
+
+    //
+    // And start to write a big amount of data into a file asyncronously
+    //
+
+    std::vector<unsigned char> buffer(10 * 1024 * 1024 /* 10 Mb */, 0);
+
+    OVERLAPPED ovl = {};
+    const auto written = WriteFile(file, buffer.data(), static_cast<DWORD>(buffer.size()), nullptr, &ovl);
+
+    if (!written && GetLastError() == ERROR_IO_PENDING)
+    {
+        WaitForSingleObject(event, INFINITE);
+
+        //
+        // Check if all bytes are written into a file
+        //
+
+        EXPECT_EQ(bytes_written, buffer.size());
+    }
+    else
+    {
+        pool.AbortIo(io);
+
+        FAIL();
+    }
+}
+
+
+TEST(Io, Cancel)
+{
+    //
+    // Create temporary file to write in
+    //
+
+    TempFile file;
+    EXPECT_TRUE(file.IsValid());
+
+    //
+    // Now submit an IO callback, that will be cancelled
+    //
+
+    size_t bytes_written = 0;
+
+    ntp::SystemThreadPool pool;
+    const auto io = pool.SubmitIo(file, [&bytes_written](LPVOID /*overlapped*/, ULONG /*result*/, ULONG_PTR bytes_transferred) {
+        bytes_written = static_cast<size_t>(bytes_transferred);
+    });
+
+    //
+    // Prepare to write a big amount of data into a file
+    //
+
+    std::vector<unsigned char> buffer(10 * 1024 * 1024 /* 10 Mb */, 0);
+
+    ntp::details::Event event(TRUE, FALSE);
+    OVERLAPPED ovl = {};
+    ovl.hEvent     = event;
+
+    //
+    // Now cancel thread pool IO (file is not bound anymore,
+    // so write is performed synchronously)
+    //
+
+    pool.CancelIo(io);
+    EXPECT_TRUE(WriteFile(file, buffer.data(), static_cast<DWORD>(buffer.size()), nullptr, &ovl));
+
+    WaitForSingleObject(event, INFINITE);
+
+    EXPECT_EQ(bytes_written, 0);
+    EXPECT_EQ(ovl.InternalHigh, buffer.size());
+}
+
+
+#if defined(NTP_HAS_COROUTINES)
+
+namespace {
+
+ntp::coroutine::Task<ntp::coroutine::IoResult> WriteAsync(ntp::SystemThreadPool& pool, HANDLE file, const std::vector<unsigned char>& buffer)
+{
+    co_return co_await ntp::coroutine::Io(pool, file, [file, &buffer](LPOVERLAPPED overlapped) {
+        return WriteFile(file, buffer.data(), static_cast<DWORD>(buffer.size()), nullptr, overlapped);
+    });
+}
+
+}  // namespace
+
+
+TEST(Io, Coroutine)
+{
+    TempFile file;
+    EXPECT_TRUE(file.IsValid());
+
+    std::vector<unsigned char> buffer(1024 * 1024 /* 1 Mb */, 0);
+    ntp::SystemThreadPool pool;
+
+    const auto [result, bytes_transferred] = ntp::coroutine::SyncWait(WriteAsync(pool, file, buffer));
+
+    EXPECT_EQ(result, NO_ERROR);
+    EXPECT_EQ(bytes_transferred, buffer.size());
+}
+
+TEST(Io, CoroutineStartFailure)
+{
+    std::vector<unsigned char> buffer(16, 0);
+    ntp::SystemThreadPool pool;
+
+    //
+    // Invalid handle: operation is not started and coroutine is not suspended
+    //
+
+    TempFile file;
+    EXPECT_TRUE(file.IsValid());
+
+    const auto starter = [](LPOVERLAPPED) {
+        SetLastError(ERROR_INVALID_HANDLE);
+        return FALSE;
+    };
+
+    const auto task = [](ntp::SystemThreadPool& pool, HANDLE file, auto starter) -> ntp::coroutine::Task<ntp::coroutine::IoResult> {
+        co_return co_await ntp::coroutine::Io(pool, file, starter);
+    };
+
+    const auto io_result = ntp::coroutine::SyncWait(task(pool, file, starter));
+
+    EXPECT_EQ(io_result.result, static_cast<ULONG>(ERROR_INVALID_HANDLE));
+    EXPECT_EQ(io_result.bytes_transferred, 0);
+}
+
+#endif  // NTP_HAS_COROUTINES
+
+
+namespace {
+
+struct WriteOperation
+{
+    OVERLAPPED overlapped;
+    std::size_t index;
+};
+
+}  // namespace
+
+
+TEST(Io, Binding)
+{
+    TempFile file;
+    EXPECT_TRUE(file.IsValid());
+
+    //
+    // A single binding serves many operations, each of them
+    // is found by its OVERLAPPED pointer in the callback
+    //
+
+    constexpr std::size_t kOperations = 256;
+    constexpr std::size_t kChunk      = 4096;
+
+    std::vector<unsigned char> buffer(kOperations * kChunk);
+    std::vector<WriteOperation> operations(kOperations);
+    std::vector<std::atomic<ULONG_PTR>> transferred(kOperations);
+
+    ntp::details::Event all_completed(TRUE, FALSE);
+    std::atomic<std::size_t> completed = 0;
+
+    ntp::SystemThreadPool pool;
+    const auto binding = pool.BindIo(file, [&](LPVOID overlapped, ULONG result, ULONG_PTR bytes_transferred) {
+        const auto operation = static_cast<WriteOperation*>(overlapped);
+
+        if (result == NO_ERROR)
+        {
+            transferred[operation->index] = bytes_transferred;
+        }
+
+        if (++completed == kOperations)
+        {
+            all_completed.Set();
+        }
+    });
+
+    for (std::size_t i = 0; i < kOperations; ++i)
+    {
+        std::memset(buffer.data() + i * kChunk, static_cast<int>(i), kChunk);
+
+        operations[i].index             = i;
+        operations[i].overlapped.Offset = static_cast<DWORD>(i * kChunk);
+
+        binding.BeginOperation();
+
+        const auto written = WriteFile(file, buffer.data() + i * kChunk, static_cast<DWORD>(kChunk), nullptr, &operations[i].overlapped);
+        ASSERT_FALSE(written);
+        ASSERT_EQ(GetLastError(), static_cast<DWORD>(ERROR_IO_PENDING));
+    }
+
+    WaitForSingleObject(all_completed, INFINITE);
+
+    for (const auto& bytes : transferred)
+    {
+        EXPECT_EQ(bytes, kChunk);
+    }
+
+    std::vector<unsigned char> content(buffer.size());
+    EXPECT_EQ(pread(DescriptorFromHandle(file), content.data(), content.size(), 0), static_cast<ssize_t>(content.size()));
+    EXPECT_EQ(content, buffer);
+
+    pool.UnbindIo(binding);
+}
+
+TEST(Io, BindingAbort)
+{
+    TempFile file;
+    EXPECT_TRUE(file.IsValid());
+
+    std::atomic_int completed = 0;
+    ntp::details::Event callback_completed(TRUE, FALSE);
+
+    ntp::SystemThreadPool pool;
+    const auto binding = pool.BindIo(file, [&completed, &callback_completed](PTP_CALLBACK_INSTANCE instance, LPVOID, ULONG, ULONG_PTR) {
+        ++completed;
+        SetEventWhenCallbackReturns(instance, callback_completed);
+    });
+
+    //
+    // Operation is announced, but never started
+    //
+
+    binding.BeginOperation();
+    binding.AbortOperation();
+
+    //
+    // The next one completes as usual
+    //
+
+    std::array<unsigned char, 64> buffer {};
+    OVERLAPPED ovl = {};
+
+    binding.BeginOperation();
+    EXPECT_FALSE(WriteFile(file, buffer.data(), static_cast<DWORD>(buffer.size()), nullptr, &ovl));
+
+    WaitForSingleObject(callback_completed, INFINITE);
+    pool.UnbindIo(binding);
+
+    EXPECT_EQ(completed, 1);
+}
+
+TEST(Io, ConcurrentReads)
+{
+    TempFile file;
+    EXPECT_TRUE(file.IsValid());
+
+    constexpr std::size_t kOperations = 256;
+    constexpr std::size_t kChunk      = 4096;
+
+    std::vector<unsigned char> content(kOperations * kChunk);
+    for (std::size_t i = 0; i < content.size(); ++i)
+    {
+        content[i] = static_cast<unsigned char>(i / kChunk + i);
+    }
+
+    ASSERT_EQ(pwrite(DescriptorFromHandle(file), content.data(), content.size(), 0), static_cast<ssize_t>(content.size()));
+
+    //
+    // All reads are in flight at once and complete in arbitrary order
+    //
+
+    std::vector<unsigned char> buffer(content.size());
+    std::vector<WriteOperation> operations(kOperations);
+
+    ntp::details::Event all_completed(TRUE, FALSE);
+    std::atomic<std::size_t> completed = 0;
+    std::atomic<std::size_t> failed    = 0;
+
+    ntp::SystemThreadPool pool;
+    const auto binding = pool.BindIo(file, [&](LPVOID, ULONG result, ULONG_PTR bytes_transferred) {
+        if (result != NO_ERROR || bytes_transferred != kChunk)
+        {
+            ++failed;
+        }
+
+        if (++completed == kOperations)
+        {
+            all_completed.Set();
+        }
+    });
+
+    for (std::size_t i = 0; i < kOperations; ++i)
+    {
+        operations[i].index             = i;
+        operations[i].overlapped.Offset = static_cast<DWORD>(i * kChunk);
+
+        binding.BeginOperation();
+
+        const auto read = ReadFile(file, buffer.data() + i * kChunk, static_cast<DWORD>(kChunk), nullptr, &operations[i].overlapped);
+        ASSERT_FALSE(read);
+        ASSERT_EQ(GetLastError(), static_cast<DWORD>(ERROR_IO_PENDING));
+    }
+
+    WaitForSingleObject(all_completed, INFINITE);
+    pool.UnbindIo(binding);
+
+    EXPECT_EQ(failed, 0);
+    EXPECT_EQ(buffer, content);
+}
+
+TEST(Io, FixedBuffer)
+{
+    TempFile file;
+    EXPECT_TRUE(file.IsValid());
+
+    std::vector<unsigned char> content(64 * 1024);
+    for (std::size_t i = 0; i < content.size(); ++i)
+    {
+        content[i] = static_cast<unsigned char>(i * 7);
+    }
+
+    ASSERT_EQ(pwrite(DescriptorFromHandle(file), content.data(), content.size(), 0), static_cast<ssize_t>(content.size()));
+
+    ntp::details::Event callback_completed(TRUE, FALSE);
+    ULONG io_result      = ERROR_IO_PENDING;
+    ULONG_PTR bytes_read = 0;
+
+    ntp::SystemThreadPool pool;
+    const auto binding = pool.BindIo(file, [&](PTP_CALLBACK_INSTANCE instance, LPVOID, ULONG result, ULONG_PTR bytes_transferred) {
+        io_result  = result;
+        bytes_read = bytes_transferred;
+
+        SetEventWhenCallbackReturns(instance, callback_completed);
+    });
+
+    //
+    // Registration fails only if io_uring is not available (then
+    // operation is performed on a pool worker, result is the same)
+    //
+
+    std::vector<unsigned char> buffer(2 * content.size());
+    const auto registered = binding.RegisterBuffer(buffer.data(), buffer.size());
+
+    //
+    // Read into the middle of registered buffer
+    //
+
+    OVERLAPPED ovl = {};
+
+    binding.BeginOperation();
+    EXPECT_FALSE(ReadFile(file, buffer.data() + 128, static_cast<DWORD>(content.size()), nullptr, &ovl));
+
+    WaitForSingleObject(callback_completed, INFINITE);
+
+    EXPECT_EQ(io_result, static_cast<ULONG>(NO_ERROR));
+    EXPECT_EQ(bytes_read, content.size());
+    EXPECT_TRUE(std::equal(content.begin(), content.end(), buffer.begin() + 128));
+
+    if (registered)
+    {
+        EXPECT_TRUE(binding.UnregisterBuffer(buffer.data()));
+        EXPECT_FALSE(binding.UnregisterBuffer(buffer.data()));
+    }
+
+    pool.UnbindIo(binding);
+}
+
+TEST(Io, PooledOperations)
+{
+    TempFile file;
+    EXPECT_TRUE(file.IsValid());
+
+    constexpr std::size_t kOperations = 256;
+    constexpr std::size_t kChunk      = 4096;
+
+    //
+    // Each write carries its data in a pooled context, which is
+    // returned into pool automatically after its callback
+    //
+
+    ntp::details::Event all_completed(TRUE, FALSE);
+    std::atomic<std::size_t> completed = 0;
+    std::atomic<std::size_t> failed    = 0;
+
+    const auto before = ntp::io::IoBufferPool::Statistics();
+
+    ntp::SystemThreadPool pool;
+    const auto binding = pool.BindIo(file, [&](ntp::io::IoOperation& operation, ULONG result, ULONG_PTR bytes_transferred) {
+        const auto index = reinterpret_cast<std::uintptr_t>(operation.Context());
+
+        if (result != NO_ERROR || bytes_transferred != kChunk ||
+            static_cast<unsigned char*>(operation.Data())[0] != static_cast<unsigned char>(index))
+        {
+            ++failed;
+        }
+
+        if (++completed == kOperations)
+        {
+            all_completed.Set();
+        }
+    });
+
+    for (std::size_t i = 0; i < kOperations; ++i)
+    {
+        const auto operation = ntp::io::IoBufferPool::Acquire(kChunk);
+
+        std::memset(operation->Data(), static_cast<int>(i), kChunk);
+        operation->SetContext(reinterpret_cast<void*>(i));
+        operation->SetOffset(i * kChunk);
+
+        binding.BeginOperation();
+
+        const auto written = WriteFile(file, operation->Data(), static_cast<DWORD>(kChunk), nullptr, operation->Overlapped());
+        ASSERT_FALSE(written);
+        ASSERT_EQ(GetLastError(), static_cast<DWORD>(ERROR_IO_PENDING));
+    }
+
+    WaitForSingleObject(all_completed, INFINITE);
+    pool.UnbindIo(binding);
+
+    EXPECT_EQ(failed, 0);
+
+    std::vector<unsigned char> content(kOperations * kChunk);
+    EXPECT_EQ(pread(DescriptorFromHandle(file), content.data(), content.size(), 0), static_cast<ssize_t>(content.size()));
+
+    for (std::size_t i = 0; i < content.size(); ++i)
+    {
+        ASSERT_EQ(content[i], static_cast<unsigned char>(i / kChunk));
+    }
+
+    //
+    // Completions are released on workers, which publish their counters lazily
+    //
+
+    const auto after = ntp::io::IoBufferPool::Statistics();
+    EXPECT_GE(after.acquisitions - before.acquisitions, kOperations);
+}
+
+TEST(Io, WriteGather)
+{
+    TempFile file;
+    EXPECT_TRUE(file.IsValid());
+
+    //
+    // Many small records are written with a single operation
+    //
+
+    constexpr std::size_t kRecords = 200;
+
+    std::vector<std::vector<unsigned char>> records;
+    std::vector<ntp::io::IoSegment> segments;
+    std::vector<unsigned char> expected;
+
+    for (std::size_t i = 0; i < kRecords; ++i)
+    {
+        records.emplace_back(i % 37 + 1, static_cast<unsigned char>(i));
+        expected.insert(expected.end(), records.back().begin(), records.back().end());
+    }
+
+    for (auto& record : records)
+    {
+        segments.push_back({ record.data(), record.size() });
+    }
+
+    ntp::details::Event callback_completed(FALSE, FALSE);
+    ULONG io_result             = ERROR_IO_PENDING;
+    ULONG_PTR transferred       = 0;
+    std::atomic_int completions = 0;
+
+    ntp::SystemThreadPool pool;
+    const auto binding = pool.BindIo(file, [&](PTP_CALLBACK_INSTANCE instance, LPVOID, ULONG result, ULONG_PTR bytes_transferred) {
+        io_result   = result;
+        transferred = bytes_transferred;
+        ++completions;
+
+        SetEventWhenCallbackReturns(instance, callback_completed);
+    });
+
+    OVERLAPPED ovl = {};
+    ovl.Offset     = 16;
+
+    ASSERT_TRUE(binding.WriteGather(file, segments.data(), segments.size(), &ovl));
+    WaitForSingleObject(callback_completed, INFINITE);
+
+    EXPECT_EQ(completions, 1);
+    EXPECT_EQ(io_result, static_cast<ULONG>(NO_ERROR));
+    EXPECT_EQ(transferred, expected.size());
+
+    std::vector<unsigned char> content(expected.size());
+    EXPECT_EQ(pread(DescriptorFromHandle(file), content.data(), content.size(), 16), static_cast<ssize_t>(content.size()));
+    EXPECT_EQ(content, expected);
+
+    //
+    // Read it back into buffers, that are split differently
+    //
+
+    std::array<std::vector<unsigned char>, 3> parts = {
+        std::vector<unsigned char>(1),
+        std::vector<unsigned char>(expected.size() / 2),
+        std::vector<unsigned char>(expected.size() - expected.size() / 2 - 1)
+    };
+
+    std::vector<ntp::io::IoSegment> read_segments;
+    for (auto& part : parts)
+    {
+        read_segments.push_back({ part.data(), part.size() });
+    }
+
+    ASSERT_TRUE(binding.ReadScatter(file, read_segments.data(), read_segments.size(), &ovl));
+    WaitForSingleObject(callback_completed, INFINITE);
+
+    EXPECT_EQ(io_result, static_cast<ULONG>(NO_ERROR));
+    EXPECT_EQ(transferred, expected.size());
+
+    std::vector<unsigned char> read;
+    for (const auto& part : parts)
+    {
+        read.insert(read.end(), part.begin(), part.end());
+    }
+
+    EXPECT_EQ(read, expected);
+
+    //
+    // Invalid operation is not started
+    //
+
+    EXPECT_FALSE(binding.WriteGather(file, segments.data(), 0, &ovl));
+    EXPECT_EQ(GetLastError(), static_cast<DWORD>(ERROR_INVALID_PARAMETER));
+
+    pool.UnbindIo(binding);
+
+    EXPECT_EQ(completions, 2);
+}
+
+TEST(Io, ScatterGatherPages)
+{
+    TempFile file;
+    EXPECT_TRUE(file.IsValid());
+
+    const auto page_size = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+
+    const auto source      = ntp::io::IoBufferPool::Acquire(4 * page_size);
+    const auto destination = ntp::io::IoBufferPool::Acquire(4 * page_size);
+
+    //
+    // The last page is transferred partially
+    //
+
+    const auto size = static_cast<DWORD>(3 * page_size + page_size / 2);
+
+    std::array<FILE_SEGMENT_ELEMENT, 5> pages {};
+    for (std::size_t i = 0; i < 4; ++i)
+    {
+        pages[i].Buffer = static_cast<char*>(source->Data()) + i * page_size;
+        std::memset(pages[i].Buffer, static_cast<int>(i + 1), page_size);
+    }
+
+    ntp::details::Event callback_completed(FALSE, FALSE);
+    ULONG_PTR transferred = 0;
+
+    ntp::SystemThreadPool pool;
+    const auto binding = pool.BindIo(file, [&](PTP_CALLBACK_INSTANCE instance, LPVOID, ULONG, ULONG_PTR bytes_transferred) {
+        transferred = bytes_transferred;
+        SetEventWhenCallbackReturns(instance, callback_completed);
+    });
+
+    OVERLAPPED ovl = {};
+
+    binding.BeginOperation();
+    EXPECT_FALSE(WriteFileGather(file, pages.data(), size, nullptr, &ovl));
+    EXPECT_EQ(GetLastError(), static_cast<DWORD>(ERROR_IO_PENDING));
+
+    WaitForSingleObject(callback_completed, INFINITE);
+    EXPECT_EQ(transferred, size);
+
+    for (std::size_t i = 0; i < 4; ++i)
+    {
+        pages[i].Buffer = static_cast<char*>(destination->Data()) + i * page_size;
+    }
+
+    binding.BeginOperation();
+    EXPECT_FALSE(ReadFileScatter(file, pages.data(), size, nullptr, &ovl));
+    EXPECT_EQ(GetLastError(), static_cast<DWORD>(ERROR_IO_PENDING));
+
+    WaitForSingleObject(callback_completed, INFINITE);
+    EXPECT_EQ(transferred, size);
+
+    EXPECT_EQ(std::memcmp(source->Data(), destination->Data(), size), 0);
+
+    pool.UnbindIo(binding);
+
+    source->Release();
+    destination->Release();
+}
+
+namespace {
+
+class Listener final
+{
+public:
+    explicit Listener()
+        : descriptor_(socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0))
+        , address_()
+    {
+        address_.sin_family      = AF_INET;
+        address_.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        socklen_t length = sizeof(address_);
+
+        if (descriptor_ < 0 ||
+            0 != bind(descriptor_, reinterpret_cast<const sockaddr*>(&address_), sizeof(address_)) ||
+            0 != listen(descriptor_, 16) ||
+            0 != getsockname(descriptor_, reinterpret_cast<sockaddr*>(&address_), &length))
+        {
+            Close();
+        }
+    }
+
+    ~Listener()
+    {
+        Close();
+    }
+
+    operator HANDLE() const noexcept { return HandleFromDescriptor(descriptor_); }
+
+    bool IsValid() const noexcept { return descriptor_ >= 0; }
+
+    int Connect() const noexcept
+    {
+        const auto client = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (client >= 0 && 0 != connect(client, reinterpret_cast<const sockaddr*>(&address_), sizeof(address_)))
+        {
+            close(client);
+            return -1;
+        }
+
+        return client;
+    }
+
+private:
+    void Close() noexcept
+    {
+        if (descriptor_ >= 0)
+        {
+            close(descriptor_);
+            descriptor_ = -1;
+        }
+    }
+
+private:
+    int descriptor_;
+    sockaddr_in address_;
+};
+
+}  // namespace
+
+TEST(Io, Accept)
+{
+    Listener listener;
+    ASSERT_TRUE(listener.IsValid());
+
+    ntp::details::Event callback_completed(TRUE, FALSE);
+    ULONG io_result = ERROR_IO_PENDING;
+    int accepted    = -1;
+
+    ntp::SystemThreadPool pool;
+    const auto binding = pool.BindIo(listener, [&](PTP_CALLBACK_INSTANCE instance, LPVOID, ULONG result, ULONG_PTR bytes_transferred) {
+        io_result = result;
+        accepted  = static_cast<int>(bytes_transferred);
+
+        SetEventWhenCallbackReturns(instance, callback_completed);
+    });
+
+    //
+    // Accept is started before anyone connects
+    //
+
+    OVERLAPPED ovl = {};
+
+    binding.BeginOperation();
+    EXPECT_FALSE(AcceptSocket(listener, nullptr, &ovl));
+    EXPECT_EQ(GetLastError(), static_cast<DWORD>(ERROR_IO_PENDING));
+
+    const auto client = listener.Connect();
+    ASSERT_GE(client, 0);
+
+    WaitForSingleObject(callback_completed, INFINITE);
+    pool.UnbindIo(binding);
+
+    ASSERT_EQ(io_result, static_cast<ULONG>(NO_ERROR));
+    ASSERT_GE(accepted, 0);
+
+    //
+    // Accepted socket is connected to the client
+    //
+
+    const char message[] = "ntp";
+    EXPECT_EQ(write(client, message, sizeof(message)), static_cast<ssize_t>(sizeof(message)));
+
+    char received[sizeof(message)] = {};
+    DWORD bytes_read = 0;
+
+    EXPECT_TRUE(ReadFile(HandleFromDescriptor(accepted), received, sizeof(received), &bytes_read, nullptr));
+    EXPECT_EQ(bytes_read, sizeof(message));
+    EXPECT_STREQ(received, message);
+
+    close(accepted);
+    close(client);
+}
+
+TEST(Io, PendingAcceptOnPoolDestruction)
+{
+    Listener listener;
+    ASSERT_TRUE(listener.IsValid());
+
+    //
+    // Nobody connects, pool must cancel the accept and not hang
+    //
+
+    std::atomic_int completed = 0;
+
+    {
+        ntp::ThreadPool pool;
+        const auto binding = pool.BindIo(listener, [&completed](LPVOID, ULONG, ULONG_PTR) {
+            ++completed;
+        });
+
+        std::array<char, 64> buffer {};
+        if (!binding.RegisterBuffer(buffer.data(), buffer.size()) && GetLastError() == ERROR_NOT_SUPPORTED)
+        {
+            //
+            // Without io_uring accept blocks a worker until someone connects
+            //
+
+            pool.UnbindIo(binding);
+            GTEST_SKIP();
+        }
+
+        binding.UnregisterBuffer(buffer.data());
+
+        OVERLAPPED ovl = {};
+
+        binding.BeginOperation();
+        EXPECT_FALSE(AcceptSocket(listener, nullptr, &ovl));
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+
+    EXPECT_EQ(completed, 0);
+}
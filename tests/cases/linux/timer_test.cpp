@@ -0,0 +1,93 @@
+#include "test_config.hpp"
+
+
+TEST(Timer, Coalesced)
+{
+    using namespace std::chrono_literals;
+
+    //
+    // Tolerance of the first timer covers due time of the second one,
+    // hence engine expires both timers during a single wakeup
+    //
+
+    std::atomic<std::chrono::steady_clock::duration> first {};
+    std::atomic<std::chrono::steady_clock::duration> second {};
+
+    ntp::SystemThreadPool pool;
+
+    const auto start = std::chrono::steady_clock::now();
+
+    pool.SubmitTimer(10ms, ntp::time::Tolerance(100ms), [&first, start]() {
+        first = std::chrono::steady_clock::now() - start;
+    });
+
+    pool.SubmitTimer(40ms, [&second, start]() {
+        second = std::chrono::steady_clock::now() - start;
+    });
+
+    std::this_thread::sleep_for(150ms);
+
+    ASSERT_NE(first.load(), std::chrono::steady_clock::duration::zero());
+    ASSERT_NE(second.load(), std::chrono::steady_clock::duration::zero());
+
+    EXPECT_GE(first.load(), 40ms);
+    EXPECT_LT(first.load(), 110ms);
+}
+
+TEST(Timer, CoalescedPeriodic)
+{
+    using namespace std::chrono_literals;
+
+    //
+    // Periodic timer with tolerance fires no later than its tolerance allows
+    //
+
+    std::atomic_int counter = 0;
+    ntp::SystemThreadPool pool;
+
+    pool.SubmitTimer(5ms, 5ms, ntp::time::Tolerance(5ms), [&counter]() {
+        ++counter;
+    });
+
+    std::this_thread::sleep_for(100ms);
+
+    EXPECT_GE(counter, 5);
+}
+
+TEST(Timer, PeriodicNoDrift)
+{
+    using namespace std::chrono_literals;
+
+    //
+    // 250us cadence: every tick is reported (either invoked or missed)
+    // and deadlines stay at start + N * period
+    //
+
+    std::atomic<std::uint64_t> counted = 0;
+    std::atomic<std::uint64_t> last    = 0;
+    std::atomic_bool drifted           = false;
+
+    ntp::SystemThreadPool pool;
+
+    const auto start = ntp::time::clock_t::now();
+    const auto timer = pool.SubmitPeriodicTimer(0ms, 250us, [&](const ntp::time::TimerTick& tick) {
+        const auto offset = tick.deadline - start;
+        if (offset < tick.index * 250us || offset > tick.index * 250us + 100us)
+        {
+            drifted = true;
+        }
+
+        counted += tick.missed + 1;
+        last     = tick.index;
+    });
+
+    std::this_thread::sleep_for(200ms);
+    pool.CancelTimer(timer);
+
+    const auto elapsed = ntp::time::clock_t::now() - start;
+
+    EXPECT_FALSE(drifted);
+    EXPECT_EQ(counted.load(), last.load() + 1);
+    EXPECT_GE(last.load(), 700u);
+    EXPECT_LE(last.load(), static_cast<std::uint64_t>(elapsed / 250us));
+}
@@ -0,0 +1,72 @@
+#include "test_config.hpp"
+
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/syscall.h>
+
+
+namespace {
+
+HANDLE SpawnSleeper(std::chrono::milliseconds duration, pid_t& pid)
+{
+    pid = fork();
+    if (0 == pid)
+    {
+        usleep(static_cast<useconds_t>(duration.count() * 1000));
+        _exit(0);
+    }
+
+    const auto descriptor = static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+    return (descriptor < 0) ? nullptr : HandleFromDescriptor(descriptor);
+}
+
+}  // namespace
+
+
+TEST(WaitGroup, ProcessExit)
+{
+    using namespace std::chrono_literals;
+
+    //
+    // Process supervision: pidfd becomes readable, when process exits
+    //
+
+    constexpr int kCount = 8;
+
+    std::vector<pid_t> pids(kCount);
+    std::vector<HANDLE> processes;
+
+    for (int i = 0; i < kCount; ++i)
+    {
+        const auto process = SpawnSleeper(std::chrono::milliseconds(5 * i), pids[i]);
+        ASSERT_NE(process, nullptr);
+
+        processes.push_back(process);
+    }
+
+    ntp::details::Event all_exited(TRUE, FALSE);
+    ntp::SystemThreadPool pool;
+
+    std::atomic_int exited   = 0;
+    std::atomic_int timeouts = 0;
+
+    pool.SubmitWaits(processes, 5s, [&](HANDLE, TP_WAIT_RESULT wait_result) {
+        ++(wait_result == WAIT_OBJECT_0 ? exited : timeouts);
+
+        if (exited + timeouts == kCount)
+        {
+            all_exited.Set();
+        }
+    });
+
+    EXPECT_EQ(WaitForSingleObject(all_exited, 10000), WAIT_OBJECT_0);
+
+    EXPECT_EQ(exited, kCount);
+    EXPECT_EQ(timeouts, 0);
+
+    for (int i = 0; i < kCount; ++i)
+    {
+        waitpid(pids[i], nullptr, 0);
+        CloseHandle(processes[i]);
+    }
+}
@@ -1,4 +1,6 @@
 #include "test_config.hpp"
+#include "logger/logger_internal.hpp"
+#include "logger/log_record.hpp"
 
 
 void TraceCallback(ntp::logger::Severity severity, const wchar_t* message)
@@ -20,3 +22,209 @@ TEST(Logger, Set)
         ntp::logger::SetLogger(TraceCallback);
     });
 }
+
+TEST(Logger, RecordFormat)
+{
+    ntp::logger::details::LogRecord record;
+    record.Encode(ntp::logger::Severity::kError, L"%1!d! %2!s! %3!zu! %4", 42, L"wide", std::size_t { 7 }, L"tail");
+
+    EXPECT_EQ(record.GetSeverity(), ntp::logger::Severity::kError);
+    EXPECT_EQ(record.Format(), L"42 wide 7 tail");
+
+    record.Encode(ntp::logger::Severity::kNormal, "%1 %2!d!", "narrow", -1);
+
+    EXPECT_EQ(record.GetSeverity(), ntp::logger::Severity::kNormal);
+    EXPECT_EQ(record.Format(), L"narrow -1");
+}
+
+TEST(Logger, RecordCopiesStrings)
+{
+    char argument[] = "original";
+
+    ntp::logger::details::LogRecord record;
+    record.Encode(ntp::logger::Severity::kNormal, "%1", argument);
+
+    std::strcpy(argument, "modified");
+
+    EXPECT_EQ(record.Format(), L"original");
+}
+
+TEST(Logger, RecordTruncatesStrings)
+{
+    const std::string argument(ntp::logger::details::LogRecord::kPayloadSize * 2, 'x');
+
+    ntp::logger::details::LogRecord record;
+    record.Encode(ntp::logger::Severity::kNormal, "%1!s!|%2!d!", argument.c_str(), 5);
+
+    const auto formatted = record.Format();
+
+    //
+    // String takes the whole payload, integer does not fit and is read as zero
+    //
+
+    EXPECT_EQ(formatted.size(), ntp::logger::details::LogRecord::kPayloadSize - 1 + 2);
+    EXPECT_EQ(formatted.substr(formatted.size() - 2), L"|0");
+}
+
+TEST(Logger, RingFifo)
+{
+    static constexpr auto kCapacity = ntp::logger::details::RecordRing::kCapacity;
+
+    const auto ring = std::make_unique<ntp::logger::details::RecordRing>();
+    EXPECT_TRUE(ring->Empty());
+
+    for (std::size_t i = 0; i < kCapacity; ++i)
+    {
+        ASSERT_TRUE(ring->TryPush(ntp::logger::Severity::kNormal, L"%1!zu!", i));
+    }
+
+    EXPECT_FALSE(ring->TryPush(ntp::logger::Severity::kNormal, L"%1!zu!", kCapacity));
+    EXPECT_EQ(ring->Size(), kCapacity);
+
+    std::size_t expected = 0;
+    const auto drained   = ring->Drain([&expected](const ntp::logger::details::LogRecord& record) {
+        EXPECT_EQ(record.Format(), std::to_wstring(expected++));
+    });
+
+    EXPECT_EQ(drained, kCapacity);
+    EXPECT_TRUE(ring->Empty());
+    EXPECT_TRUE(ring->TryPush(ntp::logger::Severity::kNormal, L"%1!zu!", kCapacity));
+}
+
+TEST(Logger, RingConcurrent)
+{
+    static constexpr std::size_t kMessages = 10000;
+
+    const auto ring = std::make_unique<ntp::logger::details::RecordRing>();
+
+    std::thread producer([&ring]() {
+        for (std::size_t i = 0; i < kMessages; ++i)
+        {
+            while (!ring->TryPush(ntp::logger::Severity::kNormal, L"%1!zu!", i))
+            {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    std::size_t expected = 0;
+    bool ordered         = true;
+
+    while (expected < kMessages)
+    {
+        ring->Drain([&expected, &ordered](const ntp::logger::details::LogRecord& record) {
+            ordered = ordered && record.Format() == std::to_wstring(expected);
+            ++expected;
+        });
+    }
+
+    producer.join();
+
+    EXPECT_TRUE(ordered);
+    EXPECT_TRUE(ring->Empty());
+}
+
+
+namespace {
+
+//
+// Messages, that do not fit into ring, are delivered synchronously,
+// hence only number and sum of delivered messages are checked
+//
+
+std::atomic<std::size_t> async_delivered { 0 };
+std::atomic<std::size_t> async_sum { 0 };
+
+void AsyncTraceCallback(ntp::logger::Severity /* severity */, const wchar_t* message)
+{
+    async_sum.fetch_add(std::wcstoull(message, nullptr, 10));
+    async_delivered.fetch_add(1);
+}
+
+}  // namespace
+
+TEST(Logger, Asynchronous)
+{
+    static constexpr std::size_t kMessages = 1000;
+
+    const auto previous_logger = ntp::logger::SetLogger(AsyncTraceCallback);
+    const auto previous_mode   = ntp::logger::SetMode(ntp::logger::Mode::kAsynchronous);
+
+    EXPECT_EQ(previous_mode, ntp::logger::Mode::kSynchronous);
+
+    for (std::size_t i = 0; i < kMessages; ++i)
+    {
+        ntp::logger::details::Logger::Instance().TraceMessage(ntp::logger::Severity::kNormal, L"%1!zu!", i);
+    }
+
+    ntp::logger::Flush();
+
+    EXPECT_EQ(async_delivered.load(), kMessages);
+    EXPECT_EQ(async_sum.load(), kMessages * (kMessages - 1) / 2);
+
+    EXPECT_EQ(ntp::logger::SetMode(ntp::logger::Mode::kSynchronous), ntp::logger::Mode::kAsynchronous);
+    ntp::logger::SetLogger(previous_logger);
+}
+
+TEST(Logger, AsynchronousThreadExit)
+{
+    static std::atomic<std::size_t> delivered { 0 };
+
+    //
+    // Traces a message, when thread-local objects are destroyed
+    // (after the thread's ring is abandoned)
+    //
+
+    struct ExitTracer
+    {
+        ~ExitTracer()
+        {
+            ntp::logger::details::Logger::Instance().TraceMessage(ntp::logger::Severity::kNormal, L"exit");
+        }
+    };
+
+    const auto previous_logger = ntp::logger::SetLogger([](ntp::logger::Severity, const wchar_t*) {
+        delivered.fetch_add(1);
+    });
+
+    ntp::logger::SetMode(ntp::logger::Mode::kAsynchronous);
+
+    std::thread([]() {
+        thread_local ExitTracer tracer;
+        static_cast<void>(tracer);
+
+        ntp::logger::details::Logger::Instance().TraceMessage(ntp::logger::Severity::kNormal, L"running");
+    }).join();
+
+    ntp::logger::Flush();
+
+    EXPECT_EQ(delivered.load(), 2);
+
+    ntp::logger::SetMode(ntp::logger::Mode::kSynchronous);
+    ntp::logger::SetLogger(previous_logger);
+}
+
+TEST(Logger, MinSeverity)
+{
+    static std::atomic<std::size_t> delivered { 0 };
+
+    const auto previous_logger = ntp::logger::SetLogger([](ntp::logger::Severity, const wchar_t*) {
+        delivered.fetch_add(1);
+    });
+
+    const auto previous_severity = ntp::logger::SetMinSeverity(ntp::logger::Severity::kError);
+    EXPECT_EQ(previous_severity, ntp::logger::Severity::kExtended);
+
+    const auto& logger = ntp::logger::details::Logger::Instance();
+    logger.TraceMessage(ntp::logger::Severity::kExtended, L"dropped");
+    logger.TraceMessage(ntp::logger::Severity::kNormal, L"dropped %1!d!", 1);
+    logger.TraceMessage(ntp::logger::Severity::kError, L"delivered");
+    logger.TraceMessage(ntp::logger::Severity::kCritical, "delivered %1", "too");
+
+    EXPECT_EQ(delivered.load(), 2);
+    EXPECT_FALSE(logger.Enabled(ntp::logger::Severity::kNormal));
+    EXPECT_TRUE(logger.Enabled(ntp::logger::Severity::kError));
+
+    EXPECT_EQ(ntp::logger::SetMinSeverity(previous_severity), ntp::logger::Severity::kError);
+    ntp::logger::SetLogger(previous_logger);
+}
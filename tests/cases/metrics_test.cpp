@@ -0,0 +1,160 @@
+#include "test_config.hpp"
+#include "details/metrics.hpp"
+
+TEST(Metrics, HistogramBuckets)
+{
+    using ntp::metrics::Histogram;
+
+    //
+    // Small values have their own buckets, larger ones are split
+    // into 4 buckets per power of 2
+    //
+
+    for (std::uint64_t value = 0; value < 4; ++value)
+    {
+        EXPECT_EQ(Histogram::BucketOf(value), value);
+    }
+
+    EXPECT_EQ(Histogram::BucketOf(4), 4);
+    EXPECT_EQ(Histogram::BucketOf(7), 7);
+    EXPECT_EQ(Histogram::BucketOf(8), 8);
+    EXPECT_EQ(Histogram::BucketOf(9), 8);
+    EXPECT_EQ(Histogram::BucketOf(10), 9);
+    EXPECT_EQ(Histogram::BucketOf(16), 12);
+    EXPECT_EQ(Histogram::BucketOf(~std::uint64_t { 0 }), Histogram::kBuckets - 1);
+
+    for (std::size_t bucket = 0; bucket + 1 < Histogram::kBuckets; ++bucket)
+    {
+        const auto lower = Histogram::LowerBoundOf(bucket);
+        const auto next  = Histogram::LowerBoundOf(bucket + 1);
+
+        EXPECT_EQ(Histogram::BucketOf(lower), bucket);
+        EXPECT_EQ(Histogram::BucketOf(next - 1), bucket);
+    }
+}
+
+TEST(Metrics, HistogramPercentile)
+{
+    using ntp::metrics::Histogram;
+
+    Histogram::buckets_t buckets {};
+    buckets[Histogram::BucketOf(100)]  = 90;
+    buckets[Histogram::BucketOf(1000)] = 10;
+
+    const Histogram histogram { buckets, 1.0 };
+
+    EXPECT_EQ(histogram.Count(), 100);
+    EXPECT_EQ(histogram.Percentile(0.5).count(), Histogram::LowerBoundOf(Histogram::BucketOf(100) + 1));
+    EXPECT_EQ(histogram.Percentile(0.99).count(), Histogram::LowerBoundOf(Histogram::BucketOf(1000) + 1));
+    EXPECT_EQ(Histogram().Percentile(0.99).count(), 0);
+
+    auto merged = histogram;
+    merged += histogram;
+
+    EXPECT_EQ(merged.Count(), 200);
+    EXPECT_EQ(merged.Count(Histogram::BucketOf(1000)), 20);
+}
+
+TEST(Metrics, RecorderConcurrent)
+{
+    //
+    // There are more threads, than slots, so some of them share a shard
+    //
+
+    static constexpr std::size_t kThreads = ntp::metrics::details::kThreadSlots + 16;
+    static constexpr std::size_t kRecords = 10000;
+
+    ntp::metrics::details::MetricsRecorder recorder;
+    std::vector<std::thread> threads;
+
+    for (std::size_t thread = 0; thread < kThreads; ++thread)
+    {
+        threads.emplace_back([&recorder]() {
+            for (std::size_t record = 0; record < kRecords; ++record)
+            {
+                recorder.Submitted();
+                recorder.Completed(0, 10, 110);
+            }
+
+            recorder.Cancelled(2);
+            recorder.Completed(0, 1000);
+        });
+    }
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    const auto metrics = recorder.Collect();
+
+    EXPECT_EQ(metrics.submitted, kThreads * kRecords);
+    EXPECT_EQ(metrics.completed, kThreads * (kRecords + 1));
+    EXPECT_EQ(metrics.cancelled, kThreads * 2);
+    EXPECT_EQ(metrics.queue_latency.Count(ntp::metrics::Histogram::BucketOf(10)), kThreads * kRecords);
+    EXPECT_EQ(metrics.run_time.Count(ntp::metrics::Histogram::BucketOf(100)), kThreads * kRecords);
+}
+
+TEST(Metrics, WorkSnapshot)
+{
+    using namespace std::chrono_literals;
+
+    static constexpr auto kCallbacks = 100;
+
+    ntp::SystemThreadPool pool;
+
+    for (auto i = 0; i < kCallbacks; ++i)
+    {
+        pool.SubmitWork([]() {});
+    }
+
+    pool.SubmitWorkBatch(std::vector<int>(kCallbacks), [](int) {
+        std::this_thread::sleep_for(10us);
+    });
+
+    ASSERT_TRUE(pool.WaitWorks());
+
+    const auto snapshot = pool.Snapshot();
+
+    EXPECT_EQ(snapshot.work.submitted, 2 * kCallbacks);
+    EXPECT_EQ(snapshot.work.completed, 2 * kCallbacks);
+    EXPECT_EQ(snapshot.work.cancelled, 0);
+    EXPECT_EQ(snapshot.work.queue_depth, 0);
+    EXPECT_EQ(snapshot.work.live_objects, 0);
+    EXPECT_EQ(snapshot.work.queue_latency.Count(), 2 * kCallbacks);
+    EXPECT_GE(snapshot.work.run_time.Percentile(1.0), 10us);
+}
+
+TEST(Metrics, ObjectsSnapshot)
+{
+    using namespace std::chrono_literals;
+
+    ntp::SystemThreadPool pool;
+    ntp::details::Event event(TRUE, FALSE);
+
+    pool.SubmitTimer(1ms, []() {});
+    pool.SubmitTimer(1h, []() {});
+    pool.SubmitSoftTimer(1h, []() {});
+    pool.SubmitWait(event, [](TP_WAIT_RESULT) {});
+
+    std::this_thread::sleep_for(50ms);
+
+    auto snapshot = pool.Snapshot();
+
+    EXPECT_EQ(snapshot.timer.submitted, 3);
+    EXPECT_EQ(snapshot.timer.completed, 1);
+    EXPECT_EQ(snapshot.timer.live_objects, 2);
+    EXPECT_EQ(snapshot.wait.submitted, 1);
+    EXPECT_EQ(snapshot.wait.live_objects, 1);
+
+    pool.CancelTimers();
+    pool.CancelSoftTimers();
+    pool.CancelWaits();
+
+    snapshot = pool.Snapshot();
+
+    EXPECT_EQ(snapshot.timer.cancelled, 2);
+    EXPECT_EQ(snapshot.timer.live_objects, 0);
+    EXPECT_EQ(snapshot.wait.cancelled, 1);
+    EXPECT_EQ(snapshot.wait.live_objects, 0);
+}
@@ -0,0 +1,301 @@
+#include "test_config.hpp"
+#include "details/queue.hpp"
+
+using ntp::details::PushResult;
+
+TEST(Queue, PopEmpty)
+{
+    ntp::details::MpmcQueue<int> queue;
+
+    int value = 0;
+    EXPECT_FALSE(queue.TryPop(value));
+    EXPECT_EQ(queue.Size(), 0);
+}
+
+TEST(Queue, Fifo)
+{
+    static constexpr auto kItems = 100;
+
+    ntp::details::MpmcQueue<int> queue;
+
+    for (auto i = 0; i < kItems; ++i)
+    {
+        ASSERT_EQ(queue.TryPush(i), PushResult::kPushed);
+    }
+
+    EXPECT_EQ(queue.Size(), kItems);
+
+    int value = 0;
+    for (auto i = 0; i < kItems; ++i)
+    {
+        ASSERT_TRUE(queue.TryPop(value));
+        EXPECT_EQ(value, i);
+    }
+
+    EXPECT_FALSE(queue.TryPop(value));
+}
+
+TEST(Queue, SegmentsReuse)
+{
+    //
+    // 4 segments of 8 items, push and pop much more items,
+    // than directory can hold at once, but keep less than
+    // 32 items in the queue
+    //
+
+    static constexpr auto kItems    = 1000;
+    static constexpr auto kInFlight = 20;
+
+    ntp::details::MpmcQueue<int, 8, 4> queue;
+
+    int value = 0;
+    for (auto i = 0; i < kItems; ++i)
+    {
+        ASSERT_EQ(queue.TryPush(i), PushResult::kPushed);
+
+        if (i >= kInFlight)
+        {
+            ASSERT_TRUE(queue.TryPop(value));
+            EXPECT_EQ(value, i - kInFlight);
+        }
+    }
+
+    for (auto i = kItems - kInFlight; i < kItems; ++i)
+    {
+        ASSERT_TRUE(queue.TryPop(value));
+        EXPECT_EQ(value, i);
+    }
+
+    EXPECT_FALSE(queue.TryPop(value));
+}
+
+TEST(Queue, Full)
+{
+    //
+    // 4 segments of 8 items: the queue is full, when the oldest
+    // segment in use is still being consumed
+    //
+
+    static constexpr auto kCapacity = 32;
+
+    ntp::details::MpmcQueue<int, 8, 4> queue;
+
+    for (auto i = 0; i < kCapacity; ++i)
+    {
+        ASSERT_EQ(queue.TryPush(i), PushResult::kPushed);
+    }
+
+    EXPECT_EQ(queue.TryPush(kCapacity), PushResult::kFull);
+    EXPECT_EQ(queue.TryPushWith([](int&) { FAIL(); }), PushResult::kFull);
+    EXPECT_EQ(queue.Size(), kCapacity);
+
+    //
+    // Segment is released only when all of its items are consumed
+    //
+
+    int value = 0;
+    for (auto i = 0; i < 7; ++i)
+    {
+        ASSERT_TRUE(queue.TryPop(value));
+    }
+
+    EXPECT_EQ(queue.TryPush(kCapacity), PushResult::kFull);
+
+    ASSERT_TRUE(queue.TryPop(value));
+    EXPECT_EQ(value, 7);
+
+    for (auto i = kCapacity; i < kCapacity + 8; ++i)
+    {
+        ASSERT_EQ(queue.TryPush(i), PushResult::kPushed);
+    }
+
+    EXPECT_EQ(queue.TryPush(kCapacity + 8), PushResult::kFull);
+
+    for (auto i = 8; i < kCapacity + 8; ++i)
+    {
+        ASSERT_TRUE(queue.TryPop(value));
+        EXPECT_EQ(value, i);
+    }
+
+    EXPECT_FALSE(queue.TryPop(value));
+}
+
+TEST(Queue, Batch)
+{
+    ntp::details::MpmcQueue<int, 8, 4> queue;
+
+    auto next = 0;
+    const auto fill = [&next](int& value) { value = next++; };
+
+    //
+    // Batch is inserted either as a whole or not at all
+    //
+
+    ASSERT_EQ(queue.TryPushBatch(20, fill), PushResult::kPushed);
+    EXPECT_EQ(queue.TryPushBatch(13, fill), PushResult::kFull);
+    EXPECT_EQ(next, 20);
+
+    ASSERT_EQ(queue.TryPushBatch(12, fill), PushResult::kPushed);
+    EXPECT_EQ(queue.Size(), 32);
+
+    int value = 0;
+    for (auto i = 0; i < 32; ++i)
+    {
+        ASSERT_TRUE(queue.TryPop(value));
+        EXPECT_EQ(value, i);
+    }
+
+    EXPECT_EQ(queue.TryPushBatch(33, fill), PushResult::kFull);
+    EXPECT_EQ(queue.TryPushBatch(0, fill), PushResult::kPushed);
+}
+
+TEST(Queue, MultipleProducersConsumers)
+{
+    static constexpr auto kProducers = 4;
+    static constexpr auto kConsumers = 4;
+    static constexpr auto kItems     = 20000;
+
+    //
+    // Small segments and directory to make queue
+    // full from time to time (producers retry then)
+    //
+
+    ntp::details::MpmcQueue<std::uint64_t, 64, 8> queue;
+    std::atomic_int finished_producers = 0;
+
+    std::vector<std::thread> threads;
+    std::array<std::vector<std::uint64_t>, kConsumers> popped;
+
+    for (auto producer = 0; producer < kProducers; ++producer)
+    {
+        threads.emplace_back([&queue, &finished_producers, producer]() {
+            for (std::uint64_t i = 0; i < kItems; ++i)
+            {
+                while (queue.TryPush((static_cast<std::uint64_t>(producer) << 32) | i) != PushResult::kPushed)
+                {
+                    std::this_thread::yield();
+                }
+            }
+
+            finished_producers++;
+        });
+    }
+
+    for (auto consumer = 0; consumer < kConsumers; ++consumer)
+    {
+        threads.emplace_back([&queue, &finished_producers, &values = popped[consumer]]() {
+            std::uint64_t value = 0;
+
+            for (;;)
+            {
+                const bool finished = (finished_producers == kProducers);
+
+                if (queue.TryPop(value))
+                {
+                    values.push_back(value);
+                }
+                else if (finished)
+                {
+                    break;
+                }
+            }
+        });
+    }
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    //
+    // Every item is popped exactly once and items
+    // of every producer are popped in FIFO order
+    //
+
+    std::array<std::vector<bool>, kProducers> seen;
+    for (auto& producer_seen : seen)
+    {
+        producer_seen.resize(kItems, false);
+    }
+
+    size_t total = 0;
+
+    for (const auto& values : popped)
+    {
+        std::array<std::int64_t, kProducers> last;
+        last.fill(-1);
+
+        for (const auto value : values)
+        {
+            const auto producer = static_cast<size_t>(value >> 32);
+            const auto index    = static_cast<std::int64_t>(value & 0xffffffff);
+
+            ASSERT_LT(producer, kProducers);
+            EXPECT_GT(index, last[producer]);
+            EXPECT_FALSE(seen[producer][index]);
+
+            last[producer]        = index;
+            seen[producer][index] = true;
+        }
+
+        total += values.size();
+    }
+
+    EXPECT_EQ(total, kProducers * kItems);
+}
+
+TEST(Queue, InPlace)
+{
+    //
+    // Non-movable items are filled and consumed right in slots
+    //
+
+    struct Item
+    {
+        Item() noexcept = default;
+        Item(const Item&) = delete;
+
+        int value = 0;
+    };
+
+    static constexpr auto kItems = 100;
+
+    ntp::details::MpmcQueue<Item, 8, 4> queue;
+
+    for (auto i = 0; i < kItems; ++i)
+    {
+        ASSERT_EQ(queue.TryPushWith([i](Item& item) { item.value = i; }), PushResult::kPushed);
+
+        EXPECT_TRUE(queue.TryConsume([i](Item& item) {
+            EXPECT_EQ(item.value, i);
+            item.value = 0;
+        }));
+    }
+
+    EXPECT_FALSE(queue.TryConsume([](Item&) { FAIL(); }));
+}
+
+TEST(Queue, InPlaceExceptions)
+{
+    ntp::details::MpmcQueue<int> queue;
+
+    //
+    // Slot is published even if filler throws
+    //
+
+    EXPECT_THROW(queue.TryPushWith([](int&) { throw std::runtime_error("fill"); }), std::runtime_error);
+    EXPECT_EQ(queue.Size(), 1);
+
+    //
+    // Slot is released even if consumer throws
+    //
+
+    EXPECT_THROW(queue.TryConsume([](int&) { throw std::runtime_error("consume"); }), std::runtime_error);
+    EXPECT_EQ(queue.Size(), 0);
+
+    ASSERT_EQ(queue.TryPush(42), PushResult::kPushed);
+
+    int value = 0;
+    EXPECT_TRUE(queue.TryPop(value));
+    EXPECT_EQ(value, 42);
+}
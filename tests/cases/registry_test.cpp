@@ -0,0 +1,87 @@
+#include "test_config.hpp"
+#include "details/registry.hpp"
+
+TEST(Registry, InsertVisitErase)
+{
+    static constexpr auto kItems = 1000;
+
+    ntp::details::ShardedRegistry<int, int> registry;
+
+    for (auto i = 0; i < kItems; ++i)
+    {
+        registry.Insert(i, i * 2, [](int& value) { value += 1; });
+    }
+
+    EXPECT_EQ(registry.Size(), kItems);
+
+    for (auto i = 0; i < kItems; ++i)
+    {
+        int found = -1;
+        EXPECT_TRUE(registry.Visit(i, [&found](int& value) { found = value; }));
+        EXPECT_EQ(found, i * 2 + 1);
+    }
+
+    EXPECT_FALSE(registry.Visit(kItems, [](int&) { FAIL(); }));
+
+    for (auto i = 0; i < kItems; i += 2)
+    {
+        EXPECT_TRUE(registry.Erase(i, [](int&) {}));
+        EXPECT_FALSE(registry.Erase(i, [](int&) { FAIL(); }));
+    }
+
+    EXPECT_EQ(registry.Size(), kItems / 2);
+}
+
+TEST(Registry, Clear)
+{
+    static constexpr auto kItems = 100;
+
+    ntp::details::ShardedRegistry<int, int, 4> registry;
+
+    for (auto i = 0; i < kItems; ++i)
+    {
+        registry.Insert(i, i, [](int&) {});
+    }
+
+    auto sum = 0;
+    registry.Clear([&sum](int key, int& value) {
+        EXPECT_EQ(key, value);
+        sum += value;
+    });
+
+    EXPECT_EQ(sum, kItems * (kItems - 1) / 2);
+    EXPECT_EQ(registry.Size(), 0);
+}
+
+TEST(Registry, Concurrent)
+{
+    static constexpr auto kThreads = 4;
+    static constexpr auto kItems   = 10000;
+
+    ntp::details::ShardedRegistry<int, int> registry;
+
+    std::vector<std::thread> threads;
+    for (auto thread = 0; thread < kThreads; ++thread)
+    {
+        threads.emplace_back([&registry, thread]() {
+            for (auto i = 0; i < kItems; ++i)
+            {
+                const auto key = thread * kItems + i;
+
+                registry.Insert(key, key, [](int&) {});
+
+                if (i % 2)
+                {
+                    registry.Erase(key, [](int&) {});
+                }
+            }
+        });
+    }
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    EXPECT_EQ(registry.Size(), kThreads * kItems / 2);
+}
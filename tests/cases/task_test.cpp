@@ -0,0 +1,212 @@
+#include "test_config.hpp"
+
+TEST(Task, Result)
+{
+    ntp::SystemThreadPool pool;
+
+    auto future = pool.SubmitTask([](int value) {
+        return value * 2;
+    }, 21);
+
+    ASSERT_TRUE(future.Valid());
+    EXPECT_EQ(future.Get(), 42);
+    EXPECT_FALSE(future.Valid());
+}
+
+TEST(Task, Void)
+{
+    std::atomic_int counter = 0;
+    ntp::SystemThreadPool pool;
+
+    auto future = pool.SubmitTask([&counter]() {
+        counter++;
+    });
+
+    future.Wait();
+
+    EXPECT_TRUE(future.IsReady());
+    EXPECT_NO_THROW(future.Get());
+    EXPECT_EQ(counter, 1);
+}
+
+TEST(Task, Instance)
+{
+    ntp::SystemThreadPool pool;
+
+    auto future = pool.SubmitTask([](PTP_CALLBACK_INSTANCE instance, int value) {
+        return instance != nullptr ? value : 0;
+    }, 42);
+
+    EXPECT_EQ(future.Get(), 42);
+}
+
+TEST(Task, MoveOnlyResult)
+{
+    ntp::SystemThreadPool pool;
+
+    auto future = pool.SubmitTask([](std::unique_ptr<int> value) {
+        return value;
+    }, std::make_unique<int>(42));
+
+    const auto result = future.Get();
+
+    ASSERT_NE(result, nullptr);
+    EXPECT_EQ(*result, 42);
+}
+
+TEST(Task, Exception)
+{
+    ntp::SystemThreadPool pool;
+
+    auto future = pool.SubmitTask([]() -> int {
+        throw std::runtime_error("task error");
+    });
+
+    EXPECT_THROW(future.Get(), std::runtime_error);
+}
+
+TEST(Task, WaitFor)
+{
+    using namespace std::chrono_literals;
+
+    std::atomic_bool release = false;
+    ntp::SystemThreadPool pool;
+
+    auto future = pool.SubmitTask([&release]() {
+        while (!release)
+        {
+            std::this_thread::sleep_for(1ms);
+        }
+
+        return 1;
+    });
+
+    EXPECT_FALSE(future.WaitFor(10ms));
+
+    release = true;
+
+    EXPECT_TRUE(future.WaitFor(10s));
+    EXPECT_EQ(future.Get(), 1);
+}
+
+TEST(Task, Then)
+{
+    std::atomic_int result = 0;
+    std::atomic<std::thread::id> continuation_thread;
+    std::atomic<std::thread::id> task_thread;
+
+    ntp::SystemThreadPool pool;
+
+    auto future = pool.SubmitTask([&task_thread]() {
+        task_thread = std::this_thread::get_id();
+        return 42;
+    });
+
+    future.Then([&result, &continuation_thread](ntp::task::Future<int> ready) {
+        EXPECT_TRUE(ready.IsReady());
+
+        continuation_thread = std::this_thread::get_id();
+        result              = ready.Get();
+    });
+
+    EXPECT_FALSE(future.Valid());
+
+    pool.WaitWorks();
+
+    EXPECT_EQ(result, 42);
+
+    //
+    // Continuation is invoked by worker, if task was not completed before
+    // Then, otherwise it is invoked by the calling thread
+    //
+
+    const auto thread = continuation_thread.load();
+    EXPECT_TRUE(thread == task_thread.load() || thread == std::this_thread::get_id());
+}
+
+TEST(Task, ThenReady)
+{
+    ntp::SystemThreadPool pool;
+
+    auto future = pool.SubmitTask([]() -> int {
+        throw std::runtime_error("task error");
+    });
+
+    future.Wait();
+
+    bool invoked = false;
+
+    future.Then([&invoked](ntp::task::Future<int> ready) {
+        invoked = true;
+        EXPECT_THROW(ready.Get(), std::runtime_error);
+    });
+
+    EXPECT_TRUE(invoked);
+}
+
+TEST(Task, Cancel)
+{
+    using namespace std::chrono_literals;
+
+    static constexpr auto kTasks = 50;
+
+    std::vector<ntp::task::Future<int>> futures;
+    ntp::ThreadPool pool(1, 1);
+
+    std::atomic_bool release = false;
+
+    pool.SubmitWork([&release]() {
+        while (!release)
+        {
+            std::this_thread::sleep_for(1ms);
+        }
+    });
+
+    for (auto i = 0; i < kTasks; ++i)
+    {
+        futures.push_back(pool.SubmitTask([i]() {
+            return i;
+        }));
+    }
+
+    std::thread canceller([&pool]() {
+        pool.CancelWorks();
+    });
+
+    std::this_thread::sleep_for(10ms);
+    release = true;
+    canceller.join();
+
+    //
+    // Every future must become ready: either with a result or with an exception
+    //
+
+    for (auto& future : futures)
+    {
+        ASSERT_TRUE(future.WaitFor(10s));
+        EXPECT_THROW(future.Get(), ntp::exception::Win32Exception);
+    }
+}
+
+TEST(Task, Abandoned)
+{
+    static constexpr auto kTasks = 100;
+
+    std::atomic_int counter = 0;
+    ntp::SystemThreadPool pool;
+
+    //
+    // Futures are destroyed right after submission
+    //
+
+    for (auto i = 0; i < kTasks; ++i)
+    {
+        pool.SubmitTask([&counter]() {
+            return ++counter;
+        });
+    }
+
+    pool.WaitWorks();
+
+    EXPECT_EQ(counter, kTasks);
+}
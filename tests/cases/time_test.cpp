@@ -0,0 +1,176 @@
+#include "test_config.hpp"
+
+namespace {
+
+using time_point_t = std::chrono::steady_clock::time_point;
+
+}  // namespace
+
+
+TEST(Time, NextExpirationOneShot)
+{
+    using namespace std::chrono_literals;
+
+    const time_point_t now { 1s };
+
+    EXPECT_EQ(ntp::time::NextExpiration(now + 10ms, 0ms, now), now + 10ms);
+    EXPECT_EQ(ntp::time::NextExpiration(now, 0ms, now), now);
+
+    //
+    // Gone deadline of one-shot timer is kept as is (timer expires immediately then)
+    //
+
+    EXPECT_EQ(ntp::time::NextExpiration(now - 10ms, 0ms, now), now - 10ms);
+}
+
+TEST(Time, NextExpirationPeriodic)
+{
+    using namespace std::chrono_literals;
+
+    const time_point_t deadline { 1s };
+
+    EXPECT_EQ(ntp::time::NextExpiration(deadline, 10ms, deadline - 5ms), deadline);
+    EXPECT_EQ(ntp::time::NextExpiration(deadline, 10ms, deadline), deadline);
+
+    //
+    // Schedule stays anchored at the original deadline
+    //
+
+    EXPECT_EQ(ntp::time::NextExpiration(deadline, 10ms, deadline + 1ns), deadline + 10ms);
+    EXPECT_EQ(ntp::time::NextExpiration(deadline, 10ms, deadline + 10ms), deadline + 10ms);
+    EXPECT_EQ(ntp::time::NextExpiration(deadline, 10ms, deadline + 10ms + 1ns), deadline + 20ms);
+    EXPECT_EQ(ntp::time::NextExpiration(deadline, 10ms, deadline + 1234ms), deadline + 1240ms);
+}
+
+TEST(Time, FileTimeRoundTrip)
+{
+    using namespace std::chrono_literals;
+
+    const auto filetime = ntp::time::AsFileTime(1500ms);
+    const auto value    = (static_cast<std::uint64_t>(filetime.dwHighDateTime) << 32) | filetime.dwLowDateTime;
+
+    EXPECT_EQ(value, 15000000ull);
+
+    const auto negated       = ntp::time::Negate(filetime);
+    const auto negated_value = (static_cast<std::uint64_t>(negated.dwHighDateTime) << 32) | negated.dwLowDateTime;
+
+    EXPECT_EQ(static_cast<std::int64_t>(negated_value), -15000000ll);
+}
+
+TEST(Time, PeriodicScheduleOnTime)
+{
+    using namespace std::chrono_literals;
+
+    const ntp::time::clock_t::time_point first { 1s };
+    ntp::time::PeriodicSchedule schedule { first, 250us };
+
+    EXPECT_FALSE(schedule.Due(first - 1ns));
+    EXPECT_TRUE(schedule.Due(first));
+
+    const auto tick = schedule.Expire(first + 10us);
+
+    EXPECT_EQ(tick.index, 0u);
+    EXPECT_EQ(tick.missed, 0u);
+    EXPECT_EQ(tick.deadline, first);
+    EXPECT_EQ(tick.lateness, 10us);
+    EXPECT_EQ(schedule.Deadline(), first + 250us);
+}
+
+TEST(Time, PeriodicScheduleMissed)
+{
+    using namespace std::chrono_literals;
+
+    const ntp::time::clock_t::time_point first { 1s };
+    ntp::time::PeriodicSchedule schedule { first, 250us };
+
+    //
+    // Ticks 0, 1 and 2 are gone, only the last one is reported
+    //
+
+    const auto tick = schedule.Expire(first + 600us);
+
+    EXPECT_EQ(tick.index, 2u);
+    EXPECT_EQ(tick.missed, 2u);
+    EXPECT_EQ(tick.deadline, first + 500us);
+    EXPECT_EQ(tick.lateness, 100us);
+    EXPECT_EQ(schedule.NextIndex(), 3u);
+    EXPECT_EQ(schedule.Deadline(), first + 750us);
+}
+
+TEST(Time, PeriodicScheduleNoDrift)
+{
+    using namespace std::chrono_literals;
+
+    const ntp::time::clock_t::time_point first { 1s };
+    ntp::time::PeriodicSchedule schedule { first, ntp::time::native_duration_t(3) };
+
+    //
+    // Each tick expires late, but deadlines stay at first + N * period
+    //
+
+    for (std::uint64_t i = 0; i < 100000; ++i)
+    {
+        const auto tick = schedule.Expire(schedule.Deadline() + 100ns);
+
+        ASSERT_EQ(tick.index, i);
+        ASSERT_EQ(tick.missed, 0u);
+    }
+
+    EXPECT_EQ(schedule.Deadline(), first + 100000 * 300ns);
+}
+
+TEST(Time, PeriodicScheduleReset)
+{
+    using namespace std::chrono_literals;
+
+    const ntp::time::clock_t::time_point first { 1s };
+    ntp::time::PeriodicSchedule schedule { first, 1ms };
+
+    schedule.Expire(first);
+    schedule.Reset(first + 10500us);
+
+    EXPECT_EQ(schedule.Deadline(), first + 10500us);
+
+    const auto tick = schedule.Expire(first + 11600us);
+
+    EXPECT_EQ(tick.index, 2u);
+    EXPECT_EQ(tick.missed, 1u);
+    EXPECT_EQ(tick.deadline, first + 11500us);
+}
+
+TEST(Time, JitterHistogram)
+{
+    using namespace std::chrono_literals;
+
+    ntp::time::JitterHistogram histogram;
+
+    EXPECT_EQ(histogram.Count(), 0u);
+    EXPECT_EQ(histogram.Percentile(0.5), ntp::time::native_duration_t::zero());
+
+    histogram.Record(ntp::time::native_duration_t(-5));
+    histogram.Record(ntp::time::native_duration_t(0));
+    histogram.Record(ntp::time::native_duration_t(1));
+    histogram.Record(ntp::time::native_duration_t(3));
+    histogram.Record(ntp::time::native_duration_t(4));
+
+    for (int i = 0; i < 95; ++i)
+    {
+        histogram.Record(10us);
+    }
+
+    EXPECT_EQ(histogram.Count(), 100u);
+    EXPECT_EQ(histogram.Bucket(0), 2u);
+    EXPECT_EQ(histogram.Bucket(1), 1u);
+    EXPECT_EQ(histogram.Bucket(2), 1u);
+    EXPECT_EQ(histogram.Bucket(3), 1u);
+    EXPECT_EQ(histogram.Max(), 10us);
+
+    //
+    // 10us is 100 native units, that is bucket [64, 128)
+    //
+
+    EXPECT_EQ(histogram.Bucket(7), 95u);
+    EXPECT_EQ(histogram.Percentile(0.0), ntp::time::native_duration_t(1));
+    EXPECT_EQ(histogram.Percentile(0.03), ntp::time::native_duration_t(2));
+    EXPECT_EQ(histogram.Percentile(0.99), 10us);
+}
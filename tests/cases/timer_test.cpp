@@ -17,6 +17,22 @@ TEST(Timer, Submit)
     EXPECT_EQ(counter, 1);
 }
 
+TEST(Timer, SubmitZero)
+{
+    using namespace std::chrono_literals;
+
+    std::atomic_int counter = 0;
+    ntp::SystemThreadPool pool;
+
+    pool.SubmitTimer(0ms, [&counter]() {
+        ++counter;
+    });
+
+    std::this_thread::sleep_for(40ms);
+
+    EXPECT_EQ(counter, 1);
+}
+
 TEST(Timer, SubmitDeadline)
 {
     using namespace std::chrono_literals;
@@ -65,3 +81,476 @@ TEST(Timer, Replace)
 
     EXPECT_EQ(counter, 1);
 }
+
+TEST(Timer, ReplaceKeepsDeadline)
+{
+    using namespace std::chrono_literals;
+
+    std::atomic<ntp::time::clock_t::time_point> fired {};
+    ntp::SystemThreadPool pool;
+
+    const auto submitted = ntp::time::clock_t::now();
+    const auto timer     = pool.SubmitTimer(60ms, []() {});
+
+    std::this_thread::sleep_for(40ms);
+
+    pool.ReplaceTimer(timer, [&fired]() {
+        fired = ntp::time::clock_t::now();
+    });
+
+    std::this_thread::sleep_for(100ms);
+
+    //
+    // Timer must not restart its timeout on replace (it would expire after 100ms then)
+    //
+
+    ASSERT_NE(fired.load(), ntp::time::clock_t::time_point {});
+    EXPECT_GE(fired.load() - submitted, 60ms);
+    EXPECT_LT(fired.load() - submitted, 95ms);
+}
+
+TEST(Timer, Rearm)
+{
+    using namespace std::chrono_literals;
+
+    std::atomic_int counter = 0;
+    ntp::SystemThreadPool pool;
+
+    const auto timer = pool.SubmitTimer(30ms, [&counter]() {
+        ++counter;
+    });
+
+    for (int i = 0; i < 5; ++i)
+    {
+        std::this_thread::sleep_for(10ms);
+        EXPECT_TRUE(pool.RearmTimer(timer, 30ms));
+    }
+
+    EXPECT_EQ(counter, 0);
+
+    std::this_thread::sleep_for(80ms);
+
+    EXPECT_EQ(counter, 1);
+
+    //
+    // One-shot timer is removed after expiration
+    //
+
+    EXPECT_FALSE(pool.RearmTimer(timer, 10ms));
+}
+
+TEST(Timer, RearmRunning)
+{
+    using namespace std::chrono_literals;
+
+    std::atomic_int counter = 0;
+    std::atomic_bool started = false;
+    ntp::SystemThreadPool pool;
+
+    const auto timer = pool.SubmitTimer(5ms, [&counter, &started]() {
+        started = true;
+        std::this_thread::sleep_for(50ms);
+
+        ++counter;
+    });
+
+    while (!started)
+    {
+        std::this_thread::sleep_for(1ms);
+    }
+
+    //
+    // Running one-shot timer is closed after its callback, so it cannot be rearmed
+    //
+
+    EXPECT_FALSE(pool.RearmTimer(timer, 10ms));
+
+    std::this_thread::sleep_for(100ms);
+
+    EXPECT_EQ(counter, 1);
+    EXPECT_FALSE(pool.RearmTimer(timer, 10ms));
+}
+
+TEST(Timer, RearmPeriodic)
+{
+    using namespace std::chrono_literals;
+
+    std::atomic_int counter = 0;
+    ntp::SystemThreadPool pool;
+
+    const auto timer = pool.SubmitTimer(1h, 5ms, [&counter]() {
+        ++counter;
+    });
+
+    EXPECT_TRUE(pool.RearmTimer(timer, 2ms));
+
+    std::this_thread::sleep_for(50ms);
+
+    EXPECT_GT(counter, 1);
+    EXPECT_TRUE(pool.RearmTimer(timer, 1h));
+}
+
+TEST(Timer, RearmConcurrent)
+{
+    using namespace std::chrono_literals;
+
+    static constexpr auto kThreads = 4;
+    static constexpr auto kRearms  = 500;
+
+    std::atomic_int counter = 0;
+    ntp::SystemThreadPool pool;
+
+    const auto timer = pool.SubmitTimer(1h, [&counter]() {
+        ++counter;
+    });
+
+    std::vector<std::thread> threads;
+
+    for (auto i = 0; i < kThreads; ++i)
+    {
+        threads.emplace_back([&pool, timer]() {
+            for (auto j = 0; j < kRearms; ++j)
+            {
+                EXPECT_TRUE(pool.RearmTimer(timer, 1h));
+            }
+        });
+    }
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    EXPECT_EQ(counter, 0);
+    EXPECT_TRUE(pool.RearmTimer(timer, 5ms));
+
+    std::this_thread::sleep_for(50ms);
+
+    EXPECT_EQ(counter, 1);
+}
+
+TEST(Timer, SubMillisecondPeriod)
+{
+    using namespace std::chrono_literals;
+
+    std::atomic_int counter = 0;
+    ntp::SystemThreadPool pool;
+
+    //
+    // Period is not a whole number of milliseconds, so it must not be truncated
+    //
+
+    const auto timer = pool.SubmitTimer(0ms, 1500us, [&counter]() {
+        ++counter;
+    });
+
+    std::this_thread::sleep_for(50ms);
+    pool.CancelTimer(timer);
+
+    EXPECT_GT(counter, 1);
+}
+
+TEST(Timer, PeriodicTicks)
+{
+    using namespace std::chrono_literals;
+
+    std::atomic<std::uint64_t> invocations = 0;
+    std::atomic<std::uint64_t> counted     = 0;
+    std::atomic<std::uint64_t> last        = 0;
+    std::atomic_int running                = 0;
+    std::atomic_bool overlapped            = false;
+
+    ntp::SystemThreadPool pool;
+    auto jitter = std::make_shared<ntp::time::JitterHistogram>();
+
+    const auto timer = pool.SubmitPeriodicTimer(1ms, 1ms, jitter, [&](const ntp::time::TimerTick& tick) {
+        if (running.fetch_add(1) != 0)
+        {
+            overlapped = true;
+        }
+
+        ++invocations;
+        counted += tick.missed + 1;
+        last     = tick.index;
+
+        //
+        // Some callbacks are longer than period, so the next ticks are missed
+        //
+
+        if (tick.index % 10 == 5)
+        {
+            std::this_thread::sleep_for(3ms);
+        }
+
+        --running;
+    });
+
+    std::this_thread::sleep_for(100ms);
+    pool.CancelTimer(timer);
+
+    EXPECT_FALSE(overlapped);
+    EXPECT_GT(invocations.load(), 10u);
+    EXPECT_LT(invocations.load(), last.load() + 1);
+    EXPECT_EQ(counted.load(), last.load() + 1);
+    EXPECT_EQ(jitter->Count(), invocations.load());
+}
+
+TEST(Timer, PeriodicInvalid)
+{
+    using namespace std::chrono_literals;
+
+    ntp::SystemThreadPool pool;
+
+    EXPECT_THROW(pool.SubmitPeriodicTimer(1ms, 0ms, []() {}), ntp::exception::Win32Exception);
+    EXPECT_THROW(pool.SubmitPeriodicTimer(1ms, -1ms, []() {}), ntp::exception::Win32Exception);
+}
+
+TEST(Timer, PeriodicReplaceRearm)
+{
+    using namespace std::chrono_literals;
+
+    std::atomic_int first  = 0;
+    std::atomic_int second = 0;
+
+    ntp::SystemThreadPool pool;
+
+    const auto timer = pool.SubmitPeriodicTimer(1ms, 1ms, [&first](PTP_CALLBACK_INSTANCE) {
+        ++first;
+    });
+
+    std::this_thread::sleep_for(20ms);
+
+    pool.ReplaceTimer(timer, [&second](PTP_CALLBACK_INSTANCE, const ntp::time::TimerTick& tick) {
+        second += tick.index > 0 ? 1 : 0;
+    });
+
+    const auto replaced = first.load();
+    std::this_thread::sleep_for(20ms);
+
+    EXPECT_GT(replaced, 0);
+    EXPECT_EQ(first, replaced);
+    EXPECT_GT(second, 0);
+
+    //
+    // Rearmed timer continues its schedule from the new deadline
+    //
+
+    EXPECT_TRUE(pool.RearmTimer(timer, 1h));
+
+    std::this_thread::sleep_for(5ms);
+    const auto rearmed = second.load();
+    std::this_thread::sleep_for(20ms);
+
+    EXPECT_EQ(second, rearmed);
+}
+
+TEST(Timer, PeriodicCancelStress)
+{
+    using namespace std::chrono_literals;
+
+    std::atomic_int counter = 0;
+    ntp::SystemThreadPool pool;
+
+    //
+    // Callbacks set their timers again, so cancellation must not race with them
+    //
+
+    for (int i = 0; i < 200; ++i)
+    {
+        const auto timer = pool.SubmitPeriodicTimer(0ms, 100us, [&counter]() {
+            ++counter;
+        });
+
+        std::this_thread::sleep_for(100us);
+        pool.CancelTimer(timer);
+    }
+
+    for (int i = 0; i < 20; ++i)
+    {
+        pool.SubmitPeriodicTimer(0ms, 100us, [&counter]() {
+            ++counter;
+        });
+    }
+
+    std::this_thread::sleep_for(5ms);
+    pool.CancelTimers();
+
+    const auto cancelled = counter.load();
+    std::this_thread::sleep_for(10ms);
+
+    EXPECT_GT(cancelled, 0);
+    EXPECT_EQ(counter, cancelled);
+}
+
+TEST(Timer, SoftSubmit)
+{
+    using namespace std::chrono_literals;
+
+    std::atomic_int counter = 0;
+    ntp::SystemThreadPool pool;
+
+    const auto start = std::chrono::steady_clock::now();
+    std::atomic<std::chrono::steady_clock::duration> elapsed {};
+
+    pool.SubmitSoftTimer(10ms, [&counter, &elapsed, start]() {
+        elapsed = std::chrono::steady_clock::now() - start;
+        ++counter;
+    });
+
+    std::this_thread::sleep_for(60ms);
+
+    EXPECT_EQ(counter, 1);
+    EXPECT_GE(elapsed.load(), 10ms);
+}
+
+TEST(Timer, SoftMany)
+{
+    using namespace std::chrono_literals;
+
+    static constexpr auto kTimers = 10000;
+
+    std::atomic_int counter = 0;
+    ntp::SystemThreadPool pool;
+
+    std::vector<ntp::soft_timer_t> timers;
+    for (auto i = 0; i < kTimers; ++i)
+    {
+        timers.push_back(pool.SubmitSoftTimer(std::chrono::milliseconds(100 + i % 20), [&counter]() {
+            ++counter;
+        }));
+    }
+
+    //
+    // Half of timers is cancelled
+    //
+
+    for (auto i = 0; i < kTimers; i += 2)
+    {
+        pool.CancelSoftTimer(timers[i]);
+    }
+
+    std::this_thread::sleep_for(300ms);
+
+    EXPECT_EQ(counter, kTimers / 2);
+
+    //
+    // Expired timers may be cancelled safely
+    //
+
+    pool.CancelSoftTimer(timers[1]);
+}
+
+TEST(Timer, SoftCancelStale)
+{
+    using namespace std::chrono_literals;
+
+    std::atomic_int counter = 0;
+    ntp::SystemThreadPool pool;
+
+    const auto expired = pool.SubmitSoftTimer(1ms, [&counter]() {
+        ++counter;
+    });
+
+    std::this_thread::sleep_for(50ms);
+    ASSERT_EQ(counter, 1);
+
+    //
+    // New timer reuses the slot of expired one, but stale handle must not cancel it
+    //
+
+    pool.SubmitSoftTimer(20ms, [&counter]() {
+        ++counter;
+    });
+
+    pool.CancelSoftTimer(expired);
+    std::this_thread::sleep_for(100ms);
+
+    EXPECT_EQ(counter, 2);
+}
+
+TEST(Timer, SoftCancelAll)
+{
+    using namespace std::chrono_literals;
+
+    std::atomic_int counter = 0;
+    ntp::SystemThreadPool pool;
+
+    for (auto i = 0; i < 100; ++i)
+    {
+        pool.SubmitSoftTimer(20ms, [&counter]() {
+            ++counter;
+        });
+    }
+
+    pool.CancelSoftTimers();
+
+    std::this_thread::sleep_for(50ms);
+
+    EXPECT_EQ(counter, 0);
+}
+
+TEST(Timer, SoftResubmit)
+{
+    using namespace std::chrono_literals;
+
+    std::atomic_int counter = 0;
+    ntp::SystemThreadPool pool;
+
+    pool.SetSoftTimerResolution(2ms);
+
+    //
+    // Callback submits the next soft timer
+    //
+
+    std::function<void()> callback = [&]() {
+        if (++counter < 5)
+        {
+            pool.SubmitSoftTimer(1ms, callback);
+        }
+    };
+
+    pool.SubmitSoftTimer(1ms, callback);
+
+    std::this_thread::sleep_for(100ms);
+
+    EXPECT_EQ(counter, 5);
+}
+
+TEST(Timer, SoftResolution)
+{
+    using namespace std::chrono_literals;
+
+    ntp::SystemThreadPool pool;
+
+    EXPECT_THROW(pool.SetSoftTimerResolution(0ms), ntp::exception::Win32Exception);
+
+    const auto timer = pool.SubmitSoftTimer(1h, []() {});
+    EXPECT_THROW(pool.SetSoftTimerResolution(5ms), ntp::exception::Win32Exception);
+
+    pool.CancelSoftTimer(timer);
+    EXPECT_NO_THROW(pool.SetSoftTimerResolution(5ms));
+}
+
+TEST(Timer, Tolerance)
+{
+    using namespace std::chrono_literals;
+
+    std::atomic_int counter = 0;
+    ntp::SystemThreadPool pool;
+
+    pool.SubmitTimer(2ms, ntp::time::Tolerance(10ms), [&counter]() {
+        ++counter;
+    });
+
+    pool.SubmitTimer(ntp::time::clock_t::now() + 2ms, ntp::time::Tolerance(10ms), [&counter]() {
+        ++counter;
+    });
+
+    pool.SubmitTimer(2ms, 5ms, ntp::time::Tolerance(1ms), [&counter]() {
+        ++counter;
+    });
+
+    std::this_thread::sleep_for(60ms);
+
+    EXPECT_GE(counter, 4);
+}
@@ -0,0 +1,156 @@
+#include "test_config.hpp"
+#include "details/timer_wheel.hpp"
+
+namespace {
+
+struct TestTimer : ntp::details::TimerWheelEntry
+{
+    std::uint64_t expired_at = 0;
+};
+
+template<typename Wheel>
+void AdvanceTo(Wheel& wheel, std::uint64_t now)
+{
+    wheel.Advance(now, [&wheel](ntp::details::TimerWheelEntry* entry) {
+        static_cast<TestTimer*>(entry)->expired_at = wheel.Now();
+    });
+}
+
+}  // namespace
+
+
+TEST(TimerWheel, ExpiresOnTime)
+{
+    ntp::details::TimerWheel<4, 3> wheel;
+
+    //
+    // Delays cover all levels and cascade boundaries (16, 256 ticks)
+    //
+
+    std::vector<std::uint64_t> delays = { 1, 2, 15, 16, 17, 31, 255, 256, 257, 1000, 4095 };
+    std::vector<TestTimer> timers(delays.size());
+
+    for (size_t i = 0; i < delays.size(); ++i)
+    {
+        wheel.Insert(&timers[i], delays[i]);
+    }
+
+    EXPECT_EQ(wheel.Size(), delays.size());
+
+    for (std::uint64_t tick = 1; tick <= 4096; ++tick)
+    {
+        AdvanceTo(wheel, tick);
+    }
+
+    EXPECT_TRUE(wheel.Empty());
+
+    for (size_t i = 0; i < delays.size(); ++i)
+    {
+        EXPECT_EQ(timers[i].expired_at, delays[i]) << "delay " << delays[i];
+    }
+}
+
+TEST(TimerWheel, AdvanceMany)
+{
+    ntp::details::TimerWheel<4, 3> wheel(100);
+
+    std::vector<TestTimer> timers(300);
+    for (size_t i = 0; i < timers.size(); ++i)
+    {
+        wheel.Insert(&timers[i], 100 + i * 7);
+    }
+
+    //
+    // Advancing by many ticks at once expires timers in order of expiration
+    //
+
+    std::vector<std::uint64_t> order;
+    wheel.Advance(100 + 300 * 7, [&order](ntp::details::TimerWheelEntry* entry) {
+        order.push_back(entry->expiry);
+    });
+
+    EXPECT_TRUE(wheel.Empty());
+    EXPECT_EQ(order.size(), timers.size());
+    EXPECT_TRUE(std::is_sorted(order.begin(), order.end()));
+}
+
+TEST(TimerWheel, Overflow)
+{
+    //
+    // Wheel covers 2^8 ticks, timer expires much later
+    //
+
+    ntp::details::TimerWheel<4, 2> wheel;
+
+    TestTimer timer;
+    wheel.Insert(&timer, 5000);
+
+    for (std::uint64_t tick = 1; tick <= 5000; ++tick)
+    {
+        AdvanceTo(wheel, tick);
+
+        if (tick < 5000)
+        {
+            ASSERT_EQ(timer.expired_at, 0) << "tick " << tick;
+        }
+    }
+
+    EXPECT_EQ(timer.expired_at, 5000);
+}
+
+TEST(TimerWheel, ExpiredOnInsert)
+{
+    ntp::details::TimerWheel<> wheel(50);
+
+    TestTimer timer;
+    wheel.Insert(&timer, 10);
+
+    AdvanceTo(wheel, 51);
+    EXPECT_EQ(timer.expired_at, 51);
+}
+
+TEST(TimerWheel, Cancel)
+{
+    ntp::details::TimerWheel<4, 3> wheel;
+
+    std::vector<TestTimer> timers(100);
+    for (size_t i = 0; i < timers.size(); ++i)
+    {
+        wheel.Insert(&timers[i], i * 3 + 1);
+    }
+
+    for (size_t i = 0; i < timers.size(); i += 2)
+    {
+        EXPECT_TRUE(wheel.Cancel(&timers[i]));
+        EXPECT_FALSE(wheel.Cancel(&timers[i]));
+    }
+
+    EXPECT_EQ(wheel.Size(), timers.size() / 2);
+
+    AdvanceTo(wheel, 1000);
+
+    for (size_t i = 0; i < timers.size(); ++i)
+    {
+        EXPECT_EQ(timers[i].expired_at, (i % 2) ? i * 3 + 1 : 0);
+    }
+}
+
+TEST(TimerWheel, Clear)
+{
+    ntp::details::TimerWheel<> wheel;
+
+    std::vector<TestTimer> timers(50);
+    for (size_t i = 0; i < timers.size(); ++i)
+    {
+        wheel.Insert(&timers[i], i * 1000);
+    }
+
+    size_t removed = 0;
+    wheel.Clear([&removed](ntp::details::TimerWheelEntry* entry) {
+        EXPECT_FALSE(entry->Linked());
+        ++removed;
+    });
+
+    EXPECT_EQ(removed, timers.size());
+    EXPECT_TRUE(wheel.Empty());
+}
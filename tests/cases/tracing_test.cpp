@@ -0,0 +1,197 @@
+#include <sstream>
+#include <thread>
+
+#include "test_config.hpp"
+#include "details/tracing.hpp"
+
+namespace {
+
+//
+// Reads protobuf varint at position and advances it
+//
+
+std::uint64_t ReadVarint(const std::string& data, std::size_t& position)
+{
+    std::uint64_t value = 0;
+
+    for (unsigned shift = 0; position < data.size(); shift += 7)
+    {
+        const auto byte = static_cast<unsigned char>(data[position++]);
+        value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+
+        if (!(byte & 0x80))
+        {
+            break;
+        }
+    }
+
+    return value;
+}
+
+ntp::tracing::Trace MakeTrace()
+{
+    using ntp::tracing::CallbackKind;
+
+    ntp::tracing::Trace trace;
+    trace.process_id           = 42;
+    trace.nanoseconds_per_tick = 1.0;
+
+    auto& first     = trace.threads.emplace_back();
+    first.thread_id = 7;
+    first.events.push_back(ntp::tracing::Event { 1000, 3500, "a\"b", CallbackKind::kWork });
+    first.events.push_back(ntp::tracing::Event { 4000, 4000, nullptr, CallbackKind::kTimer });
+
+    auto& second     = trace.threads.emplace_back();
+    second.thread_id = 8;
+    second.events.push_back(ntp::tracing::Event { 2000, 1002000, nullptr, CallbackKind::kIo });
+
+    return trace;
+}
+
+}  // namespace
+
+TEST(Tracing, ChromeTrace)
+{
+    std::ostringstream stream;
+    ntp::tracing::WriteChromeTrace(stream, MakeTrace());
+
+    const auto json = stream.str();
+
+    //
+    // Timestamps are in microseconds since the earliest event
+    //
+
+    EXPECT_EQ(json.find("{\"traceEvents\":["), 0);
+    EXPECT_NE(json.find("{\"name\":\"a\\\"b\",\"cat\":\"work\",\"ph\":\"X\",\"pid\":42,\"tid\":7,\"ts\":0.000,\"dur\":2.500}"), std::string::npos);
+    EXPECT_NE(json.find("{\"name\":\"timer\",\"cat\":\"timer\",\"ph\":\"X\",\"pid\":42,\"tid\":7,\"ts\":3.000,\"dur\":0.000}"), std::string::npos);
+    EXPECT_NE(json.find("{\"name\":\"io\",\"cat\":\"io\",\"ph\":\"X\",\"pid\":42,\"tid\":8,\"ts\":1.000,\"dur\":1000.000}"), std::string::npos);
+    EXPECT_NE(json.find("],\"displayTimeUnit\":\"ns\"}"), std::string::npos);
+}
+
+TEST(Tracing, Perfetto)
+{
+    std::ostringstream stream;
+    ntp::tracing::WritePerfetto(stream, MakeTrace());
+
+    const auto data = stream.str();
+
+    //
+    // Trace consists of packets only: a descriptor per thread
+    // and begin and end slices per event
+    //
+
+    std::size_t packets  = 0;
+    std::size_t position = 0;
+
+    while (position < data.size())
+    {
+        const auto key = ReadVarint(data, position);
+        ASSERT_EQ(key, (1 << 3) | 2);
+
+        const auto size = ReadVarint(data, position);
+        ASSERT_LE(position + size, data.size());
+
+        position += size;
+        ++packets;
+    }
+
+    EXPECT_EQ(packets, 2 + 2 * 3);
+    EXPECT_NE(data.find("a\"b"), std::string::npos);
+    EXPECT_NE(data.find("timer"), std::string::npos);
+}
+
+TEST(Tracing, Record)
+{
+    using ntp::tracing::CallbackKind;
+
+    ntp::tracing::Start();
+
+    {
+        ntp::tracing::ScopedTag tag { "outer" };
+
+        ntp::tracing::details::TraceScope scope { CallbackKind::kWait, ntp::tracing::details::current_tag };
+        EXPECT_STREQ(ntp::tracing::details::current_tag, "outer");
+    }
+
+    EXPECT_EQ(ntp::tracing::details::current_tag, nullptr);
+
+    std::thread([]() {
+        ntp::tracing::details::TraceScope scope { CallbackKind::kIo, nullptr };
+    }).join();
+
+    ntp::tracing::Stop();
+
+    {
+        //
+        // Tracing is stopped, nothing is recorded
+        //
+
+        ntp::tracing::details::TraceScope scope { CallbackKind::kWork, nullptr };
+    }
+
+    const auto trace = ntp::tracing::Collect();
+
+    ASSERT_EQ(trace.threads.size(), 2);
+
+    std::size_t events = 0;
+    for (const auto& thread : trace.threads)
+    {
+        ASSERT_EQ(thread.events.size(), 1);
+        EXPECT_EQ(thread.dropped, 0);
+        EXPECT_LE(thread.events[0].begin, thread.events[0].end);
+
+        if (thread.events[0].kind == CallbackKind::kWait)
+        {
+            EXPECT_STREQ(thread.events[0].tag, "outer");
+            ++events;
+        }
+        else if (thread.events[0].kind == CallbackKind::kIo)
+        {
+            EXPECT_EQ(thread.events[0].tag, nullptr);
+            ++events;
+        }
+    }
+
+    EXPECT_EQ(events, 2);
+
+    //
+    // Start discards previous events
+    //
+
+    ntp::tracing::Start();
+    ntp::tracing::Stop();
+
+    EXPECT_TRUE(ntp::tracing::Collect().threads.empty());
+}
+
+#if defined(NTP_ENABLE_TRACING)
+TEST(Tracing, Pool)
+{
+    ntp::SystemThreadPool pool;
+
+    ntp::tracing::Start();
+
+    {
+        ntp::tracing::ScopedTag tag { "stage" };
+        pool.SubmitWork([]() {});
+    }
+
+    pool.WaitWorks();
+    ntp::tracing::Stop();
+
+    const auto trace = ntp::tracing::Collect();
+
+    std::size_t events = 0;
+    for (const auto& thread : trace.threads)
+    {
+        for (const auto& event : thread.events)
+        {
+            EXPECT_EQ(event.kind, ntp::tracing::CallbackKind::kWork);
+            EXPECT_STREQ(event.tag, "stage");
+            ++events;
+        }
+    }
+
+    EXPECT_EQ(events, 1);
+}
+#endif  // NTP_ENABLE_TRACING
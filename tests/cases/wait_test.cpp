@@ -3,7 +3,7 @@
 
 TEST(Wait, Submit)
 {
-    ATL::CEvent event(TRUE, FALSE);
+    ntp::details::Event event(TRUE, FALSE);
     ntp::SystemThreadPool pool;
 
     EXPECT_NO_THROW({
@@ -13,8 +13,8 @@ TEST(Wait, Submit)
 
 TEST(Wait, Completion)
 {
-    ATL::CEvent event(TRUE, FALSE);
-    ATL::CEvent callback_completed(TRUE, FALSE);
+    ntp::details::Event event(TRUE, FALSE);
+    ntp::details::Event callback_completed(TRUE, FALSE);
     ntp::SystemThreadPool pool;
 
     bool is_completed = false;
@@ -34,8 +34,8 @@ TEST(Wait, TimedCompletion)
 {
     using namespace std::chrono_literals;
 
-    ATL::CEvent event(TRUE, FALSE);
-    ATL::CEvent callback_completed(TRUE, FALSE);
+    ntp::details::Event event(TRUE, FALSE);
+    ntp::details::Event callback_completed(TRUE, FALSE);
     ntp::SystemThreadPool pool;
 
     bool is_completed = false;
@@ -55,8 +55,8 @@ TEST(Wait, Timeout)
 {
     using namespace std::chrono_literals;
 
-    ATL::CEvent event(TRUE, FALSE);
-    ATL::CEvent callback_completed(TRUE, FALSE);
+    ntp::details::Event event(TRUE, FALSE);
+    ntp::details::Event callback_completed(TRUE, FALSE);
     ntp::SystemThreadPool pool;
 
     bool is_timed_out = false;
@@ -72,8 +72,8 @@ TEST(Wait, Timeout)
 
 TEST(Wait, Cancel)
 {
-    ATL::CEvent event(TRUE, FALSE);
-    ATL::CEvent callback_completed(TRUE, FALSE);
+    ntp::details::Event event(TRUE, FALSE);
+    ntp::details::Event callback_completed(TRUE, FALSE);
     ntp::SystemThreadPool pool;
 
     bool is_completed  = false;
@@ -89,8 +89,8 @@ TEST(Wait, Cancel)
 
 TEST(Wait, CancelAll)
 {
-    ATL::CEvent event1(TRUE, FALSE);
-    ATL::CEvent event2(TRUE, FALSE);
+    ntp::details::Event event1(TRUE, FALSE);
+    ntp::details::Event event2(TRUE, FALSE);
     ntp::SystemThreadPool pool;
 
     pool.SubmitWait(event1, [](TP_WAIT_RESULT) {});
@@ -100,3 +100,320 @@ TEST(Wait, CancelAll)
         pool.CancelWaits();
     });
 }
+
+TEST(Wait, Rearm)
+{
+    ntp::details::Event event(FALSE, FALSE);
+    ntp::details::Event callback_completed(FALSE, FALSE);
+    ntp::SystemThreadPool pool;
+
+    std::atomic_int counter = 0;
+    const auto wait_object = pool.SubmitWait(event, [&counter, &callback_completed](TP_WAIT_RESULT wait_result) {
+        if (wait_result == WAIT_OBJECT_0)
+        {
+            ++counter;
+        }
+
+        callback_completed.Set();
+        return ntp::wait::WaitAction::kRearm;
+    });
+
+    for (int i = 0; i < 10; ++i)
+    {
+        event.Set();
+        WaitForSingleObject(callback_completed, INFINITE);
+    }
+
+    EXPECT_EQ(counter, 10);
+    EXPECT_NO_THROW({
+        pool.CancelWait(wait_object);
+    });
+}
+
+TEST(Wait, RearmUntilComplete)
+{
+    using namespace std::chrono_literals;
+
+    ntp::details::Event event(TRUE, FALSE);
+    ntp::SystemThreadPool pool;
+
+    //
+    // Wait times out several times and then completes, stored arguments survive rearms
+    //
+
+    std::atomic_int timeouts = 0;
+    auto limit               = std::make_unique<int>(3);
+
+    pool.SubmitWait(event, 2ms, [&timeouts](PTP_CALLBACK_INSTANCE, TP_WAIT_RESULT wait_result, const std::unique_ptr<int>& limit) {
+        if (wait_result == WAIT_TIMEOUT && ++timeouts < *limit)
+        {
+            return ntp::wait::WaitAction::kRearm;
+        }
+
+        return ntp::wait::WaitAction::kComplete;
+    }, std::move(limit));
+
+    std::this_thread::sleep_for(100ms);
+
+    EXPECT_EQ(timeouts, 3);
+}
+
+TEST(Wait, RearmCancelStress)
+{
+    ntp::details::Event event(TRUE, TRUE);
+    ntp::SystemThreadPool pool;
+
+    //
+    // Manual-reset event is always signaled, so callbacks rearm their waits all the time
+    //
+
+    std::atomic_int counter = 0;
+
+    for (int i = 0; i < 100; ++i)
+    {
+        const auto wait_object = pool.SubmitWait(event, [&counter](TP_WAIT_RESULT) {
+            ++counter;
+            return ntp::wait::WaitAction::kRearm;
+        });
+
+        std::this_thread::yield();
+        pool.CancelWait(wait_object);
+    }
+
+    for (int i = 0; i < 10; ++i)
+    {
+        pool.SubmitWait(event, [&counter](TP_WAIT_RESULT) {
+            ++counter;
+            return ntp::wait::WaitAction::kRearm;
+        });
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    pool.CancelWaits();
+
+    const auto cancelled = counter.load();
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    EXPECT_GT(cancelled, 0);
+    EXPECT_EQ(counter, cancelled);
+}
+
+TEST(WaitGroup, Completion)
+{
+    constexpr int kCount = 64;
+
+    std::vector<std::unique_ptr<ntp::details::Event>> events;
+    std::vector<HANDLE> handles;
+
+    for (int i = 0; i < kCount; ++i)
+    {
+        events.push_back(std::make_unique<ntp::details::Event>(TRUE, FALSE));
+        handles.push_back(*events.back());
+    }
+
+    ntp::details::Event all_completed(TRUE, FALSE);
+    ntp::SystemThreadPool pool;
+
+    std::atomic_int completed = 0;
+    std::vector<std::atomic_int> seen(kCount);
+
+    pool.SubmitWaits(handles, [&](HANDLE wait_handle, TP_WAIT_RESULT wait_result) {
+        const auto index = std::find(handles.begin(), handles.end(), wait_handle) - handles.begin();
+        ASSERT_LT(index, kCount);
+
+        seen[index] += (wait_result == WAIT_OBJECT_0) ? 1 : 0;
+
+        if (++completed == kCount)
+        {
+            all_completed.Set();
+        }
+    });
+
+    for (auto& event : events)
+    {
+        event->Set();
+    }
+
+    WaitForSingleObject(all_completed, INFINITE);
+
+    for (auto& counter : seen)
+    {
+        EXPECT_EQ(counter, 1);
+    }
+}
+
+TEST(WaitGroup, Timeout)
+{
+    using namespace std::chrono_literals;
+
+    ntp::details::Event event1(TRUE, FALSE);
+    ntp::details::Event event2(TRUE, FALSE);
+    ntp::SystemThreadPool pool;
+
+    const std::array<HANDLE, 2> handles { event1, event2 };
+
+    std::atomic_int signaled  = 0;
+    std::atomic_int timed_out = 0;
+
+    pool.SubmitWaits(handles, 20ms, [&signaled, &timed_out](PTP_CALLBACK_INSTANCE, HANDLE, TP_WAIT_RESULT wait_result) {
+        ++(wait_result == WAIT_OBJECT_0 ? signaled : timed_out);
+    });
+
+    event1.Set();
+
+    std::this_thread::sleep_for(100ms);
+
+    EXPECT_EQ(signaled, 1);
+    EXPECT_EQ(timed_out, 1);
+}
+
+TEST(WaitGroup, Rearm)
+{
+    ntp::details::Event event1(FALSE, FALSE);
+    ntp::details::Event event2(FALSE, FALSE);
+    ntp::details::Event callback_completed(FALSE, FALSE);
+    ntp::SystemThreadPool pool;
+
+    const std::vector<HANDLE> handles { event1, event2 };
+
+    std::atomic_int counter = 0;
+    const auto group = pool.SubmitWaits(handles, [&counter, &callback_completed](HANDLE, TP_WAIT_RESULT) {
+        ++counter;
+        callback_completed.Set();
+
+        return ntp::wait::WaitAction::kRearm;
+    });
+
+    for (int i = 0; i < 5; ++i)
+    {
+        event1.Set();
+        WaitForSingleObject(callback_completed, INFINITE);
+
+        event2.Set();
+        WaitForSingleObject(callback_completed, INFINITE);
+    }
+
+    EXPECT_EQ(counter, 10);
+    EXPECT_NO_THROW({
+        pool.CancelWaitGroup(group);
+    });
+}
+
+TEST(WaitGroup, ThrowingCallback)
+{
+    using namespace std::chrono_literals;
+
+    ntp::details::Event event1(TRUE, FALSE);
+    ntp::details::Event event2(TRUE, FALSE);
+    ntp::SystemThreadPool pool;
+
+    const std::array<HANDLE, 2> handles { event1, event2 };
+
+    std::atomic_int counter = 0;
+    pool.SubmitWaits(handles, [&counter](HANDLE, TP_WAIT_RESULT) {
+        ++counter;
+        throw std::runtime_error("group callback failed");
+    });
+
+    EXPECT_EQ(pool.Snapshot().wait.live_objects, 1);
+
+    event1.Set();
+    event2.Set();
+
+    //
+    // Members, whose callbacks have thrown, are completed, so the group is removed
+    //
+
+    for (int i = 0; i < 100 && pool.Snapshot().wait.live_objects; ++i)
+    {
+        std::this_thread::sleep_for(5ms);
+    }
+
+    EXPECT_EQ(counter, 2);
+    EXPECT_EQ(pool.Snapshot().wait.live_objects, 0);
+}
+
+TEST(WaitGroup, Cancel)
+{
+    using namespace std::chrono_literals;
+
+    std::vector<std::unique_ptr<ntp::details::Event>> events;
+    std::vector<HANDLE> handles;
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        events.push_back(std::make_unique<ntp::details::Event>(TRUE, FALSE));
+        handles.push_back(*events.back());
+    }
+
+    ntp::SystemThreadPool pool;
+
+    std::atomic_int counter = 0;
+    const auto group = pool.SubmitWaits(handles, [&counter](HANDLE, TP_WAIT_RESULT) {
+        ++counter;
+    });
+
+    pool.CancelWaitGroup(group);
+
+    for (auto& event : events)
+    {
+        event->Set();
+    }
+
+    std::this_thread::sleep_for(20ms);
+
+    EXPECT_EQ(counter, 0);
+}
+
+TEST(WaitGroup, Invalid)
+{
+    ntp::SystemThreadPool pool;
+
+    const std::vector<HANDLE> handles;
+
+    EXPECT_THROW({
+        pool.SubmitWaits(handles, [](HANDLE, TP_WAIT_RESULT) {});
+    }, ntp::exception::Win32Exception);
+}
+
+TEST(WaitGroup, CancelStress)
+{
+    ntp::details::Event event(TRUE, TRUE);
+    ntp::SystemThreadPool pool;
+
+    //
+    // Event is always signaled, so groups complete or rearm concurrently with cancellation
+    //
+
+    const std::vector<HANDLE> handles(16, static_cast<HANDLE>(event));
+
+    std::atomic_int counter = 0;
+
+    for (int i = 0; i < 100; ++i)
+    {
+        const auto group = pool.SubmitWaits(handles, [&counter, i](HANDLE, TP_WAIT_RESULT) {
+            ++counter;
+            return (i % 2) ? ntp::wait::WaitAction::kRearm : ntp::wait::WaitAction::kComplete;
+        });
+
+        std::this_thread::yield();
+        pool.CancelWaitGroup(group);
+    }
+
+    for (int i = 0; i < 10; ++i)
+    {
+        pool.SubmitWaits(handles, [&counter](HANDLE, TP_WAIT_RESULT) {
+            ++counter;
+            return ntp::wait::WaitAction::kRearm;
+        });
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    pool.CancelWaits();
+
+    const auto cancelled = counter.load();
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    EXPECT_GT(cancelled, 0);
+    EXPECT_EQ(counter, cancelled);
+}
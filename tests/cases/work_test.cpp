@@ -56,3 +56,342 @@ TEST(Work, Cancel)
 
     EXPECT_LE(counter, kWorkers);
 }
+
+TEST(Work, SubmitOrder)
+{
+    static constexpr auto kWorkers = 50;
+
+    //
+    // Single worker thread must execute callbacks in submission order
+    //
+
+    std::vector<int> order;
+    ntp::ThreadPool pool(1, 1);
+
+    for (auto i = 0; i < kWorkers; ++i)
+    {
+        pool.SubmitWork([&order, i]() {
+            order.push_back(i);
+        });
+    }
+
+    pool.WaitWorks();
+
+    ASSERT_EQ(order.size(), kWorkers);
+
+    for (auto i = 0; i < kWorkers; ++i)
+    {
+        EXPECT_EQ(order[i], i);
+    }
+}
+
+TEST(Work, SubmitBatch)
+{
+    static constexpr auto kWorkers = 1000;
+
+    std::vector<int> values(kWorkers);
+    std::iota(values.begin(), values.end(), 1);
+
+    std::atomic_int counter = 0;
+    std::atomic_int sum     = 0;
+    ntp::SystemThreadPool pool;
+
+    pool.SubmitWorkBatch(values, [&counter, &sum](int value) {
+        counter++;
+        sum += value;
+    });
+
+    pool.WaitWorks();
+
+    EXPECT_EQ(counter, kWorkers);
+    EXPECT_EQ(sum, kWorkers * (kWorkers + 1) / 2);
+}
+
+TEST(Work, SubmitBatchOrder)
+{
+    static constexpr auto kWorkers = 50;
+
+    std::vector<int> values(kWorkers);
+    std::iota(values.begin(), values.end(), 0);
+
+    std::vector<int> order;
+    ntp::ThreadPool pool(1, 1);
+
+    pool.SubmitWorkBatch(values.begin(), values.end(), [&order](int value) {
+        order.push_back(value);
+    });
+
+    pool.SubmitWork([&order]() {
+        order.push_back(kWorkers);
+    });
+
+    pool.WaitWorks();
+
+    ASSERT_EQ(order.size(), kWorkers + 1);
+
+    for (auto i = 0; i <= kWorkers; ++i)
+    {
+        EXPECT_EQ(order[i], i);
+    }
+}
+
+TEST(Work, SubmitBatchInstance)
+{
+    static constexpr auto kWorkers = 100;
+
+    //
+    // Callbacks, that receive an instance, are invoked one per invocation
+    //
+
+    std::vector<int> values(kWorkers);
+    std::atomic_int counter = 0;
+
+    ntp::SystemThreadPool pool;
+
+    pool.SubmitWorkBatch(values, [&counter](PTP_CALLBACK_INSTANCE instance, int) {
+        EXPECT_NE(instance, nullptr);
+        counter++;
+    });
+
+    pool.WaitWorks();
+
+    EXPECT_EQ(counter, kWorkers);
+}
+
+TEST(Work, SubmitBatchSharedFunctor)
+{
+    static constexpr auto kWorkers = 1000;
+
+    struct Counting
+    {
+        Counting(std::atomic_int& counter, std::atomic_int& copies)
+            : counter(counter), copies(copies)
+        { }
+
+        Counting(const Counting& other)
+            : counter(other.counter), copies(other.copies)
+        {
+            ++copies;
+        }
+
+        void operator()(int) const { ++counter; }
+
+        std::atomic_int& counter;
+        std::atomic_int& copies;
+    };
+
+    //
+    // Callable is copied once for a whole batch, not into every callback
+    //
+
+    std::vector<int> values(kWorkers);
+    std::atomic_int counter = 0;
+    std::atomic_int copies  = 0;
+
+    ntp::SystemThreadPool pool;
+
+    pool.SubmitWorkBatch(values, Counting { counter, copies });
+    pool.WaitWorks();
+
+    EXPECT_EQ(counter, kWorkers);
+    EXPECT_EQ(copies, 1);
+}
+
+TEST(Work, SubmitBatchEmpty)
+{
+    std::vector<int> values;
+    std::atomic_int counter = 0;
+
+    ntp::SystemThreadPool pool;
+
+    pool.SubmitWorkBatch(values, [&counter](int) {
+        counter++;
+    });
+
+    pool.WaitWorks();
+
+    EXPECT_EQ(counter, 0);
+}
+
+TEST(Work, SubmitBatchCancel)
+{
+    static constexpr auto kWorkers = 1000;
+
+    std::vector<int> values(kWorkers);
+    std::atomic_int counter = 0;
+
+    ntp::SystemThreadPool pool;
+
+    pool.SubmitWorkBatch(values, [&counter](int) {
+        counter++;
+    });
+
+    pool.CancelWorks();
+
+    EXPECT_LE(counter, kWorkers);
+
+    //
+    // Pool must remain usable after cancellation
+    //
+
+    pool.SubmitWorkBatch(values, [&counter](int) {
+        counter++;
+    });
+
+    pool.WaitWorks();
+
+    EXPECT_GE(counter, kWorkers);
+}
+
+TEST(Work, QueueFull)
+{
+    //
+    // Blocked callback holds the oldest segment of the queue,
+    // so that the queue becomes full and Submit fails instead of waiting
+    //
+
+    static constexpr auto kMaxWorkers = 2 * 1024 * 1024;
+
+    std::atomic_bool released = false;
+    std::atomic_int counter   = 0;
+
+    ntp::SystemThreadPool pool;
+
+    pool.SubmitWork([&released, &counter]() {
+        while (!released)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        counter++;
+    });
+
+    auto submitted = 1;
+    bool full      = false;
+
+    for (; submitted < kMaxWorkers; ++submitted)
+    {
+        try
+        {
+            pool.SubmitWork([&counter]() { counter++; });
+        }
+        catch (const std::exception&)
+        {
+            full = true;
+            break;
+        }
+    }
+
+    EXPECT_TRUE(full);
+
+    released = true;
+    pool.WaitWorks();
+
+    EXPECT_EQ(counter, submitted);
+
+    //
+    // Pool must remain usable
+    //
+
+    pool.SubmitWork([&counter]() { counter++; });
+    pool.WaitWorks();
+
+    EXPECT_EQ(counter, submitted + 1);
+}
+
+TEST(Work, WaitLatency)
+{
+    using namespace std::chrono_literals;
+
+    std::atomic_int counter = 0;
+    ntp::SystemThreadPool pool;
+
+    pool.SubmitWork([&counter]() {
+        std::this_thread::sleep_for(20ms);
+        counter++;
+    });
+
+    //
+    // WaitWorks must return right after the last callback is completed
+    //
+
+    const auto start = std::chrono::steady_clock::now();
+    EXPECT_TRUE(pool.WaitWorks());
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    EXPECT_EQ(counter, 1);
+    EXPECT_LT(elapsed, 400ms);
+}
+
+TEST(Work, WaitCancelled)
+{
+    using namespace std::chrono_literals;
+
+    static constexpr auto kWorkers = 100;
+
+    std::atomic_bool cancel = false;
+    std::atomic_int counter = 0;
+
+    ntp::ThreadPool pool(1, 1, [&cancel]() { return cancel.load(); });
+
+    for (auto i = 0; i < kWorkers; ++i)
+    {
+        pool.SubmitWork([&counter, &cancel]() {
+            std::this_thread::sleep_for(10ms);
+            counter++;
+            cancel = true;
+        });
+    }
+
+    EXPECT_FALSE(pool.WaitWorks());
+    EXPECT_LT(counter, kWorkers);
+
+    //
+    // Counter of outstanding callbacks is consistent after cancellation
+    //
+
+    cancel = false;
+    counter = 0;
+
+    pool.SubmitWork([&counter]() {
+        counter++;
+    });
+
+    EXPECT_TRUE(pool.WaitWorks());
+    EXPECT_EQ(counter, 1);
+}
+
+TEST(Work, WaitConcurrent)
+{
+    static constexpr auto kWaiters = 4;
+    static constexpr auto kWorkers = 1000;
+
+    std::vector<int> values(kWorkers);
+    std::atomic_int counter = 0;
+
+    ntp::SystemThreadPool pool;
+
+    pool.SubmitWorkBatch(values, [&counter](int) {
+        counter++;
+    });
+
+    std::vector<std::thread> waiters;
+    std::atomic_int completed = 0;
+
+    for (auto i = 0; i < kWaiters; ++i)
+    {
+        waiters.emplace_back([&pool, &counter, &completed]() {
+            EXPECT_TRUE(pool.WaitWorks());
+            EXPECT_EQ(counter, kWorkers);
+
+            completed++;
+        });
+    }
+
+    for (auto& waiter : waiters)
+    {
+        waiter.join();
+    }
+
+    EXPECT_EQ(completed, kWaiters);
+}
@@ -11,9 +11,11 @@
 // Windows headers
 //
 
-#include <Windows.h>
-#include <atlsync.h>
-#include <atlfile.h>
+#if defined(_WIN32)
+#   include <Windows.h>
+#   include <atlsync.h>
+#   include <atlfile.h>
+#endif  // _WIN32
 
 
 //
@@ -25,6 +27,12 @@
 #include <chrono>
 #include <vector>
 #include <array>
+#include <cstring>
+#include <cstdint>
+#include <stdexcept>
+#include <numeric>
+#include <algorithm>
+#include <memory>
 
 
 //